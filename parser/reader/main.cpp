@@ -10,6 +10,7 @@
 #include "Watch.h"
 #include "ArgParser.h"
 #include "LefDefParser.h"
+#include "Parallel.h"
 
 #include <iostream>
 #include <sstream>    // for istringstream
@@ -20,10 +21,25 @@ using namespace std;
 void show_usage ();
 void show_banner ();
 void show_cmd_args ();
+int run (int argc, char* argv[]);
 
 #ifndef UNIT_TEST
 
+/**
+ * Run the parser, and report an error that stops it instead of aborting.
+ */
 int main (int argc, char* argv[])
+{
+    try {
+        return run(argc, argv);
+    }
+    catch (std::exception& e) {
+        cerr << e.what() << endl;
+        return -1;
+    }
+}
+
+int run (int argc, char* argv[])
 {
     util::Watch watch;
 
@@ -34,10 +50,29 @@ int main (int argc, char* argv[])
     // 支援多個 LEF 檔案，用逗號分隔
     auto filename_lef_list      = ap.get_argument("--lef");
     auto filename_def           = ap.get_argument("--def");
+    auto filename_sdc           = ap.get_argument("--sdc");
+    auto filename_tf            = ap.get_argument("--tf");
+    auto filename_weights       = ap.get_argument("--weights");
+    auto time_design            = ap.exists_argument("--sta");
+    auto filename_drive_table   = ap.get_argument("--drive-table");
     auto filename_bookshelf     = ap.get_argument("--bookshelf");
+    auto write_bookshelf        = ap.exists_argument("--bookshelf");
+    auto use_mmap               = ap.exists_argument("--mmap");
+    auto num_threads_str        = ap.get_argument("--threads");
+    auto filename_save_snapshot = ap.get_argument("--save-snapshot");
+    auto filename_load_snapshot = ap.get_argument("--load-snapshot");
+    auto lef_cache_dir          = ap.get_argument("--lef-cache");
+    auto cell_family_pattern    = ap.get_argument("--cell-families");
+    auto filename_out_def       = ap.get_argument("--write-def");
+    auto filename_rewrite_def   = ap.get_argument("--rewrite-def");
+    auto filename_update_pl     = ap.get_argument("--update-pl");
+    auto report_hpwl            = ap.exists_argument("--hpwl");
+    auto legalize               = ap.exists_argument("--legalize");
+    auto check_legality         = ap.exists_argument("--check-legality");
 
     // 2. 參數檢查
-    if (filename_lef_list.empty() || filename_def.empty()) {
+    if (filename_load_snapshot.empty() 
+        && (filename_lef_list.empty() || filename_def.empty())) {
         show_usage();
         return -1;
     }
@@ -51,23 +86,76 @@ int main (int argc, char* argv[])
 
     // 4. 取得 parser
     auto& ldp = my_lefdef::LefDefParser::get_instance();
+    ldp.set_mmap_input(use_mmap);
+    ldp.set_lef_cache_dir(lef_cache_dir);
+    if (!cell_family_pattern.empty()) {
+        ldp.set_cell_family_pattern(cell_family_pattern);
+    }
+    if (!num_threads_str.empty()) {
+        auto num_threads = stoi(num_threads_str);
+        ldp.set_num_threads(util::get_num_threads(num_threads));
+    }
 
     // 5. 依序讀入各個 LEF
-    {
+    if (!filename_load_snapshot.empty()) {
+        ldp.load_snapshot(filename_load_snapshot);
+    }
+    else {
         istringstream iss(filename_lef_list);
         string lef_file;
+        vector<string> lef_files;
         while (getline(iss, lef_file, ',')) {
             if (lef_file.empty()) continue;
-            cout << "Reading LEF: " << lef_file << endl;
-            ldp.read_lef(lef_file);
+            lef_files.push_back(lef_file);
         }
+        ldp.read_lefs(lef_files);
+
+        // 6. 讀取 DEF，並印 summary
+        ldp.read_def(filename_def);
+    }
+
+    if (!filename_sdc.empty()) {
+        ldp.read_sdc(filename_sdc);
+    }
+    if (!filename_tf.empty()) {
+        ldp.read_tf(filename_tf);
+    }
+
+    if (!filename_save_snapshot.empty()) {
+        ldp.save_snapshot(filename_save_snapshot);
+    }
+
+    if (!filename_update_pl.empty()) {
+        ldp.update_def(filename_update_pl);
+    }
+    if (legalize) {
+        ldp.legalize();
+    }
+    if (report_hpwl) {
+        ldp.report_hpwl();
+    }
+    if (check_legality) {
+        ldp.check_legality();
     }
 
-    // 6. 讀取 DEF，並印 summary
-    ldp.read_def(filename_def);
+    if (time_design) {
+        ldp.time_design(filename_drive_table);
+    }
+    if (!filename_weights.empty()) {
+        ldp.read_weights(filename_weights);
+    }
+
+    if (!filename_out_def.empty()) {
+        ldp.write_def(filename_out_def);
+    }
+    if (!filename_rewrite_def.empty()) {
+        ldp.rewrite_def(filename_rewrite_def);
+    }
 
     // 7. 輸出 bookshelf 格式
-    // ldp.write_bookshelf(filename_bookshelf);
+    if (write_bookshelf) {
+        ldp.write_bookshelf(filename_bookshelf);
+    }
 
     cout << endl << "Done." << endl;
     return 0;
@@ -77,7 +165,34 @@ void show_usage ()
 {
     cout << endl;
     cout << "Usage:" << endl;
-    cout << "  bookshelf_writer --lef <lef1[,lef2,...]> --def <def> [--bookshelf <prefix>]" << endl << endl;
+    cout << "  bookshelf_writer --lef <lef1[,lef2,...]> --def <def> [--bookshelf <prefix>]" << endl;
+    cout << "                   [--sdc <sdc>] [--tf <tf>] [--mmap] [--threads <n>] [--lef-cache <dir>]" << endl;
+    cout << "                   [--save-snapshot <file>] [--update-pl <pl>]" << endl;
+    cout << "                   [--write-def <file>] [--rewrite-def <file>] [--hpwl]" << endl;
+    cout << "                   [--legalize] [--check-legality] [--sta] [--drive-table <file>]" << endl;
+    cout << "                   [--weights <file>] [--cell-families <regex>]" << endl;
+    cout << "  bookshelf_writer --load-snapshot <file> [--bookshelf <prefix>]" << endl << endl;
+    cout << "  --sdc s      Read the constraints s on the IO pins of the DEF." << endl;
+    cout << "  --tf t       Read the layer and via tables of the technology file t." << endl;
+    cout << "  --mmap       Read LEF/DEF files through memory mappings." << endl;
+    cout << "  --threads n  Read COMPONENTS, PINS and NETS natively on n threads," << endl;
+    cout << "               and LEF files on n processes (0 for all hardware threads)." << endl;
+    cout << "  --lef-cache d      Cache parsed LEF files in the directory d." << endl;
+    cout << "  --cell-families r  Group the macros into swappable families by the regular" << endl;
+    cout << "                     expression r, whose groups match the varying parts" << endl;
+    cout << "                     of the names." << endl;
+    cout << "  --save-snapshot f  Save the LEF/DEF data read to a binary snapshot f." << endl;
+    cout << "  --load-snapshot f  Load a snapshot f instead of reading LEF/DEF files." << endl;
+    cout << "  --update-pl p      Move the components to the bookshelf placement p." << endl;
+    cout << "  --hpwl             Report the HPWL of the nets." << endl;
+    cout << "  --legalize         Move the movable components onto the rows, without overlaps." << endl;
+    cout << "  --check-legality   Check the placement against the rows, the die and the" << endl;
+    cout << "                     blockages and fences." << endl;
+    cout << "  --sta              Report the setup timing with the constraints of the SDC." << endl;
+    cout << "  --drive-table d    Take the cell drives of the timing from d." << endl;
+    cout << "  --weights w        Report the cost of the design with the weights w." << endl;
+    cout << "  --write-def f      Write the DEF data to f (formatted on the threads if given)." << endl;
+    cout << "  --rewrite-def f    Copy the DEF read to f with the moved placements replaced." << endl << endl;
 }
 
 void show_banner ()
@@ -94,7 +209,16 @@ void show_cmd_args ()
     auto& ap = ArgParser::get();
     cout << "  LEF file(s): " << ap.get_argument("--lef") << endl;
     cout << "  DEF file   : " << ap.get_argument("--def") << endl;
-    cout << "  Bookshelf  : " << (ap.get_argument("--bookshelf").empty() ? "out" : ap.get_argument("--bookshelf")) << endl;
+    cout << "  SDC file   : " << (ap.exists_argument("--sdc") ? ap.get_argument("--sdc") : "-") << endl;
+    cout << "  Tech file  : " << (ap.exists_argument("--tf") ? ap.get_argument("--tf") : "-") << endl;
+    cout << "  Bookshelf  : " << (!ap.exists_argument("--bookshelf") ? "-" : ap.get_argument("--bookshelf").empty() ? "out" : ap.get_argument("--bookshelf")) << endl;
+    cout << "  Input      : " << (ap.exists_argument("--mmap") ? "mmap" : "stdio") << endl;
+    cout << "  Threads    : " << (ap.exists_argument("--threads") ? ap.get_argument("--threads") : "-") << endl;
+    cout << "  LEF cache  : " << (ap.exists_argument("--lef-cache") ? ap.get_argument("--lef-cache") : "-") << endl;
+    cout << "  Output DEF : " << (ap.exists_argument("--write-def") ? ap.get_argument("--write-def")
+                                : ap.exists_argument("--rewrite-def") ? "rewrite " + ap.get_argument("--rewrite-def") : "-") << endl;
+    cout << "  Snapshot   : " << (ap.exists_argument("--load-snapshot") ? "load " + ap.get_argument("--load-snapshot")
+                                : ap.exists_argument("--save-snapshot") ? "save " + ap.get_argument("--save-snapshot") : "-") << endl;
 }
 
 #else
@@ -14,5 +14,6 @@ enum class PinUse   { na, analog, clock, ground, power, signal };
 enum class SiteSymmetry { na, x, y, r90 };
 enum class LayerDir { na, horizontal, vertical };
 enum class TrackDir { na, x, y };
+enum class RegionType { na, fence, guide };
 
 #endif
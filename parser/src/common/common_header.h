@@ -43,6 +43,7 @@
 #include <cstdlib>
 #include <cmath>
 #include <cstring>
+#include <cstdint>
 #include <climits>
 #include <cassert>
 #include <sys/time.h>
@@ -0,0 +1,109 @@
+/**
+ * @file    BlockageIndex.cpp
+ */
+
+#include "BlockageIndex.h"
+
+using namespace std;
+
+namespace def
+{
+
+BlockageIndex::BlockageIndex ()
+    : def_(nullptr), macros_(1, nullptr), max_overhang_(0)
+{
+    //
+}
+
+void BlockageIndex::clear ()
+{
+    *this = BlockageIndex();
+}
+
+/**
+ * Macros are numbered in the order their first components appear; the
+ * macros without obstructions share the slot 0, which has none.
+ */
+void BlockageIndex::build (const Def& def)
+{
+    clear();
+    def_ = &def;
+
+    auto& components = def.get_components();
+    macro_of_component_.assign(components.size(), 0);
+    for (auto& c : components) {
+        macro_of_component_[c->id_] = add_macro(c->lef_macro_.get());
+    }
+}
+
+void BlockageIndex::update_component (const Component& c)
+{
+    if (c.id_ < macro_of_component_.size()) {
+        macro_of_component_[c.id_] = add_macro(c.lef_macro_.get());
+    }
+}
+
+/**
+ * @return The slot of @a m, given one and its ranges if it has none yet.
+ */
+uint32_t BlockageIndex::add_macro (const lef::Macro* m)
+{
+    if (m == nullptr || m->obs_boxes_.empty()) {
+        return 0;
+    }
+
+    auto found = slot_of_macro_.find(m);
+    if (found != slot_of_macro_.end()) {
+        return found->second;
+    }
+
+    auto slot = static_cast<uint32_t>(macros_.size());
+    slot_of_macro_.emplace(m, slot);
+    macros_.push_back(m);
+
+    auto num_layers = layers_.size();
+    for (auto l : m->obs_layers_) {
+        if (layer_of_symbol_.emplace(l, layers_.size()).second) {
+            layers_.push_back(l);
+        }
+    }
+
+    // The sides of a box only trade places under the orientations.
+    for (auto& b : m->obs_boxes_) {
+        max_overhang_ = max({max_overhang_, -b.lx_, -b.ly_,
+                             b.ux_ - m->size_x_dbu_, b.uy_ - m->size_y_dbu_});
+    }
+
+    // New layers widen the ranges of every macro.
+    vector<pair<uint32_t, uint32_t>> ranges(macros_.size() * layers_.size(), 
+                                            make_pair(0u, 0u));
+    for (size_t i = 0; i < slot; i++) {
+        copy_n(ranges_.begin() + i * num_layers, num_layers, 
+               ranges.begin() + i * layers_.size());
+    }
+    ranges_.swap(ranges);
+
+    for (size_t l = 0; l < m->obs_layers_.size(); l++) {
+        auto layer = layer_of_symbol_[m->obs_layers_[l]];
+        ranges_[slot * layers_.size() + layer] =
+            make_pair(m->obs_begin_[l], m->obs_begin_[l + 1]);
+    }
+    return slot;
+}
+
+int BlockageIndex::find_layer (util::SymbolId layer) const
+{
+    auto found = layer_of_symbol_.find(layer);
+    return found == layer_of_symbol_.end() ? -1 : found->second;
+}
+
+void BlockageIndex::query_window (int layer, const util::Box& window,
+                                  vector<Blockage>& blockages) const
+{
+    blockages.clear();
+    for_each_in_window(layer, window, [&blockages] (uint32_t c, const util::Box& box) {
+        blockages.push_back(Blockage{c, box});
+    });
+}
+
+}   // End of namespace def
@@ -0,0 +1,161 @@
+/**
+ * @file    BlockageIndex.h
+ */
+
+#ifndef BLOCKAGE_INDEX_H
+#define BLOCKAGE_INDEX_H
+
+#include "common_header.h"
+#include "Geometry.h"
+#include "SymbolTable.h"
+#include "Def.h"
+#include "SpatialIndex.h"
+
+namespace def
+{
+
+/**
+ * The obstructions (LEF OBS) of the placed components of a Def, by layer.
+ *
+ * Nothing is stored per component: a query finds the components near its
+ * window with the spatial index of the Def, and places the obstruction
+ * tables of their macros (Macro::obs_boxes_) on the fly. The index thus
+ * follows moved components, and takes memory per macro and layer only.
+ * Queries do not modify the index and may run concurrently.
+ */
+class BlockageIndex
+{
+public:
+    /**
+     * An obstruction of a component, in DBU.
+     */
+    struct Blockage
+    {
+        uint32_t component_;    ///< Dense id of the component.
+        util::Box box_;
+    };
+
+    BlockageIndex ();
+
+    /**
+     * Index the macros of the components of @a def. The obstruction tables
+     * of the macros must be in the DBU of the Def.
+     */
+    void build (const Def& def);
+    void clear ();
+
+    /**
+     * Follow a macro swap of the component @a c, indexing its new macro if
+     * no other component uses it.
+     */
+    void update_component (const Component& c);
+
+    /**
+     * @return Index of the layer named by @a layer, -1 if no obstruction is
+     *         on it.
+     */
+    int find_layer (util::SymbolId layer) const;
+    size_t get_num_layers () const;
+    util::SymbolId get_layer_id (int layer) const;
+
+    /**
+     * Call @a func(component, box) for every obstruction on @a layer (by
+     * find_layer()) that touches @a window.
+     */
+    template <typename Func>
+    void for_each_in_window (int layer, const util::Box& window, Func func) const;
+    void query_window (int layer, const util::Box& window,
+                       vector<Blockage>& blockages) const;
+
+    /**
+     * Call @a func(box) for every obstruction of the component @a id on
+     * @a layer, at its current place.
+     */
+    template <typename Func>
+    void for_each_of_component (uint32_t id, int layer, Func func) const;
+
+private:
+    const Def* def_;
+
+    vector<util::SymbolId> layers_;
+    unordered_map<util::SymbolId, int> layer_of_symbol_;
+
+    // Per macro and layer, the range of the obstructions of the macro on the
+    // layer: [begin, end) in Macro::obs_boxes_ at [macro * num_layers + layer].
+    vector<pair<uint32_t, uint32_t>> ranges_;
+    vector<const lef::Macro*> macros_;      ///< Indexed by slot.
+    unordered_map<const lef::Macro*, uint32_t> slot_of_macro_;
+    vector<uint32_t> macro_of_component_;   ///< Indexed by Component::id_.
+
+    int max_overhang_;  ///< How far an obstruction reaches out of its cell.
+
+    uint32_t add_macro (const lef::Macro* m);
+
+    template <typename Func>
+    void place (uint32_t id, int layer, Func func) const;
+};
+
+
+inline size_t BlockageIndex::get_num_layers () const
+{
+    return layers_.size();
+}
+
+inline util::SymbolId BlockageIndex::get_layer_id (int layer) const
+{
+    return layers_[layer];
+}
+
+template <typename Func>
+void BlockageIndex::place (uint32_t id, int layer, Func func) const
+{
+    auto& c = *def_->get_components()[id];
+    auto m = c.lef_macro_.get();
+    auto& range = ranges_[static_cast<size_t>(macro_of_component_[id]) * layers_.size()
+                          + layer];
+
+    for (auto i = range.first; i < range.second; i++) {
+        func(util::transform_cell_box(m->obs_boxes_[i], m->size_x_dbu_,
+                                      m->size_y_dbu_, c.orient_).shifted(c.x_, c.y_));
+    }
+}
+
+template <typename Func>
+void BlockageIndex::for_each_of_component (uint32_t id, int layer, Func func) const
+{
+    if (def_ == nullptr || layer < 0 || layer >= static_cast<int>(layers_.size())
+        || id >= macro_of_component_.size()) {
+        return;
+    }
+    place(id, layer, func);
+}
+
+template <typename Func>
+void BlockageIndex::for_each_in_window (int layer, const util::Box& window,
+                                        Func func) const
+{
+    if (def_ == nullptr || layer < 0 || layer >= static_cast<int>(layers_.size())) {
+        return;
+    }
+
+    // Components are indexed by their cells; look as far as an
+    // obstruction may reach out of one.
+    util::Box search(window.lx_ - max_overhang_, window.ly_ - max_overhang_,
+                     window.ux_ + max_overhang_, window.uy_ + max_overhang_);
+
+    def_->get_spatial_index().for_each_in_window(search,
+        [&] (SpatialIndex::Item item) {
+            if (item.type_ != SpatialIndex::ItemType::component) {
+                return;
+            }
+            place(item.id_, layer, [&] (const util::Box& box) {
+                if (box.intersects(window)) {
+                    func(item.id_, box);
+                }
+            });
+        });
+}
+
+}   // End of namespace def
+
+#endif
@@ -7,12 +7,40 @@
  */
 
 #include "Def.h"
+#include "Arena.h"
+#include "MappedFile.h"
+#include "DefFastReader.h"
+#include "SpatialIndex.h"
+#include "BlockageIndex.h"
+#include "PlacementConstraints.h"
+#include "Watch.h"
 
 using namespace std;
 
 namespace def
 {
 
+/**
+ * Arenas keeping the design objects of a DEF file.
+ *
+ * The smart pointers handed out by Def alias this storage (they share its
+ * control block), so creating an object costs no separate heap allocation
+ * and objects of the same kind are laid out contiguously.
+ */
+struct DesignStorage : public std::enable_shared_from_this<DesignStorage>
+{
+    util::Arena<Component>    components_;
+    util::Arena<Pin>          pins_;
+    util::Arena<Net>          nets_;
+
+    template <typename T, typename... Args>
+    shared_ptr<T> create (util::Arena<T>& arena, Args&&... args)
+    {
+        return shared_ptr<T>(shared_from_this(), 
+                             arena.create(std::forward<Args>(args)...));
+    }
+};
+
 /**
  * Implementation of the class Def.
  */
@@ -32,10 +60,54 @@ struct Def::Impl
     vector<TrackPtr> tracks_;
     vector<GCellGridPtr> gcell_grids_;
 
-    unordered_map<string, PinPtr> pin_umap_;
-    unordered_map<string, ComponentPtr> component_umap_;
-    unordered_map<string, NetPtr> net_umap_;
-    unordered_map<string, SpecialNetPtr> special_net_umap_;
+    shared_ptr<DesignStorage> storage_;
+
+    vector<ComponentPtr> components_;   ///< Indexed by Component::id_.
+    vector<PinPtr> pins_;               ///< Indexed by Pin::id_.
+    vector<NetPtr> nets_;               ///< Indexed by Net::id_.
+
+    // Net -> connection adjacency in CSR form: the connections of the net n
+    // are net_pins_[net_pin_begin_[n], net_pin_begin_[n + 1]).
+    vector<Connection> net_pins_;
+    vector<uint32_t> net_pin_begin_;
+
+    // Dense ids of the objects, indexed by the symbol ids of their names.
+    vector<uint32_t> component_of_symbol_;
+    vector<uint32_t> pin_of_symbol_;
+    vector<uint32_t> net_of_symbol_;
+    vector<uint32_t> special_net_of_symbol_;
+
+    // Name -> object maps, built on first use from the vectors; the names
+    // themselves live in the symbol table only.
+    mutable PinUMap pin_umap_;
+    mutable ComponentUMap component_umap_;
+    mutable NetUMap net_umap_;
+    mutable SpecialNetUMap special_net_umap_;
+    vector<SpecialNetPtr> special_nets_;    ///< Indexed by SpecialNet::id_.
+    SpecialNetPtr current_special_net_;     ///< The net being read.
+    SpecialShapes special_shapes_;
+
+    vector<BlockagePtr> blockages_;
+    vector<RegionPtr> regions_;         ///< Indexed by Region::id_.
+    vector<GroupPtr> groups_;           ///< Indexed by Group::id_.
+
+    SpatialIndex spatial_index_;
+    BlockageIndex blockage_index_;
+    PlacementConstraints placement_constraints_;
+
+    // Component -> (net, pin) adjacency in CSR form.
+    vector<uint32_t> comp_net_begin_;   ///< Indexed by Component::id_.
+    vector<NetPin> comp_nets_;
+
+    vector<bool> moved_components_;     ///< Indexed by Component::id_.
+    size_t num_moved_components_;
+
+    vector<Section> sections_;     ///< Sections of the file read.
+    int64_t file_size_;             ///< Size of the file read.
+    int64_t file_mtime_ns_;         ///< Modification time of the file read.
+
+    Impl () : storage_(make_shared<DesignStorage>()), num_moved_components_(0),
+              file_size_(-1), file_mtime_ns_(-1) {}
 };
 
 
@@ -62,6 +134,11 @@ int Def::get_dbu () const
     return pimpl_->dbu_;
 }
 
+string Def::get_filename () const
+{
+    return pimpl_->filename_;
+}
+
 const vector<RowPtr>& Def::get_rows () const
 {
     return pimpl_->rows_;
@@ -77,71 +154,447 @@ const vector<GCellGridPtr>& Def::get_gcell_grids () const
     return pimpl_->gcell_grids_;
 }
 
+/**
+ * Fill @a umap with the objects of @a objects by name unless it is up to
+ * date.
+ */
+template <typename UMap, typename Vec>
+static const UMap& build_umap (UMap& umap, const Vec& objects)
+{
+    if (umap.size() != objects.size()) {
+        umap.clear();
+        umap.reserve(objects.size());
+        for (auto& o : objects) {
+            umap.emplace(o->get_name(), o);
+        }
+    }
+    return umap;
+}
+
 const ComponentUMap& Def::get_component_umap () const
 {
-    return pimpl_->component_umap_;
+    return build_umap(pimpl_->component_umap_, pimpl_->components_);
 }
 
 const NetUMap& Def::get_net_umap () const
 {
-    return pimpl_->net_umap_;
+    return build_umap(pimpl_->net_umap_, pimpl_->nets_);
 }
 
 const SpecialNetUMap& Def::get_special_net_umap () const
 {
-    return pimpl_->special_net_umap_;
+    return build_umap(pimpl_->special_net_umap_, pimpl_->special_nets_);
 }
 
 const PinUMap& Def::get_pin_umap () const
 {
-    return pimpl_->pin_umap_;
+    return build_umap(pimpl_->pin_umap_, pimpl_->pins_);
+}
+
+const ComponentVec& Def::get_components () const
+{
+    return pimpl_->components_;
+}
+
+const PinVec& Def::get_pins () const
+{
+    return pimpl_->pins_;
+}
+
+const NetVec& Def::get_nets () const
+{
+    return pimpl_->nets_;
+}
+
+
+const vector<SpecialNetPtr>& Def::get_special_nets () const
+{
+    return pimpl_->special_nets_;
+}
+
+const SpecialShapes& Def::get_special_shapes () const
+{
+    return pimpl_->special_shapes_;
+}
+
+const vector<BlockagePtr>& Def::get_blockages () const
+{
+    return pimpl_->blockages_;
+}
+
+const vector<RegionPtr>& Def::get_regions () const
+{
+    return pimpl_->regions_;
 }
 
+const vector<GroupPtr>& Def::get_groups () const
+{
+    return pimpl_->groups_;
+}
+
+int Def::find_region (const string& name) const
+{
+    for (auto& r : pimpl_->regions_) {
+        if (r->name_ == name) {
+            return r->id_;
+        }
+    }
+    return -1;
+}
 
 NetPtr Def::get_net (string name)
 {
-    auto& net_umap = pimpl_->net_umap_;
-    auto found = net_umap.find(name);
+    return get_net(util::SymbolTable::get_instance().find(name));
+}
 
-    if (found == net_umap.end()) {
-        return nullptr;
+ComponentPtr Def::get_component (string name)
+{
+    return get_component(util::SymbolTable::get_instance().find(name));
+}
+
+PinPtr Def::get_pin (string name)
+{
+    return get_pin(util::SymbolTable::get_instance().find(name));
+}
+
+
+/**
+ * Map the symbol @a sym to the object id @a id.
+ */
+static void bind_symbol (vector<uint32_t>& object_of_symbol, 
+                         util::SymbolId sym, uint32_t id)
+{
+    if (sym >= object_of_symbol.size()) {
+        object_of_symbol.resize(sym + 1, util::SymbolTable::invalid_symbol);
     }
-    else {
-        return found->second;
+    object_of_symbol[sym] = id;
+}
+
+/**
+ * @return The object id bound to @a sym, or invalid_symbol.
+ */
+static uint32_t find_symbol (const vector<uint32_t>& object_of_symbol,
+                             util::SymbolId sym)
+{
+    if (sym >= object_of_symbol.size()) {
+        return util::SymbolTable::invalid_symbol;
     }
+    return object_of_symbol[sym];
 }
 
-ComponentPtr Def::get_component (string name)
+NetPtr Def::get_net (util::SymbolId name) const
+{
+    auto id = find_symbol(pimpl_->net_of_symbol_, name);
+    return id == util::SymbolTable::invalid_symbol ? nullptr : pimpl_->nets_[id];
+}
+
+ComponentPtr Def::get_component (util::SymbolId name) const
+{
+    auto id = find_symbol(pimpl_->component_of_symbol_, name);
+    return id == util::SymbolTable::invalid_symbol 
+               ? nullptr : pimpl_->components_[id];
+}
+
+PinPtr Def::get_pin (util::SymbolId name) const
 {
-    auto& component_umap = pimpl_->component_umap_;
-    auto found = component_umap.find(name);
+    auto id = find_symbol(pimpl_->pin_of_symbol_, name);
+    return id == util::SymbolTable::invalid_symbol ? nullptr : pimpl_->pins_[id];
+}
+
 
-    if (found == component_umap.end()) {
-        return nullptr;
+void Def::move_component (uint32_t id, int x, int y, int orient)
+{
+    auto& c = pimpl_->components_[id];
+    c->x_ = x;
+    c->y_ = y;
+    if (orient >= 0 && orient < util::num_orients) {
+        c->orient_ = orient;
+        c->orient_str_ = util::get_orient_name(orient);
     }
-    else {
-        return found->second;
+    else if (c->orient_ < 0) {
+        // An unplaced component has no orientation yet.
+        c->orient_ = 0;
+        c->orient_str_ = "N";
     }
+    c->is_placed_ = true;
+
+    mark_moved(id);
+
+    pimpl_->spatial_index_.update_component(*c);
 }
 
-PinPtr Def::get_pin (string name)
+void Def::swap_macro (uint32_t id, lef::MacroPtr macro)
 {
-    auto& pin_umap = pimpl_->pin_umap_;
-    auto found = pin_umap.find(name);
+    auto& c = pimpl_->components_[id];
+    auto old = c->lef_macro_;
+    if (old == macro) {
+        return;
+    }
+    if (old == nullptr || macro == nullptr || old->family_ != macro->family_ 
+        || old->family_ == nullptr) {
+        throw invalid_argument("(E) " + (macro ? macro->name_ : string("null")) 
+                               + " is not a swap candidate of " 
+                               + c->get_name() + ".");
+    }
 
-    if (found == pin_umap.end()) {
-        return nullptr;
+    for (auto& np : get_component_nets(id)) {
+        auto& conn = pimpl_->net_pins_[pimpl_->net_pin_begin_[np.net_] + np.pin_];
+        conn.pin_index_ = macro->ranked_pins_[old->pin_ranks_[conn.pin_index_]];
+        conn.lef_pin_ = macro->pins_[conn.pin_index_].get();
     }
-    else {
-        return found->second;
+
+    c->lef_macro_ = macro;
+    c->ref_name_id_ = macro->name_id_;
+
+    mark_moved(id);
+
+    pimpl_->spatial_index_.update_component(*c);
+    pimpl_->blockage_index_.update_component(*c);
+}
+
+const SpatialIndex& Def::get_spatial_index () const
+{
+    return pimpl_->spatial_index_;
+}
+
+const BlockageIndex& Def::get_blockage_index () const
+{
+    return pimpl_->blockage_index_;
+}
+
+const PlacementConstraints& Def::get_placement_constraints () const
+{
+    return pimpl_->placement_constraints_;
+}
+
+util::Span<NetPin> Def::get_component_nets (uint32_t id) const
+{
+    auto& begin = pimpl_->comp_net_begin_;
+    if (id + 1 >= begin.size()) {
+        return util::Span<NetPin>();
+    }
+    auto data = pimpl_->comp_nets_.data();
+    return util::Span<NetPin>(data + begin[id], data + begin[id + 1]);
+}
+
+/**
+ * Point the nets to their rows of connections, now that no connection is
+ * added any more.
+ */
+void Def::build_net_pins ()
+{
+    auto& begin = pimpl_->net_pin_begin_;
+    auto& pins = pimpl_->net_pins_;
+    begin.push_back(pins.size());
+
+    for (auto& n : pimpl_->nets_) {
+        n->connections_ = util::Span<Connection>(pins.data() + begin[n->id_],
+                                                 pins.data() + begin[n->id_ + 1]);
+    }
+}
+
+/**
+ * Build the component -> (net, pin) adjacency: count the pins of each
+ * component, and fill the rows in net order.
+ */
+void Def::build_component_nets ()
+{
+    auto begin_time = std::chrono::system_clock::now();
+
+    auto& nets = pimpl_->nets_;
+    auto& begin = pimpl_->comp_net_begin_;
+    auto& entries = pimpl_->comp_nets_;
+
+    begin.assign(pimpl_->components_.size() + 1, 0);
+    for (auto& n : nets) {
+        for (auto& c : n->connections_) {
+            if (c.component_) {
+                begin[c.component_->id_ + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i < begin.size(); i++) {
+        begin[i] += begin[i - 1];
+    }
+
+    entries.resize(begin.back());
+    vector<uint32_t> next(begin.begin(), begin.end() - 1);
+    for (auto& n : nets) {
+        auto& connections = n->connections_;
+        for (uint32_t i = 0; i < connections.size(); i++) {
+            auto comp = connections[i].component_;
+            if (comp) {
+                entries[next[comp->id_]++] = NetPin{n->id_, i};
+            }
+        }
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin_time).count();
+    cout << "Component-net adjacency: " << entries.size() << " pins of "
+         << pimpl_->components_.size() << " components in " 
+         << elapsed << " sec" << endl;
+}
+
+void Def::mark_moved (uint32_t id)
+{
+    auto& moved = pimpl_->moved_components_;
+    if (moved.size() < pimpl_->components_.size()) {
+        moved.resize(pimpl_->components_.size(), false);
+    }
+    if (!moved[id]) {
+        moved[id] = true;
+        pimpl_->num_moved_components_++;
+    }
+}
+
+bool Def::is_component_moved (uint32_t id) const
+{
+    auto& moved = pimpl_->moved_components_;
+    return id < moved.size() && moved[id];
+}
+
+size_t Def::get_num_moved_components () const
+{
+    return pimpl_->num_moved_components_;
+}
+
+const vector<Section>& Def::get_sections () const
+{
+    return pimpl_->sections_;
+}
+
+const Section* Def::find_section (string name) const
+{
+    for (auto& s : pimpl_->sections_) {
+        if (s.name_ == name) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @return Size and modification time (ns) of @a filename, or -1s.
+ */
+static pair<int64_t, int64_t> get_file_stamp (string filename)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return make_pair(-1, -1);
+    }
+    return make_pair(static_cast<int64_t>(st.st_size),
+                     static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000
+                     + st.st_mtim.tv_nsec);
+}
+
+bool Def::is_file_unchanged () const
+{
+    if (pimpl_->file_size_ < 0) {
+        return false;
+    }
+    return get_file_stamp(pimpl_->filename_) 
+           == make_pair(pimpl_->file_size_, pimpl_->file_mtime_ns_);
+}
+
+
+static inline bool is_space (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @return True if the line at @a pos starts with the word @a keyword.
+ */
+static bool starts_with_word (const char* data, size_t pos, size_t eol, 
+                              const char* keyword)
+{
+    auto len = strlen(keyword);
+    return pos + len <= eol && memcmp(data + pos, keyword, len) == 0
+           && (pos + len == eol || is_space(data[pos + len]));
+}
+
+/**
+ * Find the top-level sections ending with "END KEYWORD" line by line.
+ */
+static vector<Section> locate_sections (const char* data, size_t size)
+{
+    static const char* keywords[] = { 
+        "PROPERTYDEFINITIONS", "VIAS", "STYLES", "NONDEFAULTRULES", "REGIONS", 
+        "COMPONENTS", "PINS", "PINPROPERTIES", "BLOCKAGES", "SLOTS", "FILLS", 
+        "SPECIALNETS", "NETS", "SCANCHAINS", "GROUPS" 
+    };
+
+    vector<Section> sections;
+    Section current;
+    bool in_section = false;
+
+    size_t pos = 0;
+    while (pos < size) {
+        auto found = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+        auto eol = found ? static_cast<size_t>(found - data) : size;
+
+        auto q = pos;
+        while (q < eol && (data[q] == ' ' || data[q] == '\t')) {
+            q++;
+        }
+
+        if (!in_section) {
+            for (auto keyword : keywords) {
+                if (!starts_with_word(data, q, eol, keyword)) {
+                    continue;
+                }
+                // PROPERTYDEFINITIONS has no count; other headers end with ';'.
+                auto header_end = eol;
+                if (strcmp(keyword, "PROPERTYDEFINITIONS") != 0) {
+                    auto semi = static_cast<const char*>(memchr(data + q, ';', size - q));
+                    if (semi == nullptr) {
+                        return sections;
+                    }
+                    header_end = semi - data + 1;
+                }
+                current.name_ = keyword;
+                current.begin_ = pos;
+                current.body_begin_ = header_end;
+                in_section = true;
+
+                // Skip the lines of the header.
+                while (eol < header_end && eol < size) {
+                    found = static_cast<const char*>(
+                                memchr(data + eol + 1, '\n', size - eol - 1));
+                    eol = found ? static_cast<size_t>(found - data) : size;
+                }
+                break;
+            }
+        }
+        else if (starts_with_word(data, q, eol, "END")) {
+            auto r = q + 3;
+            while (r < eol && (data[r] == ' ' || data[r] == '\t')) {
+                r++;
+            }
+            if (starts_with_word(data, r, eol, current.name_.c_str())) {
+                current.body_end_ = pos;
+                current.end_ = r + current.name_.size();
+                sections.push_back(current);
+                in_section = false;
+            }
+        }
+
+        pos = eol + 1;
     }
+
+    return sections;
 }
 
 
 /**
- * Read a DEF file @a filename.
+ * Read a DEF file @a filename. If @a use_mmap is set, the file is memory
+ * mapped and fed to the parser through its read hook instead of stdio.
+ * If @a num_threads is positive, the COMPONENTS, PINS and NETS sections are
+ * read by the native reader (DefFastReader) on that many threads, and the
+ * Si2 parser only sees the rest of the file.
  */
-void Def::read_def (string filename)
+void Def::read_def (string filename, bool use_mmap, int num_threads)
 {
     // The typical way to create a unique_ptr for a FILE* pointer
 	auto fp = unique_ptr<FILE, decltype(&fclose)>(
@@ -153,8 +606,63 @@ void Def::read_def (string filename)
 
     pimpl_->filename_ = filename;
 
+    unique_ptr<util::MappedFile> mapped_file;
+    if (use_mmap || num_threads > 0) {
+        mapped_file.reset(new util::MappedFile(filename));
+    }
+
+    // Record the sections, so that a rewrite can pass them through.
+    if (mapped_file) {
+        pimpl_->sections_ = locate_sections(mapped_file->get_data(), 
+                                            mapped_file->get_size());
+    }
+    else {
+        util::MappedFile file(filename);
+        pimpl_->sections_ = locate_sections(file.get_data(), file.get_size());
+    }
+    auto stamp = get_file_stamp(filename);
+    pimpl_->file_size_ = stamp.first;
+    pimpl_->file_mtime_ns_ = stamp.second;
+
+    unique_ptr<DefFastReader> fast_reader;
+    if (num_threads > 0) {
+        cout << "Reading COMPONENTS, PINS and NETS natively." << endl;
+        util::Watch watch;
+
+        fast_reader.reset(new DefFastReader(mapped_file->get_data(), 
+                                            mapped_file->get_size(), num_threads));
+        fast_reader->read();
+        mapped_file->set_ranges(fast_reader->get_remaining_ranges());
+
+        // The native times are per section, for checking the scaling with
+        // the number of threads.
+        auto report = [] (const char* section, bool native, double seconds) {
+            cout << "\t" << section << (native ? "native" : "Si2");
+            if (native) {
+                cout << " (" << fixed << setprecision(3) << seconds << " sec)";
+                cout.unsetf(std::ios_base::floatfield);
+            }
+            cout << endl;
+        };
+        report("COMPONENTS: ", fast_reader->has_components(), 
+               fast_reader->get_components_seconds());
+        report("PINS      : ", fast_reader->has_pins(), 
+               fast_reader->get_pins_seconds());
+        report("NETS      : ", fast_reader->has_nets(), 
+               fast_reader->get_nets_seconds());
+
+        // Nets are added after the Si2 pass, which sets the units.
+        add_fast_components(*fast_reader);
+        add_fast_pins(*fast_reader);
+    }
+
     defrInit();
 
+    if (mapped_file) {
+        util::MappedFile::set_active(mapped_file.get());
+        defrSetReadFunction(util::MappedFile::read_active);
+    }
+
     defrSetDesignCbk(DefParser::set_design_name);
     defrSetUnitsCbk(DefParser::set_units);
     defrSetDieAreaCbk(DefParser::set_die_area);
@@ -168,29 +676,560 @@ void Def::read_def (string filename)
 
     defrSetPinCbk(DefParser::set_pin);
 
-    // cout << "SPECIAL NETS..." << endl;
-    // defrSetSNetStartCbk(DefParser::set_special_net_start);
-    // defrSetSNetCbk(DefParser::set_special_net);
-    // cout << "SPECIAL NETS..." << endl;
+    // Wires of special nets are handed over one at a time, and freed.
+    defrSetSNetStartCbk(DefParser::set_special_net_start);
+    defrSetSNetWireCbk(DefParser::set_special_net_wire);
+    defrSetSNetCbk(DefParser::set_special_net);
 
 	defrSetNetStartCbk(DefParser::set_net_start);
 	defrSetNetCbk(DefParser::set_net);
 
+    // Keep the paths of routed nets for process_routed_net().
+    defrSetAddPathToNet();
+
+    defrSetBlockageCbk(DefParser::set_blockage);
+    defrSetRegionCbk(DefParser::set_region);
+    defrSetGroupNameCbk(DefParser::set_group_name);
+    defrSetGroupMemberCbk(DefParser::set_group_member);
+    defrSetGroupCbk(DefParser::set_group);
+
     // TODO
-    // group, region, net, via
+    // via
 
 
     // Read the DEF file.
     auto ret = defrRead(fp.get(), filename.c_str(), (void*) this, true);
 
+    if (mapped_file) {
+        defrUnsetReadFunction();
+        util::MappedFile::set_active(nullptr);
+    }
+
     if (ret != 0) {
         throw logic_error("(E) An error occured in DEF parser.");
     }
 
+    if (fast_reader) {
+        add_fast_nets(*fast_reader);
+    }
+
     defrReleaseNResetMemory();
     defrClear();
+
+    lef::Lef::get_instance().update_pin_boxes(pimpl_->dbu_);
+    build_net_pins();
+    build_component_nets();
+    pimpl_->spatial_index_.build(*this);
+    pimpl_->blockage_index_.build(*this);
+    pimpl_->placement_constraints_.build(*this);
+    pimpl_->current_special_net_ = nullptr;
+    pimpl_->special_shapes_.build(pimpl_->dbu_);
 }
 
+/**
+ * Create a component and register it under its dense id and names.
+ */
+ComponentPtr Def::add_component (string name, string ref_name)
+{
+    auto& storage = *pimpl_->storage_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    auto the_comp = storage.create(storage.components_);
+
+    the_comp->id_ = pimpl_->components_.size();
+    the_comp->name_id_ = symbols.intern(name);
+    the_comp->ref_name_id_ = symbols.intern(ref_name);
+
+    // Set the pointer to the lef macro
+    auto& lef = lef::Lef::get_instance();
+    the_comp->lef_macro_ = lef.get_macro(the_comp->ref_name_id_);
+
+    pimpl_->components_.emplace_back(the_comp);
+    bind_symbol(pimpl_->component_of_symbol_, the_comp->name_id_, the_comp->id_);
+
+    return the_comp;
+}
+
+/**
+ * Create a pin and register it under its dense id and names.
+ */
+PinPtr Def::add_pin (string name, string net_name)
+{
+    auto& storage = *pimpl_->storage_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    auto the_pin = storage.create(storage.pins_);
+
+    the_pin->id_ = pimpl_->pins_.size();
+    the_pin->name_id_ = symbols.intern(name);
+    the_pin->net_name_id_ = symbols.intern(net_name);
+
+    pimpl_->pins_.emplace_back(the_pin);
+    bind_symbol(pimpl_->pin_of_symbol_, the_pin->name_id_, the_pin->id_);
+
+    return the_pin;
+}
+
+/**
+ * Create a net without connections and register it. Its connections are
+ * the ones added until the next net.
+ */
+NetPtr Def::add_net (string name)
+{
+    auto& storage = *pimpl_->storage_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    auto the_net = storage.create(storage.nets_);
+
+    the_net->id_ = pimpl_->nets_.size();
+    the_net->name_id_ = symbols.intern(name);
+    pimpl_->net_pin_begin_.push_back(pimpl_->net_pins_.size());
+
+    pimpl_->nets_.emplace_back(the_net);
+    bind_symbol(pimpl_->net_of_symbol_, the_net->name_id_, the_net->id_);
+
+    return the_net;
+}
+
+/**
+ * Connect the pin @a pin_name of the instance @a inst_name to @a the_net.
+ * IO pins use the instance name "PIN".
+ */
+void Def::add_connection (NetPtr the_net, const char* inst_name, 
+                          const char* pin_name)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+    const auto pin_id = symbols.intern(pin_name);
+
+    auto comp = get_component(symbols.find(inst_name));
+    auto& connections = pimpl_->net_pins_;
+    assert(the_net->id_ + 1 == pimpl_->net_pin_begin_.size());
+
+    if (!comp) {
+        // 這是 IO pin（不屬於任何 component）
+        auto pin = get_pin(pin_id);
+        if (!pin) {
+            cerr << "[ERROR] DEF pin '" << pin_name
+                 << "' not found in DEF file\n";
+            return;  // 跳過這個連線
+        }
+        connections.emplace_back(pin.get());
+    } else {
+        // 先檢查 lef_macro 是否存在
+        auto lef_macro = comp->lef_macro_;
+        if (!lef_macro) {
+            cerr << "[ERROR] LEF macro '" << comp->get_ref_name()
+                 << "' not found for component '" << inst_name << "'\n";
+            return;
+        }
+        // 再從 macro 的 pins_ 取 pin
+        auto& lef_pins = lef_macro->pins_;
+        uint32_t pin_index = 0;
+        while (pin_index < lef_pins.size() 
+               && lef_pins[pin_index]->name_id_ != pin_id) {
+            pin_index++;
+        }
+        if (pin_index == lef_pins.size()) {
+            cerr << "[ERROR] pin '" << pin_name
+                 << "' not found in LEF macro '" << comp->get_ref_name() << "'\n";
+            return;
+        }
+
+        // The pin box is looked up in the table of the macro when needed.
+        connections.emplace_back(comp.get(), lef_pins[pin_index].get(), pin_index);
+    }
+}
+
+/**
+ * Add the components read by the native reader.
+ */
+void Def::add_fast_components (const DefFastReader& reader)
+{
+    auto& components = reader.get_components();
+    pimpl_->components_.reserve(components.size());
+
+    for (auto& c : components) {
+        auto the_comp = add_component(c.name_.to_string(), c.ref_name_.to_string());
+        the_comp->is_fixed_ = c.is_fixed_;
+        the_comp->is_placed_ = c.is_placed_;
+        the_comp->x_ = c.x_;
+        the_comp->y_ = c.y_;
+        the_comp->orient_str_ = c.orient_str_.to_string();
+        the_comp->orient_ = c.orient_;
+    }
+}
+
+/**
+ * Add the pins read by the native reader.
+ */
+void Def::add_fast_pins (const DefFastReader& reader)
+{
+    for (auto& p : reader.get_pins()) {
+        auto the_pin = add_pin(p.name_.to_string(), p.net_name_.to_string());
+
+        auto dir_str = p.direction_.to_string();
+        if (dir_str == "INPUT" || dir_str == "input") {
+            the_pin->dir_ = PinDir::input;
+        }
+        else if (dir_str == "OUTPUT" || dir_str == "output") {
+            the_pin->dir_ = PinDir::output;
+        }
+
+        the_pin->x_ = p.x_;
+        the_pin->y_ = p.y_;
+        the_pin->orient_str_ = p.orient_str_.to_string();
+        the_pin->orient_ = p.orient_;
+
+        if (p.has_layer_) {
+            the_pin->layer_ = p.layer_.to_string();
+            the_pin->lx_ = p.lx_;
+            the_pin->ly_ = p.ly_;
+            the_pin->ux_ = p.ux_;
+            the_pin->uy_ = p.uy_;
+        }
+    }
+}
+
+/**
+ * Add the nets read by the native reader.
+ */
+void Def::add_fast_nets (const DefFastReader& reader)
+{
+    auto& nets = reader.get_nets();
+    auto& connections = reader.get_connections();
+    pimpl_->nets_.reserve(nets.size());
+    pimpl_->net_pins_.reserve(pimpl_->net_pins_.size() + connections.size());
+
+    for (auto& n : nets) {
+        auto the_net = add_net(n.name_.to_string());
+
+        for (uint32_t i = 0; i < n.num_connections_; i++) {
+            auto& c = connections[n.first_connection_ + i];
+            add_connection(the_net, c.first.to_string().c_str(), 
+                           c.second.to_string().c_str());
+        }
+    }
+}
+
+
+/**
+ * Write the design to @a w. Objects are written in the order of their
+ * dense ids, and references between them are written as ids.
+ */
+void Def::write_snapshot (util::BinaryWriter& w) const
+{
+    auto& impl = *pimpl_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    w.write_string(impl.design_name_);
+    w.write(impl.dbu_);
+    w.write(impl.die_lx_);
+    w.write(impl.die_ly_);
+    w.write(impl.die_ux_);
+    w.write(impl.die_uy_);
+    w.write_string(impl.filename_);
+
+    w.write<uint32_t>(impl.rows_.size());
+    for (auto& r : impl.rows_) {
+        w.write_string(r->name_);
+        w.write_string(r->macro_);
+        w.write_string(r->orient_str_);
+        w.write(r->orient_);
+        w.write(r->x_);
+        w.write(r->y_);
+        w.write(r->num_x_);
+        w.write(r->num_y_);
+        w.write(r->step_x_);
+        w.write(r->step_y_);
+    }
+
+    w.write<uint32_t>(impl.tracks_.size());
+    for (auto& t : impl.tracks_) {
+        w.write(t->direction_);
+        w.write(t->location_);
+        w.write(t->num_tracks_);
+        w.write(t->step_);
+        w.write(t->len_);
+        w.write(t->num_layers_);
+        w.write_string(t->layer_);
+        w.write<uint32_t>(t->layers_.size());
+        for (auto& l : t->layers_) {
+            w.write_string(l);
+        }
+    }
+
+    w.write<uint32_t>(impl.gcell_grids_.size());
+    for (auto& g : impl.gcell_grids_) {
+        w.write(g->direction_);
+        w.write(g->location_);
+        w.write(g->num_);
+        w.write(g->step_);
+    }
+
+    w.write<uint32_t>(impl.components_.size());
+    for (auto& c : impl.components_) {
+        w.write_string(c->get_name());
+        w.write_string(c->get_ref_name());
+        w.write(c->is_fixed_);
+        w.write(c->is_placed_);
+        w.write(c->x_);
+        w.write(c->y_);
+        w.write_string(c->orient_str_);
+        w.write(c->orient_);
+    }
+
+    w.write<uint32_t>(impl.pins_.size());
+    for (auto& p : impl.pins_) {
+        w.write_string(p->get_name());
+        w.write_string(p->get_net_name());
+        w.write_string(p->layer_);
+        w.write(p->dir_);
+        w.write(p->x_);
+        w.write(p->y_);
+        w.write_string(p->orient_str_);
+        w.write(p->orient_);
+        w.write(p->lx_);
+        w.write(p->ly_);
+        w.write(p->ux_);
+        w.write(p->uy_);
+    }
+
+    w.write<uint32_t>(impl.nets_.size());
+    for (auto& n : impl.nets_) {
+        w.write_string(n->get_name());
+
+        w.write<uint32_t>(n->connections_.size());
+        for (auto& c : n->connections_) {
+            w.write<int32_t>(c.component_ ? c.component_->id_ : -1);
+            w.write<int32_t>(c.pin_ ? c.pin_->id_ : -1);
+            w.write(c.pin_index_);
+        }
+
+        n->wires_.write(w);
+    }
+
+    w.write<uint32_t>(impl.special_nets_.size());
+    for (auto& n : impl.special_nets_) {
+        w.write_string(n->get_name());
+        w.write_string(n->use_);
+        w.write<uint32_t>(n->pins_.size());
+        for (auto& p : n->pins_) {
+            w.write_string(symbols.get_name(p.first));
+            w.write_string(symbols.get_name(p.second));
+        }
+    }
+    impl.special_shapes_.write(w);
+
+    auto write_boxes = [&w] (const vector<util::Box>& boxes) {
+        w.write<uint32_t>(boxes.size());
+        for (auto& b : boxes) {
+            w.write(b);
+        }
+    };
+
+    w.write<uint32_t>(impl.blockages_.size());
+    for (auto& b : impl.blockages_) {
+        w.write_string(b->layer_);
+        w.write_string(b->component_);
+        w.write(b->is_soft_);
+        w.write(b->is_pushdown_);
+        w.write(b->max_density_);
+        write_boxes(b->boxes_);
+    }
+
+    w.write<uint32_t>(impl.regions_.size());
+    for (auto& r : impl.regions_) {
+        w.write_string(r->name_);
+        w.write(r->type_);
+        write_boxes(r->boxes_);
+    }
+
+    w.write<uint32_t>(impl.groups_.size());
+    for (auto& g : impl.groups_) {
+        w.write_string(g->name_);
+        w.write(g->region_);
+        w.write<uint32_t>(g->patterns_.size());
+        for (auto& p : g->patterns_) {
+            w.write_string(p);
+        }
+    }
+}
+
+/**
+ * Replace the design with the one written by write_snapshot().
+ * The LEF library must be loaded first.
+ */
+void Def::read_snapshot (util::BinaryReader& r)
+{
+    pimpl_.reset(new Impl());
+    auto& impl = *pimpl_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    impl.design_name_ = r.read_string();
+    impl.dbu_ = r.read<int>();
+    impl.die_lx_ = r.read<int>();
+    impl.die_ly_ = r.read<int>();
+    impl.die_ux_ = r.read<int>();
+    impl.die_uy_ = r.read<int>();
+    impl.filename_ = r.read_string();
+
+    auto num_rows = r.read<uint32_t>();
+    impl.rows_.reserve(num_rows);
+    for (uint32_t i = 0; i < num_rows; i++) {
+        auto row = make_shared<Row>();
+        row->name_ = r.read_string();
+        row->macro_ = r.read_string();
+        row->orient_str_ = r.read_string();
+        row->orient_ = r.read<int>();
+        row->x_ = r.read<int>();
+        row->y_ = r.read<int>();
+        row->num_x_ = r.read<int>();
+        row->num_y_ = r.read<int>();
+        row->step_x_ = r.read<int>();
+        row->step_y_ = r.read<int>();
+        impl.rows_.push_back(row);
+    }
+
+    auto num_tracks = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_tracks; i++) {
+        auto track = make_shared<Track>();
+        track->direction_ = r.read<TrackDir>();
+        track->location_ = r.read<int>();
+        track->num_tracks_ = r.read<int>();
+        track->step_ = r.read<int>();
+        track->len_ = r.read<int>();
+        track->num_layers_ = r.read<int>();
+        track->layer_ = r.read_string();
+        auto num_layers = r.read<uint32_t>();
+        for (uint32_t j = 0; j < num_layers; j++) {
+            track->layers_.push_back(r.read_string());
+        }
+        impl.tracks_.push_back(track);
+    }
+
+    auto num_grids = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_grids; i++) {
+        auto grid = make_shared<GCellGrid>();
+        grid->direction_ = r.read<TrackDir>();
+        grid->location_ = r.read<int>();
+        grid->num_ = r.read<int>();
+        grid->step_ = r.read<int>();
+        impl.gcell_grids_.push_back(grid);
+    }
+
+    auto num_components = r.read<uint32_t>();
+    impl.components_.reserve(num_components);
+    for (uint32_t i = 0; i < num_components; i++) {
+        auto name = r.read_string();
+        auto the_comp = add_component(std::move(name), r.read_string());
+        the_comp->is_fixed_ = r.read<bool>();
+        the_comp->is_placed_ = r.read<bool>();
+        the_comp->x_ = r.read<int>();
+        the_comp->y_ = r.read<int>();
+        the_comp->orient_str_ = r.read_string();
+        the_comp->orient_ = r.read<int>();
+    }
+
+    auto num_pins = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_pins; i++) {
+        auto name = r.read_string();
+        auto the_pin = add_pin(std::move(name), r.read_string());
+        the_pin->layer_ = r.read_string();
+        the_pin->dir_ = r.read<PinDir>();
+        the_pin->x_ = r.read<int>();
+        the_pin->y_ = r.read<int>();
+        the_pin->orient_str_ = r.read_string();
+        the_pin->orient_ = r.read<int>();
+        the_pin->lx_ = r.read<int>();
+        the_pin->ly_ = r.read<int>();
+        the_pin->ux_ = r.read<int>();
+        the_pin->uy_ = r.read<int>();
+    }
+
+    auto num_nets = r.read<uint32_t>();
+    impl.nets_.reserve(num_nets);
+    for (uint32_t i = 0; i < num_nets; i++) {
+        auto name = r.read_string();
+        auto num_connections = r.read<uint32_t>();
+        auto the_net = add_net(std::move(name));
+
+        for (uint32_t j = 0; j < num_connections; j++) {
+            auto comp_id = r.read<int32_t>();
+            auto pin_id = r.read<int32_t>();
+            auto pin_index = r.read<uint32_t>();
+
+            if (comp_id >= 0) {
+                auto comp = impl.components_.at(comp_id);
+                impl.net_pins_.emplace_back(comp.get(), 
+                                            comp->lef_macro_->pins_.at(pin_index).get(),
+                                            pin_index);
+            }
+            else {
+                impl.net_pins_.emplace_back(impl.pins_.at(pin_id).get());
+            }
+        }
+
+        the_net->wires_.read(r);
+    }
+
+    auto num_special_nets = r.read<uint32_t>();
+    impl.special_nets_.reserve(num_special_nets);
+    for (uint32_t i = 0; i < num_special_nets; i++) {
+        auto the_net = get_current_special_net(r.read_string().c_str());
+        the_net->use_ = r.read_string();
+        the_net->pins_.resize(r.read<uint32_t>());
+        for (auto& p : the_net->pins_) {
+            p.first = symbols.intern(r.read_string());
+            p.second = symbols.intern(r.read_string());
+        }
+    }
+    impl.current_special_net_ = nullptr;
+
+    lef::Lef::get_instance().update_pin_boxes(impl.dbu_);
+    build_net_pins();
+    build_component_nets();
+    impl.spatial_index_.build(*this);
+    impl.blockage_index_.build(*this);
+    impl.special_shapes_.read(r, impl.dbu_);
+
+    auto read_boxes = [&r] (vector<util::Box>& boxes) {
+        boxes.resize(r.read<uint32_t>());
+        for (auto& b : boxes) {
+            b = r.read<util::Box>();
+        }
+    };
+
+    auto num_blockages = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_blockages; i++) {
+        auto blockage = make_shared<Blockage>();
+        blockage->layer_ = r.read_string();
+        blockage->component_ = r.read_string();
+        blockage->is_soft_ = r.read<bool>();
+        blockage->is_pushdown_ = r.read<bool>();
+        blockage->max_density_ = r.read<double>();
+        read_boxes(blockage->boxes_);
+        impl.blockages_.push_back(blockage);
+    }
+
+    auto num_regions = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_regions; i++) {
+        auto region = add_region(r.read_string());
+        region->type_ = r.read<RegionType>();
+        read_boxes(region->boxes_);
+    }
+
+    auto num_groups = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_groups; i++) {
+        auto group = add_group(r.read_string());
+        group->region_ = r.read<int>();
+        group->patterns_.resize(r.read<uint32_t>());
+        for (auto& p : group->patterns_) {
+            p = r.read_string();
+        }
+    }
+
+    impl.placement_constraints_.build(*this);
+}
 
 void Def::report () const
 {
@@ -198,9 +1237,41 @@ void Def::report () const
     cout << "File name: " << pimpl_->filename_ << endl;
     cout << "\t#Rows      : " << pimpl_->rows_.size() << endl;
     cout << "\t#Tracks    : " << pimpl_->tracks_.size() << endl;
-    cout << "\t#Components: " << pimpl_->component_umap_.size() << endl;
-    cout << "\t#Pins      : " << pimpl_->pin_umap_.size() << endl;
-    cout << "\t#Nets      : " << pimpl_->net_umap_.size() << endl;
+    cout << "\t#Components: " << pimpl_->components_.size() << endl;
+    cout << "\t#Pins      : " << pimpl_->pins_.size() << endl;
+    cout << "\t#Nets      : " << pimpl_->nets_.size() << endl;
+
+    size_t num_routed = 0, num_points = 0, memory = 0, unpacked_memory = 0;
+    for (auto& n : pimpl_->nets_) {
+        if (!n->wires_.empty()) {
+            num_routed++;
+            num_points += n->wires_.get_num_points();
+            memory += n->wires_.get_memory();
+            unpacked_memory += n->wires_.get_unpacked_memory();
+        }
+    }
+    if (num_routed > 0) {
+        cout << "\t#Routed    : " << num_routed << " nets, " 
+             << num_points << " points" << endl;
+        cout << "\tRouting    : " << memory << " bytes (" 
+             << unpacked_memory << " bytes unpacked)" << endl;
+    }
+
+    auto& shapes = pimpl_->special_shapes_;
+    cout << "\t#Spc. nets : " << pimpl_->special_nets_.size() << endl;
+    if (shapes.get_num_shapes() > 0) {
+        cout << "\t#Spc. shape: " << shapes.get_num_shapes() << " on " 
+             << shapes.get_num_layers() << " layers, " 
+             << shapes.get_memory() << " bytes" << endl;
+    }
+
+    if (!pimpl_->blockages_.empty()) {
+        cout << "\t#Blockages : " << pimpl_->blockages_.size() << endl;
+    }
+    if (!pimpl_->regions_.empty() || !pimpl_->groups_.empty()) {
+        cout << "\t#Regions   : " << pimpl_->regions_.size() << endl;
+        cout << "\t#Groups    : " << pimpl_->groups_.size() << endl;
+    }
     cout << endl;
 }
 
@@ -218,18 +1289,18 @@ void Def::report_verbose () const
     }
 
     cout << "Components: " << endl;
-    for (auto& it : pimpl_->component_umap_) {
-        cout << "\t" << *(it.second) << endl;
+    for (auto& it : pimpl_->components_) {
+        cout << "\t" << *it << endl;
     }
 
     cout << "Pins:" << endl;
-    for (auto& it : pimpl_->pin_umap_) {
-        cout << "\t" << *(it.second) << endl;
+    for (auto& it : pimpl_->pins_) {
+        cout << "\t" << *it << endl;
     }
 
     cout << "Nets: " << endl;
-    for (auto& it : pimpl_->net_umap_) {
-        cout << "\t" << *(it.second) << endl;
+    for (auto& it : pimpl_->nets_) {
+        cout << "\t" << *it << endl;
     }
 }
 
@@ -260,6 +1331,17 @@ int DefParser::set_die_area (defrCallbackType_e, defiBox* box, defiUserData ud)
     def->pimpl_->die_ux_ = box->xh();
     def->pimpl_->die_uy_ = box->yh();
 
+    // A die given as a polygon keeps its bounding box; xl() and the like
+    // are taken from the first two points only.
+    auto points = box->getPoint();
+    for (int i = 0; i < points.numPoints; i++) {
+        auto& impl = *def->pimpl_;
+        impl.die_lx_ = min(impl.die_lx_, points.x[i]);
+        impl.die_ly_ = min(impl.die_ly_, points.y[i]);
+        impl.die_ux_ = max(impl.die_ux_, points.x[i]);
+        impl.die_uy_ = max(impl.die_uy_, points.y[i]);
+    }
+
     return 0;
 }
 
@@ -362,8 +1444,7 @@ int DefParser::set_component_start (defrCallbackType_e, int num_components,
                                     defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto& components = def->pimpl_->component_umap_;
-    components.reserve(num_components);
+    def->pimpl_->components_.reserve(num_components);
 
     return 0;
 }
@@ -372,12 +1453,8 @@ int DefParser::set_component (defrCallbackType_e, defiComponent* comp,
                               defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto& components = def->pimpl_->component_umap_;
+    auto the_comp = def->add_component(comp->id(), comp->name());
 
-    auto the_comp = make_shared<Component>();
-
-    the_comp->name_ = comp->id();
-    the_comp->ref_name_ = comp->name();
     the_comp->is_fixed_ = comp->isFixed();
     the_comp->is_placed_ = comp->isPlaced();
     the_comp->x_ = comp->placementX();
@@ -385,24 +1462,13 @@ int DefParser::set_component (defrCallbackType_e, defiComponent* comp,
     the_comp->orient_str_ = comp->placementOrientStr();
     the_comp->orient_ = comp->placementOrient();
 
-    // Set the pointer to the lef macro
-    auto& lef = lef::Lef::get_instance();
-    the_comp->lef_macro_ = lef.get_macro(the_comp->ref_name_);
-    
-    components[the_comp->name_] = the_comp;
-
     return 0;
 }
 
 int DefParser::set_pin (defrCallbackType_e, defiPin* pin, defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto& pins = def->pimpl_->pin_umap_;
-
-    auto the_pin = make_shared<Pin>();
-
-    the_pin->name_ = pin->pinName();
-    the_pin->net_name_ = pin->netName();
+    auto the_pin = def->add_pin(pin->pinName(), pin->netName());
 
     auto dir_str = string(pin->direction());
     if (dir_str == "INPUT" || dir_str == "input") {
@@ -430,8 +1496,6 @@ int DefParser::set_pin (defrCallbackType_e, defiPin* pin, defiUserData ud)
         the_pin->uy_ = yh;
     }
 
-    pins[the_pin->name_] = the_pin;
-
     return 0;
 }
 
@@ -439,29 +1503,22 @@ int DefParser::set_net_start (defrCallbackType_e, int num_nets,
                               defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto& net_umap = def->pimpl_->net_umap_;
-    net_umap.reserve(num_nets);
+    def->pimpl_->nets_.reserve(num_nets);
 
     return 0;
 }
 
 static void process_routed_net (NetPtr the_net, defiNet* net)
 {
-    cout << "Processing routed net..." << endl;
-    the_net->wires_.reserve(net->numWires());
+    auto& symbols = util::SymbolTable::get_instance();
+    auto& wires = the_net->wires_;
 
     for (int i = 0; i < net->numWires(); i++) {
-        the_net->wires_.emplace_back(make_shared<Wire>());
-        auto& the_wire = the_net->wires_.back();
         auto wire = net->wire(i);
-
-        the_wire->wire_type_ = wire->wireType();
-        the_wire->wire_segments_.reserve(wire->numPaths());
-        auto& wire_segments = the_wire->wire_segments_;
+        auto wire_type = symbols.intern(wire->wireType());
 
         for (int j = 0; j < wire->numPaths(); j++) {
-            wire_segments.emplace_back(make_shared<WireSegment>());
-            auto& wire_segment = wire_segments.back();
+            wires.add_path(wire_type, j == 0);
 
             auto path = wire->path(j);
             path->initTraverse();
@@ -471,29 +1528,25 @@ static void process_routed_net (NetPtr the_net, defiNet* net)
                 int x, y, ext;
                 switch (path_id) {
                     case DEFIPATH_LAYER:
-                        wire_segment->layer_name_ = path->getLayer();
+                        wires.set_layer(symbols.intern(path->getLayer()));
                         break;
                     case DEFIPATH_WIDTH:
-                        wire_segment->width_ = path->getWidth();
+                        wires.set_width(path->getWidth());
                         break;
                     case DEFIPATH_POINT:
                         path->getPoint(&x, &y);
-                        wire_segment->rpoints_.emplace_back(
-                            make_shared<RoutingPoint>(x, y, 0)
-                        );
+                        wires.add_point(x, y);
                         break;
                     case DEFIPATH_FLUSHPOINT:
                         path->getFlushPoint(&x, &y, &ext);
-                        wire_segment->rpoints_.emplace_back(
-                            make_shared<RoutingPoint>(x, y, 0)
-                        );
+                        wires.add_point(x, y);
                         break;
                     case DEFIPATH_VIA:
-                        if (wire_segment->rpoints_.empty()) {
+                        if (wires.get_paths().back().num_points_ == 0) {
                             cerr << "WARNING: VIA without preceding POINT for net '"
-                                 << the_net->name_ << "'" << endl;
+                                 << the_net->get_name() << "'" << endl;
                         } else {
-                            wire_segment->rpoints_.back()->has_via_ = true;
+                            wires.set_via(symbols.intern(path->getVia()));
                         }
                         break;
                 }
@@ -503,63 +1556,13 @@ static void process_routed_net (NetPtr the_net, defiNet* net)
     }
 }
 
-static NetPtr create_net(Def* def, int dbu, defiNet* net) {
-    auto the_net = make_shared<Net>();
-    the_net->name_ = net->name();
-    the_net->connections_.reserve(net->numConnections());
+int DefParser::set_net (defrCallbackType_e, defiNet* net, defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    auto the_net = def->add_net(net->name());
 
     for (int i = 0; i < net->numConnections(); ++i) {
-        const string inst_name = net->instance(i);
-        const string pin_name  = net->pin(i);
-
-        auto comp = def->get_component(inst_name);
-        int lx = 0, ly = 0, ux = 0, uy = 0;
-        lef::PinPtr lef_pin = nullptr;
-        ConnectionPtr c = nullptr;
-
-        if (!comp) {
-            // 這是 IO pin（不屬於任何 component）
-            auto pin = def->get_pin(pin_name);
-            if (!pin) {
-                cerr << "[ERROR] DEF pin '" << pin_name
-                     << "' not found in DEF file\n";
-                continue;  // 跳過這個連線
-            }
-            lx = pin->lx_;
-            ly = pin->ly_;
-            ux = pin->ux_;
-            uy = pin->uy_;
-            c = make_shared<Connection>(pin_name, pin, lx, ly, ux, uy);
-        } else {
-            // 先檢查 lef_macro 是否存在
-            auto lef_macro = comp->lef_macro_;
-            if (!lef_macro) {
-                cerr << "[ERROR] LEF macro '" << comp->ref_name_
-                     << "' not found for component '" << inst_name << "'\n";
-                continue;
-            }
-            // 再從 macro 的 pin_umap_ 取 pin
-            auto it = lef_macro->pin_umap_.find(pin_name);
-            if (it == lef_macro->pin_umap_.end() || !it->second) {
-                cerr << "[ERROR] pin '" << pin_name
-                     << "' not found in LEF macro '" << comp->ref_name_ << "'\n";
-                continue;
-            }
-            lef_pin = it->second;
-
-            // 安全使用 bbox 計算實體座標
-            lx = comp->x_ + static_cast<int>(lef_pin->bbox_.lx_ * dbu);
-            ly = comp->y_ + static_cast<int>(lef_pin->bbox_.ly_ * dbu);
-            ux = comp->x_ + static_cast<int>(lef_pin->bbox_.ux_ * dbu);
-            uy = comp->y_ + static_cast<int>(lef_pin->bbox_.uy_ * dbu);
-
-            c = make_shared<Connection>(pin_name, comp, lef_pin, lx, ly, ux, uy);
-        }
-
-        // 只有在成功產生 ConnectionPtr 時才加入
-        if (c) {
-            the_net->connections_.emplace_back(std::move(c));
-        }
+        def->add_connection(the_net, net->instance(i), net->pin(i));
     }
 
     // 處理 routing information
@@ -567,71 +1570,310 @@ static NetPtr create_net(Def* def, int dbu, defiNet* net) {
         process_routed_net(the_net, net);
     }
 
-    return the_net;
+    return 0;
 }
 
-
-int DefParser::set_net (defrCallbackType_e, defiNet* net, defiUserData ud)
+int DefParser::set_special_net_start (defrCallbackType_e, int num_nets, 
+                                      defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto dbu = def->pimpl_->dbu_;
+    def->pimpl_->special_nets_.reserve(num_nets);
 
-    auto the_net = create_net(def, dbu, net);
+    return 0;
+}
 
-    auto& net_umap = def->pimpl_->net_umap_;
-    net_umap[the_net->name_] = the_net;
+/**
+ * @return The special net @a name, created on first sight. A net is seen
+ *         once per wire and once at its end.
+ */
+SpecialNetPtr Def::get_current_special_net (const char* name)
+{
+    auto& current = pimpl_->current_special_net_;
+    auto name_id = util::SymbolTable::get_instance().intern(name);
+    if (current != nullptr && current->name_id_ == name_id) {
+        return current;
+    }
 
-    return 0;
+    auto id = find_symbol(pimpl_->special_net_of_symbol_, name_id);
+    if (id != util::SymbolTable::invalid_symbol) {
+        current = pimpl_->special_nets_[id];
+        return current;
+    }
+
+    current = make_shared<SpecialNet>();
+    current->id_ = pimpl_->special_nets_.size();
+    current->name_id_ = name_id;
+
+    pimpl_->special_nets_.push_back(current);
+    bind_symbol(pimpl_->special_net_of_symbol_, name_id, current->id_);
+    return current;
 }
 
-int DefParser::set_special_net_start (defrCallbackType_e, int num_nets, 
-                                      defiUserData ud)
+/**
+ * Add the shapes of the wires of @a net: a wire between every two
+ * consecutive points of a path, and a via (or an array of vias) where one
+ * is placed. Polygons and "+ VIA" shapes are not kept.
+ */
+static void process_special_wires (SpecialShapes& shapes, uint32_t net_id, 
+                                   defiNet* net)
+{
+    for (int i = 0; i < net->numWires(); i++) {
+        auto wire = net->wire(i);
+        auto status = SpecialShapes::find_status(wire->wireType());
+
+        for (int j = 0; j < wire->numPaths(); j++) {
+            auto path = wire->path(j);
+            path->initTraverse();
+
+            const char* layer = "";
+            const char* via = nullptr;
+            int width = 0, shape_type = 0;
+            int x = 0, y = 0, num_points = 0;
+
+            int path_id = path->next();
+            while (path_id != DEFIPATH_DONE) {
+                int px, py, ext;
+                switch (path_id) {
+                    case DEFIPATH_LAYER:
+                        layer = path->getLayer();
+                        break;
+                    case DEFIPATH_WIDTH:
+                        width = path->getWidth();
+                        break;
+                    case DEFIPATH_SHAPE:
+                        shape_type = SpecialShapes::find_shape_type(path->getShape());
+                        break;
+                    case DEFIPATH_POINT:
+                    case DEFIPATH_FLUSHPOINT:
+                        if (path_id == DEFIPATH_POINT) {
+                            path->getPoint(&px, &py);
+                        }
+                        else {
+                            path->getFlushPoint(&px, &py, &ext);
+                        }
+                        if (num_points++ > 0) {
+                            shapes.add_wire(net_id, layer, width, x, y, px, py, 
+                                            status, shape_type);
+                        }
+                        x = px;
+                        y = py;
+                        break;
+                    case DEFIPATH_VIA:
+                        via = path->getVia();
+                        shapes.add_via(net_id, via, layer, width, x, y, 
+                                       status, shape_type);
+                        break;
+                    case DEFIPATH_VIADATA: {
+                        int num_x, num_y, step_x, step_y;
+                        path->getViaData(&num_x, &num_y, &step_x, &step_y);
+                        for (int iy = 0; iy < num_y; iy++) {
+                            for (int ix = (iy == 0); ix < num_x; ix++) {
+                                shapes.add_via(net_id, via, layer, width, 
+                                               x + ix * step_x, y + iy * step_y, 
+                                               status, shape_type);
+                            }
+                        }
+                        break;
+                    }
+                }
+                path_id = path->next();
+            }
+        }
+    }
+}
+
+int DefParser::set_special_net_wire (defrCallbackType_e, defiNet* net, 
+                                     defiUserData ud)
 {
     auto def = static_cast<Def*>(ud); 
-    auto& special_net_umap = def->pimpl_->special_net_umap_;
-    special_net_umap.reserve(num_nets);
+    auto the_net = def->get_current_special_net(net->name());
+    process_special_wires(def->pimpl_->special_shapes_, the_net->id_, net);
 
     return 0;
 }
 
 int DefParser::set_special_net (defrCallbackType_e, defiNet* net, defiUserData ud)
 {
-    cout << "DEBUG: Skipping special net processing" << endl;
+    auto def = static_cast<Def*>(ud); 
+    auto& symbols = util::SymbolTable::get_instance();
+    auto& shapes = def->pimpl_->special_shapes_;
+    auto the_net = def->get_current_special_net(net->name());
+
+    for (int i = 0; i < net->numConnections(); ++i) {
+        the_net->pins_.emplace_back(symbols.intern(net->instance(i)), 
+                                    symbols.intern(net->pin(i)));
+    }
+
+    // Wires not handed over by set_special_net_wire().
+    process_special_wires(shapes, the_net->id_, net);
+
+    for (int i = 0; i < net->numRectangles(); i++) {
+        shapes.add_rect(the_net->id_, net->rectName(i), 
+                        util::Box(net->xl(i), net->yl(i), net->xh(i), net->yh(i)),
+                        SpecialShapes::find_status(net->rectRouteStatus(i)), 
+                        SpecialShapes::find_shape_type(net->rectShapeType(i)));
+    }
+
+    if (net->hasUse()) {
+        the_net->use_ = net->use();
+    }
+
+    return 0;
+}
+
+/**
+ * Create a region without rectangles and register it.
+ */
+RegionPtr Def::add_region (string name)
+{
+    auto the_region = make_shared<Region>();
+    the_region->id_ = pimpl_->regions_.size();
+    the_region->name_ = std::move(name);
+    the_region->name_id_ = util::SymbolTable::get_instance().intern(the_region->name_);
+    the_region->type_ = RegionType::na;
+
+    pimpl_->regions_.push_back(the_region);
+    return the_region;
+}
+
+/**
+ * Create a group without members and register it.
+ */
+GroupPtr Def::add_group (string name)
+{
+    auto the_group = make_shared<Group>();
+    the_group->id_ = pimpl_->groups_.size();
+    the_group->name_ = std::move(name);
+    the_group->name_id_ = util::SymbolTable::get_instance().intern(the_group->name_);
+    the_group->region_ = -1;
+
+    pimpl_->groups_.push_back(the_group);
+    return the_group;
+}
+
+//
+// - [ LAYER layerName ... | PLACEMENT [+ SOFT | + PARTIAL maxDensity]
+//        [+ COMPONENT compName] [+ PUSHDOWN] ]
+//   { RECT pt pt | POLYGON pt pt pt ... } ... ;
+int DefParser::set_blockage (defrCallbackType_e, defiBlockage* blockage, 
+                             defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    auto the_blockage = make_shared<Blockage>();
+
+    if (blockage->hasLayer()) {
+        the_blockage->layer_ = blockage->layerName();
+        if (blockage->hasComponent()) {
+            the_blockage->component_ = blockage->layerComponentName();
+        }
+    }
+    else if (blockage->hasComponent()) {
+        the_blockage->component_ = blockage->placementComponentName();
+    }
+    the_blockage->is_soft_ = blockage->hasSoft();
+    the_blockage->is_pushdown_ = blockage->hasPushdown();
+    the_blockage->max_density_ = blockage->hasPartial() 
+                                     ? blockage->placementMaxDensity() : 0;
+
+    auto& boxes = the_blockage->boxes_;
+    for (int i = 0; i < blockage->numRectangles(); i++) {
+        boxes.emplace_back(blockage->xl(i), blockage->yl(i), 
+                           blockage->xh(i), blockage->yh(i));
+    }
+    for (int i = 0; i < blockage->numPolygons(); i++) {
+        auto points = blockage->getPolygon(i);
+        if (points.numPoints == 0) {
+            continue;
+        }
+        util::Box box(points.x[0], points.y[0], points.x[0], points.y[0]);
+        for (int j = 1; j < points.numPoints; j++) {
+            box.lx_ = min(box.lx_, points.x[j]);
+            box.ly_ = min(box.ly_, points.y[j]);
+            box.ux_ = max(box.ux_, points.x[j]);
+            box.uy_ = max(box.uy_, points.y[j]);
+        }
+        boxes.push_back(box);
+    }
+
+    def->pimpl_->blockages_.push_back(the_blockage);
+
     return 0;
-    // auto def = static_cast<Def*>(ud); 
-    // auto dbu = def->pimpl_->dbu_;
+}
 
-    // // 添加檢查
-    // if (net == nullptr) {
-    //     cout << "Warning: null special net pointer" << endl;
-    //     return 0;
-    // }
+//
+// - regionName pt pt [pt pt] ... [+ TYPE {FENCE | GUIDE}] 
+//   [+ PROPERTY {propName propVal} ...] ... ;
+int DefParser::set_region (defrCallbackType_e, defiRegion* region, defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    auto the_region = def->add_region(region->name());
 
-    // auto the_net = create_net(def, dbu, net);
-    
-    // // 檢查 create_net 是否成功
-    // if (the_net == nullptr) {
-    //     cout << "Warning: failed to create special net" << endl;
-    //     return 0;
-    // }
+    if (region->hasType()) {
+        string type = region->type();
+        if (type == "FENCE") {
+            the_region->type_ = RegionType::fence;
+        }
+        else if (type == "GUIDE") {
+            the_region->type_ = RegionType::guide;
+        }
+    }
 
-    // cout << "Processing special net: " << the_net->name_ << endl;
+    for (int i = 0; i < region->numRectangles(); i++) {
+        the_region->boxes_.emplace_back(region->xl(i), region->yl(i), 
+                                        region->xh(i), region->yh(i));
+    }
 
-    // auto& special_net_umap = def->pimpl_->special_net_umap_;
-    
-    // // 創建 SpecialNet 而不是轉換
-    // auto special_net = make_shared<SpecialNet>();
-    // special_net->name_ = the_net->name_;
-    // special_net->connections_ = the_net->connections_;
-    // special_net->wires_ = the_net->wires_;
-    // special_net->vias_ = the_net->vias_;
-    
-    // special_net_umap[special_net->name_] = special_net;
+    return 0;
+}
 
-    // return 0;
+//
+// - groupName [compNamePattern ...] [+ REGION regionName]
+//   [+ PROPERTY {propName propVal} ...] ... ;
+//
+// The name and the members are handed over before the group itself.
+int DefParser::set_group_name (defrCallbackType_e, const char* name, defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    def->add_group(name);
+
+    return 0;
 }
 
+int DefParser::set_group_member (defrCallbackType_e, const char* pattern, 
+                                 defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    def->pimpl_->groups_.back()->patterns_.emplace_back(pattern);
 
+    return 0;
+}
+
+int DefParser::set_group (defrCallbackType_e, defiGroup* group, defiUserData ud)
+{
+    auto def = static_cast<Def*>(ud); 
+    auto& the_group = def->pimpl_->groups_.back();
+
+    if (group->hasRegionName()) {
+        the_group->region_ = def->find_region(group->regionName());
+        if (the_group->region_ < 0) {
+            cout << "(W) Region " << group->regionName() << " of the group " 
+                 << the_group->name_ << " not found." << endl;
+        }
+    }
+    else if (group->hasRegionBox()) {
+        // A region given in place (DEF 5.4 and before) gets the group's name.
+        auto the_region = def->add_region(the_group->name_);
+        int num_boxes;
+        int *xl, *yl, *xh, *yh;
+        group->regionRects(&num_boxes, &xl, &yl, &xh, &yh);
+        for (int i = 0; i < num_boxes; i++) {
+            the_region->boxes_.emplace_back(xl[i], yl[i], xh[i], yh[i]);
+        }
+        the_group->region_ = the_region->id_;
+    }
+
+    return 0;
+}
 
 
 ostream& operator<< (ostream& os, const Row& r)
@@ -662,8 +1904,8 @@ ostream& operator<< (ostream& os, const Track& t)
 
 ostream& operator<< (ostream& os, const Component& c)
 {
-    os << "Component (name=" << c.name_
-       << ", ref_name=" << c.ref_name_
+    os << "Component (name=" << c.get_name()
+       << ", ref_name=" << c.get_ref_name()
        << ", x=" << c.x_ << ", y=" << c.y_
        << ", is_fixed=" << c.is_fixed_
        << ", is_placed=" << c.is_placed_
@@ -676,8 +1918,8 @@ ostream& operator<< (ostream& os, const Component& c)
 
 ostream& operator<< (ostream& os, const Pin& p)
 {
-    os << "Pin (name=" << p.name_
-       << ", net_name=" << p.net_name_
+    os << "Pin (name=" << p.get_name()
+       << ", net_name=" << p.get_net_name()
        << ", layer=" << p.layer_
        << ", dir=" << static_cast<long long>(p.dir_)
        << ", x=" << p.x_ << ", y=" << p.y_
@@ -698,41 +1940,12 @@ ostream& operator<< (ostream& os, const Via& v)
     return os;
 }
 
-ostream& operator<< (ostream& os, const RoutingPoint& rp)
-{
-    os << "RoutingPoint (x=" << rp.x_ << ", y=" << rp.y_ << ", ext=" << rp.ext_
-       << ", has_via=" << rp.has_via_
-       << ")";
-
-    return os;
-}
-
-ostream& operator<< (ostream& os, const Wire& w)
-{
-    os << "Wire (wire_type=" << w.wire_type_
-       << ", layer=" << w.layer_
-       << ", num_wire_segments=" << w.wire_segments_.size()
-       << ")";
-
-    return os;
-}
-
-ostream& operator<< (ostream& os, const WireSegment& ws)
-{
-    os << "WireSegment (layer_name=" << ws.layer_name_
-       << ", width=" << ws.width_
-       << ", num_rpoints=" << ws.rpoints_.size()
-       << ")";
-
-    return os;
-}
-
-
 ostream& operator<< (ostream& os, const Connection& c)
 {
-    os << "Connection (name=" << c.name_
-       << ", lx=" << c.lx_ << ", ly=" << c.ly_
-       << ", ux=" << c.ux_ << ", uy=" << c.uy_;
+    auto box = get_connection_box(c);
+    os << "Connection (name=" << c.get_pin_name()
+       << ", lx=" << box.lx_ << ", ly=" << box.ly_
+       << ", ux=" << box.ux_ << ", uy=" << box.uy_;
 
     if (c.lef_pin_ != nullptr) {
         os << ", lef_pin=" << *(c.lef_pin_);
@@ -744,9 +1957,9 @@ ostream& operator<< (ostream& os, const Connection& c)
 
 ostream& operator<< (ostream& os, const Net& n)
 {
-    os << "Net (name=" << n.name_
+    os << "Net (name=" << n.get_name()
        << ", num_pins=" << n.connections_.size()
-       << ", num_wires=" << n.wires_.size()
+       << ", num_wires=" << n.wires_.get_num_wires()
        << ", num_vias=" << n.vias_.size()
        << ")";
 
@@ -14,6 +14,9 @@
 #include "common_enum.h"
 
 #include "Lef.h"
+#include "Span.h"
+#include "RoutedWires.h"
+#include "SpecialShapes.h"
 
 namespace def
 {
@@ -25,12 +28,16 @@ struct GCellGrid;
 struct Component;
 struct Pin;
 struct Via;
-struct RoutingPoint;
-struct WireSegment;
-struct Wire;
 struct Connection;
 struct Net;
 struct SpecialNet;
+struct Blockage;
+struct Region;
+struct Group;
+class  DefFastReader;
+class  SpatialIndex;
+class  BlockageIndex;
+class  PlacementConstraints;
 
 // Alias to basic data structures
 using RowPtr          = shared_ptr<Row>;
@@ -39,17 +46,19 @@ using GCellGridPtr    = shared_ptr<GCellGrid>;
 using ComponentPtr    = shared_ptr<Component>;
 using PinPtr          = shared_ptr<Pin>;
 using ViaPtr          = shared_ptr<Via>;
-using WirePtr         = shared_ptr<Wire>;
-using RoutingPointPtr = shared_ptr<RoutingPoint>;
-using WireSegmentPtr  = shared_ptr<WireSegment>;
-using ConnectionPtr   = shared_ptr<Connection>;
 using NetPtr          = shared_ptr<Net>;
 using SpecialNetPtr   = shared_ptr<SpecialNet>;
+using BlockagePtr     = shared_ptr<Blockage>;
+using RegionPtr       = shared_ptr<Region>;
+using GroupPtr        = shared_ptr<Group>;
 
 // Some containers
 using RowVec          = vector<RowPtr>;
 using TrackVec        = vector<TrackPtr>;
 using GCellGridVec    = vector<GCellGridPtr>;
+using ComponentVec    = vector<ComponentPtr>;
+using PinVec          = vector<PinPtr>;
+using NetVec          = vector<NetPtr>;
 using ComponentUMap   = unordered_map<string, ComponentPtr>;
 using PinUMap         = unordered_map<string, PinPtr>;
 using NetUMap         = unordered_map<string, NetPtr>;
@@ -60,9 +69,6 @@ ostream& operator<< (ostream& os, const Track&);
 ostream& operator<< (ostream& os, const Component&);
 ostream& operator<< (ostream& os, const Pin&);
 ostream& operator<< (ostream& os, const Via&);
-ostream& operator<< (ostream& os, const RoutingPoint&);
-ostream& operator<< (ostream& os, const Wire&);
-ostream& operator<< (ostream& os, const WireSegment&);
 ostream& operator<< (ostream& os, const Connection&);
 ostream& operator<< (ostream& os, const Net&);
 
@@ -119,8 +125,9 @@ struct GCellGrid
  */
 struct Component
 {
-    string name_;
-    string ref_name_;
+    uint32_t id_;      ///< Dense id, the index in Def::get_components().
+    util::SymbolId name_id_;
+    util::SymbolId ref_name_id_;
     bool is_fixed_;
     bool is_placed_;
     int x_;
@@ -129,6 +136,21 @@ struct Component
     int orient_;
 
     lef::MacroPtr lef_macro_;
+
+    // The names are kept in the symbol table only.
+    string get_name () const { return util::get_symbol_name(name_id_); }
+    string get_ref_name () const { return util::get_symbol_name(ref_name_id_); }
+
+    /**
+     * @return The macros the component can be swapped to in place, by area,
+     *         its own included; see Def::swap_macro().
+     */
+    const vector<lef::MacroPtr>& get_swap_candidates () const
+    {
+        static const vector<lef::MacroPtr> none;
+        return lef_macro_ && lef_macro_->family_ ? lef_macro_->family_->macros_ 
+                                                 : none;
+    }
 };
 
 
@@ -137,9 +159,10 @@ struct Component
  */
 struct Pin 
 {
-    string name_;
-    string net_name_;
+    uint32_t id_;      ///< Dense id, the index in Def::get_pins().
     string layer_;
+    util::SymbolId name_id_;
+    util::SymbolId net_name_id_;
     PinDir dir_;
 
     int x_;
@@ -151,86 +174,106 @@ struct Pin
     int ly_;
     int ux_;
     int uy_;
+
+    string get_name () const { return util::get_symbol_name(name_id_); }
+    string get_net_name () const { return util::get_symbol_name(net_name_id_); }
 };
 
 
 /**
- *
+ * A class to represent a via.
  */
-struct RoutingPoint
+struct Via
 {
-    int x_;
-    int y_;
-    int ext_;
-    bool has_via_;
-
-    RoutingPoint (int x, int y, int ext) : x_(x), y_(y), ext_(ext) {}
+    string layer_;
 };
 
 
 /**
- *
+ * A pin on a net: the pin pin_index_ of the macro of component_, or the IO
+ * pin pin_. The box of the pin is not stored but looked up in the pin box
+ * table of the macro; see get_connection_box(). The connections of all the
+ * nets are kept in one array, net by net, and point into the objects of
+ * the Def and the Lef.
  */
-struct WireSegment
+struct Connection
 {
-    string layer_name_;
-    int width_;
-    vector<RoutingPointPtr> rpoints_;    
+    Component* component_;
+    lef::Pin* lef_pin_;
+    Pin* pin_;
+    uint32_t pin_index_;    ///< Index of lef_pin_ in the pins of its macro.
+
+    Connection (Component* component, lef::Pin* lef_pin, uint32_t pin_index)
+        : component_(component), lef_pin_(lef_pin), pin_(nullptr), 
+          pin_index_(pin_index) {}
+
+    explicit Connection (Pin* pin)
+        : component_(nullptr), lef_pin_(nullptr), pin_(pin), pin_index_(0) {}
+
+    string get_pin_name () const
+    {
+        return lef_pin_ ? lef_pin_->name_ : pin_->get_name();
+    }
 };
 
 /**
- * A class to represent a wire.
+ * @return True unless @a c is a pin of an unplaced component, whose place
+ *         is meaningless.
  */
-struct Wire
+inline bool is_placed (const Connection& c)
 {
-    string wire_type_;
-    string layer_;
-    vector<WireSegmentPtr> wire_segments_;
-};
-
+    return c.component_ == nullptr || c.component_->is_placed_ 
+           || c.component_->is_fixed_;
+}
 
 /**
- * A class to represent a via.
+ * @return The box of @a c in DBU, at the current place of its component.
+ *         The pin box tables must be in the DBU of the DEF.
  */
-struct Via
+inline util::Box get_connection_box (const Connection& c)
 {
-    string layer_;
-};
+    if (c.component_) {
+        auto& comp = *c.component_;
+        return comp.lef_macro_->get_pin_box(c.pin_index_, comp.orient_)
+                   .shifted(comp.x_, comp.y_);
+    }
+    auto& p = *c.pin_;
+    return util::transform_box(util::Box(p.lx_, p.ly_, p.ux_, p.uy_), p.orient_)
+               .shifted(p.x_, p.y_);
+}
 
-
-struct Connection
+/**
+ * @return The box of the cell of @a c placed at (@a x, @a y) in its current
+ *         orientation, in DBU; empty if the macro of @a c is unknown.
+ */
+inline util::Box get_cell_box (const Component& c, int x, int y)
 {
-    string name_;
-    ComponentPtr component_;
-    lef::PinPtr lef_pin_;
-    PinPtr pin_;
-
-    int lx_;
-    int ly_;
-    int ux_;
-    int uy_;
-
-    Connection (string name, ComponentPtr component, lef::PinPtr lef_pin,
-                int lx, int ly, int ux, int uy)
-        : name_(name), component_(component), lef_pin_(lef_pin), pin_(nullptr),
-          lx_(lx), ly_(ly), ux_(ux), uy_(uy) {}
-
-    Connection (string name, PinPtr pin, 
-                int lx, int ly, int ux, int uy)
-        : name_(name), component_(nullptr), lef_pin_(nullptr), pin_(pin),
-          lx_(lx), ly_(ly), ux_(ux), uy_(uy) {}
-};
+    int w = 0, h = 0;
+    if (c.lef_macro_) {
+        w = c.lef_macro_->size_x_dbu_;
+        h = c.lef_macro_->size_y_dbu_;
+    }
+    // W, E, FW and FE turn the cell by 90 degrees; an unplaced cell has
+    // no orientation (-1), and is seen as N.
+    if (c.orient_ >= 0 && (c.orient_ & 1)) {
+        std::swap(w, h);
+    }
+    return util::Box(x, y, x + w, y + h);
+}
 
 /**
  * A class to represent a net.
  */
 struct Net
 {
-    string name_;
-    vector<ConnectionPtr> connections_;
+    uint32_t id_;      ///< Dense id, the index in Def::get_nets().
+    util::SymbolId name_id_;
+    util::Span<Connection> connections_;   ///< Set when the design is read.
 
-    vector<WirePtr> wires_;
+    RoutedWires wires_;     ///< Routing, if the net is routed.
     vector<ViaPtr> vias_;
+
+    string get_name () const { return util::get_symbol_name(name_id_); }
 };
 
 
@@ -239,7 +282,84 @@ struct Net
  */
 struct SpecialNet : public Net
 {
+    // Instance (or "*") and pin names of the connections; "PIN" and the
+    // pin name for an IO pin. The geometry is in Def::get_special_shapes().
+    vector<pair<util::SymbolId, util::SymbolId>> pins_;
+    string use_;        ///< USE, if given.
+};
+
+/**
+ * A blockage. A placement blockage (no layer_) keeps cells out of its
+ * rectangles; a layer blockage keeps routing out of layer_.
+ */
+struct Blockage
+{
+    string layer_;              ///< Empty for a placement blockage.
+    string component_;          ///< + COMPONENT, if given.
+    bool is_soft_;              ///< + SOFT: kept out by the global placement only.
+    bool is_pushdown_;
+    double max_density_;        ///< + PARTIAL, in percent; 0 if not partial.
+
+    // Rectangles; a polygon is kept as its bounding box.
+    vector<util::Box> boxes_;
+
+    bool is_placement () const { return layer_.empty(); }
+
+    /**
+     * @return True if no cell may overlap the blockage.
+     */
+    bool is_hard () const
+    {
+        return is_placement() && !is_soft_ && max_density_ == 0;
+    }
+};
+
+/**
+ * A region. Members of a group bound to a fence must lie in it, and other
+ * cells must not enter it; a guide only attracts its members.
+ */
+struct Region
+{
+    uint32_t id_;      ///< Dense id, the index in Def::get_regions().
+    string name_;
+    util::SymbolId name_id_;
+    RegionType type_;
+    vector<util::Box> boxes_;
+};
+
+/**
+ * A group of components, named by patterns in which '*' and '?' are
+ * wildcards. The patterns are resolved into the components when the
+ * design is read; see PlacementConstraints.
+ */
+struct Group
+{
+    uint32_t id_;      ///< Dense id, the index in Def::get_groups().
+    string name_;
+    util::SymbolId name_id_;
+    vector<string> patterns_;
+    int region_;        ///< Index in Def::get_regions(), -1 if none.
+};
 
+/**
+ * A pin of a component on a net: the connection pin_ of the net net_.
+ */
+struct NetPin
+{
+    uint32_t net_;      ///< Dense id of the net.
+    uint32_t pin_;      ///< Index in the connections of the net.
+};
+
+/**
+ * Byte range of a section "KEYWORD n ; ... END KEYWORD" in the DEF file read.
+ */
+struct Section
+{
+    string name_;
+    size_t begin_;          ///< Start of the header line.
+    size_t body_begin_;     ///< After the header.
+    size_t body_end_;       ///< Start of the END line.
+    size_t end_;            ///< After "END KEYWORD".
 };
 
 /**
@@ -252,6 +372,7 @@ public:
 
     string get_design_name () const;
     int get_dbu () const;
+    string get_filename () const;
 
     const RowVec& get_rows () const;
     const TrackVec& get_tracks () const;
@@ -261,14 +382,95 @@ public:
     const NetUMap& get_net_umap () const;
     const SpecialNetUMap& get_special_net_umap () const;
 
+    // Objects in the order they were read, indexed by their dense ids.
+    const ComponentVec& get_components () const;
+    const PinVec& get_pins () const;
+    const NetVec& get_nets () const;
+    const vector<SpecialNetPtr>& get_special_nets () const;
+    const vector<BlockagePtr>& get_blockages () const;
+    const vector<RegionPtr>& get_regions () const;
+    const vector<GroupPtr>& get_groups () const;
+
+    /**
+     * @return Index of the region @a name in get_regions(), -1 if none.
+     */
+    int find_region (const string& name) const;
+
     NetPtr get_net (string name);
     ComponentPtr get_component (string name);
     PinPtr get_pin (string name);
 
-    void read_def (string filename);
+    // Lookups by interned name; integer operations only.
+    NetPtr get_net (util::SymbolId name) const;
+    ComponentPtr get_component (util::SymbolId name) const;
+    PinPtr get_pin (util::SymbolId name) const;
+
+    /**
+     * @return The index of the placed components and the IO pins, built
+     *         when the design is read.
+     */
+    const SpatialIndex& get_spatial_index () const;
+
+    /**
+     * @return The index of the obstructions of the placed components,
+     *         built when the design is read.
+     */
+    const BlockageIndex& get_blockage_index () const;
+
+    /**
+     * @return The blockages, regions and group memberships, resolved for
+     *         placement legality when the design is read.
+     */
+    const PlacementConstraints& get_placement_constraints () const;
+
+    /**
+     * @return The pins of the component @a id on nets, in net order. The
+     *         adjacency is built when the design is read.
+     */
+    util::Span<NetPin> get_component_nets (uint32_t id) const;
+
+    /**
+     * @return The stripes, rails, vias and rectangles of the special nets,
+     *         indexed by layer when the design is read.
+     */
+    const SpecialShapes& get_special_shapes () const;
+
+    /**
+     * Move the component @a id to (@a x, @a y) and mark it as moved. It is
+     * turned to @a orient if one is given; otherwise it keeps its
+     * orientation, and an unplaced component is placed in N. The spatial
+     * index is updated.
+     */
+    void move_component (uint32_t id, int x, int y, int orient = -1);
+    bool is_component_moved (uint32_t id) const;
+    size_t get_num_moved_components () const;
+
+    /**
+     * Rebind the component @a id to @a macro, one of its swap candidates,
+     * and mark it as moved. The pins of its connections are rebound by name
+     * and the spatial and blockage indexes are updated.
+     */
+    void swap_macro (uint32_t id, lef::MacroPtr macro);
+
+    /**
+     * @return Sections of the DEF file read, in file order. Empty if the
+     *         design was loaded from a snapshot.
+     */
+    const vector<Section>& get_sections () const;
+    const Section* find_section (string name) const;
+
+    /**
+     * @return True if the DEF file read has not changed on disk since.
+     */
+    bool is_file_unchanged () const;
+
+    void read_def (string filename, bool use_mmap = false, int num_threads = 0);
     void report () const;
     void report_verbose () const;
 
+    void write_snapshot (util::BinaryWriter& writer) const;
+    void read_snapshot (util::BinaryReader& reader);
+
     int get_die_lx () const;
     int get_die_ly () const;
     int get_die_ux () const;
@@ -280,6 +482,22 @@ private:
 
     friend class DefParser;
 
+    ComponentPtr add_component (string name, string ref_name);
+    PinPtr add_pin (string name, string net_name);
+    NetPtr add_net (string name);
+    void add_connection (NetPtr net, const char* inst_name, const char* pin_name);
+    SpecialNetPtr get_current_special_net (const char* name);
+    RegionPtr add_region (string name);
+    GroupPtr add_group (string name);
+
+    void add_fast_components (const DefFastReader& reader);
+    void add_fast_pins (const DefFastReader& reader);
+    void add_fast_nets (const DefFastReader& reader);
+
+    void build_net_pins ();
+    void build_component_nets ();
+    void mark_moved (uint32_t id);
+
     Def ();
     ~Def () = default;
     Def (const Def&) = delete;
@@ -308,6 +526,12 @@ public:
     static int set_net (defrCallbackType_e, defiNet*, defiUserData);
     static int set_special_net_start (defrCallbackType_e, int, defiUserData);
     static int set_special_net (defrCallbackType_e, defiNet*, defiUserData);
+    static int set_special_net_wire (defrCallbackType_e, defiNet*, defiUserData);
+    static int set_blockage (defrCallbackType_e, defiBlockage*, defiUserData);
+    static int set_region (defrCallbackType_e, defiRegion*, defiUserData);
+    static int set_group_name (defrCallbackType_e, const char*, defiUserData);
+    static int set_group_member (defrCallbackType_e, const char*, defiUserData);
+    static int set_group (defrCallbackType_e, defiGroup*, defiUserData);
 
 private:
     DefParser () = default;
@@ -0,0 +1,671 @@
+/**
+ * @file    DefFastReader.cpp
+ */
+
+#include "DefFastReader.h"
+#include "Parallel.h"
+
+using namespace std;
+
+namespace def
+{
+
+static const size_t min_chunk_size = 64 * 1024;
+
+static inline bool is_space (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool equals (const Token& t, const char* str)
+{
+    return strlen(str) == t.len_ && memcmp(t.str_, str, t.len_) == 0;
+}
+
+static bool to_int (const Token& t, int& value)
+{
+    uint32_t i = 0;
+    bool negative = false;
+
+    if (t.len_ > 0 && (t.str_[0] == '-' || t.str_[0] == '+')) {
+        negative = (t.str_[0] == '-');
+        i++;
+    }
+    if (i == t.len_ || t.len_ - i > 10) {
+        return false;
+    }
+
+    long long v = 0;
+    for (; i < t.len_; i++) {
+        auto c = t.str_[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        v = v * 10 + (c - '0');
+    }
+    v = negative ? -v : v;
+
+    if (v < numeric_limits<int>::min() || v > numeric_limits<int>::max()) {
+        return false;
+    }
+    value = static_cast<int>(v);
+
+    return true;
+}
+
+/**
+ * @return Orientation code of the Si2 parser (N, W, S, E, FN, FW, FS, FE),
+ *         or -1 if @a t is not an orientation.
+ */
+static int to_orient (const Token& t)
+{
+    static const char* orients[] = { "N", "W", "S", "E", "FN", "FW", "FS", "FE" };
+
+    for (int i = 0; i < 8; i++) {
+        if (equals(t, orients[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * A whitespace tokenizer over [begin, end).
+ */
+class Tokenizer
+{
+public:
+    Tokenizer (const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    bool next (Token& t)
+    {
+        while (p_ < end_ && is_space(*p_)) {
+            p_++;
+        }
+        if (p_ == end_) {
+            return false;
+        }
+
+        auto begin = p_;
+        while (p_ < end_ && !is_space(*p_)) {
+            p_++;
+        }
+        t.str_ = begin;
+        t.len_ = p_ - begin;
+
+        return true;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+/**
+ * Parse "( x y ) orient".
+ */
+static bool parse_placement (Tokenizer& tk, int& x, int& y, 
+                             Token& orient_str, int& orient)
+{
+    Token t, tx, ty;
+
+    if (!tk.next(t) || !equals(t, "(") || !tk.next(tx) || !tk.next(ty)
+        || !tk.next(t) || !equals(t, ")") || !tk.next(orient_str)) {
+        return false;
+    }
+    orient = to_orient(orient_str);
+
+    return orient >= 0 && to_int(tx, x) && to_int(ty, y);
+}
+
+/**
+ * Parse "( x y )".
+ */
+static bool parse_point (Tokenizer& tk, int& x, int& y)
+{
+    Token t, tx, ty;
+
+    if (!tk.next(t) || !equals(t, "(") || !tk.next(tx) || !tk.next(ty)
+        || !tk.next(t) || !equals(t, ")")) {
+        return false;
+    }
+
+    return to_int(tx, x) && to_int(ty, y);
+}
+
+//
+// - compName modelName
+//      [+ {FIXED | COVER | PLACED} pt orient | + UNPLACED]
+//      [+ SOURCE {...}] [+ WEIGHT weight] ;
+static bool parse_components (const char* begin, const char* end, 
+                              vector<FastComponent>& components)
+{
+    Tokenizer tk(begin, end);
+    Token t;
+
+    while (tk.next(t)) {
+        FastComponent c;
+
+        if (!equals(t, "-") || !tk.next(c.name_) || !tk.next(c.ref_name_)) {
+            return false;
+        }
+
+        // Same defaults as defiComponent.
+        c.is_fixed_ = false;
+        c.is_placed_ = false;
+        c.x_ = 0;
+        c.y_ = 0;
+        c.orient_str_ = Token{"N", 1};
+        c.orient_ = 0;
+
+        while (true) {
+            if (!tk.next(t)) {
+                return false;
+            }
+            if (equals(t, ";")) {
+                break;
+            }
+            if (!equals(t, "+") || !tk.next(t)) {
+                return false;
+            }
+
+            if (equals(t, "PLACED") || equals(t, "FIXED") || equals(t, "COVER")) {
+                c.is_placed_ = equals(t, "PLACED");
+                c.is_fixed_ = equals(t, "FIXED");
+                if (!parse_placement(tk, c.x_, c.y_, c.orient_str_, c.orient_)) {
+                    return false;
+                }
+            }
+            else if (equals(t, "UNPLACED")) {
+                c.x_ = -1;
+                c.y_ = -1;
+                c.orient_str_ = Token{"", 0};
+                c.orient_ = -1;
+            }
+            else if (equals(t, "SOURCE") || equals(t, "WEIGHT")) {
+                if (!tk.next(t)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+
+        components.push_back(c);
+    }
+
+    return true;
+}
+
+//
+// - pinName + NET netName [+ SPECIAL] [+ DIRECTION dir] [+ USE use]
+//      [+ LAYER layerName pt pt]
+//      [+ {FIXED | COVER | PLACED} pt orient] ;
+static bool parse_pins (const char* begin, const char* end, 
+                        vector<FastPin>& pins)
+{
+    Tokenizer tk(begin, end);
+    Token t;
+
+    while (tk.next(t)) {
+        FastPin p;
+
+        if (!equals(t, "-") || !tk.next(p.name_) 
+            || !tk.next(t) || !equals(t, "+")
+            || !tk.next(t) || !equals(t, "NET") || !tk.next(p.net_name_)) {
+            return false;
+        }
+
+        // Same defaults as defiPin.
+        p.direction_ = Token{"", 0};
+        p.layer_ = Token{"", 0};
+        p.has_layer_ = false;
+        p.x_ = 0;
+        p.y_ = 0;
+        p.orient_str_ = Token{"N", 1};
+        p.orient_ = 0;
+        p.lx_ = p.ly_ = p.ux_ = p.uy_ = 0;
+
+        while (true) {
+            if (!tk.next(t)) {
+                return false;
+            }
+            if (equals(t, ";")) {
+                break;
+            }
+            if (!equals(t, "+") || !tk.next(t)) {
+                return false;
+            }
+
+            if (equals(t, "SPECIAL")) {
+                continue;
+            }
+            else if (equals(t, "DIRECTION")) {
+                if (!tk.next(p.direction_)) {
+                    return false;
+                }
+            }
+            else if (equals(t, "USE")) {
+                if (!tk.next(t)) {
+                    return false;
+                }
+            }
+            else if (equals(t, "LAYER")) {
+                // Multiple layers, masks and spacing rules are left to Si2.
+                if (p.has_layer_ || !tk.next(p.layer_)
+                    || !parse_point(tk, p.lx_, p.ly_) 
+                    || !parse_point(tk, p.ux_, p.uy_)) {
+                    return false;
+                }
+                p.has_layer_ = true;
+            }
+            else if (equals(t, "PLACED") || equals(t, "FIXED") || equals(t, "COVER")) {
+                if (!parse_placement(tk, p.x_, p.y_, p.orient_str_, p.orient_)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+
+        pins.push_back(p);
+    }
+
+    return true;
+}
+
+//
+// - netName { ( {compName | PIN} pinName [+ SYNTHESIZED] ) } ...
+//      [+ USE use] [+ SOURCE src] [+ WEIGHT w] ... ;
+static bool parse_nets (const char* begin, const char* end, 
+                        vector<FastNet>& nets,
+                        vector<pair<Token, Token>>& connections)
+{
+    Tokenizer tk(begin, end);
+    Token t;
+
+    while (tk.next(t)) {
+        FastNet n;
+
+        if (!equals(t, "-") || !tk.next(n.name_) || equals(n.name_, "MUSTJOIN")) {
+            return false;
+        }
+        n.first_connection_ = connections.size();
+
+        while (true) {
+            if (!tk.next(t)) {
+                return false;
+            }
+            if (equals(t, ";")) {
+                break;
+            }
+
+            if (equals(t, "(")) {
+                Token inst, pin;
+                if (!tk.next(inst) || !tk.next(pin) || !tk.next(t)
+                    || equals(inst, "*")) {
+                    return false;
+                }
+                if (equals(t, "+")) {
+                    if (!tk.next(t) || !equals(t, "SYNTHESIZED") || !tk.next(t)) {
+                        return false;
+                    }
+                }
+                if (!equals(t, ")")) {
+                    return false;
+                }
+                connections.emplace_back(inst, pin);
+            }
+            else if (equals(t, "+")) {
+                // Wiring, shielding, subnets, ... are left to Si2.
+                if (!tk.next(t)) {
+                    return false;
+                }
+                if (!(equals(t, "USE") || equals(t, "SOURCE") || equals(t, "WEIGHT")
+                      || equals(t, "ORIGINAL") || equals(t, "PATTERN")
+                      || equals(t, "ESTCAP") || equals(t, "NONDEFAULTRULE")
+                      || equals(t, "XTALK") || equals(t, "FREQUENCY"))) {
+                    return false;
+                }
+                if (!tk.next(t)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+
+        n.num_connections_ = connections.size() - n.first_connection_;
+        nets.push_back(n);
+    }
+
+    return true;
+}
+
+
+DefFastReader::DefFastReader (const char* data, size_t size, int num_threads)
+    : data_(data), size_(size), num_threads_(util::get_num_threads(num_threads))
+{
+    //
+}
+
+/**
+ * Locate the sections and parse them in parallel.
+ */
+/**
+ * @return Seconds since @a begin, which is moved to now.
+ */
+static double lap (chrono::steady_clock::time_point& begin)
+{
+    auto now = chrono::steady_clock::now();
+    auto seconds = chrono::duration<double>(now - begin).count();
+    begin = now;
+    return seconds;
+}
+
+void DefFastReader::read ()
+{
+    locate_sections();
+
+    auto begin = chrono::steady_clock::now();
+    components_section_.parsed_ = components_section_.found_ && read_components();
+    components_section_.seconds_ = lap(begin);
+    pins_section_.parsed_ = pins_section_.found_ && read_pins();
+    pins_section_.seconds_ = lap(begin);
+    nets_section_.parsed_ = nets_section_.found_ && read_nets();
+    nets_section_.seconds_ = lap(begin);
+
+    if (!components_section_.parsed_) {
+        components_.clear();
+    }
+    if (!pins_section_.parsed_) {
+        pins_.clear();
+    }
+    if (!nets_section_.parsed_) {
+        nets_.clear();
+        connections_.clear();
+    }
+}
+
+bool DefFastReader::has_components () const
+{
+    return components_section_.parsed_;
+}
+
+bool DefFastReader::has_pins () const
+{
+    return pins_section_.parsed_;
+}
+
+bool DefFastReader::has_nets () const
+{
+    return nets_section_.parsed_;
+}
+
+double DefFastReader::get_components_seconds () const
+{
+    return components_section_.seconds_;
+}
+
+double DefFastReader::get_pins_seconds () const
+{
+    return pins_section_.seconds_;
+}
+
+double DefFastReader::get_nets_seconds () const
+{
+    return nets_section_.seconds_;
+}
+
+const vector<FastComponent>& DefFastReader::get_components () const
+{
+    return components_;
+}
+
+const vector<FastPin>& DefFastReader::get_pins () const
+{
+    return pins_;
+}
+
+const vector<FastNet>& DefFastReader::get_nets () const
+{
+    return nets_;
+}
+
+const vector<pair<Token, Token>>& DefFastReader::get_connections () const
+{
+    return connections_;
+}
+
+vector<pair<size_t, size_t>> DefFastReader::get_remaining_ranges () const
+{
+    vector<const Section*> sections;
+    for (auto s : {&components_section_, &pins_section_, &nets_section_}) {
+        if (s->parsed_) {
+            sections.push_back(s);
+        }
+    }
+    sort(sections.begin(), sections.end(), 
+         [] (const Section* a, const Section* b) { return a->begin_ < b->begin_; });
+
+    vector<pair<size_t, size_t>> ranges;
+    size_t pos = 0;
+    for (auto s : sections) {
+        ranges.emplace_back(pos, s->begin_);
+        pos = s->end_;
+    }
+    ranges.emplace_back(pos, size_);
+
+    return ranges;
+}
+
+/**
+ * @return True if the line at @a pos starts with the word @a keyword.
+ */
+static bool starts_with_word (const char* data, size_t pos, size_t eol, 
+                              const char* keyword)
+{
+    auto len = strlen(keyword);
+    return pos + len <= eol && memcmp(data + pos, keyword, len) == 0
+           && (pos + len == eol || is_space(data[pos + len]));
+}
+
+/**
+ * Find the top-level COMPONENTS, PINS and NETS sections line by line.
+ */
+void DefFastReader::locate_sections ()
+{
+    const char* keywords[] = { "COMPONENTS", "PINS", "NETS" };
+    Section* sections[] = { &components_section_, &pins_section_, &nets_section_ };
+    Section* current = nullptr;
+    const char* current_keyword = nullptr;
+
+    size_t pos = 0;
+    while (pos < size_) {
+        auto found = static_cast<const char*>(memchr(data_ + pos, '\n', size_ - pos));
+        auto eol = found ? static_cast<size_t>(found - data_) : size_;
+
+        auto q = pos;
+        while (q < eol && (data_[q] == ' ' || data_[q] == '\t')) {
+            q++;
+        }
+
+        if (current == nullptr) {
+            for (int i = 0; i < 3; i++) {
+                if (sections[i]->found_ || !starts_with_word(data_, q, eol, keywords[i])) {
+                    continue;
+                }
+                // The header ends with the first ';'.
+                auto semi = static_cast<const char*>(memchr(data_ + q, ';', size_ - q));
+                if (semi == nullptr) {
+                    return;
+                }
+                current = sections[i];
+                current_keyword = keywords[i];
+                current->begin_ = pos;
+                current->body_begin_ = semi - data_ + 1;
+
+                // Skip the lines of the header.
+                while (eol < current->body_begin_ && eol < size_) {
+                    found = static_cast<const char*>(
+                                memchr(data_ + eol + 1, '\n', size_ - eol - 1));
+                    eol = found ? static_cast<size_t>(found - data_) : size_;
+                }
+                break;
+            }
+        }
+        else if (starts_with_word(data_, q, eol, "END")) {
+            auto r = q + 3;
+            while (r < eol && (data_[r] == ' ' || data_[r] == '\t')) {
+                r++;
+            }
+            if (starts_with_word(data_, r, eol, current_keyword)) {
+                current->body_end_ = pos;
+                current->end_ = r + strlen(current_keyword);
+                current->found_ = true;
+                current = nullptr;
+            }
+        }
+
+        pos = eol + 1;
+    }
+}
+
+/**
+ * Split the body of @a section into chunks ending at ';'.
+ */
+vector<pair<size_t, size_t>> DefFastReader::split_chunks (const Section& section) const
+{
+    auto begin = section.body_begin_;
+    auto end = section.body_end_;
+    auto num_chunks = static_cast<size_t>(num_threads_) * 4;
+    num_chunks = std::max<size_t>(1, std::min(num_chunks, (end - begin) / min_chunk_size));
+
+    vector<pair<size_t, size_t>> chunks;
+    auto last = begin;
+
+    for (size_t k = 1; k < num_chunks; k++) {
+        auto pos = begin + (end - begin) * k / num_chunks;
+        if (pos < last) {
+            continue;
+        }
+        auto semi = static_cast<const char*>(memchr(data_ + pos, ';', end - pos));
+        if (semi == nullptr) {
+            break;
+        }
+        pos = semi - data_ + 1;
+        chunks.emplace_back(last, pos);
+        last = pos;
+    }
+    chunks.emplace_back(last, end);
+
+    return chunks;
+}
+
+/**
+ * @return False if the body of @a section contains strings or comments.
+ */
+static bool is_plain (const char* data, size_t begin, size_t end)
+{
+    return memchr(data + begin, '"', end - begin) == nullptr
+           && memchr(data + begin, '#', end - begin) == nullptr;
+}
+
+bool DefFastReader::read_components ()
+{
+    auto& s = components_section_;
+    if (!is_plain(data_, s.body_begin_, s.body_end_)) {
+        return false;
+    }
+
+    auto chunks = split_chunks(s);
+    vector<vector<FastComponent>> results(chunks.size());
+    vector<char> ok(chunks.size(), 0);
+
+    util::parallel_for(chunks.size(), num_threads_, [&] (size_t i) {
+        ok[i] = parse_components(data_ + chunks[i].first, 
+                                 data_ + chunks[i].second, results[i]);
+    });
+
+    if (find(ok.begin(), ok.end(), 0) != ok.end()) {
+        return false;
+    }
+
+    size_t n = 0;
+    for (auto& r : results) {
+        n += r.size();
+    }
+    components_.reserve(n);
+    for (auto& r : results) {
+        components_.insert(components_.end(), r.begin(), r.end());
+    }
+
+    return true;
+}
+
+bool DefFastReader::read_pins ()
+{
+    auto& s = pins_section_;
+    if (!is_plain(data_, s.body_begin_, s.body_end_)) {
+        return false;
+    }
+
+    auto chunks = split_chunks(s);
+    vector<vector<FastPin>> results(chunks.size());
+    vector<char> ok(chunks.size(), 0);
+
+    util::parallel_for(chunks.size(), num_threads_, [&] (size_t i) {
+        ok[i] = parse_pins(data_ + chunks[i].first, 
+                           data_ + chunks[i].second, results[i]);
+    });
+
+    if (find(ok.begin(), ok.end(), 0) != ok.end()) {
+        return false;
+    }
+
+    for (auto& r : results) {
+        pins_.insert(pins_.end(), r.begin(), r.end());
+    }
+
+    return true;
+}
+
+bool DefFastReader::read_nets ()
+{
+    auto& s = nets_section_;
+    if (!is_plain(data_, s.body_begin_, s.body_end_)) {
+        return false;
+    }
+
+    auto chunks = split_chunks(s);
+    vector<vector<FastNet>> results(chunks.size());
+    vector<vector<pair<Token, Token>>> connections(chunks.size());
+    vector<char> ok(chunks.size(), 0);
+
+    util::parallel_for(chunks.size(), num_threads_, [&] (size_t i) {
+        ok[i] = parse_nets(data_ + chunks[i].first, data_ + chunks[i].second,
+                           results[i], connections[i]);
+    });
+
+    if (find(ok.begin(), ok.end(), 0) != ok.end()) {
+        return false;
+    }
+
+    // Concatenate in order, shifting the connection indices of each chunk.
+    for (size_t i = 0; i < chunks.size(); i++) {
+        auto offset = connections_.size();
+        for (auto& n : results[i]) {
+            n.first_connection_ += offset;
+            nets_.push_back(n);
+        }
+        connections_.insert(connections_.end(), 
+                            connections[i].begin(), connections[i].end());
+    }
+
+    return true;
+}
+
+}   // End of namespace def
@@ -0,0 +1,148 @@
+/**
+ * @file    DefFastReader.h
+ */
+
+#ifndef DEF_FAST_READER_H
+#define DEF_FAST_READER_H
+
+#include "common_header.h"
+
+namespace def
+{
+
+/**
+ * A token pointing into the input buffer (not null-terminated).
+ */
+struct Token
+{
+    const char* str_;
+    uint32_t len_;
+
+    string to_string () const { return string(str_, len_); }
+};
+
+/**
+ * A component statement of the COMPONENTS section.
+ */
+struct FastComponent
+{
+    Token name_;
+    Token ref_name_;
+    bool is_fixed_;
+    bool is_placed_;
+    int x_;
+    int y_;
+    Token orient_str_;
+    int orient_;
+};
+
+/**
+ * A pin statement of the PINS section.
+ */
+struct FastPin
+{
+    Token name_;
+    Token net_name_;
+    Token direction_;
+    Token layer_;
+    bool has_layer_;
+    int x_;
+    int y_;
+    Token orient_str_;
+    int orient_;
+    int lx_;
+    int ly_;
+    int ux_;
+    int uy_;
+};
+
+/**
+ * A net statement of the NETS section.
+ */
+struct FastNet
+{
+    Token name_;
+    uint32_t first_connection_;     ///< Index into the connection array.
+    uint32_t num_connections_;
+};
+
+/**
+ * A native reader for the COMPONENTS, PINS and NETS sections of a DEF file.
+ *
+ * Each section body is split into chunks at statement boundaries (';'),
+ * and the chunks are tokenized on a pool of threads. Tokens point into the
+ * input buffer, which must outlive the reader. A section using syntax the
+ * reader does not support (routed wiring, ports, quoted strings, ...) is
+ * left untouched, and should be parsed by the Si2 reader instead.
+ */
+class DefFastReader
+{
+public:
+    DefFastReader (const char* data, size_t size, int num_threads);
+
+    void read ();
+
+    bool has_components () const;
+    bool has_pins () const;
+    bool has_nets () const;
+
+    /**
+     * @return Seconds spent reading COMPONENTS, PINS and NETS.
+     */
+    double get_components_seconds () const;
+    double get_pins_seconds () const;
+    double get_nets_seconds () const;
+
+    const vector<FastComponent>& get_components () const;
+    const vector<FastPin>& get_pins () const;
+    const vector<FastNet>& get_nets () const;
+
+    /**
+     * @return (instance, pin) tokens of the connections of all nets.
+     */
+    const vector<pair<Token, Token>>& get_connections () const;
+
+    /**
+     * @return Byte ranges of the input not covered by the parsed sections.
+     */
+    vector<pair<size_t, size_t>> get_remaining_ranges () const;
+
+private:
+    /**
+     * Location of a section "KEYWORD n ; ... END KEYWORD".
+     */
+    struct Section
+    {
+        bool found_ = false;
+        bool parsed_ = false;
+        size_t begin_;          ///< Start of the header line.
+        size_t body_begin_;     ///< After the header.
+        size_t body_end_;       ///< Start of the END line.
+        size_t end_;            ///< After "END KEYWORD".
+        double seconds_ = 0;    ///< Time spent reading the section.
+    };
+
+    const char* data_;
+    size_t size_;
+    int num_threads_;
+
+    Section components_section_;
+    Section pins_section_;
+    Section nets_section_;
+
+    vector<FastComponent> components_;
+    vector<FastPin> pins_;
+    vector<FastNet> nets_;
+    vector<pair<Token, Token>> connections_;
+
+    void locate_sections ();
+    vector<pair<size_t, size_t>> split_chunks (const Section& section) const;
+
+    bool read_components ();
+    bool read_pins ();
+    bool read_nets ();
+};
+
+}   // End of namespace def
+
+#endif
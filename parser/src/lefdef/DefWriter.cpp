@@ -8,6 +8,13 @@
 
 #include "DefWriter.h"
 #include "def/defwWriter.hpp"
+#include "TextBuffer.h"
+#include "Parallel.h"
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 
 using namespace my_lefdef;
 
@@ -82,14 +89,13 @@ static void write_gcell_grids (def::Def* def)
 
 static void write_components (def::Def* def)
 {
-    auto& component_umap = def->get_component_umap();
+    auto& components = def->get_components();
+    auto& symbols = util::SymbolTable::get_instance();
 
-    auto status = defwStartComponents(component_umap.size());
+    auto status = defwStartComponents(components.size());
     CHECK_STATUS(status);
 
-    for (auto it : component_umap) {
-        auto c = it.second;
-
+    for (auto& c : components) {
         string status_str = "UNPLACED";
         if (c->is_fixed_) {
             status_str = "FIXED";
@@ -103,7 +109,8 @@ static void write_components (def::Def* def)
         }
 
         status = defwComponentStr(
-                    c->name_.c_str(), c->ref_name_.c_str(), 
+                    symbols.get_name(c->name_id_), 
+                    symbols.get_name(c->ref_name_id_), 
                     0, NULL, NULL, NULL, NULL, NULL,    // Optionals
                     0, NULL, NULL, NULL, NULL, status_str.c_str(),
                     c->x_, c->y_, c->orient_str_.c_str(),
@@ -117,14 +124,13 @@ static void write_components (def::Def* def)
 
 static void write_pins (def::Def* def)
 {
-    auto& pin_umap = def->get_pin_umap();
+    auto& pins = def->get_pins();
+    auto& symbols = util::SymbolTable::get_instance();
 
-    auto status = defwStartPins(pin_umap.size());
+    auto status = defwStartPins(pins.size());
     CHECK_STATUS(status);
 
-    for (auto it : pin_umap) {
-        auto p = it.second;
-
+    for (auto& p : pins) {
         string direction_str = "INOUT";
         if (p->dir_ == PinDir::input) {
             direction_str = "INPUT";
@@ -133,7 +139,8 @@ static void write_pins (def::Def* def)
             direction_str = "OUTPUT";
         }
 
-        auto status = defwPinStr(p->name_.c_str(), p->net_name_.c_str(), 
+        auto status = defwPinStr(symbols.get_name(p->name_id_), 
+                                 symbols.get_name(p->net_name_id_), 
                                  0, direction_str.c_str(), 
                                  "SIGNAL", "FIXED", 
                                   p->x_, p->y_, p->orient_str_.c_str(), p->layer_.c_str(),
@@ -145,35 +152,117 @@ static void write_pins (def::Def* def)
     CHECK_STATUS(status);
 }
 
+/**
+ * @return Indices of the special shapes grouped by net, in the order of
+ *         the store; the shapes of the net i are in [begin[i], begin[i+1]).
+ */
+static vector<uint32_t> order_special_shapes (const def::Def& def, 
+                                              vector<uint32_t>& begin)
+{
+    auto& shapes = def.get_special_shapes().get_shapes();
+
+    begin.assign(def.get_special_nets().size() + 1, 0);
+    for (auto& s : shapes) {
+        begin[s.net_ + 1]++;
+    }
+    for (size_t i = 1; i < begin.size(); i++) {
+        begin[i] += begin[i - 1];
+    }
+
+    vector<uint32_t> order(shapes.size());
+    vector<uint32_t> next(begin.begin(), begin.end() - 1);
+    for (uint32_t i = 0; i < shapes.size(); i++) {
+        order[next[shapes[i].net_]++] = i;
+    }
+    return order;
+}
+
+/**
+ * Every wire and via is written as a path of its own; paths of the same
+ * status are joined with NEW. Rectangles follow the paths.
+ */
 static void write_special_nets (def::Def* def)
 {
-    auto& special_net_umap = def->get_special_net_umap();
+    using Shapes = def::SpecialShapes;
 
-    auto status = defwStartSpecialNets(special_net_umap.size());
+    auto& nets = def->get_special_nets();
+    auto& shapes = def->get_special_shapes();
+    auto& symbols = util::SymbolTable::get_instance();
+
+    vector<uint32_t> begin;
+    auto order = order_special_shapes(*def, begin);
+
+    auto status = defwStartSpecialNets(nets.size());
     CHECK_STATUS(status);
 
-    for (auto it : special_net_umap) {
-        auto n = it.second;
-        status = defwSpecialNet(n->name_.c_str());
+    for (auto& n : nets) {
+        status = defwSpecialNet(symbols.get_name(n->name_id_));
         CHECK_STATUS(status);
 
-        for (auto con : n->connections_) {
-            if (con->component_ != nullptr) {
-                status = defwSpecialNetConnection(con->component_->name_.c_str(), 
-                                  con->lef_pin_->name_.c_str(), 0);
+        for (auto& p : n->pins_) {
+            status = defwSpecialNetConnection(symbols.get_name(p.first), 
+                                              symbols.get_name(p.second), 0);
+            CHECK_STATUS(status);
+        }
+
+        int path_status = -1;
+        for (auto i = begin[n->id_]; i < begin[n->id_ + 1]; i++) {
+            auto& s = shapes.get_shapes()[order[i]];
+            if (s.kind_ == Shapes::Kind::rect) {
+                continue;
             }
-            else if (con->pin_ != nullptr) {
-                status = defwSpecialNetConnection("PIN", con->pin_->name_.c_str(), 0);
+
+            if (path_status == static_cast<int>(s.get_status())) {
+                status = defwSpecialNetPathStart("NEW");
             }
             else {
-                status = defwSpecialNetConnection("PIN", con->name_.c_str(), 0);
+                if (path_status >= 0) {
+                    status = defwSpecialNetPathEnd();
+                    CHECK_STATUS(status);
+                }
+                path_status = static_cast<int>(s.get_status());
+                status = defwSpecialNetPathStart(Shapes::get_status_name(s.get_status()));
+            }
+            CHECK_STATUS(status);
+
+            status = defwSpecialNetPathLayer(shapes.get_layer_name(shapes.get_path_layer(s)));
+            CHECK_STATUS(status);
+            status = defwSpecialNetPathWidth(s.width_);
+            CHECK_STATUS(status);
+            if (s.get_shape_type() != 0) {
+                status = defwSpecialNetPathShape(Shapes::get_shape_type_name(s.get_shape_type()));
+                CHECK_STATUS(status);
+            }
+
+            double xs[2] = {static_cast<double>(s.x1_), static_cast<double>(s.x2_)};
+            double ys[2] = {static_cast<double>(s.y1_), static_cast<double>(s.y2_)};
+            if (s.kind_ == Shapes::Kind::wire) {
+                status = defwSpecialNetPathPoint(2, xs, ys);
+            }
+            else {
+                status = defwSpecialNetPathPoint(1, xs, ys);
+                CHECK_STATUS(status);
+                status = defwSpecialNetPathVia(shapes.get_via_name(s));
             }
             CHECK_STATUS(status);
         }
+        if (path_status >= 0) {
+            status = defwSpecialNetPathEnd();
+            CHECK_STATUS(status);
+        }
+
+        for (auto i = begin[n->id_]; i < begin[n->id_ + 1]; i++) {
+            auto& s = shapes.get_shapes()[order[i]];
+            if (s.kind_ == Shapes::Kind::rect) {
+                status = defwSpecialNetRect(shapes.get_layer_name(s.layer_), 
+                                            s.x1_, s.y1_, s.x2_, s.y2_);
+                CHECK_STATUS(status);
+            }
+        }
 
-        if (n->wires_.empty() == false) {
-//            status = defwSpecialNetPathStart("ROUTED");
-//            status = defwSpecialNetPathEnd();
+        if (!n->use_.empty()) {
+            status = defwSpecialNetUse(n->use_.c_str());
+            CHECK_STATUS(status);
         }
 
         status = defwSpecialNetEndOneNet();
@@ -184,29 +273,146 @@ static void write_special_nets (def::Def* def)
     CHECK_STATUS(status);
 }
 
-static void write_nets (def::Def* def)
+static void write_regions (def::Def* def)
 {
-    auto& net_umap = def->get_net_umap();
+    auto& regions = def->get_regions();
+    if (regions.empty()) {
+        return;
+    }
 
-    auto status = defwStartNets(net_umap.size());
+    auto status = defwStartRegions(regions.size());
     CHECK_STATUS(status);
 
-    for (auto it : net_umap) {
-        auto n = it.second;
+    for (auto& r : regions) {
+        status = defwRegionName(r->name_.c_str());
+        CHECK_STATUS(status);
+        for (auto& b : r->boxes_) {
+            status = defwRegionPoints(b.lx_, b.ly_, b.ux_, b.uy_);
+            CHECK_STATUS(status);
+        }
+        if (r->type_ != RegionType::na) {
+            status = defwRegionType(r->type_ == RegionType::fence ? "FENCE" : "GUIDE");
+            CHECK_STATUS(status);
+        }
+    }
+
+    status = defwEndRegions();
+    CHECK_STATUS(status);
+}
+
+static void write_blockages (def::Def* def)
+{
+    auto& blockages = def->get_blockages();
+    if (blockages.empty()) {
+        return;
+    }
+
+    auto status = defwStartBlockages(blockages.size());
+    CHECK_STATUS(status);
+
+    for (auto& b : blockages) {
+        if (b->is_placement()) {
+            status = defwBlockagesPlacement();
+            CHECK_STATUS(status);
+            if (!b->component_.empty()) {
+                status = defwBlockagesPlacementComponent(b->component_.c_str());
+                CHECK_STATUS(status);
+            }
+            if (b->is_pushdown_) {
+                status = defwBlockagesPlacementPushdown();
+                CHECK_STATUS(status);
+            }
+            if (b->is_soft_) {
+                status = defwBlockagesPlacementSoft();
+                CHECK_STATUS(status);
+            }
+            if (b->max_density_ != 0) {
+                status = defwBlockagesPlacementPartial(b->max_density_);
+                CHECK_STATUS(status);
+            }
+        }
+        else {
+            status = defwBlockagesLayer(b->layer_.c_str());
+            CHECK_STATUS(status);
+            if (!b->component_.empty()) {
+                status = defwBlockagesLayerComponent(b->component_.c_str());
+                CHECK_STATUS(status);
+            }
+            if (b->is_pushdown_) {
+                status = defwBlockagesLayerPushdown();
+                CHECK_STATUS(status);
+            }
+        }
+
+        for (auto& r : b->boxes_) {
+            status = defwBlockagesRect(r.lx_, r.ly_, r.ux_, r.uy_);
+            CHECK_STATUS(status);
+        }
+    }
+
+    status = defwEndBlockages();
+    CHECK_STATUS(status);
+}
+
+/**
+ * Write the routed wires of @a n: a path starts a wire ("+ ROUTED", ...)
+ * or continues it ("NEW"), and the path statement ends after the last one.
+ */
+static void write_net_wires (const def::Net& n)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+    auto& paths = n.wires_.get_paths();
+    if (paths.empty()) {
+        return;
+    }
+
+    auto it = n.wires_.begin();
+    for (auto& p : paths) {
+        auto status = defwNetPathStart(p.new_wire_ ? symbols.get_name(p.wire_type_) 
+                                                   : "NEW");
+        CHECK_STATUS(status);
+        if (p.layer_id_ != util::SymbolTable::invalid_symbol) {
+            status = defwNetPathLayer(symbols.get_name(p.layer_id_), 0, nullptr);
+            CHECK_STATUS(status);
+        }
+        for (uint32_t i = 0; i < p.num_points_; i++, ++it) {
+            double x = it->x_, y = it->y_;
+            status = defwNetPathPoint(1, &x, &y);
+            CHECK_STATUS(status);
+            if (it->has_via_) {
+                status = defwNetPathVia(symbols.get_name(it->via_));
+                CHECK_STATUS(status);
+            }
+        }
+    }
+
+    auto status = defwNetPathEnd();
+    CHECK_STATUS(status);
+}
+
+static void write_nets (def::Def* def)
+{
+    auto& nets = def->get_nets();
+    auto& symbols = util::SymbolTable::get_instance();
+
+    auto status = defwStartNets(nets.size());
+    CHECK_STATUS(status);
 
-        status = defwNet(n->name_.c_str());
+    for (auto& n : nets) {
+        status = defwNet(symbols.get_name(n->name_id_));
         CHECK_STATUS(status);
 
-        for (auto con : n->connections_) {
-            if (con->component_ != nullptr) {
-                status = defwNetConnection(con->component_->name_.c_str(), 
-                                  con->lef_pin_->name_.c_str(), 0);
+        for (auto& con : n->connections_) {
+            if (con.component_ != nullptr) {
+                status = defwNetConnection(symbols.get_name(con.component_->name_id_), 
+                                  con.lef_pin_->name_.c_str(), 0);
             }
             else {
-                status = defwNetConnection("PIN", con->pin_->name_.c_str(), 0);
+                status = defwNetConnection("PIN", symbols.get_name(con.pin_->name_id_), 0);
             }
             CHECK_STATUS(status);
         }
+        write_net_wires(*n);
 
         status = defwNetEndOneNet();
         CHECK_STATUS(status);
@@ -216,16 +422,42 @@ static void write_nets (def::Def* def)
     CHECK_STATUS(status);
 }
 
-void DefWriter::write_def (def::Def& def, string filename)
+static void write_groups (def::Def* def)
 {
-    def_ = &def;
-
-    FILE* fout = fopen(filename.c_str(), "w");
-    if (fout == nullptr) {
-        fprintf(stderr, "ERROR: could not open output file\n");
+    auto& groups = def->get_groups();
+    auto& regions = def->get_regions();
+    if (groups.empty()) {
         return;
     }
 
+    auto status = defwStartGroups(groups.size());
+    CHECK_STATUS(status);
+
+    for (auto& g : groups) {
+        // defw takes a null member list as an error, even an empty one.
+        vector<const char*> patterns;
+        patterns.reserve(g->patterns_.size() + 1);
+        for (auto& p : g->patterns_) {
+            patterns.push_back(p.c_str());
+        }
+        status = defwGroup(g->name_.c_str(), patterns.size(), 
+                           patterns.data());
+        CHECK_STATUS(status);
+        if (g->region_ >= 0) {
+            status = defwGroupRegion(0, 0, 0, 0, regions[g->region_]->name_.c_str());
+            CHECK_STATUS(status);
+        }
+    }
+
+    status = defwEndGroups();
+    CHECK_STATUS(status);
+}
+
+/**
+ * Write the DEF statements of @a def to @a fout with the defw library.
+ */
+static void write_design (def::Def* def, FILE* fout)
+{
     int status;    // return code, if none 0 means error
     status = defwInitCbk(fout);
     CHECK_STATUS(status);
@@ -235,9 +467,9 @@ void DefWriter::write_def (def::Def& def, string filename)
     CHECK_STATUS(status);
     status = defwBusBitChars("[]");
     CHECK_STATUS(status);
-    status = defwDesignName(def_->get_design_name().c_str());
+    status = defwDesignName(def->get_design_name().c_str());
     CHECK_STATUS(status);
-    status = defwUnits(def_->get_dbu());
+    status = defwUnits(def->get_dbu());
     CHECK_STATUS(status);
 
     status = defwNewLine();
@@ -250,33 +482,42 @@ void DefWriter::write_def (def::Def& def, string filename)
     CHECK_STATUS(status);
 
     // Die area
-    status = defwDieArea(def_->get_die_lx(), def_->get_die_ly(),
-                         def_->get_die_ux(), def_->get_die_uy());
+    status = defwDieArea(def->get_die_lx(), def->get_die_ly(),
+                         def->get_die_ux(), def->get_die_uy());
     CHECK_STATUS(status);
 
     status = defwNewLine();
     CHECK_STATUS(status);
 
     // Rows
-    write_rows(def_);
+    write_rows(def);
 
     // Tracks
-    write_tracks(def_);
+    write_tracks(def);
 
     // GCell grid
-    write_gcell_grids(def_);
+    write_gcell_grids(def);
+
+    // Regions
+    write_regions(def);
 
     // Components
-    write_components(def_);
+    write_components(def);
 
     // Pins
-    write_pins(def_);
+    write_pins(def);
+
+    // Blockages
+    write_blockages(def);
 
     // Special Nets
-    write_special_nets(def_);
+    write_special_nets(def);
 
     // Nets
-    write_nets(def_);
+    write_nets(def);
+
+    // Groups
+    write_groups(def);
 
     status = defwEnd();
     CHECK_STATUS(status);
@@ -285,7 +526,738 @@ void DefWriter::write_def (def::Def& def, string filename)
     if (lineNumber == 0) {
         fprintf(stderr, "ERROR: nothing has been read.\n");
     }
-    fclose(fout);
 }
 
+/**
+ * Write @a def to @a filename with the defw library.
+ * @return False if @a filename could not be written.
+ */
+bool DefWriter::write_def (def::Def& def, string filename)
+{
+    def_ = &def;
+
+    FILE* fout = fopen(filename.c_str(), "w");
+    if (fout == nullptr) {
+        fprintf(stderr, "ERROR: could not open output file\n");
+        return false;
+    }
+
+    write_design(def_, fout);
+
+    auto ok = !ferror(fout);
+    ok = (fclose(fout) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write output file\n");
+    }
+    return ok;
+}
+
+
+
+
+/*
+ * A buffered DEF emitter producing the same text as the defw calls above.
+ * Note that defw closes a ROW statement lazily: its ";" is printed by the
+ * next defw call, which also adds a blank line unless it is another ROW.
+ */
+
+static const char* orient_strs[] = {"N", "W", "S", "E", "FN", "FW", "FS", "FE"};
+
+/**
+ * Append the name of the symbol @a id to @a buf.
+ */
+static util::TextBuffer& append_symbol (util::TextBuffer& buf, util::SymbolId id)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+    return buf.append(symbols.get_name(id), symbols.get_length(id));
+}
+
+static void emit_row (util::TextBuffer& buf, const def::Row& r)
+{
+    buf.append("ROW ").append(r.name_).append(' ').append(r.macro_).append(' ');
+    buf.append_int(r.x_).append(' ').append_int(r.y_).append(' ');
+    buf.append(0 <= r.orient_ && r.orient_ < 8 ? orient_strs[r.orient_] : "")
+       .append(' ');
+
+    if (r.num_x_ != 0 || r.num_y_ != 0) {
+        buf.append("DO ").append_int(r.num_x_)
+           .append(" BY ").append_int(r.num_y_).append(' ');
+
+        if (r.step_x_ != 0 || r.step_y_ != 0) {
+            buf.append("STEP ").append_int(r.step_x_)
+               .append(' ').append_int(r.step_y_).append(' ');
+        }
+    }
+}
+
+static void emit_track (util::TextBuffer& buf, const def::Track& t)
+{
+    buf.append("TRACKS ").append(t.direction_ == TrackDir::x ? "X " : "Y ");
+    buf.append_int(t.location_).append(" DO ").append_int(t.num_tracks_)
+       .append(" STEP ").append_int(t.step_)
+       .append(" LAYER ").append(t.layer_).append(" ;\n");
+}
+
+static void emit_gcell_grid (util::TextBuffer& buf, const def::GCellGrid& g)
+{
+    buf.append("GCELLGRID ").append(g.direction_ == TrackDir::x ? "X " : "Y ");
+    buf.append_int(g.location_).append(" DO ").append_int(g.num_)
+       .append(" STEP ").append_int(g.step_).append(" ;\n");
+}
+
+static void emit_component (util::TextBuffer& buf, const def::Component& c)
+{
+    append_symbol(buf.append("   - "), c.name_id_).append(' ');
+    append_symbol(buf, c.ref_name_id_).append(" \n      + ");
+
+    if (c.is_fixed_ || c.is_placed_) {
+        buf.append(c.is_fixed_ ? "FIXED ( " : "PLACED ( ");
+        buf.append_int(c.x_).append(' ').append_int(c.y_).append(" ) ");
+        buf.append(c.orient_str_.empty() ? string("N") : c.orient_str_);
+        buf.append(" ;\n");
+    }
+    else {
+        buf.append("UNPLACED ;\n");
+    }
+}
+
+static void emit_pin (util::TextBuffer& buf, const def::Pin& p)
+{
+    const char* direction_str = "INOUT";
+    if (p.dir_ == PinDir::input) {
+        direction_str = "INPUT";
+    }
+    else if (p.dir_ == PinDir::output) {
+        direction_str = "OUTPUT";
+    }
+
+    append_symbol(buf.append("   - "), p.name_id_).append(" + NET ");
+    append_symbol(buf, p.net_name_id_);
+    buf.append("\n      + DIRECTION ").append(direction_str);
+    buf.append("\n      + USE SIGNAL");
+    buf.append("\n      + FIXED ( ").append_int(p.x_).append(' ')
+       .append_int(p.y_).append(" ) ").append(p.orient_str_);
+    buf.append("\n      + LAYER ").append(p.layer_)
+       .append(" ( ").append_int(p.lx_).append(' ').append_int(p.ly_)
+       .append(" ) ( ").append_int(p.ux_).append(' ').append_int(p.uy_)
+       .append(" ) ;\n");
+}
+
+/**
+ * defw breaks the line before every fourth item of a special net, counting
+ * from the start of the net, of a path, or of its SHAPE.
+ */
+static void emit_special_item (util::TextBuffer& buf, unsigned& num_items)
+{
+    buf.append((++num_items & 3) == 0 ? "\n      " : " ");
+}
+
+static void emit_special_net (util::TextBuffer& buf, const def::SpecialNet& n,
+                              const def::SpecialShapes& shapes,
+                              const vector<uint32_t>& order, 
+                              const vector<uint32_t>& begin)
+{
+    using Shapes = def::SpecialShapes;
+
+    auto& symbols = util::SymbolTable::get_instance();
+
+    append_symbol(buf.append("   - "), n.name_id_);
+
+    unsigned num_items = 0;
+    for (auto& p : n.pins_) {
+        emit_special_item(buf, num_items);
+        buf.append("( ").append(symbols.get_name(p.first)).append(' ')
+           .append(symbols.get_name(p.second)).append(" ) ");
+    }
+
+    int path_status = -1;
+    for (auto i = begin[n.id_]; i < begin[n.id_ + 1]; i++) {
+        auto& s = shapes.get_shapes()[order[i]];
+        if (s.kind_ == Shapes::Kind::rect) {
+            continue;
+        }
+
+        if (path_status == static_cast<int>(s.get_status())) {
+            buf.append(" NEW");
+        }
+        else {
+            path_status = static_cast<int>(s.get_status());
+            buf.append("\n      + ").append(Shapes::get_status_name(s.get_status()));
+        }
+        num_items = 0;
+
+        emit_special_item(buf, num_items);
+        buf.append(shapes.get_layer_name(shapes.get_path_layer(s)));
+        emit_special_item(buf, num_items);
+        buf.append_int(s.width_);
+        if (s.get_shape_type() != 0) {
+            buf.append("\n      + SHAPE ")
+               .append(Shapes::get_shape_type_name(s.get_shape_type()));
+            num_items = 0;
+        }
+
+        emit_special_item(buf, num_items);
+        buf.append("( ").append_int(s.x1_).append(' ').append_int(s.y1_).append(" )");
+        emit_special_item(buf, num_items);
+        if (s.kind_ == Shapes::Kind::wire) {
+            buf.append("( ");
+            if (s.x2_ == s.x1_) {
+                buf.append('*');
+            }
+            else {
+                buf.append_int(s.x2_);
+            }
+            buf.append(' ');
+            if (s.y2_ == s.y1_) {
+                buf.append('*');
+            }
+            else {
+                buf.append_int(s.y2_);
+            }
+            buf.append(" )");
+        }
+        else {
+            buf.append(shapes.get_via_name(s));
+        }
+    }
+
+    for (auto i = begin[n.id_]; i < begin[n.id_ + 1]; i++) {
+        auto& s = shapes.get_shapes()[order[i]];
+        if (s.kind_ == Shapes::Kind::rect) {
+            buf.append("\n      + RECT ").append(shapes.get_layer_name(s.layer_))
+               .append(" ( ").append_int(s.x1_).append(' ').append_int(s.y1_)
+               .append(" ) ( ").append_int(s.x2_).append(' ').append_int(s.y2_)
+               .append(" ) ");
+        }
+    }
+
+    if (!n.use_.empty()) {
+        buf.append("\n      + USE ").append(n.use_);
+    }
+    buf.append(" ;\n");
+}
+
+/**
+ * Append the routed wires of @a n. As for a special net, defw breaks the
+ * line before every fourth item of a path, counting its layer.
+ */
+static void emit_net_wires (util::TextBuffer& buf, const def::Net& n)
+{
+    auto it = n.wires_.begin();
+    for (auto& p : n.wires_.get_paths()) {
+        if (p.new_wire_) {
+            append_symbol(buf.append("\n      + "), p.wire_type_);
+        }
+        else {
+            buf.append("\n         NEW");
+        }
+
+        unsigned num_items = 0;
+        if (p.layer_id_ != util::SymbolTable::invalid_symbol) {
+            num_items++;
+            append_symbol(buf.append(' '), p.layer_id_);
+        }
+        for (uint32_t i = 0; i < p.num_points_; i++, ++it) {
+            buf.append((++num_items & 3) == 0 ? "\n         " : " ");
+            buf.append("( ").append_int(it->x_).append(' ')
+               .append_int(it->y_).append(" )");
+            if (it->has_via_) {
+                buf.append((++num_items & 3) == 0 ? "\n         " : " ");
+                append_symbol(buf, it->via_);
+            }
+        }
+    }
+}
+
+static void emit_net (util::TextBuffer& buf, const def::Net& n)
+{
+    append_symbol(buf.append("   - "), n.name_id_);
+
+    // defw breaks the line before every fourth connection.
+    unsigned num_items = 0;
+    for (auto& con : n.connections_) {
+        if ((++num_items & 3) == 0) {
+            buf.append("\n");
+        }
+        buf.append(" ( ");
+        if (con.component_ != nullptr) {
+            append_symbol(buf, con.component_->name_id_).append(' ')
+                .append(con.lef_pin_->name_);
+        }
+        else {
+            append_symbol(buf.append("PIN "), con.pin_->name_id_);
+        }
+        buf.append(" ) ");
+    }
+    emit_net_wires(buf, n);
+
+    buf.append(" ;\n");
+}
+
+static void emit_region (util::TextBuffer& buf, const def::Region& r)
+{
+    buf.append("   - ").append(r.name_);
+    for (auto& b : r.boxes_) {
+        buf.append("       ( ").append_int(b.lx_).append(' ').append_int(b.ly_)
+           .append(" ) ( ").append_int(b.ux_).append(' ').append_int(b.uy_)
+           .append(" )");
+    }
+    if (r.type_ != RegionType::na) {
+        buf.append("          + TYPE ")
+           .append(r.type_ == RegionType::fence ? "FENCE" : "GUIDE");
+    }
+    buf.append(" ;\n");
+}
+
+static void emit_blockage (util::TextBuffer& buf, const def::Blockage& b)
+{
+    if (b.is_placement()) {
+        buf.append("   - PLACEMENT");
+    }
+    else {
+        buf.append("   - LAYER ").append(b.layer_);
+    }
+    if (!b.component_.empty()) {
+        buf.append("\n     + COMPONENT ").append(b.component_);
+    }
+    if (b.is_pushdown_) {
+        buf.append("\n     + PUSHDOWN");
+    }
+    if (b.is_placement() && b.is_soft_) {
+        buf.append("\n     + SOFT");
+    }
+    if (b.is_placement() && b.max_density_ != 0) {
+        // defw prints the density with "%.11g".
+        char density[32];
+        auto len = snprintf(density, sizeof(density), "%.11g", b.max_density_);
+        buf.append("\n     + PARTIAL ").append(density, len);
+    }
+    for (auto& r : b.boxes_) {
+        buf.append("\n     RECT ( ").append_int(r.lx_).append(' ').append_int(r.ly_)
+           .append(" ) ( ").append_int(r.ux_).append(' ').append_int(r.uy_)
+           .append(" )");
+    }
+    buf.append(" ;\n");
+}
+
+static void emit_group (util::TextBuffer& buf, const def::Group& g, 
+                        const vector<def::RegionPtr>& regions)
+{
+    buf.append("   - ").append(g.name_);
+    for (auto& p : g.patterns_) {
+        buf.append(' ').append(p);
+    }
+    if (g.region_ >= 0) {
+        buf.append("\n      + REGION ").append(regions[g.region_]->name_);
+    }
+    buf.append(" ;\n");
+}
+
+/**
+ * Format @a objects with @a emit into per-chunk buffers on @a num_threads
+ * threads, and write the buffers to @a fp in order.
+ */
+template <typename Vec, typename Emit>
+static bool emit_section (FILE* fp, const Vec& objects, int num_threads, Emit emit)
+{
+    auto buffers = util::format_chunks(objects.size(), num_threads, 
+                       [&] (util::TextBuffer& buf, size_t i) { emit(buf, *objects[i]); });
+
+    bool ok = true;
+    for (auto& buf : buffers) {
+        ok = buf.write(fp) && ok;
+    }
+    return ok;
+}
+
+/**
+ * Write @a def to @a filename without the defw library. The output is the
+ * same as that of write_def(), but the COMPONENTS, PINS and NETS sections
+ * are formatted on @a num_threads threads.
+ * @return False if @a filename could not be written.
+ */
+bool DefWriter::write_def_buffered (def::Def& def, string filename, int num_threads)
+{
+    def_ = &def;
+
+    auto fout = unique_ptr<FILE, decltype(&fclose)>(
+                    fopen(filename.c_str(), "w"), &fclose);
+    if (fout == nullptr) {
+        fprintf(stderr, "ERROR: could not open output file\n");
+        return false;
+    }
+    auto fp = fout.get();
+
+    util::TextBuffer buf;
+    buf.append("VERSION 5.8 ;\nDIVIDERCHAR \"/\" ;\nBUSBITCHARS \"[]\" ;\n");
+    buf.append("DESIGN ").append(def.get_design_name()).append(" ;\n");
+    buf.append("UNITS DISTANCE MICRONS ").append_int(def.get_dbu()).append(" ;\n");
+    buf.append("\n");
+    buf.append("HISTORY Placed with ComPLx. ;\n");
+    buf.append("\n");
+    buf.append("DIEAREA ( ").append_int(def.get_die_lx()).append(' ')
+       .append_int(def.get_die_ly()).append(" ) ( ").append_int(def.get_die_ux())
+       .append(' ').append_int(def.get_die_uy()).append(" ) ;\n");
+    buf.append("\n");
+
+    // Rows, tracks and gcell grids, with the lazy ";" of the last row.
+    auto& rows = def.get_rows();
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (i > 0) {
+            buf.append(";\n");
+        }
+        emit_row(buf, *rows[i]);
+    }
+    auto row_open = !rows.empty();
+
+    auto& tracks = def.get_tracks();
+    for (auto& t : tracks) {
+        if (row_open) {
+            buf.append(";\n\n");
+            row_open = false;
+        }
+        emit_track(buf, *t);
+    }
+    buf.append("\n");
+
+    auto& gcell_grids = def.get_gcell_grids();
+    for (auto& g : gcell_grids) {
+        if (row_open) {
+            buf.append(";\n\n");
+            row_open = false;
+        }
+        emit_gcell_grid(buf, *g);
+    }
+    buf.append("\n");
+
+    if (row_open) {
+        buf.append(";\n\n");
+    }
+
+    // Regions
+    auto& regions = def.get_regions();
+    if (!regions.empty()) {
+        buf.append("REGIONS ").append_int(regions.size()).append(" ;\n");
+        for (auto& r : regions) {
+            emit_region(buf, *r);
+        }
+        buf.append("END REGIONS\n\n");
+    }
+
+    // Components
+    auto& components = def.get_components();
+    buf.append("COMPONENTS ").append_int(components.size()).append(" ;\n");
+    bool ok = buf.write(fp);
+    buf.clear();
+
+    ok = emit_section(fp, components, num_threads, emit_component) && ok;
+    buf.append("END COMPONENTS\n\n");
+
+    // Pins
+    auto& pins = def.get_pins();
+    buf.append("PINS ").append_int(pins.size()).append(" ;\n");
+    ok = buf.write(fp) && ok;
+    buf.clear();
+
+    ok = emit_section(fp, pins, num_threads, emit_pin) && ok;
+    buf.append("END PINS\n\n");
+
+    // Blockages
+    auto& blockages = def.get_blockages();
+    if (!blockages.empty()) {
+        buf.append("BLOCKAGES ").append_int(blockages.size()).append(" ;\n");
+        for (auto& b : blockages) {
+            emit_blockage(buf, *b);
+        }
+        buf.append("END BLOCKAGES\n\n");
+    }
+
+    // Special nets
+    auto& special_nets = def.get_special_nets();
+    vector<uint32_t> begin;
+    auto order = order_special_shapes(def, begin);
+    buf.append("SPECIALNETS ").append_int(special_nets.size()).append(" ;\n");
+    ok = buf.write(fp) && ok;
+    buf.clear();
+
+    ok = emit_section(fp, special_nets, num_threads, 
+             [&] (util::TextBuffer& b, const def::SpecialNet& n) { 
+                 emit_special_net(b, n, def.get_special_shapes(), order, begin); 
+             }) && ok;
+    buf.append("END SPECIALNETS\n\n");
+
+    // Nets
+    auto& nets = def.get_nets();
+    buf.append("NETS ").append_int(nets.size()).append(" ;\n");
+    ok = buf.write(fp) && ok;
+    buf.clear();
+
+    ok = emit_section(fp, nets, num_threads, emit_net) && ok;
+    buf.append("END NETS\n\n");
+
+    // Groups
+    auto& groups = def.get_groups();
+    if (!groups.empty()) {
+        buf.append("GROUPS ").append_int(groups.size()).append(" ;\n");
+        for (auto& g : groups) {
+            emit_group(buf, *g, regions);
+        }
+        buf.append("END GROUPS\n\n");
+    }
+
+    buf.append("END DESIGN\n\n");
+    ok = buf.write(fp) && ok;
+    ok = (fflush(fp) == 0) && ok;
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write output file\n");
+    }
+    return ok;
+}
+
+
+/*
+ * Rewriting a DEF file in place of regenerating it. Everything but the
+ * placements and macros of the moved components is passed through from the
+ * file read.
+ */
+
+/**
+ * Copies byte ranges of a source file to an output file, interleaved with
+ * text. Small ranges are buffered; large ones are copied in the kernel with
+ * copy_file_range(), or written from the mapping where it is not supported.
+ */
+class PassThroughWriter
+{
+public:
+    PassThroughWriter (const util::MappedFile& src, int src_fd, int dst_fd)
+        : src_(src), src_fd_(src_fd), dst_fd_(dst_fd), 
+          use_copy_file_range_(true), ok_(true) {}
+
+    util::TextBuffer& text () { return buf_; }
+
+    void copy (size_t begin, size_t end)
+    {
+        const size_t min_copy_size = 64 * 1024;
 
+        if (end - begin < min_copy_size) {
+            buf_.append(src_.get_data() + begin, end - begin);
+            return;
+        }
+
+        flush();
+        while (ok_ && begin < end && use_copy_file_range_) {
+            loff_t off_in = begin;
+            auto n = copy_file_range(src_fd_, &off_in, dst_fd_, nullptr, 
+                                     end - begin, 0);
+            if (n > 0) {
+                begin += n;
+            }
+            else if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            else {
+                // EXDEV, ENOSYS, EINVAL, ...: fall back to write().
+                use_copy_file_range_ = false;
+            }
+        }
+        write_all(src_.get_data() + begin, end - begin);
+    }
+
+    bool flush ()
+    {
+        write_all(buf_.data(), buf_.size());
+        buf_.clear();
+        return ok_;
+    }
+
+private:
+    const util::MappedFile& src_;
+    int src_fd_;
+    int dst_fd_;
+    bool use_copy_file_range_;
+    bool ok_;
+    util::TextBuffer buf_;
+
+    void write_all (const char* data, size_t size)
+    {
+        while (ok_ && size > 0) {
+            auto n = ::write(dst_fd_, data, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            ok_ = (n > 0);
+            data += std::max<ssize_t>(n, 0);
+            size -= std::max<ssize_t>(n, 0);
+        }
+    }
+};
+
+static inline bool is_space (char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @return The whitespace-delimited word at or after @a pos in [pos, end),
+ *         as [first, second).
+ */
+static pair<size_t, size_t> next_word (const char* data, size_t pos, size_t end)
+{
+    while (pos < end && is_space(data[pos])) {
+        pos++;
+    }
+    auto begin = pos;
+    while (pos < end && !is_space(data[pos])) {
+        pos++;
+    }
+    return make_pair(begin, pos);
+}
+
+static bool word_equals (const char* data, pair<size_t, size_t> w, const char* str)
+{
+    auto len = strlen(str);
+    return w.second - w.first == len && memcmp(data + w.first, str, len) == 0;
+}
+
+/**
+ * @return The byte range of the placement "+ PLACED ( x y ) orient" (or
+ *         FIXED, COVER, UNPLACED) in the statement [begin, end), or an empty
+ *         range at @a end if there is none.
+ */
+static pair<size_t, size_t> find_placement (const char* data, size_t begin, size_t end)
+{
+    auto w = next_word(data, begin, end);
+    while (w.first < end) {
+        if (word_equals(data, w, "+")) {
+            auto plus = w.first;
+            w = next_word(data, w.second, end);
+            if (word_equals(data, w, "UNPLACED")) {
+                return make_pair(plus, w.second);
+            }
+            if (word_equals(data, w, "PLACED") || word_equals(data, w, "FIXED")
+                || word_equals(data, w, "COVER")) {
+                // "( x y ) orient"
+                for (int i = 0; i < 5 && w.first < end; i++) {
+                    w = next_word(data, w.second, end);
+                }
+                return make_pair(plus, w.second);
+            }
+            continue;
+        }
+        w = next_word(data, w.second, end);
+    }
+    return make_pair(end, end);
+}
+
+static void emit_placement (util::TextBuffer& buf, const def::Component& c)
+{
+    buf.append(c.is_fixed_ ? "+ FIXED ( " : "+ PLACED ( ");
+    buf.append_int(c.x_).append(' ').append_int(c.y_).append(" ) ");
+    buf.append(c.orient_str_.empty() ? string("N") : c.orient_str_);
+}
+
+/**
+ * Rewrite the DEF file @a def was read from to @a filename. Sections are
+ * copied as they are, except that the placements and the macros of the
+ * moved components are replaced in COMPONENTS. Attributes not kept by Def (SOURCE, WEIGHT,
+ * ...) and sections not parsed (PROPERTYDEFINITIONS, VIAS, ...) survive.
+ * @return False if the file read is not available or changed, in which case
+ *         nothing is written, or if @a filename could not be written.
+ */
+bool DefWriter::rewrite_def (def::Def& def, string filename)
+{
+    def_ = &def;
+
+    auto section = def.find_section("COMPONENTS");
+    if (section == nullptr || !def.is_file_unchanged()) {
+        fprintf(stderr, "ERROR: %s is not available for a rewrite\n", 
+                def.get_filename().c_str());
+        return false;
+    }
+
+    util::MappedFile src(def.get_filename());
+    auto src_fd = open(def.get_filename().c_str(), O_RDONLY);
+    if (src_fd < 0) {
+        fprintf(stderr, "ERROR: could not open input file\n");
+        return false;
+    }
+    auto dst_fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dst_fd < 0) {
+        close(src_fd);
+        fprintf(stderr, "ERROR: could not open output file\n");
+        return false;
+    }
+
+    PassThroughWriter out(src, src_fd, dst_fd);
+    auto data = src.get_data();
+    auto& components = def.get_components();
+    auto& symbols = util::SymbolTable::get_instance();
+
+    // Component statements "- name ref ... ;" are in the order of their ids
+    // unless names say otherwise.
+    size_t copied = 0;
+    size_t next_id = 0;
+    auto pos = section->body_begin_;
+    while (def.get_num_moved_components() > 0 && pos < section->body_end_) {
+        auto semi = static_cast<const char*>(
+                        memchr(data + pos, ';', section->body_end_ - pos));
+        if (semi == nullptr) {
+            break;
+        }
+        auto end = static_cast<size_t>(semi - data);
+
+        auto dash = next_word(data, pos, end);
+        auto name = next_word(data, dash.second, end);
+        auto len = name.second - name.first;
+
+        def::ComponentPtr c = nullptr;
+        if (next_id < components.size() 
+            && symbols.get_length(components[next_id]->name_id_) == len
+            && memcmp(symbols.get_name(components[next_id]->name_id_), 
+                      data + name.first, len) == 0) {
+            c = components[next_id];
+        }
+        else {
+            c = def.get_component(string(data + name.first, len));
+        }
+
+        if (c != nullptr) {
+            next_id = c->id_ + 1;
+
+            if (def.is_component_moved(c->id_)) {
+                // A swapped component gets the name of its new macro.
+                auto ref = next_word(data, name.second, end);
+                if (!word_equals(data, ref, symbols.get_name(c->ref_name_id_))) {
+                    out.copy(copied, ref.first);
+                    append_symbol(out.text(), c->ref_name_id_);
+                    copied = ref.second;
+                }
+
+                auto placement = find_placement(data, name.second, end);
+                out.copy(copied, placement.first);
+                if (placement.first == end) {
+                    out.text().append(' ');
+                    emit_placement(out.text(), *c);
+                    out.text().append(' ');
+                }
+                else {
+                    emit_placement(out.text(), *c);
+                }
+                copied = placement.second;
+            }
+        }
+
+        pos = end + 1;
+    }
+    out.copy(copied, src.get_size());
+
+    auto ok = out.flush();
+    ok = (close(dst_fd) == 0) && ok;
+    close(src_fd);
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not write output file\n");
+    }
+    return ok;
+}
@@ -22,7 +22,9 @@ class DefWriter
 public:
     static DefWriter& get_instance ();
 
-    void write_def (def::Def& def, string filename);
+    bool write_def (def::Def& def, string filename);
+    bool write_def_buffered (def::Def& def, string filename, int num_threads = 1);
+    bool rewrite_def (def::Def& def, string filename);
 
 private:
     def::Def* def_;
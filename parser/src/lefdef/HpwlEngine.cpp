@@ -0,0 +1,382 @@
+/**
+ * @file    HpwlEngine.cpp
+ */
+
+#include "HpwlEngine.h"
+#include "Def.h"
+#include "Parallel.h"
+
+using namespace std;
+
+namespace def
+{
+
+HpwlEngine::HpwlEngine () : hpwl_(0), stamp_(0)
+{
+    //
+}
+
+/**
+ * Pins are placed at the centers of their boxes. Component pins are kept
+ * as offsets from the component origin, taken from the pin box table of the
+ * macro in the orientation of the component; IO pins as positions relative
+ * to a fixed origin at (0, 0). Pins of unplaced components are left out.
+ */
+void HpwlEngine::build (const Def& def, int num_threads)
+{
+    auto& components = def.get_components();
+    auto& nets = def.get_nets();
+    const auto num_components = static_cast<uint32_t>(components.size());
+
+    comp_x_.assign(num_components + 1, 0);
+    comp_y_.assign(num_components + 1, 0);
+    for (auto& c : components) {
+        comp_x_[c->id_] = c->x_;
+        comp_y_[c->id_] = c->y_;
+    }
+
+    size_t num_pins = 0;
+    for (auto& n : nets) {
+        num_pins += n->connections_.size();
+    }
+
+    net_pin_begin_.clear();
+    net_pin_begin_.reserve(nets.size() + 1);
+    pin_comp_.clear();
+    pin_net_.clear();
+    pin_off_x_.clear();
+    pin_off_y_.clear();
+    pin_comp_.reserve(num_pins);
+    pin_net_.reserve(num_pins);
+    pin_off_x_.reserve(num_pins);
+    pin_off_y_.reserve(num_pins);
+
+    for (auto& n : nets) {
+        net_pin_begin_.push_back(pin_comp_.size());
+
+        for (auto& con : n->connections_) {
+            int64_t cx, cy;
+            uint32_t comp;
+
+            if (!is_placed(con)) {
+                continue;
+            }
+            if (con.component_ != nullptr) {
+                auto& c = *con.component_;
+                auto& b = c.lef_macro_->get_pin_box(con.pin_index_, c.orient_);
+                comp = c.id_;
+                cx = (static_cast<int64_t>(b.lx_) + b.ux_) / 2;
+                cy = (static_cast<int64_t>(b.ly_) + b.uy_) / 2;
+            }
+            else if (con.pin_ != nullptr) {
+                auto b = get_connection_box(con);
+                comp = num_components;
+                cx = (static_cast<int64_t>(b.lx_) + b.ux_) / 2;
+                cy = (static_cast<int64_t>(b.ly_) + b.uy_) / 2;
+            }
+            else {
+                continue;
+            }
+
+            pin_comp_.push_back(comp);
+            pin_net_.push_back(n->id_);
+            pin_off_x_.push_back(static_cast<int>(cx));
+            pin_off_y_.push_back(static_cast<int>(cy));
+        }
+    }
+    net_pin_begin_.push_back(pin_comp_.size());
+    num_pins = pin_comp_.size();
+
+    // Component -> pins, in pin order.
+    comp_pin_begin_.assign(num_components + 2, 0);
+    for (auto comp : pin_comp_) {
+        comp_pin_begin_[comp + 1]++;
+    }
+    for (size_t i = 1; i < comp_pin_begin_.size(); i++) {
+        comp_pin_begin_[i] += comp_pin_begin_[i - 1];
+    }
+    comp_pins_.resize(num_pins);
+    {
+        auto next = comp_pin_begin_;
+        for (uint32_t p = 0; p < num_pins; p++) {
+            comp_pins_[next[pin_comp_[p]]++] = p;
+        }
+    }
+
+    pin_x_.resize(num_pins);
+    pin_y_.resize(num_pins);
+
+    auto num_nets = nets.size();
+    net_lx_.assign(num_nets, 0);
+    net_ly_.assign(num_nets, 0);
+    net_ux_.assign(num_nets, 0);
+    net_uy_.assign(num_nets, 0);
+    num_lx_.assign(num_nets, 0);
+    num_ly_.assign(num_nets, 0);
+    num_ux_.assign(num_nets, 0);
+    num_uy_.assign(num_nets, 0);
+
+    net_stamp_.assign(num_nets, 0);
+    net_dirty_.assign(num_nets, 0);
+    touched_nets_.clear();
+    dirty_nets_.clear();
+    stamp_ = 0;
+
+    recompute(num_threads);
+}
+
+/**
+ * Pin positions are gathered into flat arrays first, so the box of a net is
+ * a plain min/max reduction over a contiguous range.
+ */
+int64_t HpwlEngine::recompute (int num_threads)
+{
+    const size_t chunk_size = 16 * 1024;
+    auto num_pins = pin_comp_.size();
+    auto num_nets = net_lx_.size();
+
+    util::parallel_for((num_pins + chunk_size - 1) / chunk_size, num_threads,
+                       [&] (size_t chunk) {
+        auto begin = chunk * chunk_size;
+        auto end = std::min(num_pins, begin + chunk_size);
+        auto comp = pin_comp_.data();
+        auto cx = comp_x_.data();
+        auto cy = comp_y_.data();
+        auto ox = pin_off_x_.data();
+        auto oy = pin_off_y_.data();
+        auto px = pin_x_.data();
+        auto py = pin_y_.data();
+        for (auto i = begin; i < end; i++) {
+            px[i] = cx[comp[i]] + ox[i];
+            py[i] = cy[comp[i]] + oy[i];
+        }
+    });
+
+    auto num_chunks = (num_nets + chunk_size - 1) / chunk_size;
+    vector<int64_t> partial(num_chunks, 0);
+    util::parallel_for(num_chunks, num_threads, [&] (size_t chunk) {
+        auto begin = chunk * chunk_size;
+        auto end = std::min(num_nets, begin + chunk_size);
+        int64_t sum = 0;
+        for (auto n = begin; n < end; n++) {
+            compute_net(n);
+            sum += get_net_hpwl(n);
+        }
+        partial[chunk] = sum;
+    });
+
+    hpwl_ = std::accumulate(partial.begin(), partial.end(), int64_t(0));
+    return hpwl_;
+}
+
+void HpwlEngine::compute_net (uint32_t net)
+{
+    auto begin = net_pin_begin_[net];
+    auto end = net_pin_begin_[net + 1];
+    if (begin == end) {
+        net_lx_[net] = net_ly_[net] = net_ux_[net] = net_uy_[net] = 0;
+        num_lx_[net] = num_ly_[net] = num_ux_[net] = num_uy_[net] = 0;
+        return;
+    }
+
+    auto px = pin_x_.data();
+    auto py = pin_y_.data();
+
+    int lx = px[begin], ux = px[begin];
+    int ly = py[begin], uy = py[begin];
+    for (auto i = begin + 1; i < end; i++) {
+        lx = std::min(lx, px[i]);
+        ux = std::max(ux, px[i]);
+        ly = std::min(ly, py[i]);
+        uy = std::max(uy, py[i]);
+    }
+
+    uint32_t nlx = 0, nux = 0, nly = 0, nuy = 0;
+    for (auto i = begin; i < end; i++) {
+        nlx += (px[i] == lx);
+        nux += (px[i] == ux);
+        nly += (py[i] == ly);
+        nuy += (py[i] == uy);
+    }
+
+    net_lx_[net] = lx;
+    net_ux_[net] = ux;
+    net_ly_[net] = ly;
+    net_uy_[net] = uy;
+    num_lx_[net] = nlx;
+    num_ux_[net] = nux;
+    num_ly_[net] = nly;
+    num_uy_[net] = nuy;
+}
+
+/**
+ * Update the lower side @a lo (with @a num pins on it) for a pin moving
+ * from @a old_v to @a new_v.
+ * @return False if the side must be found again by a scan.
+ */
+static inline bool move_on_lower_side (int& lo, uint32_t& num, int old_v, int new_v)
+{
+    if (new_v < lo) {
+        lo = new_v;
+        num = 1;
+    }
+    else if (new_v == lo) {
+        num += (old_v != lo);
+    }
+    else if (old_v == lo) {
+        return --num > 0;
+    }
+    return true;
+}
+
+static inline bool move_on_upper_side (int& hi, uint32_t& num, int old_v, int new_v)
+{
+    if (new_v > hi) {
+        hi = new_v;
+        num = 1;
+    }
+    else if (new_v == hi) {
+        num += (old_v != hi);
+    }
+    else if (old_v == hi) {
+        return --num > 0;
+    }
+    return true;
+}
+
+void HpwlEngine::move_pin (uint32_t pin, int new_x, int new_y)
+{
+    auto net = pin_net_[pin];
+    auto old_x = pin_x_[pin];
+    auto old_y = pin_y_[pin];
+    pin_x_[pin] = new_x;
+    pin_y_[pin] = new_y;
+
+    if (net_dirty_[net]) {
+        return;
+    }
+
+    auto ok = move_on_lower_side(net_lx_[net], num_lx_[net], old_x, new_x);
+    ok = move_on_upper_side(net_ux_[net], num_ux_[net], old_x, new_x) && ok;
+    ok = move_on_lower_side(net_ly_[net], num_ly_[net], old_y, new_y) && ok;
+    ok = move_on_upper_side(net_uy_[net], num_uy_[net], old_y, new_y) && ok;
+
+    if (!ok) {
+        net_dirty_[net] = 1;
+        dirty_nets_.push_back(net);
+    }
+}
+
+/**
+ * Apply @a moves, saving the touched nets to @a saved if given.
+ * @return The change of the total HPWL.
+ */
+int64_t HpwlEngine::update_moves (const vector<Move>& moves, vector<NetState>* saved)
+{
+    if (++stamp_ == 0) {
+        std::fill(net_stamp_.begin(), net_stamp_.end(), 0);
+        stamp_ = 1;
+    }
+    touched_nets_.clear();
+    dirty_nets_.clear();
+
+    int64_t old_hpwl = 0;
+    for (auto& m : moves) {
+        comp_x_[m.component_] = m.x_;
+        comp_y_[m.component_] = m.y_;
+
+        for (auto i = comp_pin_begin_[m.component_];
+             i < comp_pin_begin_[m.component_ + 1]; i++) {
+            auto pin = comp_pins_[i];
+            auto net = pin_net_[pin];
+
+            if (net_stamp_[net] != stamp_) {
+                net_stamp_[net] = stamp_;
+                touched_nets_.push_back(net);
+                old_hpwl += get_net_hpwl(net);
+                if (saved) {
+                    saved->push_back({net, net_lx_[net], net_ly_[net],
+                                      net_ux_[net], net_uy_[net],
+                                      num_lx_[net], num_ly_[net],
+                                      num_ux_[net], num_uy_[net]});
+                }
+            }
+
+            move_pin(pin, m.x_ + pin_off_x_[pin], m.y_ + pin_off_y_[pin]);
+        }
+    }
+
+    for (auto net : dirty_nets_) {
+        compute_net(net);
+        net_dirty_[net] = 0;
+    }
+
+    int64_t new_hpwl = 0;
+    for (auto net : touched_nets_) {
+        new_hpwl += get_net_hpwl(net);
+    }
+
+    hpwl_ += new_hpwl - old_hpwl;
+    return new_hpwl - old_hpwl;
+}
+
+int64_t HpwlEngine::apply_moves (const vector<Move>& moves)
+{
+    return update_moves(moves, nullptr);
+}
+
+int64_t HpwlEngine::evaluate_moves (const vector<Move>& moves)
+{
+    // Positions before the moves. Undone in reverse order, a component
+    // ends at the position before its first move.
+    vector<Move> undo;
+    undo.reserve(moves.size());
+    for (auto& m : moves) {
+        undo.push_back({m.component_, comp_x_[m.component_], comp_y_[m.component_]});
+    }
+
+    vector<NetState> saved;
+    auto delta = update_moves(moves, &saved);
+
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+        auto& u = *it;
+        comp_x_[u.component_] = u.x_;
+        comp_y_[u.component_] = u.y_;
+        for (auto i = comp_pin_begin_[u.component_];
+             i < comp_pin_begin_[u.component_ + 1]; i++) {
+            auto pin = comp_pins_[i];
+            pin_x_[pin] = u.x_ + pin_off_x_[pin];
+            pin_y_[pin] = u.y_ + pin_off_y_[pin];
+        }
+    }
+    for (auto& s : saved) {
+        net_lx_[s.net_] = s.lx_;
+        net_ly_[s.net_] = s.ly_;
+        net_ux_[s.net_] = s.ux_;
+        net_uy_[s.net_] = s.uy_;
+        num_lx_[s.net_] = s.num_lx_;
+        num_ly_[s.net_] = s.num_ly_;
+        num_ux_[s.net_] = s.num_ux_;
+        num_uy_[s.net_] = s.num_uy_;
+    }
+    hpwl_ -= delta;
+
+    return delta;
+}
+
+int64_t HpwlEngine::get_hpwl () const
+{
+    return hpwl_;
+}
+
+size_t HpwlEngine::get_num_nets () const
+{
+    return net_lx_.size();
+}
+
+size_t HpwlEngine::get_num_pins () const
+{
+    return pin_comp_.size();
+}
+
+}   // End of namespace def
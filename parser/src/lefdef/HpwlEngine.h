@@ -0,0 +1,152 @@
+/**
+ * @file    HpwlEngine.h
+ */
+
+#ifndef HPWL_ENGINE_H
+#define HPWL_ENGINE_H
+
+#include "common_header.h"
+
+namespace def
+{
+
+// Forward declaration.
+class Def;
+
+/**
+ * Half-perimeter wirelength of the nets of a Def, kept up to date under
+ * component moves.
+ *
+ * Pins, nets and components are held in flat arrays: the pins of a net are
+ * contiguous, and each component lists its pins. Each net caches its
+ * bounding box and the number of pins on each of its four sides. A move
+ * updates the boxes of the nets of the moved component; a net is scanned
+ * again only if the last pin on a side moved inward.
+ *
+ * The engine keeps its own copy of the component positions; moving
+ * components here does not change the Def, and vice versa.
+ */
+class HpwlEngine
+{
+public:
+    /**
+     * Move of the component id_ to (x_, y_).
+     */
+    struct Move
+    {
+        uint32_t component_;
+        int x_;
+        int y_;
+    };
+
+    HpwlEngine ();
+
+    /**
+     * Take the nets and the component positions of @a def, and compute the
+     * bounding boxes of all nets on @a num_threads threads.
+     */
+    void build (const Def& def, int num_threads = 1);
+
+    /**
+     * Recompute the bounding boxes of all nets from the pin positions.
+     * @return The total HPWL.
+     */
+    int64_t recompute (int num_threads = 1);
+
+    /**
+     * Apply @a moves in order.
+     * @return The change of the total HPWL.
+     */
+    int64_t apply_moves (const vector<Move>& moves);
+
+    /**
+     * @return The change of the total HPWL @a moves would make; the state is
+     *         left as it is.
+     */
+    int64_t evaluate_moves (const vector<Move>& moves);
+
+    int64_t get_hpwl () const;
+    int64_t get_net_hpwl (uint32_t net) const;
+
+    size_t get_num_nets () const;
+    size_t get_num_pins () const;
+
+    /**
+     * @return The position of the pin @a pin (index in the pin arrays).
+     */
+    int get_pin_x (uint32_t pin) const;
+    int get_pin_y (uint32_t pin) const;
+
+private:
+    // Components; the last entry is a fixed origin for IO pins.
+    vector<int> comp_x_;
+    vector<int> comp_y_;
+    vector<uint32_t> comp_pin_begin_;   ///< CSR: component -> pins.
+    vector<uint32_t> comp_pins_;
+
+    // Pins, grouped by net.
+    vector<uint32_t> pin_comp_;
+    vector<uint32_t> pin_net_;
+    vector<int> pin_off_x_;     ///< Offset from the component origin.
+    vector<int> pin_off_y_;
+    vector<int> pin_x_;         ///< Position, kept up to date.
+    vector<int> pin_y_;
+
+    // Nets.
+    vector<uint32_t> net_pin_begin_;    ///< CSR: net -> pins.
+    vector<int> net_lx_;
+    vector<int> net_ly_;
+    vector<int> net_ux_;
+    vector<int> net_uy_;
+    vector<uint32_t> num_lx_;   ///< Number of pins at lx_, and so on.
+    vector<uint32_t> num_ly_;
+    vector<uint32_t> num_ux_;
+    vector<uint32_t> num_uy_;
+
+    int64_t hpwl_;
+
+    /**
+     * A net box saved before a tentative move.
+     */
+    struct NetState
+    {
+        uint32_t net_;
+        int lx_, ly_, ux_, uy_;
+        uint32_t num_lx_, num_ly_, num_ux_, num_uy_;
+    };
+
+    // Nets touched by the current batch of moves (stamped with stamp_), and
+    // the ones to rescan.
+    vector<uint32_t> net_stamp_;
+    vector<uint8_t> net_dirty_;
+    vector<uint32_t> touched_nets_;
+    vector<uint32_t> dirty_nets_;
+    uint32_t stamp_;
+
+    void compute_net (uint32_t net);
+    void move_pin (uint32_t pin, int new_x, int new_y);
+    int64_t update_moves (const vector<Move>& moves, vector<NetState>* saved);
+};
+
+inline int HpwlEngine::get_pin_x (uint32_t pin) const
+{
+    return pin_x_[pin];
+}
+
+inline int HpwlEngine::get_pin_y (uint32_t pin) const
+{
+    return pin_y_[pin];
+}
+
+inline int64_t HpwlEngine::get_net_hpwl (uint32_t net) const
+{
+    if (net_pin_begin_[net + 1] - net_pin_begin_[net] < 2) {
+        return 0;
+    }
+    return static_cast<int64_t>(net_ux_[net]) - net_lx_[net]
+           + static_cast<int64_t>(net_uy_[net]) - net_ly_[net];
+}
+
+}   // End of namespace def
+
+#endif
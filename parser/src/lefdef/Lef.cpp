@@ -8,14 +8,40 @@
 
 #include "Lef.h"
 #include "StringUtil.h"
+#include "Arena.h"
+#include "MappedFile.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 #include <iostream>
 #include <cassert>
+#include <regex>
 
 using namespace std;
 
 namespace lef
 {
 
+/**
+ * Arenas keeping the macros, pins, and ports of the LEF libraries.
+ * Smart pointers handed out by Lef alias this storage.
+ */
+struct LibraryStorage : public std::enable_shared_from_this<LibraryStorage>
+{
+    util::Arena<Macro> macros_;
+    util::Arena<Pin>   pins_;
+    util::Arena<Port>  ports_;
+
+    LibraryStorage () : macros_(256), pins_(1024), ports_(1024) {}
+
+    template <typename T, typename... Args>
+    shared_ptr<T> create (util::Arena<T>& arena, Args&&... args)
+    {
+        return shared_ptr<T>(shared_from_this(), 
+                             arena.create(std::forward<Args>(args)...));
+    }
+};
+
 /**
  * Implementation of the class Lef.
  */
@@ -29,21 +55,32 @@ struct Lef::Impl
 
     Unit unit_;
 
+    shared_ptr<LibraryStorage> storage_;
+
     vector<SitePtr>  sites_;
     vector<LayerPtr> layers_;
     vector<ViaPtr>   vias_;
-    vector<ObstPtr>  obsts_;
     vector<PinPtr>   pins_;
 
     vector<MacroPtr> macros_;
 
     unordered_map<string, MacroPtr> macro_umap_;
     unordered_map<string, LayerPtr> layer_umap_;
+    unordered_map<util::SymbolId, MacroPtr> macro_sym_umap_;
+
+    vector<CellFamily> cell_families_;
+    string family_pattern_ = "^SNPS(H|L|R|SL)OPT25_.+_([0-9]+)$";
+    bool family_match_width_ = true;
 
     double min_x_pitch_ = 987654321.0;
     double min_y_pitch_ = 987654321.0;
     int    min_x_pitch_dbu_ = 987654321;
     int    min_y_pitch_dbu_ = 987654321;
+
+    // Set while reading a LEF file, for the LEF cache.
+    bool has_units_ = false;        ///< The file has a UNITS DATABASE.
+
+    Impl () : storage_(make_shared<LibraryStorage>()) {}
 };
 
 /* Constructors and destructor. */
@@ -58,10 +95,44 @@ Lef& Lef::get_instance ()
     return lef;
 }
 
+// Header of a LEF cache file, followed by the payload.
+static const char lef_cache_magic[8] = {'L', 'E', 'F', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t lef_cache_version = 4;
+
+struct LefCacheHeader
+{
+    char magic_[8];
+    uint32_t version_;          ///< lef_cache_version.
+    uint32_t reserved_;
+    uint64_t lef_hash_;         ///< hash_bytes() of the LEF file.
+    uint64_t lef_size_;         ///< Size of the LEF file.
+    double parse_time_;         ///< Seconds the LEF parser took.
+    uint64_t payload_size_;
+    uint64_t checksum_;         ///< hash_bytes() of the payload.
+};
+
+/**
+ * @return Path of the cache file in @a cache_dir for a LEF file of
+ *         content hash @a lef_hash. The key covers the cache version.
+ */
+static string get_cache_file (string cache_dir, uint64_t lef_hash)
+{
+    auto key = util::hash_bytes(reinterpret_cast<const char*>(&lef_cache_version),
+                                sizeof(lef_cache_version), lef_hash);
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.lefc", 
+             static_cast<unsigned long long>(key));
+
+    return cache_dir + "/" + name;
+}
+
 /**
- * Read a LEF file @a filename.
+ * Read a LEF file @a filename. If @a use_mmap is set, the file is memory
+ * mapped and fed to the parser through its read hook instead of stdio.
+ * If @a cache_dir is given, the tables defined by the file are loaded from
+ * the cache there when its content was seen before, and cached otherwise.
  */
-void Lef::read_lef (string filename)
+void Lef::read_lef (string filename, bool use_mmap, string cache_dir)
 {
     // The typical way to create a unique_ptr for a FILE* pointer
     auto fp = unique_ptr<FILE, decltype(&fclose)>(
@@ -73,17 +144,60 @@ void Lef::read_lef (string filename)
 
     pimpl_->filename_ = filename;
 
+    stable_sort(pimpl_->sites_.begin(), pimpl_->sites_.end(),
+                [](const SitePtr a, const SitePtr b)->bool {
+                    return a->name_ < b->name_;
+                });
+
+    unique_ptr<util::MappedFile> mapped_file;
+    if (use_mmap || !cache_dir.empty()) {
+        mapped_file.reset(new util::MappedFile(filename));
+    }
+
+    string cache_file;
+    uint64_t lef_hash = 0;
+    if (!cache_dir.empty()) {
+        lef_hash = util::hash_bytes(mapped_file->get_data(), 
+                                    mapped_file->get_size());
+        cache_file = get_cache_file(cache_dir, lef_hash);
+
+        auto begin = std::chrono::system_clock::now();
+        auto parse_time = 0.0;
+        if (read_cache(cache_file, lef_hash, mapped_file->get_size(), parse_time)) {
+            auto load_time = std::chrono::duration<double>(
+                                 std::chrono::system_clock::now() - begin).count();
+            cout << "LEF cache hit: " << filename << " (" << cache_file 
+                 << ") loaded in " << fixed << setprecision(3) << load_time 
+                 << " sec, saved " << parse_time - load_time << " sec of " 
+                 << parse_time << " sec parse" << endl;
+            cout.unsetf(std::ios_base::floatfield);
+
+            update_min_pitches();
+            update_pin_boxes(get_dbu());
+            update_cell_families();
+            return;
+        }
+    }
+
+    auto begin = std::chrono::system_clock::now();
+
+    auto first_site = pimpl_->sites_.size();
+    auto first_layer = pimpl_->layers_.size();
+    auto first_via = pimpl_->vias_.size();
+    auto first_macro = pimpl_->macros_.size();
+    pimpl_->has_units_ = false;
+
     lefrInit();
 
+    if (mapped_file) {
+        util::MappedFile::set_active(mapped_file.get());
+        lefrSetReadFunction(util::MappedFile::read_active);
+    }
+
     // Set the call-back functions.
     lefrSetUnitsCbk (LefParser::set_units);
     lefrSetSiteCbk  (LefParser::set_site);
 
-    stable_sort(pimpl_->sites_.begin(), pimpl_->sites_.end(),
-                [](const SitePtr a, const SitePtr b)->bool {
-                    return a->name_ < b->name_;
-                });
-
     lefrSetLayerCbk (LefParser::set_layer);
     lefrSetViaCbk   (LefParser::set_via);
     lefrSetObstructionCbk (LefParser::set_obstruction); 
@@ -96,11 +210,203 @@ void Lef::read_lef (string filename)
     // Read the LEF file.
     auto ret = lefrRead(fp.get(), filename.c_str(), (void*) this);
 
+    if (mapped_file) {
+        lefrUnsetReadFunction();
+        util::MappedFile::set_active(nullptr);
+    }
+
     if (ret != 0) {
         throw logic_error("(E) An error occured in LEF parser.");
     }
 
-    // Set the minimum horizontal/vertical metal pitches
+    update_min_pitches();
+    update_pin_boxes(get_dbu());
+    update_cell_families();
+
+    lefrReleaseNResetMemory();
+
+    if (!cache_file.empty()) {
+        auto parse_time = std::chrono::duration<double>(
+                              std::chrono::system_clock::now() - begin).count();
+        write_cache(cache_file, lef_hash, mapped_file->get_size(), parse_time,
+                    first_site, first_layer, first_via, first_macro);
+        cout << "LEF cache miss: " << filename << " parsed in " << fixed 
+             << setprecision(3) << parse_time << " sec, cached to " 
+             << cache_file << endl;
+        cout.unsetf(std::ios_base::floatfield);
+    }
+}
+
+/**
+ * Read the LEF files @a filenames in parallel on up to @a num_workers
+ * worker processes, and merge them in the given order. The result is the
+ * same as reading them one by one with read_lef().
+ *
+ * The Si2 LEF reader keeps its state in globals, so each file is parsed
+ * in a forked process, which writes the tables defined by the file in the
+ * LEF cache format. A file found in @a cache_dir is not parsed at all.
+ */
+void Lef::read_lefs (vector<string> filenames, bool use_mmap, 
+                     string cache_dir, int num_workers)
+{
+    struct Job
+    {
+        string filename_;
+        uint64_t lef_hash_;
+        uint64_t lef_size_;
+        string output_;     ///< Cache file holding the tables of the file.
+        bool is_temp_;      ///< Whether the output is a temporary file.
+        bool is_cached_;    ///< Whether a cache hit, not parsed by a worker.
+    };
+
+    vector<Job> jobs;
+    jobs.reserve(filenames.size());
+
+    for (auto& filename : filenames) {
+        if (access(filename.c_str(), R_OK) != 0) {
+            throw invalid_argument("(E) LEF (" + filename + ") not found.");
+        }
+    }
+
+    for (auto& filename : filenames) {
+        util::MappedFile mapped_file(filename);
+
+        Job job;
+        job.filename_ = filename;
+        job.lef_hash_ = util::hash_bytes(mapped_file.get_data(), 
+                                         mapped_file.get_size());
+        job.lef_size_ = mapped_file.get_size();
+        job.is_temp_ = cache_dir.empty();
+        job.is_cached_ = false;
+
+        if (job.is_temp_) {
+            char tmp_name[] = "/tmp/lefXXXXXX";
+            auto fd = mkstemp(tmp_name);
+            if (fd < 0) {
+                throw runtime_error("(E) Cannot create a temporary file.");
+            }
+            close(fd);
+            job.output_ = tmp_name;
+        }
+        else {
+            job.output_ = get_cache_file(cache_dir, job.lef_hash_);
+
+            struct stat st;
+            job.is_cached_ = stat(job.output_.c_str(), &st) == 0;
+        }
+        jobs.push_back(job);
+    }
+
+    // Fork the workers. Flush first, or the buffered output is duplicated.
+    auto first_site = pimpl_->sites_.size();
+    auto first_layer = pimpl_->layers_.size();
+    auto first_via = pimpl_->vias_.size();
+    auto first_macro = pimpl_->macros_.size();
+
+    cout << "Reading " << jobs.size() << " LEF files on " 
+         << max(1, num_workers) << " worker processes." << endl;
+    cout.flush();
+    fflush(stdout);
+
+    unordered_map<pid_t, size_t> running;
+    vector<int> status(jobs.size(), 0);
+    size_t next = 0;
+
+    while (next < jobs.size() || !running.empty()) {
+        if (next < jobs.size() && running.size() < static_cast<size_t>(max(1, num_workers))) {
+            auto& job = jobs[next];
+            if (job.is_cached_) {
+                next++;
+                continue;
+            }
+
+            auto pid = fork();
+            if (pid < 0) {
+                throw runtime_error("(E) Cannot fork a LEF worker.");
+            }
+            if (pid == 0) {
+                // The worker: parse the file and exit without cleanup.
+                auto dev_null = open("/dev/null", O_WRONLY);
+                if (dev_null >= 0) {
+                    dup2(dev_null, STDOUT_FILENO);
+                }
+                try {
+                    auto begin = std::chrono::system_clock::now();
+                    read_lef(job.filename_, use_mmap);
+                    auto parse_time = std::chrono::duration<double>(
+                                          std::chrono::system_clock::now() - begin).count();
+                    write_cache(job.output_, job.lef_hash_, job.lef_size_, 
+                                parse_time, first_site, first_layer, 
+                                first_via, first_macro);
+                }
+                catch (std::exception& e) {
+                    cerr << e.what() << endl;
+                    _exit(1);
+                }
+                _exit(0);
+            }
+
+            running[pid] = next++;
+            continue;
+        }
+
+        int wstatus;
+        auto pid = waitpid(-1, &wstatus, 0);
+        if (pid < 0) {
+            throw runtime_error("(E) Cannot wait for the LEF workers.");
+        }
+        auto found = running.find(pid);
+        if (found != running.end()) {
+            status[found->second] = wstatus;
+            running.erase(found);
+        }
+    }
+
+    // Merge the tables in the order of the files.
+    for (size_t i = 0; i < jobs.size(); i++) {
+        auto& job = jobs[i];
+        auto failed = !WIFEXITED(status[i]) || WEXITSTATUS(status[i]) != 0;
+
+        if (job.is_cached_) {
+            // Read as read_lef() would, which reparses an invalid cache.
+            read_lef(job.filename_, use_mmap, cache_dir);
+            continue;
+        }
+
+        pimpl_->filename_ = job.filename_;
+        stable_sort(pimpl_->sites_.begin(), pimpl_->sites_.end(),
+                    [](const SitePtr a, const SitePtr b)->bool {
+                        return a->name_ < b->name_;
+                    });
+
+        auto parse_time = 0.0;
+        if (failed || !read_cache(job.output_, job.lef_hash_, job.lef_size_, 
+                                  parse_time)) {
+            for (auto j = i; j < jobs.size(); j++) {
+                if (jobs[j].is_temp_) {
+                    remove(jobs[j].output_.c_str());
+                }
+            }
+            throw logic_error("(E) An error occured in LEF parser (" 
+                              + job.filename_ + ").");
+        }
+        if (job.is_temp_) {
+            remove(job.output_.c_str());
+        }
+
+        cout << "Merged LEF: " << job.filename_ << " (parsed in " 
+             << parse_time << " sec)" << endl;
+        update_min_pitches();
+        update_pin_boxes(get_dbu());
+        update_cell_families();
+    }
+}
+
+/**
+ * Set the minimum horizontal/vertical metal pitches.
+ */
+void Lef::update_min_pitches ()
+{
     for (auto l : pimpl_->layers_) {
         if (l->dir_ == LayerDir::horizontal) {
             pimpl_->min_y_pitch_ = (l->pitch_y_ < pimpl_->min_y_pitch_) 
@@ -119,10 +425,183 @@ void Lef::read_lef (string filename)
     pimpl_->min_x_pitch_dbu_ = pimpl_->min_x_pitch_ * DBU;
     pimpl_->min_x_pitch_dbu_ = pimpl_->min_x_pitch_ * DBU;
     pimpl_->min_y_pitch_dbu_ = pimpl_->min_y_pitch_ * DBU;
+}
 
-    lefrReleaseNResetMemory();
+/**
+ * Pin boxes are rounded to the nearest DBU. A pin without ports is put at
+ * the lower-left corner of the cell.
+ */
+void Lef::update_pin_boxes (int dbu)
+{
+    if (dbu <= 0) {
+        return;
+    }
+
+    auto to_dbu = [dbu] (double v) {
+        return static_cast<int>(lround(v * dbu));
+    };
+
+    for (auto& m : pimpl_->macros_) {
+        const auto num_pins = m->pins_.size();
+        if (m->pin_box_dbu_ == dbu 
+            && m->pin_boxes_.size() == util::num_orients * num_pins
+            && m->obs_boxes_.size() == m->obsts_.size()) {
+            continue;
+        }
+
+        m->pin_box_dbu_ = dbu;
+        m->size_x_dbu_ = to_dbu(m->size_x_);
+        m->size_y_dbu_ = to_dbu(m->size_y_);
+        m->pin_boxes_.resize(util::num_orients * num_pins);
+
+        for (size_t i = 0; i < num_pins; i++) {
+            auto& r = m->pins_[i]->bbox_;
+            util::Box b;
+            if (r.lx_ <= r.ux_ && r.ly_ <= r.uy_) {
+                b = util::Box(to_dbu(r.lx_), to_dbu(r.ly_), 
+                              to_dbu(r.ux_), to_dbu(r.uy_));
+            }
+            for (int o = 0; o < util::num_orients; o++) {
+                m->pin_boxes_[o * num_pins + i] = util::transform_cell_box(
+                        b, m->size_x_dbu_, m->size_y_dbu_, o);
+            }
+        }
+
+        // Obstructions, grouped by layer in the order the layers appear.
+        m->obs_layers_.clear();
+        vector<uint32_t> layer_of_obst(m->obsts_.size());
+        for (size_t i = 0; i < m->obsts_.size(); i++) {
+            auto layer = m->find_obs_layer(m->obsts_[i].layer_id_);
+            if (layer < 0) {
+                layer = m->obs_layers_.size();
+                m->obs_layers_.push_back(m->obsts_[i].layer_id_);
+            }
+            layer_of_obst[i] = layer;
+        }
+
+        m->obs_begin_.assign(m->obs_layers_.size() + 1, 0);
+        for (auto l : layer_of_obst) {
+            m->obs_begin_[l + 1]++;
+        }
+        for (size_t l = 0; l < m->obs_layers_.size(); l++) {
+            m->obs_begin_[l + 1] += m->obs_begin_[l];
+        }
+
+        m->obs_boxes_.resize(m->obsts_.size());
+        vector<uint32_t> next(m->obs_begin_.begin(), m->obs_begin_.end() - 1);
+        for (size_t i = 0; i < m->obsts_.size(); i++) {
+            auto& r = m->obsts_[i].rect_;
+            m->obs_boxes_[next[layer_of_obst[i]]++] = util::Box(
+                    to_dbu(r.lx_), to_dbu(r.ly_), to_dbu(r.ux_), to_dbu(r.uy_));
+        }
+    }
+}
+
+/**
+ * @return @a name with the parts matched by the capture groups of @a match
+ *         replaced by '*'. A group nested in another is part of it.
+ */
+static string get_family_name (const string& name, const smatch& match)
+{
+    string family;
+    size_t end = 0;
+    for (size_t i = 1; i < match.size(); i++) {
+        if (!match[i].matched) {
+            continue;
+        }
+        auto begin = static_cast<size_t>(match.position(i));
+        if (begin < end) {
+            continue;
+        }
+        family.append(name, end, begin - end).append(1, '*');
+        end = begin + match.length(i);
+    }
+    return family.append(name, end, string::npos);
+}
+
+/**
+ * A family is keyed by its name, the size of its macros and their pins,
+ * ranked by name, with their directions.
+ */
+void Lef::build_cell_families (string pattern, bool match_width)
+{
+    regex re;
+    try {
+        re = regex(pattern);
+    }
+    catch (regex_error&) {
+        throw invalid_argument("(E) Invalid cell family pattern (" + pattern + ").");
+    }
+    pimpl_->family_pattern_ = pattern;
+    pimpl_->family_match_width_ = match_width;
+
+    auto& families = pimpl_->cell_families_;
+    families.clear();
+    unordered_map<string, size_t> family_of_key;
+
+    for (auto& m : pimpl_->macros_) {
+        auto& pins = m->pins_;
+        m->ranked_pins_.resize(pins.size());
+        iota(m->ranked_pins_.begin(), m->ranked_pins_.end(), 0);
+        sort(m->ranked_pins_.begin(), m->ranked_pins_.end(),
+             [&pins] (uint32_t a, uint32_t b) {
+                 return pins[a]->name_ < pins[b]->name_;
+             });
+        m->pin_ranks_.resize(pins.size());
+        for (uint32_t r = 0; r < pins.size(); r++) {
+            m->pin_ranks_[m->ranked_pins_[r]] = r;
+        }
+
+        // A macro redefined by a later LEF is no longer returned by
+        // get_macro(), and must not be offered as a swap candidate.
+        auto live = pimpl_->macro_umap_.find(m->name_);
+        if (live == pimpl_->macro_umap_.end() || live->second != m) {
+            m->family_ = nullptr;
+            continue;
+        }
+
+        smatch match;
+        auto name = regex_search(m->name_, match, re) 
+                    ? get_family_name(m->name_, match) : m->name_;
+
+        auto key = name + ' ' + to_string(match_width ? m->size_x_ : 0.0) 
+                   + ' ' + to_string(m->size_y_);
+        for (auto p : m->ranked_pins_) {
+            key += ' ' + pins[p]->name_ + ':' 
+                   + to_string(static_cast<int>(pins[p]->dir_));
+        }
+
+        auto found = family_of_key.find(key);
+        if (found == family_of_key.end()) {
+            found = family_of_key.emplace(key, families.size()).first;
+            families.push_back(CellFamily{name, {}});
+        }
+        families[found->second].macros_.push_back(m);
+    }
+
+    for (auto& f : families) {
+        stable_sort(f.macros_.begin(), f.macros_.end(),
+                    [] (const MacroPtr& a, const MacroPtr& b) {
+                        auto area_a = a->size_x_ * a->size_y_;
+                        auto area_b = b->size_x_ * b->size_y_;
+                        return area_a < area_b 
+                               || (area_a == area_b && a->name_ < b->name_);
+                    });
+        for (auto& m : f.macros_) {
+            m->family_ = &f;
+        }
+    }
+}
+
+void Lef::update_cell_families ()
+{
+    build_cell_families(pimpl_->family_pattern_, pimpl_->family_match_width_);
 }
 
+const vector<CellFamily>& Lef::get_cell_families () const
+{
+    return pimpl_->cell_families_;
+}
 
 void Lef::report () const
 {
@@ -131,6 +610,19 @@ void Lef::report () const
     cout << "\t#Sites : " << pimpl_->sites_.size() << endl;
     cout << "\t#Layers: " << pimpl_->layers_.size() << endl;
     cout << "\t#Macros: " << pimpl_->macros_.size() << endl;
+
+    size_t num_obsts = 0;
+    for (auto& m : pimpl_->macros_) {
+        num_obsts += m->obsts_.size();
+    }
+    cout << "\t#Obs   : " << num_obsts << " rectangles" << endl;
+
+    size_t num_swappable = 0;
+    for (auto& f : pimpl_->cell_families_) {
+        num_swappable += f.macros_.size() > 1 ? 1 : 0;
+    }
+    cout << "\t#Families: " << pimpl_->cell_families_.size() << " ("
+         << num_swappable << " of two or more macros)" << endl;
     cout << endl;
 }
 
@@ -183,6 +675,16 @@ LayerPtr Lef::get_layer (string name)
     }
 }
 
+ViaPtr Lef::get_via (string name)
+{
+    for (auto& v : pimpl_->vias_) {
+        if (v->name_ == name) {
+            return v;
+        }
+    }
+    return nullptr;
+}
+
 MacroPtr Lef::get_macro (string name)
 {
     auto found = pimpl_->macro_umap_.find(name);
@@ -195,6 +697,18 @@ MacroPtr Lef::get_macro (string name)
     }
 }
 
+MacroPtr Lef::get_macro (util::SymbolId name)
+{
+    auto found = pimpl_->macro_sym_umap_.find(name);
+
+    if (found == pimpl_->macro_sym_umap_.end()) {
+        return nullptr;
+    }
+    else {
+        return found->second;
+    }
+}
+
 int Lef::get_dbu () const
 {
     return pimpl_->unit_.db_number_;
@@ -228,6 +742,7 @@ int LefParser::set_units (lefrCallbackType_e, lefiUnits* units,
     auto lef = static_cast<Lef*>(ud);
 
     if (units->hasDatabase()) {
+        lef->pimpl_->has_units_ = true;
         auto& unit = lef->pimpl_->unit_;
         unit.db_name_ = units->databaseName();
         unit.db_number_ = (int) units->databaseNumber();
@@ -255,6 +770,7 @@ int LefParser::set_site  (lefrCallbackType_e type, lefiSite* site,
 
     // Set the attributes.
     cur_site->name_  = site->name();
+    cur_site->name_id_ = util::SymbolTable::get_instance().intern(cur_site->name_);
     cur_site->class_ = site->hasClass() ? site->siteClass() : "";
     if (site->hasSize()) {
         cur_site->x_ = site->sizeX();
@@ -290,6 +806,7 @@ int LefParser::set_layer (lefrCallbackType_e, lefiLayer* layer,
 
     // Set the attributes.
     l->name_ = layer->name();
+    l->name_id_ = util::SymbolTable::get_instance().intern(l->name_);
     l->type_ = layer->hasType() ? layer->type() : "";
 
     // Direction
@@ -360,6 +877,7 @@ int LefParser::set_via (lefrCallbackType_e, lefiVia* via, lefiUserData ud)
     auto& the_via = vias.back();
 
     the_via->name_ = via->name();
+    the_via->name_id_ = util::SymbolTable::get_instance().intern(the_via->name_);
     the_via->layers_.reserve(via->numLayers());
 
     for (int i = 0; i < via->numLayers(); i++) {
@@ -379,17 +897,214 @@ int LefParser::set_via (lefrCallbackType_e, lefiVia* via, lefiUserData ud)
     return 0;
 }
 
+/**
+ * Add the rectangles of a path of @a width through the @a n points
+ * (@a x, @a y) shifted by (@a dx, @a dy). A segment is extended by half the
+ * width at both ends.
+ */
+static void add_path_obsts (vector<Obst>& obsts, util::SymbolId layer, double width,
+                            const double* x, const double* y, int n, 
+                            double dx, double dy)
+{
+    auto half = width / 2;
+    if (n == 1) {
+        obsts.push_back(Obst{layer, Rect(x[0] + dx - half, y[0] + dy - half,
+                                         x[0] + dx + half, y[0] + dy + half)});
+    }
+    for (int i = 0; i + 1 < n; i++) {
+        obsts.push_back(Obst{layer, Rect(min(x[i], x[i + 1]) + dx - half, 
+                                         min(y[i], y[i + 1]) + dy - half,
+                                         max(x[i], x[i + 1]) + dx + half, 
+                                         max(y[i], y[i + 1]) + dy + half)});
+    }
+}
+
+/**
+ * Add the rectangles covering a polygon of @a n points shifted by (@a dx,
+ * @a dy). A rectilinear polygon is cut into horizontal slabs, each slab
+ * into the intervals between its vertical edges (even-odd rule); slabs of
+ * the same interval are merged. Other polygons are kept as their bounding
+ * boxes.
+ */
+static void add_polygon_obsts (vector<Obst>& obsts, util::SymbolId layer,
+                               const double* x, const double* y, int n, 
+                               double dx, double dy)
+{
+    if (n < 3) {
+        return;
+    }
+
+    bool rectilinear = true;
+    vector<double> ys;
+    Rect bbox;
+    for (int i = 0; i < n; i++) {
+        auto j = (i + 1) % n;
+        rectilinear = rectilinear && (x[i] == x[j] || y[i] == y[j]);
+        ys.push_back(y[i]);
+        bbox.lx_ = min(bbox.lx_, x[i]);
+        bbox.ly_ = min(bbox.ly_, y[i]);
+        bbox.ux_ = max(bbox.ux_, x[i]);
+        bbox.uy_ = max(bbox.uy_, y[i]);
+    }
+
+    if (!rectilinear) {
+        obsts.push_back(Obst{layer, Rect(bbox.lx_ + dx, bbox.ly_ + dy, 
+                                         bbox.ux_ + dx, bbox.uy_ + dy)});
+        return;
+    }
+
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+
+    // Rectangles reaching the top of the previous slab, by interval.
+    vector<size_t> open, next_open;
+    vector<double> xs;
+    for (size_t k = 0; k + 1 < ys.size(); k++) {
+        auto mid = (ys[k] + ys[k + 1]) / 2;
+
+        xs.clear();
+        for (int i = 0; i < n; i++) {
+            auto j = (i + 1) % n;
+            if (x[i] == x[j] && min(y[i], y[j]) < mid && mid < max(y[i], y[j])) {
+                xs.push_back(x[i] + dx);
+            }
+        }
+        sort(xs.begin(), xs.end());
+
+        next_open.clear();
+        for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+            auto found = find_if(open.begin(), open.end(), [&] (size_t o) {
+                             return obsts[o].rect_.lx_ == xs[i] 
+                                    && obsts[o].rect_.ux_ == xs[i + 1];
+                         });
+            if (found != open.end()) {
+                obsts[*found].rect_.uy_ = ys[k + 1] + dy;
+                next_open.push_back(*found);
+            }
+            else {
+                next_open.push_back(obsts.size());
+                obsts.push_back(Obst{layer, Rect(xs[i], ys[k] + dy, 
+                                                 xs[i + 1], ys[k + 1] + dy)});
+            }
+        }
+        open.swap(next_open);
+    }
+}
+
+/**
+ * Add the rectangles of the via @a name placed at (@a x, @a y), on the
+ * layers of the via.
+ */
+static void add_via_obsts (Lef& lef, vector<Obst>& obsts, const char* name,
+                           double x, double y)
+{
+    auto via = lef.get_via(name);
+    if (via == nullptr) {
+        cout << "(W) Unknown via " << name << " in an obstruction." << endl;
+        return;
+    }
+
+    for (auto& l : via->layers_) {
+        auto layer = util::SymbolTable::get_instance().intern(l.name_);
+        for (auto& r : l.rect_vec_) {
+            obsts.push_back(Obst{layer, Rect(r.lx_ + x, r.ly_ + y, 
+                                             r.ux_ + x, r.uy_ + y)});
+        }
+    }
+}
+
+/**
+ * Keep the rectangles, paths, polygons and vias of an OBS, with their
+ * ITERATE patterns expanded, in the current macro. The step pattern
+ * "DO nx BY ny STEP sx sy" is given as xStart, yStart, xStep and yStep.
+ */
 int LefParser::set_obstruction (lefrCallbackType_e, lefiObstruction* obs, 
                                 lefiUserData ud)
 {
     auto lef = static_cast<Lef*>(ud);
+    if (lef->pimpl_->macros_.empty()) {
+        return 0;
+    }
 
+    auto& obsts = lef->pimpl_->macros_.back()->obsts_;
     auto geometries = obs->lefiObstruction::geometries();
-    auto num_items = geometries->numItems();
-
-    // TODO
-    auto& obsts = lef->pimpl_->obsts_;
-    obsts.resize(num_items);
+    auto layer = util::SymbolTable::invalid_symbol;
+    double width = 0;
+
+    for (int i = 0; i < geometries->numItems(); i++) {
+        switch (geometries->itemType(i)) {
+            case lefiGeomLayerE:
+                layer = util::SymbolTable::get_instance().intern(geometries->getLayer(i));
+                width = 0;
+                break;
+            case lefiGeomWidthE:
+                width = geometries->getWidth(i);
+                break;
+            case lefiGeomRectE: {
+                auto r = geometries->getRect(i);
+                obsts.push_back(Obst{layer, Rect(r->xl, r->yl, r->xh, r->yh)});
+                break;
+            }
+            case lefiGeomRectIterE: {
+                auto r = geometries->getRectIter(i);
+                for (int iy = 0; iy < r->yStart; iy++) {
+                    for (int ix = 0; ix < r->xStart; ix++) {
+                        auto dx = ix * r->xStep, dy = iy * r->yStep;
+                        obsts.push_back(Obst{layer, Rect(r->xl + dx, r->yl + dy, 
+                                                         r->xh + dx, r->yh + dy)});
+                    }
+                }
+                break;
+            }
+            case lefiGeomPathE: {
+                auto p = geometries->getPath(i);
+                add_path_obsts(obsts, layer, width, p->x, p->y, p->numPoints, 0, 0);
+                break;
+            }
+            case lefiGeomPathIterE: {
+                auto p = geometries->getPathIter(i);
+                for (int iy = 0; iy < p->yStart; iy++) {
+                    for (int ix = 0; ix < p->xStart; ix++) {
+                        add_path_obsts(obsts, layer, width, p->x, p->y, p->numPoints,
+                                       ix * p->xStep, iy * p->yStep);
+                    }
+                }
+                break;
+            }
+            case lefiGeomPolygonE: {
+                auto p = geometries->getPolygon(i);
+                add_polygon_obsts(obsts, layer, p->x, p->y, p->numPoints, 0, 0);
+                break;
+            }
+            case lefiGeomPolygonIterE: {
+                auto p = geometries->getPolygonIter(i);
+                for (int iy = 0; iy < p->yStart; iy++) {
+                    for (int ix = 0; ix < p->xStart; ix++) {
+                        add_polygon_obsts(obsts, layer, p->x, p->y, p->numPoints,
+                                          ix * p->xStep, iy * p->yStep);
+                    }
+                }
+                break;
+            }
+            case lefiGeomViaE: {
+                auto v = geometries->getVia(i);
+                add_via_obsts(*lef, obsts, v->name, v->x, v->y);
+                break;
+            }
+            case lefiGeomViaIterE: {
+                auto v = geometries->getViaIter(i);
+                for (int iy = 0; iy < v->yStart; iy++) {
+                    for (int ix = 0; ix < v->xStart; ix++) {
+                        add_via_obsts(*lef, obsts, v->name, 
+                                      v->x + ix * v->xStep, v->y + iy * v->yStep);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
 
     return 0;
 }
@@ -401,11 +1116,14 @@ int LefParser::set_macro_begin (lefrCallbackType_e, const char* name,
     auto& macros = lef->pimpl_->macros_;
     auto& macro_umap = lef->pimpl_->macro_umap_;
 
-    auto the_macro = make_shared<Macro>();
+    auto& storage = *lef->pimpl_->storage_;
+    auto the_macro = storage.create(storage.macros_);
     the_macro->name_ = string(name);
+    the_macro->name_id_ = util::SymbolTable::get_instance().intern(name);
 
     macros.emplace_back(the_macro);
     macro_umap[the_macro->name_] = the_macro;
+    lef->pimpl_->macro_sym_umap_[the_macro->name_id_] = the_macro;
 
     return 0;
 }
@@ -448,13 +1166,17 @@ int LefParser::set_pin (lefrCallbackType_e, lefiPin* pin, lefiUserData ud)
 {
     // Create a new pin
     auto lef = static_cast<Lef*>(ud);
+    auto& storage = *lef->pimpl_->storage_;
     auto& pins = lef->pimpl_->pins_;
 
-    pins.emplace_back(make_shared<Pin>());
+    pins.emplace_back(storage.create(storage.pins_));
     auto the_pin = pins.back();
 
+    auto& symbols = util::SymbolTable::get_instance();
+
     // Set name and direction
     the_pin->name_ = string(pin->name());
+    the_pin->name_id_ = symbols.intern(pin->name());
     string dir_str = string(pin->direction());
     if (dir_str == "INPUT" || dir_str == "input") {
         the_pin->dir_ = PinDir::input;
@@ -484,14 +1206,13 @@ int LefParser::set_pin (lefrCallbackType_e, lefiPin* pin, lefiUserData ud)
     // Create ports
     for (int i = 0; i < pin->numPorts(); i++) {
         auto port = pin->port(i);   // Type: lefiGeometries*
-        the_pin->ports_.emplace_back(make_shared<Port>());
+        the_pin->ports_.emplace_back(storage.create(storage.ports_));
 
         auto cur_port = the_pin->ports_.back();
-        cur_port->name_ = the_pin->name_;
 
         for (int j = 0; j < port->numItems(); j++) {
             if (port->itemType(j) == lefiGeomLayerE) {
-                cur_port->layer_name_ = port->getLayer(j);
+                cur_port->layer_id_ = symbols.intern(port->getLayer(j));
             }
             else if (port->itemType(j) == lefiGeomRectE) {
                 auto rect = port->getRect(j);
@@ -555,10 +1276,391 @@ int LefParser::set_pin (lefrCallbackType_e, lefiPin* pin, lefiUserData ud)
 
     // (FIXME) Get the current macro
     auto m = lef->pimpl_->macros_.back();
+    m->pins_.emplace_back(the_pin);
     m->pin_umap_[the_pin->name_] = the_pin;
     return 0;
 }
 
+// Binary serialization, shared by snapshots and the LEF cache.
+static void write_rect (util::BinaryWriter& w, const Rect& r)
+{
+    w.write(r.lx_);
+    w.write(r.ly_);
+    w.write(r.ux_);
+    w.write(r.uy_);
+}
+
+static Rect read_rect (util::BinaryReader& r)
+{
+    Rect rect;
+    rect.lx_ = r.read<double>();
+    rect.ly_ = r.read<double>();
+    rect.ux_ = r.read<double>();
+    rect.uy_ = r.read<double>();
+    return rect;
+}
+
+static void write_rects (util::BinaryWriter& w, const vector<Rect>& rects)
+{
+    w.write<uint32_t>(rects.size());
+    for (auto& r : rects) {
+        write_rect(w, r);
+    }
+}
+
+static void read_rects (util::BinaryReader& r, vector<Rect>& rects)
+{
+    auto n = r.read<uint32_t>();
+    rects.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        rects.push_back(read_rect(r));
+    }
+}
+
+/**
+ * Write the sites, layers, vias, and macros from the given positions on.
+ */
+void Lef::write_tables (util::BinaryWriter& w, size_t first_site, 
+                        size_t first_layer, size_t first_via, 
+                        size_t first_macro) const
+{
+    auto& impl = *pimpl_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    w.write<uint32_t>(impl.sites_.size() - first_site);
+    for (auto i = first_site; i < impl.sites_.size(); i++) {
+        auto& s = impl.sites_[i];
+        w.write_string(s->name_);
+        w.write_string(s->class_);
+        w.write(s->x_);
+        w.write(s->y_);
+        w.write(s->symmetry_);
+    }
+
+    w.write<uint32_t>(impl.layers_.size() - first_layer);
+    for (auto i = first_layer; i < impl.layers_.size(); i++) {
+        auto& l = impl.layers_[i];
+        w.write_string(l->name_);
+        w.write_string(l->type_);
+        w.write(l->dir_);
+        w.write(l->min_width_);
+        w.write(l->area_);
+        w.write(l->width_);
+        w.write(l->spacing_);
+        w.write(l->pitch_);
+        w.write(l->pitch_x_);
+        w.write(l->pitch_y_);
+    }
+
+    w.write<uint32_t>(impl.vias_.size() - first_via);
+    for (auto i = first_via; i < impl.vias_.size(); i++) {
+        auto& v = impl.vias_[i];
+        w.write_string(v->name_);
+        w.write<uint32_t>(v->layers_.size());
+        for (auto& l : v->layers_) {
+            w.write_string(l.name_);
+            write_rects(w, l.rect_vec_);
+        }
+    }
+
+    w.write<uint32_t>(impl.macros_.size() - first_macro);
+    for (auto i = first_macro; i < impl.macros_.size(); i++) {
+        auto& m = impl.macros_[i];
+        w.write_string(m->name_);
+        w.write_string(m->site_name_);
+        w.write(m->size_x_);
+        w.write(m->size_y_);
+
+        w.write<uint32_t>(m->pins_.size());
+        for (auto& p : m->pins_) {
+            w.write_string(p->name_);
+            w.write(p->dir_);
+            w.write(p->use_);
+            write_rect(w, p->bbox_);
+
+            w.write<uint32_t>(p->ports_.size());
+            for (auto& port : p->ports_) {
+                w.write_string(util::get_symbol_name(port->layer_id_));
+                write_rects(w, port->rects_);
+                write_rect(w, port->bbox_);
+            }
+        }
+
+        w.write<uint32_t>(m->obsts_.size());
+        for (auto& o : m->obsts_) {
+            w.write_string(symbols.get_name(o.layer_id_));
+            write_rect(w, o.rect_);
+        }
+    }
+}
+
+/**
+ * @return The site named @a name in @a sites, nullptr if none.
+ */
+static SitePtr get_site_by_name (const vector<SitePtr>& sites, const string& name)
+{
+    auto found = find_if(sites.begin(), sites.end(),
+                         [&name] (const SitePtr& s) { return s->name_ == name; });
+
+    return found != sites.end() ? *found : nullptr;
+}
+
+/**
+ * Append the tables written by write_tables(). Via layers and macro sites
+ * are resolved by name against the library read so far, as the parser
+ * does, so the tables may come from a LEF file parsed on its own.
+ */
+void Lef::read_tables (util::BinaryReader& r)
+{
+    auto& impl = *pimpl_;
+    auto& storage = *impl.storage_;
+    auto& symbols = util::SymbolTable::get_instance();
+
+    auto num_sites = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_sites; i++) {
+        auto s = make_shared<Site>();
+        s->name_ = r.read_string();
+        s->name_id_ = symbols.intern(s->name_);
+        s->class_ = r.read_string();
+        s->x_ = r.read<double>();
+        s->y_ = r.read<double>();
+        s->symmetry_ = r.read<SiteSymmetry>();
+        impl.sites_.push_back(s);
+    }
+
+    auto num_layers = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_layers; i++) {
+        auto l = make_shared<Layer>();
+        l->name_ = r.read_string();
+        l->name_id_ = symbols.intern(l->name_);
+        l->type_ = r.read_string();
+        l->dir_ = r.read<LayerDir>();
+        l->min_width_ = r.read<double>();
+        l->area_ = r.read<double>();
+        l->width_ = r.read<double>();
+        l->spacing_ = r.read<double>();
+        l->pitch_ = r.read<double>();
+        l->pitch_x_ = r.read<double>();
+        l->pitch_y_ = r.read<double>();
+        impl.layers_.push_back(l);
+        impl.layer_umap_[l->name_] = l;
+    }
+
+    auto num_vias = r.read<uint32_t>();
+    for (uint32_t i = 0; i < num_vias; i++) {
+        auto v = make_shared<Via>();
+        v->name_ = r.read_string();
+        v->name_id_ = symbols.intern(v->name_);
+
+        auto num_via_layers = r.read<uint32_t>();
+        for (uint32_t j = 0; j < num_via_layers; j++) {
+            auto name = r.read_string();
+            v->layers_.emplace_back(name, get_layer(name));
+            read_rects(r, v->layers_.back().rect_vec_);
+        }
+        impl.vias_.push_back(v);
+    }
+
+    auto num_macros = r.read<uint32_t>();
+    impl.macros_.reserve(impl.macros_.size() + num_macros);
+    for (uint32_t i = 0; i < num_macros; i++) {
+        auto m = storage.create(storage.macros_);
+        m->name_ = r.read_string();
+        m->name_id_ = symbols.intern(m->name_);
+        m->site_name_ = r.read_string();
+        m->size_x_ = r.read<double>();
+        m->size_y_ = r.read<double>();
+
+        m->site_ = get_site_by_name(impl.sites_, m->site_name_);
+
+        auto num_pins = r.read<uint32_t>();
+        for (uint32_t j = 0; j < num_pins; j++) {
+            auto p = storage.create(storage.pins_);
+            p->name_ = r.read_string();
+            p->name_id_ = symbols.intern(p->name_);
+            p->dir_ = r.read<PinDir>();
+            p->use_ = r.read<PinUse>();
+            p->bbox_ = read_rect(r);
+
+            auto num_ports = r.read<uint32_t>();
+            for (uint32_t k = 0; k < num_ports; k++) {
+                auto port = storage.create(storage.ports_);
+                port->layer_id_ = symbols.intern(r.read_string());
+                read_rects(r, port->rects_);
+                port->bbox_ = read_rect(r);
+                p->ports_.push_back(port);
+            }
+
+            m->pins_.push_back(p);
+            m->pin_umap_[p->name_] = p;
+            impl.pins_.push_back(p);
+        }
+
+        m->obsts_.resize(r.read<uint32_t>());
+        for (auto& o : m->obsts_) {
+            o.layer_id_ = symbols.intern(r.read_string());
+            o.rect_ = read_rect(r);
+        }
+
+        // Later definitions of a macro override earlier ones.
+        impl.macros_.push_back(m);
+        impl.macro_umap_[m->name_] = m;
+        impl.macro_sym_umap_[m->name_id_] = m;
+    }
+}
+
+/**
+ * Write the library to @a w.
+ */
+void Lef::write_snapshot (util::BinaryWriter& w) const
+{
+    auto& impl = *pimpl_;
+
+    w.write_string(impl.filename_);
+    w.write(impl.manufacturing_grid_);
+    w.write_string(impl.clearance_measure_);
+    w.write(impl.use_min_spacing_obs_);
+    w.write_string(impl.unit_.db_name_);
+    w.write(impl.unit_.db_number_);
+
+    write_tables(w, 0, 0, 0, 0);
+
+    w.write(impl.min_x_pitch_);
+    w.write(impl.min_y_pitch_);
+    w.write(impl.min_x_pitch_dbu_);
+    w.write(impl.min_y_pitch_dbu_);
+}
+
+/**
+ * Replace the library with the one written by write_snapshot().
+ */
+void Lef::read_snapshot (util::BinaryReader& r)
+{
+    auto family_pattern = pimpl_->family_pattern_;
+    auto family_match_width = pimpl_->family_match_width_;
+
+    pimpl_.reset(new Impl());
+    auto& impl = *pimpl_;
+    impl.family_pattern_ = family_pattern;
+    impl.family_match_width_ = family_match_width;
+
+    impl.filename_ = r.read_string();
+    impl.manufacturing_grid_ = r.read<double>();
+    impl.clearance_measure_ = r.read_string();
+    impl.use_min_spacing_obs_ = r.read<bool>();
+    impl.unit_.db_name_ = r.read_string();
+    impl.unit_.db_number_ = r.read<int>();
+
+    read_tables(r);
+
+    impl.min_x_pitch_ = r.read<double>();
+    impl.min_y_pitch_ = r.read<double>();
+    impl.min_x_pitch_dbu_ = r.read<int>();
+    impl.min_y_pitch_dbu_ = r.read<int>();
+
+    update_pin_boxes(get_dbu());
+    update_cell_families();
+}
+
+/**
+ * Append the tables cached in @a cache_file, if it is a valid cache of
+ * a LEF file of hash @a lef_hash and size @a lef_size. The time the LEF
+ * parser took for the file is returned in @a parse_time.
+ * @return false if it is not, leaving the library untouched.
+ */
+bool Lef::read_cache (string cache_file, uint64_t lef_hash, uint64_t lef_size,
+                      double& parse_time)
+{
+    struct stat st;
+    if (stat(cache_file.c_str(), &st) != 0) {
+        return false;
+    }
+
+    util::MappedFile mapped_file(cache_file);
+
+    auto data = mapped_file.get_data();
+    auto size = mapped_file.get_size();
+
+    LefCacheHeader header;
+    if (size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+    }
+    if (size < sizeof(header)
+        || memcmp(header.magic_, lef_cache_magic, sizeof(lef_cache_magic)) != 0
+        || header.version_ != lef_cache_version
+        || header.lef_hash_ != lef_hash
+        || header.lef_size_ != lef_size
+        || header.payload_size_ != size - sizeof(header)
+        || util::hash_bytes(data + sizeof(header), header.payload_size_) 
+           != header.checksum_) 
+    {
+        cout << "(W) Ignoring invalid LEF cache " << cache_file << endl;
+        return false;
+    }
+
+    util::BinaryReader reader(data + sizeof(header), header.payload_size_);
+
+    if (reader.read<bool>()) {
+        pimpl_->unit_.db_name_ = reader.read_string();
+        pimpl_->unit_.db_number_ = reader.read<int>();
+    }
+    read_tables(reader);
+
+    parse_time = header.parse_time_;
+
+    return true;
+}
+
+/**
+ * Cache the tables defined by the LEF file just read, which are those
+ * from the given positions on.
+ */
+void Lef::write_cache (string cache_file, uint64_t lef_hash, uint64_t lef_size,
+                       double parse_time, size_t first_site, size_t first_layer,
+                       size_t first_via, size_t first_macro) const
+{
+    util::BinaryWriter writer;
+
+    writer.write(pimpl_->has_units_);
+    if (pimpl_->has_units_) {
+        writer.write_string(pimpl_->unit_.db_name_);
+        writer.write(pimpl_->unit_.db_number_);
+    }
+    write_tables(writer, first_site, first_layer, first_via, first_macro);
+
+    auto& payload = writer.get_buffer();
+
+    LefCacheHeader header;
+    memcpy(header.magic_, lef_cache_magic, sizeof(lef_cache_magic));
+    header.version_ = lef_cache_version;
+    header.reserved_ = 0;
+    header.lef_hash_ = lef_hash;
+    header.lef_size_ = lef_size;
+    header.parse_time_ = parse_time;
+    header.payload_size_ = payload.size();
+    header.checksum_ = util::hash_bytes(payload.data(), payload.size());
+
+    // Write to a temporary file first, so that concurrent runs never see
+    // a partial cache file.
+    auto cache_dir = cache_file.substr(0, cache_file.rfind('/'));
+    mkdir(cache_dir.c_str(), 0755);
+
+    auto tmp_file = cache_file + "." + std::to_string(getpid());
+    {
+        ofstream ofs(tmp_file, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(payload.data(), payload.size());
+
+        if (!ofs) {
+            cout << "(W) Cannot write LEF cache " << cache_file << endl;
+            ofs.close();
+            remove(tmp_file.c_str());
+            return;
+        }
+    }
+    rename(tmp_file.c_str(), cache_file.c_str());
+}
+
 ostream& operator<< (ostream& os, const Unit& u)
 {
     os << "Unit (db_name=" << u.db_name_
@@ -606,6 +1708,7 @@ ostream& operator<< (ostream& os, const Macro& m)
        << ", site_name=" << m.site_name_
        << ", size_x=" << m.size_x_ << ", size_y=" << m.size_y_
        << ", num_pins=" << m.pin_umap_.size() 
+       << ", num_obsts=" << m.obsts_.size()
        << ")";
 
     return os;
@@ -625,8 +1728,7 @@ ostream& operator<< (ostream& os, const Pin& p)
 
 ostream& operator<< (ostream& os, const Port& p)
 {
-    os << "Port (name=" << p.name_
-       << "layer=" << p.layer_name_
+    os << "Port (layer=" << util::get_symbol_name(p.layer_id_)
        << "num_rects=" << p.rects_.size()
        << ")";
 
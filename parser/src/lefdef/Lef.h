@@ -12,6 +12,9 @@
 #include "lef/lefrReader.hpp"
 #include "common_header.h"
 #include "common_enum.h"
+#include "SymbolTable.h"
+#include "BinaryIO.h"
+#include "Geometry.h"
 
 namespace lef
 {
@@ -26,6 +29,7 @@ struct Obst;
 struct Macro;
 struct Pin;
 struct Port;
+struct CellFamily;
 class  Lef;
 
 using RectPtr  =  shared_ptr<Rect>;
@@ -78,6 +82,7 @@ ostream& operator<< (ostream& os, const Unit& u);
 struct Site
 {
     string name_;       ///< Name of the site.
+    util::SymbolId name_id_;
     string class_;      ///< Class of the site. 
     double x_;          ///< Width.
     double y_;          ///< Height.
@@ -92,6 +97,7 @@ ostream& operator<< (ostream& os, const Site& s);
 struct Layer
 {
     string name_;      ///< Name of the layer.
+    util::SymbolId name_id_;
     string type_;      ///< Type of the layer.
     LayerDir dir_;       ///< Direction of the layer.
 
@@ -119,6 +125,7 @@ ostream& operator<< (ostream& os, const Layer& l);
 struct Via
 {
     string name_;          ///< Name of the via.
+    util::SymbolId name_id_;
 
     struct Layer {
         string name_;
@@ -136,11 +143,13 @@ ostream& operator<< (ostream& os, const Via& v);
 
 
 /**
- * A class to represent an obstruction.
+ * A rectangle of an obstruction (OBS) of a macro, in microns. Paths, vias
+ * and polygons are kept as the rectangles they cover.
  */
 struct Obst
 {
-    // 
+    util::SymbolId layer_id_;
+    Rect rect_;
 };
 
 
@@ -150,18 +159,79 @@ struct Obst
 struct Macro
 {
     string name_;
+    util::SymbolId name_id_;
     string site_name_;
     double size_x_;
     double size_y_;
 
     SitePtr site_;
 
+    vector<PinPtr> pins_;     ///< Pins in the order of the LEF file.
     unordered_map<string, PinPtr> pin_umap_;
+
+    // The pin boxes in DBU for every orientation, as seen from the lower-left
+    // corner of the placed cell; see Lef::update_pin_boxes().
+    int pin_box_dbu_ = 0;               ///< DBU of the table, 0 if not built.
+    int size_x_dbu_ = 0;
+    int size_y_dbu_ = 0;
+    vector<util::Box> pin_boxes_;       ///< [orient * pins_.size() + pin]
+
+    vector<Obst> obsts_;      ///< Obstructions in the order of the LEF file.
+
+    // The obstructions in the DBU of the pin boxes, as placed N, grouped by
+    // layer: those on obs_layers_[i] are [obs_begin_[i], obs_begin_[i+1]).
+    vector<util::SymbolId> obs_layers_;
+    vector<uint32_t> obs_begin_;
+    vector<util::Box> obs_boxes_;
+
+    // The family of footprint-compatible macros the macro is in; see
+    // Lef::build_cell_families(). The pins of a family are ranked by name.
+    const CellFamily* family_ = nullptr;
+    vector<uint32_t> pin_ranks_;        ///< Rank of each pin.
+    vector<uint32_t> ranked_pins_;      ///< Pin of each rank.
+
+    /**
+     * @return The box of the pin @a pin placed with @a orient. An orient
+     *         out of range, -1 for an unplaced component, is taken as N, as
+     *         util::transform_box() does.
+     */
+    const util::Box& get_pin_box (size_t pin, int orient) const
+    {
+        if (orient < 0 || orient >= util::num_orients) {
+            orient = 0;
+        }
+        return pin_boxes_[orient * pins_.size() + pin];
+    }
+
+    /**
+     * @return Index of @a layer in obs_layers_, -1 if no obstruction is on it.
+     */
+    int find_obs_layer (util::SymbolId layer) const
+    {
+        for (size_t i = 0; i < obs_layers_.size(); i++) {
+            if (obs_layers_[i] == layer) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
 };
 
 ostream& operator<< (ostream& os, const Macro& m);
 
 
+/**
+ * Macros of the same function, pin names, pin directions and footprint,
+ * which differ in their threshold voltage or drive strength and can be
+ * swapped for one another in place.
+ */
+struct CellFamily
+{
+    string name_;               ///< Macro name with its varying parts as '*'.
+    vector<MacroPtr> macros_;   ///< By area, then by name.
+};
+
+
 /**
  * A class to represent a pin.
  */
@@ -169,6 +239,7 @@ struct Pin
 {
     MacroPtr owner_;
     string name_;
+    util::SymbolId name_id_;
     PinDir dir_;
     PinUse use_;
 
@@ -188,8 +259,7 @@ struct Port
     PinPtr owner_;
     LayerPtr layer_;
 
-    string name_;
-    string layer_name_;
+    util::SymbolId layer_id_;
     vector<Rect> rects_;
     Rect bbox_;
 };
@@ -205,15 +275,45 @@ class Lef
 public:
     static Lef& get_instance ();
 
-    void read_lef (string filename);
+    void read_lef (string filename, bool use_mmap = false, 
+                   string cache_dir = "");
+    void read_lefs (vector<string> filenames, bool use_mmap = false,
+                    string cache_dir = "", int num_workers = 1);
     void report () const;
     void report_verbose () const;
 
+    void write_snapshot (util::BinaryWriter& writer) const;
+    void read_snapshot (util::BinaryReader& reader);
+
     SitePtr get_site (string name);
     LayerPtr get_layer (string name);
+    ViaPtr get_via (string name);
     MacroPtr get_macro (string name);
+    MacroPtr get_macro (util::SymbolId name);
 
     int get_dbu () const;
+
+    /**
+     * Build the pin box and obstruction tables of the macros in @a dbu DBU
+     * per micron. The tables are built in the LEF DBU when a LEF is read; a
+     * DEF of another DBU calls this again. Tables already in @a dbu are kept.
+     */
+    void update_pin_boxes (int dbu);
+
+    /**
+     * Group the macros into cell families. The capture groups of the regular
+     * expression @a pattern mark the parts of a macro name that vary within
+     * a family, such as the threshold voltage and the drive strength; a
+     * macro whose name does not match is a family of its own. Macros of a
+     * family also have the same pin names and directions, and the same
+     * size, or the same height only if @a match_width is false.
+     *
+     * The families are built again with the last pattern whenever a LEF is
+     * read; by default "^SNPS(H|L|R|SL)OPT25_.+_([0-9]+)$".
+     */
+    void build_cell_families (string pattern, bool match_width = true);
+    const vector<CellFamily>& get_cell_families () const;
+
     double get_min_x_pitch () const;
     double get_min_y_pitch () const;
     int get_min_x_pitch_dbu () const;
@@ -225,6 +325,20 @@ private:
 
     friend class LefParser;
 
+    void update_min_pitches ();
+    void update_cell_families ();
+
+    void write_tables (util::BinaryWriter& writer, size_t first_site, 
+                       size_t first_layer, size_t first_via, 
+                       size_t first_macro) const;
+    void read_tables (util::BinaryReader& reader);
+
+    bool read_cache (string cache_file, uint64_t lef_hash, uint64_t lef_size,
+                     double& parse_time);
+    void write_cache (string cache_file, uint64_t lef_hash, uint64_t lef_size,
+                      double parse_time, size_t first_site, size_t first_layer,
+                      size_t first_via, size_t first_macro) const;
+
     Lef ();
     ~Lef () = default;
     Lef (const Lef&) = delete;
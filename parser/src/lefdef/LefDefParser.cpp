@@ -7,9 +7,17 @@
  */
 
 #include "LefDefParser.h"
+#include "DefWriter.h"
+#include "HpwlEngine.h"
+#include "Legality.h"
+#include "Legalizer.h"
+#include "TextBuffer.h"
+#include "Parallel.h"
 #include "StringUtil.h"
 #include "Watch.h"
 #include "Logger.h"
+#include "MappedFile.h"
+#include "BinaryIO.h"
 
 namespace my_lefdef
 {
@@ -18,7 +26,10 @@ namespace my_lefdef
  * Default ctor.
  */
 LefDefParser::LefDefParser () : lef_(lef::Lef::get_instance()),
-                                def_(def::Def::get_instance())
+                                def_(def::Def::get_instance()),
+                                use_mmap_(false),
+                                num_threads_(0),
+                                lef_cache_dir_()
 {
     //
 }
@@ -32,12 +43,61 @@ LefDefParser& LefDefParser::get_instance ()
     return ldp;
 }
 
+/**
+ * Print the read throughput of @a filename.
+ */
+static void report_throughput (string filename, 
+                               std::chrono::system_clock::time_point begin)
+{
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        return;
+    }
+    auto mb = st.st_size / (1024.0 * 1024.0);
+
+    cout << "Read " << fixed << setprecision(2) << mb << " MB in "
+         << setprecision(3) << elapsed << " sec ("
+         << setprecision(2) << (elapsed > 0 ? mb / elapsed : 0.0) << " MB/s)" 
+         << endl;
+    cout.unsetf(std::ios_base::floatfield);
+}
+
 /**
  * Read a LEF file @a filename.
  */
 void LefDefParser::read_lef (string filename)
 {
-    lef_.read_lef(filename);
+    auto begin = std::chrono::system_clock::now();
+    lef_.read_lef(filename, use_mmap_, lef_cache_dir_);
+    report_throughput(filename, begin);
+    lef_.report();
+}
+
+/**
+ * Read the LEF files @a filenames in order. With more than one thread set,
+ * they are parsed in parallel on worker processes and then merged.
+ */
+void LefDefParser::read_lefs (vector<string> filenames)
+{
+    if (num_threads_ <= 0 || filenames.size() <= 1) {
+        for (auto& filename : filenames) {
+            cout << "Reading LEF: " << filename << endl;
+            read_lef(filename);
+        }
+        return;
+    }
+
+    auto begin = std::chrono::system_clock::now();
+    lef_.read_lefs(filenames, use_mmap_, lef_cache_dir_, num_threads_);
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Read " << filenames.size() << " LEF files in " << fixed 
+         << setprecision(3) << elapsed << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
     lef_.report();
 }
 
@@ -46,16 +106,348 @@ void LefDefParser::read_lef (string filename)
  */
 void LefDefParser::read_def (string filename)
 {
-    def_.read_def(filename);
+    auto begin = std::chrono::system_clock::now();
+    def_.read_def(filename, use_mmap_, num_threads_);
+    report_throughput(filename, begin);
     def_.report();
 }
 
 /**
- *
+ * Read the SDC file @a filename, with its ports bound to the pins of the
+ * DEF read.
+ */
+void LefDefParser::read_sdc (string filename)
+{
+    auto begin = std::chrono::system_clock::now();
+    sdc_.read_sdc(filename, def_);
+    report_throughput(filename, begin);
+    sdc_.report();
+}
+
+/**
+ * Read the technology file @a filename, with its layers and contact codes
+ * linked to those of the LEF read.
+ */
+void LefDefParser::read_tf (string filename)
+{
+    auto begin = std::chrono::system_clock::now();
+    tech_.read_tf(filename, lef_);
+    report_throughput(filename, begin);
+    tech_.report();
+}
+
+/**
+ * Read the objective weights @a filename and evaluate the cost of the DEF
+ * read.
+ */
+void LefDefParser::read_weights (string filename)
+{
+    cost_.build(def_, opt::read_weights(filename));
+    cost_.report();
+}
+
+/**
+ * Read the following LEF/DEF files through memory mappings if @a use_mmap.
+ */
+void LefDefParser::set_mmap_input (bool use_mmap)
+{
+    use_mmap_ = use_mmap;
+}
+
+/**
+ * Read the COMPONENTS, PINS and NETS sections of the following DEF files
+ * with the native reader on @a num_threads threads, and multiple LEF files
+ * on as many worker processes (0 disables both).
+ */
+void LefDefParser::set_num_threads (int num_threads)
+{
+    num_threads_ = num_threads;
+}
+
+/**
+ * Cache the LEF files read from now on in @a cache_dir, keyed by their
+ * contents (an empty string disables the cache).
+ */
+void LefDefParser::set_lef_cache_dir (string cache_dir)
+{
+    lef_cache_dir_ = cache_dir;
+}
+
+/**
+ * Group the macros into cell families by @a pattern; see
+ * lef::Lef::build_cell_families().
+ */
+void LefDefParser::set_cell_family_pattern (string pattern)
+{
+    lef_.build_cell_families(pattern);
+}
+
+// Header of a snapshot file, followed by the payload.
+static const char snapshot_magic[8] = {'L', 'D', 'P', 'S', 'N', 'A', 'P', '\0'};
+static const uint32_t snapshot_version = 10;
+
+struct SnapshotHeader
+{
+    char magic_[8];
+    uint32_t version_;
+    uint32_t reserved_;
+    uint64_t payload_size_;
+    uint64_t checksum_;         ///< hash_bytes() of the payload.
+};
+
+/**
+ * Save the LEF library and the DEF design read so far to @a filename.
+ */
+void LefDefParser::save_snapshot (string filename) const
+{
+    cout << "Saving snapshot " << filename << endl;
+    util::Watch watch;
+
+    util::BinaryWriter writer;
+    lef_.write_snapshot(writer);
+    def_.write_snapshot(writer);
+    auto& payload = writer.get_buffer();
+
+    SnapshotHeader header;
+    memcpy(header.magic_, snapshot_magic, sizeof(snapshot_magic));
+    header.version_ = snapshot_version;
+    header.reserved_ = 0;
+    header.payload_size_ = payload.size();
+    header.checksum_ = util::hash_bytes(payload.data(), payload.size());
+
+    ofstream ofs(filename, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(payload.data(), payload.size());
+
+    if (!ofs) {
+        throw runtime_error("(E) Cannot write snapshot (" + filename + ").");
+    }
+}
+
+/**
+ * Replace the LEF library and the DEF design with the snapshot @a filename.
+ */
+void LefDefParser::load_snapshot (string filename)
+{
+    cout << "Loading snapshot " << filename << endl;
+    auto begin = std::chrono::system_clock::now();
+    {
+        util::Watch watch;
+        util::MappedFile mapped_file(filename);
+
+        auto data = mapped_file.get_data();
+        auto size = mapped_file.get_size();
+
+        SnapshotHeader header;
+        if (size < sizeof(header)) {
+            throw runtime_error("(E) Snapshot (" + filename + ") is truncated.");
+        }
+        memcpy(&header, data, sizeof(header));
+
+        if (memcmp(header.magic_, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+            throw runtime_error("(E) " + filename + " is not a snapshot.");
+        }
+        if (header.version_ != snapshot_version) {
+            throw runtime_error("(E) Snapshot (" + filename + ") has version "
+                                + std::to_string(header.version_) + ", expected "
+                                + std::to_string(snapshot_version) + ".");
+        }
+        if (header.payload_size_ != size - sizeof(header)) {
+            throw runtime_error("(E) Snapshot (" + filename + ") is truncated.");
+        }
+
+        auto payload = data + sizeof(header);
+        if (util::hash_bytes(payload, header.payload_size_) != header.checksum_) {
+            throw runtime_error("(E) Snapshot (" + filename + ") is corrupted.");
+        }
+
+        util::BinaryReader reader(payload, header.payload_size_);
+        lef_.read_snapshot(reader);
+        def_.read_snapshot(reader);
+    }
+    report_throughput(filename, begin);
+
+    lef_.report();
+    def_.report();
+}
+
+/**
+ * Write the DEF data to @a filename. Without threads set, it is written with
+ * the defw library; otherwise the buffered writer formats it on the threads.
+ * Throws if the file cannot be written.
+ */
+void LefDefParser::write_def (string filename) const
+{
+    auto begin = std::chrono::system_clock::now();
+    auto& writer = DefWriter::get_instance();
+    auto ok = false;
+    if (num_threads_ <= 0) {
+        ok = writer.write_def(def_, filename);
+    }
+    else {
+        ok = writer.write_def_buffered(def_, filename, num_threads_);
+    }
+    if (!ok) {
+        throw runtime_error("(E) Cannot write DEF (" + filename + ").");
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Wrote " << filename << " in " << fixed 
+         << setprecision(3) << elapsed << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+}
+
+/**
+ * Write the DEF file read to @a filename with only the placements of the 
+ * moved components changed (see DefWriter::rewrite_def()). If the file read
+ * is not available or the rewrite fails, the DEF data is written with
+ * write_def() instead.
+ */
+void LefDefParser::rewrite_def (string filename) const
+{
+    auto begin = std::chrono::system_clock::now();
+    if (!DefWriter::get_instance().rewrite_def(def_, filename)) {
+        cout << "Writing the whole DEF instead." << endl;
+        write_def(filename);
+        return;
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Rewrote " << filename << " (" << def_.get_num_moved_components()
+         << " components moved) in " << fixed << setprecision(3) << elapsed 
+         << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+}
+
+/**
+ * Print the total HPWL of the nets, computed on the threads set.
+ */
+void LefDefParser::report_hpwl () const
+{
+    auto begin = std::chrono::system_clock::now();
+    def::HpwlEngine hpwl;
+    hpwl.build(def_, num_threads_);
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "HPWL: " << hpwl.get_hpwl() << " DBU (" << hpwl.get_num_nets() 
+         << " nets, " << hpwl.get_num_pins() << " pins) in " << fixed 
+         << setprecision(3) << elapsed << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+}
+
+/**
+ * Check the placement of the components on the threads set, and print the
+ * violations found, the first few of each kind by name.
+ */
+void LefDefParser::check_legality () const
+{
+    auto begin = std::chrono::system_clock::now();
+    def::SiteMap sites;
+    auto report = def::check_legality(def_, sites, num_threads_);
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Legality: " << report.num_checked_ << " placed components ("
+         << report.num_unplaced_ << " unplaced) on " << sites.get_num_rows() 
+         << " rows in " << fixed << setprecision(3) << elapsed << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+
+    const size_t num_shown = 10;
+    auto& components = def_.get_components();
+    auto show = [&] (const char* kind, const vector<uint32_t>& ids) {
+        cout << "\t" << kind << ids.size() << endl;
+        for (size_t i = 0; i < ids.size() && i < num_shown; i++) {
+            auto& c = *components[ids[i]];
+            cout << "\t\t" << c.get_name() << " (" << c.x_ << ", " << c.y_ << ")" << endl;
+        }
+    };
+
+    cout << "\tOverlaps     : " << report.overlaps_.size() << endl;
+    for (size_t i = 0; i < report.overlaps_.size() && i < num_shown; i++) {
+        cout << "\t\t" << components[report.overlaps_[i].first]->get_name() 
+             << " - " << components[report.overlaps_[i].second]->get_name() 
+             << endl;
+    }
+    show("Off row      : ", report.off_row_);
+    show("Off site     : ", report.off_site_);
+    show("Off orient   : ", report.off_orient_);
+    show("Out of die   : ", report.out_of_die_);
+    show("Constrained  : ", report.constrained_);
+    cout << (report.is_legal() ? "Placement is legal." : "Placement is not legal.") << endl;
+}
+
+/**
+ * Legalize the placement of the movable components on the threads set,
+ * and print the displacement.
+ */
+void LefDefParser::legalize ()
+{
+    auto begin = std::chrono::system_clock::now();
+    auto report = def::legalize(def_, num_threads_);
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Legalized " << report.num_cells_ << " components ("
+         << report.num_moved_ << " moved, " << report.num_failed_ << " failed) in "
+         << fixed << setprecision(3) << elapsed << " sec" << endl;
+    cout << "\tAverage displacement: " << setprecision(1)
+         << report.get_average_displacement() << " DBU" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+    cout << "\tMaximum displacement: " << report.max_displacement_ << " DBU" << endl;
+}
+
+/**
+ * Time the DEF read with the constraints of the SDC read, with the drives
+ * of @a drive_table if given, and make it the timing term of the cost.
+ */
+void LefDefParser::time_design (string drive_table)
+{
+    // Wires of a middle metal layer, in kOhm and pF per micron.
+    const double wire_resistance = 0.01;
+    const double wire_capacitance = 0.0002;
+
+    auto begin = std::chrono::system_clock::now();
+    sta::DriveTable drives;
+    if (!drive_table.empty()) {
+        drives.read(drive_table);
+    }
+    timer_.build(def_, sdc_, sta::make_delay_model(drives, wire_resistance, wire_capacitance),
+                 num_threads_);
+
+    auto elapsed = std::chrono::duration<double>(
+                       std::chrono::system_clock::now() - begin).count();
+    cout << "Timed " << timer_.get_num_nodes() << " pins in " << fixed << setprecision(3)
+         << elapsed << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+    timer_.report();
+
+    cost_.set_timing_term([this] (const vector<uint32_t>& changed) {
+        timer_.update(changed);
+        return -timer_.get_tns();
+    });
+}
+
+/**
+ * Swap the macro of the component @a id for @a macro, one of its swap
+ * candidates, and tell the cost model.
+ */
+void LefDefParser::swap_macro (uint32_t id, lef::MacroPtr macro)
+{
+    def_.swap_macro(id, macro);
+    cost_.update_swapped(id);
+}
+
+/**
+ * Write the design in the bookshelf format, as @a filename.aux and the files
+ * it lists. The files are written concurrently, and objects are written in
+ * the order of their dense ids, so the output is the same from run to run.
  */
 void LefDefParser::write_bookshelf (string filename) const
 {
-    cout << "Writing bookshelf aux file." << endl;
+    cout << "Writing bookshelf files." << endl;
     ofstream ofs(filename + ".aux");
     ofs << "RowBasedPlacement : "
         << " " << filename << ".nodes"
@@ -66,27 +458,31 @@ void LefDefParser::write_bookshelf (string filename) const
         << " " << filename << ".shapes" << endl;
     ofs.close();
 
-    cout << "Writing bookshelf nodes file." << endl;
-    write_bookshelf_nodes (filename + ".nodes");
-
-    // nets
-    cout << "Writing bookshelf nets file." << endl;
-    write_bookshelf_nets (filename + ".nets");
-
-    // wts
-    cout << "Writing bookshelf wts file." << endl;
-    write_bookshelf_wts (filename + ".wts");
-
-    // scl
-    cout << "Writing bookshelf scl file." << endl;
-    write_bookshelf_scl (filename + ".scl");
-
-    // pl
-    cout << "Writing bookshelf pl file." << endl;
-    write_bookshelf_pl (filename + ".pl");
-
-    // aux
-    cout << "Writing bookshelf aux file." << endl;
+    using Writer = void (LefDefParser::*)(string) const;
+    const char* suffixes[] = { "nodes", "nets", "wts", "scl", "pl" };
+    Writer writers[] = {
+        &LefDefParser::write_bookshelf_nodes, &LefDefParser::write_bookshelf_nets,
+        &LefDefParser::write_bookshelf_wts, &LefDefParser::write_bookshelf_scl,
+        &LefDefParser::write_bookshelf_pl
+    };
+    const size_t num_files = sizeof(writers) / sizeof(writers[0]);
+
+    auto begin = std::chrono::system_clock::now();
+    vector<double> elapsed(num_files);
+    util::parallel_for(num_files, num_files, [&] (size_t i) {
+        auto file_begin = std::chrono::system_clock::now();
+        (this->*writers[i])(filename + "." + suffixes[i]);
+        elapsed[i] = std::chrono::duration<double>(
+                         std::chrono::system_clock::now() - file_begin).count();
+    });
+
+    for (size_t i = 0; i < num_files; i++) {
+        cout << "\t" << std::setw(6) << std::left << suffixes[i] << ": " 
+             << fixed << setprecision(3) << elapsed[i] << " sec" << endl;
+    }
+    cout << "\tTotal : " << std::chrono::duration<double>(
+                std::chrono::system_clock::now() - begin).count() << " sec" << endl;
+    cout.unsetf(std::ios_base::floatfield);
 }
 
 /**
@@ -103,57 +499,85 @@ static string get_current_time_stamp ()
     return oss.str();
 }
 
+/**
+ * Write @a header followed by @a body to @a filename.
+ */
+static void write_text_file (string filename, const util::TextBuffer& header,
+                             const vector<util::TextBuffer>& body)
+{
+    auto fp = unique_ptr<FILE, decltype(&fclose)>(
+                  fopen(filename.c_str(), "w"), &fclose);
+    if (fp == nullptr) {
+        throw invalid_argument("Cannot open " + filename);
+    }
+
+    auto ok = header.write(fp.get());
+    for (auto& buf : body) {
+        ok = buf.write(fp.get()) && ok;
+    }
+    if (!ok) {
+        throw runtime_error("Cannot write " + filename);
+    }
+}
+
 /**
  *
  */
 void LefDefParser::write_bookshelf_nodes (string filename) const
 {
-    ofstream ofs(filename);
-    ofs << "UCLA nodes 1.0" << endl;
-    ofs << "# Created : ";
-    ofs << get_current_time_stamp() << endl;
+    util::TextBuffer header;
+    header.append("UCLA nodes 1.0\n");
+    header.append("# Created : ").append(get_current_time_stamp()).append('\n');
 
-    auto& component_umap = def_.get_component_umap();
-    auto& pin_umap = def_.get_pin_umap();
+    auto& components = def_.get_components();
+    auto& pins = def_.get_pins();
 
     const auto x_pitch = lef_.get_min_x_pitch();
     const auto y_pitch = lef_.get_min_y_pitch();
 
-    auto num_terminals = pin_umap.size();
-    for (auto c : component_umap) {
-        if (c.second->is_fixed_) {
+    auto num_terminals = pins.size();
+    for (auto& c : components) {
+        if (c->is_fixed_) {
             num_terminals++;
         }
     }
 
-    ofs << "NumNodes : " << component_umap.size() + pin_umap.size() << endl;
-    ofs << "NumTerminals : " << num_terminals << endl;
-
-    for (auto p : pin_umap) {
-        ofs << "\t" << std::setw(40) << std::left  << p.first;
-        ofs << "\t" << std::setw(8)  << std::right << 1;
-        ofs << "\t" << std::setw(8)  << std::right << 1;
-        ofs << "\t" << "terminal" << endl;
-    }
+    header.append("NumNodes : ").append_int(components.size() + pins.size()).append('\n');
+    header.append("NumTerminals : ").append_int(num_terminals).append('\n');
+
+    auto num_pins = pins.size();
+    auto& symbols = util::SymbolTable::get_instance();
+    auto body = util::format_chunks(num_pins + components.size(), num_threads_,
+                    [&] (util::TextBuffer& buf, size_t i) {
+        if (i < num_pins) {
+            auto name = pins[i]->name_id_;
+            buf.append('\t').append_left(symbols.get_name(name), 
+                                          symbols.get_length(name), 40);
+            buf.append('\t').append_int_right(1, 8);
+            buf.append('\t').append_int_right(1, 8);
+            buf.append("\tterminal\n");
+            return;
+        }
 
-    for (auto c : component_umap) {
-        ofs << "\t" << std::setw(40) << std::left << c.first;
+        auto& c = components[i - num_pins];
+        buf.append('\t').append_left(symbols.get_name(c->name_id_), 
+                                      symbols.get_length(c->name_id_), 40);
 
         // Get width and height
-        auto macro = c.second->lef_macro_;
-        auto site = macro->site_;
+        auto macro = c->lef_macro_;
         auto w = lround(macro->size_x_ / x_pitch);
         auto h = lround(macro->size_y_ / y_pitch);
 
-        ofs << "\t" << std::setw(8) << std::right << w;
-        ofs << "\t" << std::setw(8) << std::right << h;
+        buf.append('\t').append_int_right(w, 8);
+        buf.append('\t').append_int_right(h, 8);
         
-        if (c.second->is_fixed_) {
-            ofs << "\t" << "terminal";
+        if (c->is_fixed_) {
+            buf.append("\tterminal");
         }
-        ofs << endl;
-    }
-    ofs.close();
+        buf.append('\n');
+    });
+
+    write_text_file(filename, header, body);
 }
 
 /**
@@ -161,61 +585,59 @@ void LefDefParser::write_bookshelf_nodes (string filename) const
  */
 void LefDefParser::write_bookshelf_nets (string filename) const
 {
-    ofstream ofs(filename);
-    ofs << "UCLA nets 1.0" << endl;
-    ofs << "# Created : ";
-    ofs << get_current_time_stamp() << endl << endl;
+    util::TextBuffer header;
+    header.append("UCLA nets 1.0\n");
+    header.append("# Created : ").append(get_current_time_stamp()).append("\n\n");
 
-    auto& net_umap = def_.get_net_umap();
-    auto num_connections = 0;
+    auto& nets = def_.get_nets();
+    size_t num_connections = 0;
 
-    for (auto& n : net_umap) {
-        auto net = n.second;
-        num_connections += net->connections_.size();
+    for (auto& n : nets) {
+        num_connections += n->connections_.size();
     }
 
     // Count the number of pins
-    ofs << "NumNets : " << net_umap.size() << endl;
-    ofs << "NumPins : " << num_connections << endl << endl;
+    header.append("NumNets : ").append_int(nets.size()).append('\n');
+    header.append("NumPins : ").append_int(num_connections).append("\n\n");
 
-    for (auto& n : net_umap) {
-        auto net = n.second;
-        ofs << "NetDegree : " << std::setw(8) << std::right
-            << net->connections_.size() << "\t" << n.first << endl;
+    auto& symbols = util::SymbolTable::get_instance();
+    auto body = util::format_chunks(nets.size(), num_threads_,
+                    [&] (util::TextBuffer& buf, size_t i) {
+        auto& net = nets[i];
+        buf.append("NetDegree : ").append_int_right(net->connections_.size(), 8)
+           .append('\t').append(symbols.get_name(net->name_id_), 
+                                 symbols.get_length(net->name_id_)).append('\n');
 
         for (auto& c : net->connections_) {
             // Populate the name and the direction of the pin
-            string name;
+            util::SymbolId name;
             PinDir direction;
 
-            if (c->lef_pin_ == nullptr) {
-                name = c->name_;
-                direction = c->pin_->dir_;
+            if (c.lef_pin_ == nullptr) {
+                name = c.pin_->name_id_;
+                direction = c.pin_->dir_;
             }
             else {
-                name = c->component_->name_;
-                direction = c->lef_pin_->dir_;
+                name = c.component_->name_id_;
+                direction = c.lef_pin_->dir_;
             }
 
-            // Print out
-            ofs << "\t" << std::setw(20) << std::left << name;
-            if (direction == PinDir::input) {
-                ofs << " I  :";
-            }
-            else if (direction == PinDir::output) {
-                ofs << " O  :";
+            buf.append('\t').append_left(symbols.get_name(name), 
+                                          symbols.get_length(name), 20);
+            if (direction == PinDir::output) {
+                buf.append(" O  :");
             }
             else {
-                // FIXME
-                ofs << " I  :";
+                // FIXME: inout pins are written as inputs.
+                buf.append(" I  :");
             }
 
             // Offset
-            ofs << " 0.5 0.5" << endl;
+            buf.append(" 0.5 0.5\n");
         }
-    }
+    });
 
-    ofs.close();
+    write_text_file(filename, header, body);
 }
 
 /**
@@ -223,18 +645,21 @@ void LefDefParser::write_bookshelf_nets (string filename) const
  */
 void LefDefParser::write_bookshelf_wts (string filename) const
 {
-    ofstream ofs(filename);
-    ofs << "UCLA wts 1.0" << endl;
-    ofs << "# Created : ";
-    ofs << get_current_time_stamp() << endl << endl;
+    util::TextBuffer header;
+    header.append("UCLA wts 1.0\n");
+    header.append("# Created : ").append(get_current_time_stamp()).append("\n\n");
 
-    auto& net_umap = def_.get_net_umap();
+    auto& nets = def_.get_nets();
 
-    for (auto& n : net_umap) {
-        ofs << std::setw(40) << std::left << n.first << "\t1" << endl;
-    }
+    auto& symbols = util::SymbolTable::get_instance();
+    auto body = util::format_chunks(nets.size(), num_threads_,
+                    [&] (util::TextBuffer& buf, size_t i) {
+        auto name = nets[i]->name_id_;
+        buf.append_left(symbols.get_name(name), symbols.get_length(name), 40)
+           .append("\t1\n");
+    });
 
-    ofs.close();
+    write_text_file(filename, header, body);
 }
 
 /**
@@ -242,10 +667,9 @@ void LefDefParser::write_bookshelf_wts (string filename) const
  */
 void LefDefParser::write_bookshelf_scl (string filename) const
 {
-    ofstream ofs(filename);
-    ofs << "UCLA scl 1.0" << endl;
-    ofs << "# Created : ";
-    ofs << get_current_time_stamp() << endl << endl;
+    util::TextBuffer header;
+    header.append("UCLA scl 1.0\n");
+    header.append("# Created : ").append(get_current_time_stamp()).append("\n\n");
 
     auto& rows = def_.get_rows();
 
@@ -255,11 +679,13 @@ void LefDefParser::write_bookshelf_scl (string filename) const
     auto x_pitch_dbu = lef_.get_min_x_pitch_dbu();
     auto y_pitch_dbu = lef_.get_min_y_pitch_dbu();
 
-    ofs << "NumRows : " << rows.size() << endl << endl;
+    header.append("NumRows : ").append_int(rows.size()).append("\n\n");
 
-    for (auto& r : rows) {
+    auto body = util::format_chunks(rows.size(), num_threads_,
+                    [&] (util::TextBuffer& buf, size_t i) {
+        auto& r = rows[i];
         auto site = lef_.get_site(r->macro_);
-        string sym_str;
+        const char* sym_str;
         if (site->symmetry_ == SiteSymmetry::x) {
             sym_str = "X"; 
         }
@@ -274,20 +700,20 @@ void LefDefParser::write_bookshelf_scl (string filename) const
             sym_str = "Y";
         }
 
-        ofs << "CoreRow Horizontal" << endl;
-        ofs << "\tCoordinate   : " << r->y_ / y_pitch_dbu << endl;
-        ofs << "\tHeight       : " << site->y_ / y_pitch << endl;
-        ofs << "\tSitewidth    : " << site->x_ / x_pitch << endl;
-        ofs << "\tSitespacing  : " << r->step_x_ / x_pitch_dbu << endl;
-        ofs << "\tSiteorient   : " << r->orient_str_ << endl;
-        ofs << "\tSitesymmetry : " << sym_str << endl;
-
-        ofs << "\tSubrowOrigin : " << r->x_ / x_pitch_dbu;
-        ofs << "\tNumSites : " << r->num_x_ << endl;
-        ofs << "End" << endl;
-    }
+        buf.append("CoreRow Horizontal\n");
+        buf.append("\tCoordinate   : ").append_int(r->y_ / y_pitch_dbu).append('\n');
+        buf.append("\tHeight       : ").append_double(site->y_ / y_pitch).append('\n');
+        buf.append("\tSitewidth    : ").append_double(site->x_ / x_pitch).append('\n');
+        buf.append("\tSitespacing  : ").append_int(r->step_x_ / x_pitch_dbu).append('\n');
+        buf.append("\tSiteorient   : ").append(r->orient_str_).append('\n');
+        buf.append("\tSitesymmetry : ").append(sym_str).append('\n');
 
-    ofs.close();
+        buf.append("\tSubrowOrigin : ").append_int(r->x_ / x_pitch_dbu);
+        buf.append("\tNumSites : ").append_int(r->num_x_).append('\n');
+        buf.append("End\n");
+    });
+
+    write_text_file(filename, header, body);
 }
 
 /**
@@ -295,40 +721,45 @@ void LefDefParser::write_bookshelf_scl (string filename) const
  */
 void LefDefParser::write_bookshelf_pl (string filename) const
 {
-    ofstream ofs(filename);
-    ofs << "UCLA pl 1.0" << endl;
-    ofs << "# Created : ";
-    ofs << get_current_time_stamp() << endl << endl;
+    util::TextBuffer header;
+    header.append("UCLA pl 1.0\n");
+    header.append("# Created : ").append(get_current_time_stamp()).append("\n\n");
 
-    auto& component_umap = def_.get_component_umap();
-    auto& pin_umap = def_.get_pin_umap();
+    auto& components = def_.get_components();
+    auto& pins = def_.get_pins();
 
     auto x_pitch_dbu = lef_.get_min_x_pitch_dbu();
     auto y_pitch_dbu = lef_.get_min_y_pitch_dbu();
 
-    for (auto it : component_umap) {
-        auto c = it.second;
-        ofs << std::setw(40) << std::left << c->name_;
-
-        if (c->is_placed_ || c->is_fixed_) {
-            ofs << "\t" << c->x_ / x_pitch_dbu 
-                << "\t" << c->y_ / y_pitch_dbu 
-                << "\t: " << c->orient_str_ << endl;
-        }
-        else {
-            ofs << "\t" << 0 << "\t" << 0 << "\t: N" << endl;
+    auto num_components = components.size();
+    auto& symbols = util::SymbolTable::get_instance();
+    auto body = util::format_chunks(num_components + pins.size(), num_threads_,
+                    [&] (util::TextBuffer& buf, size_t i) {
+        if (i < num_components) {
+            auto& c = components[i];
+            buf.append_left(symbols.get_name(c->name_id_), 
+                            symbols.get_length(c->name_id_), 40);
+
+            if (c->is_placed_ || c->is_fixed_) {
+                buf.append('\t').append_int(c->x_ / x_pitch_dbu)
+                   .append('\t').append_int(c->y_ / y_pitch_dbu)
+                   .append("\t: ").append(c->orient_str_).append('\n');
+            }
+            else {
+                buf.append("\t0\t0\t: N\n");
+            }
+            return;
         }
-    }
 
-    for (auto& it : pin_umap) {
-        auto p = it.second;
-        ofs << std::setw(40) << std::left  << p->name_;
-        ofs << "\t" << p->x_ / x_pitch_dbu
-            << "\t" << p->y_ / y_pitch_dbu 
-            << "\t: " << p->orient_str_ << endl;
-    }
+        auto& p = pins[i - num_components];
+        buf.append_left(symbols.get_name(p->name_id_), 
+                        symbols.get_length(p->name_id_), 40);
+        buf.append('\t').append_int(p->x_ / x_pitch_dbu)
+           .append('\t').append_int(p->y_ / y_pitch_dbu)
+           .append("\t: ").append(p->orient_str_).append('\n');
+    });
 
-    ofs.close();
+    write_text_file(filename, header, body);
 }
 
 /**
@@ -363,28 +794,26 @@ void LefDefParser::update_def (string bookshelf_pl)
     }
 
     cout << "Updating DEF file..." << endl;
-    auto& component_umap = def_.get_component_umap();
+    auto& components = def_.get_components();
     auto x_pitch_dbu = lef_.get_min_x_pitch_dbu();
     auto y_pitch_dbu = lef_.get_min_y_pitch_dbu();
 
-    for (auto it : component_umap) {
-        auto found = pl_umap.find(it.first);
+    for (auto& c : components) {
+        auto name = c->get_name();
+        auto found = pl_umap.find(name);
         if (found == pl_umap.end()) {
-            cout << "Error: " << it.first << " not found in .pl." << endl;
+            cout << "Error: " << name << " not found in .pl." << endl;
+            continue;
         }
-        if (!it.second->is_fixed_) {
-            auto x_orig = it.second->x_;
-            auto y_orig = it.second->y_;
+        if (!c->is_fixed_) {
             auto x_new = found->second.first * x_pitch_dbu;
             auto y_new = found->second.second * y_pitch_dbu;
-//            cout << it.first << " : (" << x_orig << ", " << y_orig << ")"
-//                             << " -> (" << x_new << ", " << y_new << ")" << endl;
-            it.second->x_ = x_new; 
-            it.second->y_ = y_new; 
-
-            it.second->is_placed_ = true;
+            if (!c->is_placed_ || x_new != c->x_ || y_new != c->y_) {
+                def_.move_component(c->id_, x_new, y_new);
+            }
         }
     }
+    cout << "Moved " << def_.get_num_moved_components() << " components." << endl;
 }
 
 
@@ -393,4 +822,24 @@ def::Def& LefDefParser::get_def ()
     return def_;
 }
 
+const sdc::Sdc& LefDefParser::get_sdc () const
+{
+    return sdc_;
+}
+
+const tf::Tech& LefDefParser::get_tech () const
+{
+    return tech_;
+}
+
+opt::CostModel& LefDefParser::get_cost_model ()
+{
+    return cost_;
+}
+
+sta::Timer& LefDefParser::get_timer ()
+{
+    return timer_;
+}
+
 }
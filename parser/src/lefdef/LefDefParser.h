@@ -13,6 +13,10 @@
 
 #include "Lef.h"
 #include "Def.h"
+#include "Sdc.h"
+#include "Tech.h"
+#include "CostModel.h"
+#include "Timer.h"
 #include "util.h"
 
 namespace my_lefdef
@@ -22,7 +26,28 @@ class LefDefParser
 {
 public:
     void read_lef (string filename);
+    void read_lefs (vector<string> filenames);
     void read_def (string filename);
+    void read_sdc (string filename);
+    void read_tf (string filename);
+    void read_weights (string filename);
+
+    void set_mmap_input (bool use_mmap);
+    void set_num_threads (int num_threads);
+    void set_lef_cache_dir (string cache_dir);
+    void set_cell_family_pattern (string pattern);
+
+    void save_snapshot (string filename) const;
+    void load_snapshot (string filename);
+
+    void report_hpwl () const;
+    void check_legality () const;
+    void legalize ();
+    void time_design (string drive_table = "");
+    void swap_macro (uint32_t id, lef::MacroPtr macro);
+
+    void write_def (string filename) const;
+    void rewrite_def (string filename) const;
 
     void write_bookshelf (string filename) const;
     void write_bookshelf_nodes (string filename) const;
@@ -37,10 +62,22 @@ public:
 
     // Following functions will be removed soon
     def::Def& get_def ();
+    const sdc::Sdc& get_sdc () const;
+    const tf::Tech& get_tech () const;
+    opt::CostModel& get_cost_model ();
+    sta::Timer& get_timer ();
 
 private:
     lef::Lef&    lef_;
     def::Def&    def_;
+    sdc::Sdc     sdc_;
+    tf::Tech     tech_;
+    opt::CostModel cost_;
+    sta::Timer   timer_;
+
+    bool use_mmap_;     ///< Read LEF/DEF files through memory mappings.
+    int num_threads_;   ///< Threads of the native DEF reader and LEF workers.
+    string lef_cache_dir_;  ///< Directory of the LEF cache, empty to disable it.
 
     // Do not allow instantiation of this class.
     LefDefParser ();
@@ -0,0 +1,172 @@
+/**
+ * @file    Legality.cpp
+ */
+
+#include "Legality.h"
+#include "PlacementConstraints.h"
+#include "Parallel.h"
+
+#include <atomic>
+
+using namespace std;
+
+namespace def
+{
+
+/**
+ * Violations found in a block of components.
+ */
+struct CellViolations
+{
+    size_t num_unplaced_ = 0;
+    vector<uint32_t> off_row_;
+    vector<uint32_t> off_site_;
+    vector<uint32_t> off_orient_;
+    vector<uint32_t> out_of_die_;
+    vector<uint32_t> constrained_;
+};
+
+/**
+ * The cells are checked one by one in blocks, and bucketed by the rows
+ * they cross. Then every row sorts its cells by their first site and sweeps
+ * them left to right, keeping the cell that reaches furthest: a cell that
+ * starts before it ends overlaps it. Rows own their words in the site map,
+ * so they are filled in parallel.
+ */
+LegalityReport check_legality (const Def& def, SiteMap& sites, int num_threads)
+{
+    sites.build(def);
+
+    auto& components = def.get_components();
+    auto& constraints = def.get_placement_constraints();
+    const util::Box die(def.get_die_lx(), def.get_die_ly(),
+                        def.get_die_ux(), def.get_die_uy());
+    const auto num_rows = sites.get_num_rows();
+
+    const size_t block_size = 1 << 14;
+    const auto num_blocks = (components.size() + block_size - 1) / block_size;
+
+    vector<CellViolations> blocks(num_blocks);
+    vector<pair<uint32_t, uint32_t>> rows_of_cell(components.size());
+    vector<atomic<uint32_t>> row_count(num_rows + 1);
+
+    util::parallel_for(num_blocks, num_threads, [&] (size_t b) {
+        auto& v = blocks[b];
+        auto end = min(components.size(), (b + 1) * block_size);
+        for (auto id = b * block_size; id < end; id++) {
+            auto& c = *components[id];
+            if (!c.is_placed_ && !c.is_fixed_) {
+                rows_of_cell[id] = make_pair(0u, 0u);
+                v.num_unplaced_++;
+                continue;
+            }
+
+            auto box = get_cell_box(c, c.x_, c.y_);
+            auto rows = sites.find_rows(box.ly_, box.uy_);
+            rows_of_cell[id] = rows;
+            for (auto r = rows.first; r < rows.second; r++) {
+                row_count[r].fetch_add(1, memory_order_relaxed);
+            }
+
+            if (c.is_fixed_) {
+                continue;
+            }
+
+            auto row = sites.find_row(box.lx_, box.ly_);
+            if (row < 0 || box.ux_ > sites.get_row(row).get_ux()) {
+                v.off_row_.push_back(id);
+            }
+            else if ((box.lx_ - sites.get_row(row).x_) % sites.get_row(row).site_width_ != 0) {
+                v.off_site_.push_back(id);
+            }
+            // A cell may be mirrored about the y axis (FN in an N row).
+            if (row >= 0 && c.orient_ != sites.get_row(row).orient_ 
+                && c.orient_ != (sites.get_row(row).orient_ ^ 4)) {
+                v.off_orient_.push_back(id);
+            }
+            if (box.lx_ < die.lx_ || box.ly_ < die.ly_ || box.ux_ > die.ux_ || box.uy_ > die.uy_) {
+                v.out_of_die_.push_back(id);
+            }
+            if (!constraints.is_allowed(id, box)) {
+                v.constrained_.push_back(id);
+            }
+        }
+    });
+
+    // Row -> cells, in CSR form; the counters become the insert positions.
+    vector<uint32_t> row_begin(num_rows + 1, 0);
+    for (size_t r = 0; r < num_rows; r++) {
+        row_begin[r + 1] = row_begin[r] + row_count[r].load(memory_order_relaxed);
+        row_count[r].store(row_begin[r], memory_order_relaxed);
+    }
+
+    vector<uint32_t> row_cells(row_begin.back());
+    util::parallel_for(num_blocks, num_threads, [&] (size_t b) {
+        auto end = min(components.size(), (b + 1) * block_size);
+        for (auto id = b * block_size; id < end; id++) {
+            auto rows = rows_of_cell[id];
+            for (auto r = rows.first; r < rows.second; r++) {
+                row_cells[row_count[r].fetch_add(1, memory_order_relaxed)] = id;
+            }
+        }
+    });
+
+    // Sweep every row.
+    vector<vector<pair<uint32_t, uint32_t>>> row_overlaps(num_rows);
+    util::parallel_for(num_rows, num_threads, [&] (size_t r) {
+        struct Item { uint32_t first_, last_, id_; };
+        vector<Item> items;
+        items.reserve(row_begin[r + 1] - row_begin[r]);
+
+        for (auto i = row_begin[r]; i < row_begin[r + 1]; i++) {
+            auto& c = *components[row_cells[i]];
+            auto s = sites.get_sites(r, get_cell_box(c, c.x_, c.y_));
+            if (s.first < s.second) {
+                items.push_back(Item{s.first, s.second, c.id_});
+            }
+        }
+        sort(items.begin(), items.end(), [] (const Item& a, const Item& b) {
+            return a.first_ < b.first_ || (a.first_ == b.first_ && a.id_ < b.id_);
+        });
+
+        const Item* reach = nullptr;
+        for (auto& item : items) {
+            if (reach != nullptr && item.first_ < reach->last_
+                && !(components[item.id_]->is_fixed_ && components[reach->id_]->is_fixed_)) {
+                row_overlaps[r].emplace_back(min(item.id_, reach->id_),
+                                             max(item.id_, reach->id_));
+            }
+            if (reach == nullptr || item.last_ > reach->last_) {
+                reach = &item;
+            }
+            sites.set_sites(r, item.first_, item.last_, true);
+        }
+    });
+
+    LegalityReport report;
+    report.num_unplaced_ = 0;
+    for (auto& v : blocks) {
+        report.num_unplaced_ += v.num_unplaced_;
+        report.off_row_.insert(report.off_row_.end(), v.off_row_.begin(), v.off_row_.end());
+        report.off_site_.insert(report.off_site_.end(), v.off_site_.begin(), v.off_site_.end());
+        report.off_orient_.insert(report.off_orient_.end(),
+                                  v.off_orient_.begin(), v.off_orient_.end());
+        report.out_of_die_.insert(report.out_of_die_.end(),
+                                  v.out_of_die_.begin(), v.out_of_die_.end());
+        report.constrained_.insert(report.constrained_.end(),
+                                   v.constrained_.begin(), v.constrained_.end());
+    }
+    report.num_checked_ = components.size() - report.num_unplaced_;
+
+    // A cell over several rows may be paired in each.
+    for (auto& o : row_overlaps) {
+        report.overlaps_.insert(report.overlaps_.end(), o.begin(), o.end());
+    }
+    sort(report.overlaps_.begin(), report.overlaps_.end());
+    report.overlaps_.erase(unique(report.overlaps_.begin(), report.overlaps_.end()),
+                           report.overlaps_.end());
+
+    return report;
+}
+
+}   // End of namespace def
@@ -0,0 +1,51 @@
+/**
+ * @file    Legality.h
+ */
+
+#ifndef LEGALITY_H
+#define LEGALITY_H
+
+#include "common_header.h"
+#include "SiteMap.h"
+
+namespace def
+{
+
+/**
+ * Violations of a placement, by dense component id in increasing order.
+ */
+struct LegalityReport
+{
+    size_t num_checked_;        ///< Placed components.
+    size_t num_unplaced_;
+
+    // Each overlapping movable cell is paired with one cell it overlaps
+    // (the one reaching furthest right among those on its left); a pair is
+    // listed once. Fixed cells are not paired with each other, so a fixed
+    // cell under a wider fixed cell may be left out.
+    vector<pair<uint32_t, uint32_t>> overlaps_;
+
+    // Movable cells only.
+    vector<uint32_t> off_row_;      ///< The bottom is not on a row spanning the cell.
+    vector<uint32_t> off_site_;     ///< The left is not on a site of its row.
+    vector<uint32_t> off_orient_;   ///< Not in the orientation of its row, or its mirror.
+    vector<uint32_t> out_of_die_;
+    vector<uint32_t> constrained_;  ///< Against blockages or fences.
+
+    bool is_legal () const
+    {
+        return overlaps_.empty() && off_row_.empty() && off_site_.empty()
+               && off_orient_.empty() && out_of_die_.empty() && constrained_.empty();
+    }
+};
+
+/**
+ * Check the placement of the components of @a def on @a num_threads
+ * threads, and fill @a sites with the cells. @a sites is rebuilt from the
+ * rows of @a def.
+ */
+LegalityReport check_legality (const Def& def, SiteMap& sites, int num_threads = 1);
+
+}   // End of namespace def
+
+#endif
@@ -0,0 +1,557 @@
+/**
+ * @file    Legalizer.cpp
+ */
+
+#include "Legalizer.h"
+#include "SiteMap.h"
+#include "PlacementConstraints.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace def
+{
+
+namespace
+{
+
+/**
+ * A movable component to legalize.
+ */
+struct Cell
+{
+    uint32_t id_;
+    int x_;             ///< Place to start from, in DBU.
+    int y_;
+    int width_;
+    int height_;
+    int fence_;         ///< -1 if none.
+};
+
+/**
+ * Cells packed side by side from the site x_ of a segment: the cells of
+ * Segment::cells_ from first_ to the first cell of the next cluster.
+ */
+struct Cluster
+{
+    uint32_t first_;
+    double e_;          ///< Number of cells.
+    double q_;          ///< q_ / e_ is the site minimizing the squared displacement.
+    int width_;         ///< In sites.
+    int x_;
+};
+
+/**
+ * The free sites [first_, last_) of a row, all in one fence or in none.
+ */
+struct Segment
+{
+    uint32_t row_;
+    uint32_t first_;
+    uint32_t last_;
+    int fence_;         ///< -1 out of the fences.
+    int lx_;            ///< In DBU.
+    int ux_;
+    uint32_t used_;     ///< Sites taken by the cells.
+    vector<uint32_t> cells_;    ///< Left to right.
+    vector<Cluster> clusters_;
+};
+
+/**
+ * The segments of the rows, by line: the rows at the same y, left to right.
+ */
+struct Segments
+{
+    const SiteMap* sites_;
+    const vector<Cell>* cells_;
+    vector<Segment> segments_;
+    vector<int> line_y_;
+    vector<uint32_t> line_begin_;   ///< Line l has the segments [line_begin_[l], line_begin_[l+1]).
+};
+
+inline int get_width_in_sites (const Cell& c, const SiteMap::SiteRow& row)
+{
+    return (c.width_ + row.site_width_ - 1) / row.site_width_;
+}
+
+/**
+ * @return The site nearest to @a x where @a width sites fit in @a s.
+ */
+inline int clamp_site (double x, const Segment& s, int width)
+{
+    auto site = static_cast<int64_t>(llround(x));
+    site = min<int64_t>(site, static_cast<int64_t>(s.last_) - width);
+    return static_cast<int>(max<int64_t>(site, s.first_));
+}
+
+/**
+ * @return The site a cell of @a width sites aiming at the site @a target
+ *         gets if appended to @a s; @a s must have room for it.
+ */
+int try_append (const Segment& s, double target, int width)
+{
+    auto e = 1.0;
+    auto q = target;
+    auto w = width;
+    auto x = clamp_site(q / e, s, w);
+    for (auto k = s.clusters_.size(); k-- > 0; ) {
+        auto& cluster = s.clusters_[k];
+        if (cluster.x_ + cluster.width_ <= x) {
+            break;
+        }
+        q = cluster.q_ + q - e * cluster.width_;
+        e += cluster.e_;
+        w += cluster.width_;
+        x = clamp_site(q / e, s, w);
+    }
+    return x + w - width;
+}
+
+/**
+ * Append the cell @a cell to @a s, and collapse the clusters it pushes.
+ */
+void append (Segment& s, uint32_t cell, double target, int width)
+{
+    Cluster cur{static_cast<uint32_t>(s.cells_.size()), 1.0, target, width, 0};
+    cur.x_ = clamp_site(target, s, width);
+    s.cells_.push_back(cell);
+    s.used_ += width;
+
+    while (!s.clusters_.empty()) {
+        auto& prev = s.clusters_.back();
+        if (prev.x_ + prev.width_ <= cur.x_) {
+            break;
+        }
+        prev.q_ += cur.q_ - cur.e_ * prev.width_;
+        prev.e_ += cur.e_;
+        prev.width_ += cur.width_;
+        cur = prev;
+        s.clusters_.pop_back();
+        cur.x_ = clamp_site(cur.q_ / cur.e_, s, cur.width_);
+    }
+    s.clusters_.push_back(cur);
+}
+
+/**
+ * Append the cell @a i to the segment of the lines [@a first_line,
+ * @a last_line) where it lands nearest. Lines are tried from the nearest
+ * one out, and segments from the nearest one out, while they may be
+ * nearer than the best so far.
+ * @return False if none of the segments of its fence has room for it.
+ */
+bool place_cell (Segments& rows, uint32_t i, uint32_t first_line, uint32_t last_line)
+{
+    auto& c = (*rows.cells_)[i];
+    auto& segments = rows.segments_;
+    auto best = numeric_limits<int64_t>::max();
+    Segment* best_segment = nullptr;
+
+    auto try_segment = [&] (Segment& s, int64_t dy) {
+        if (s.fence_ != c.fence_) {
+            return;
+        }
+        auto& row = rows.sites_->get_row(s.row_);
+        auto width = get_width_in_sites(c, row);
+        if (s.used_ + width > s.last_ - s.first_) {
+            return;
+        }
+        auto target = static_cast<double>(c.x_ - row.x_) / row.site_width_;
+        auto x = row.x_ + static_cast<int64_t>(try_append(s, target, width)) * row.site_width_;
+        auto cost = dy + llabs(x - c.x_);
+        if (cost < best) {
+            best = cost;
+            best_segment = &s;
+        }
+    };
+
+    auto try_line = [&] (uint32_t l, int64_t dy) {
+        auto begin = segments.begin() + rows.line_begin_[l];
+        auto end = segments.begin() + rows.line_begin_[l + 1];
+        auto mid = upper_bound(begin, end, c.x_,
+                               [] (int x, const Segment& s) { return x < s.ux_; });
+        for (auto it = mid; it != end; ++it) {
+            if (dy + max<int64_t>(0, static_cast<int64_t>(it->lx_) - c.x_) >= best) {
+                break;
+            }
+            try_segment(*it, dy);
+        }
+        for (auto it = mid; it != begin; --it) {
+            auto& s = *(it - 1);
+            if (dy + max<int64_t>(0, static_cast<int64_t>(c.x_) + c.width_ - s.ux_) >= best) {
+                break;
+            }
+            try_segment(s, dy);
+        }
+    };
+
+    auto& line_y = rows.line_y_;
+    auto up = static_cast<uint32_t>(lower_bound(line_y.begin() + first_line,
+                                                line_y.begin() + last_line, c.y_)
+                                    - line_y.begin());
+    auto down = up;
+    const auto none = numeric_limits<int64_t>::max();
+    while (true) {
+        auto dy_up = up < last_line ? llabs(static_cast<int64_t>(line_y[up]) - c.y_) : none;
+        auto dy_down = down > first_line
+                       ? llabs(static_cast<int64_t>(line_y[down - 1]) - c.y_) : none;
+        if (min(dy_up, dy_down) >= best) {
+            break;
+        }
+        if (dy_up <= dy_down) {
+            try_line(up++, dy_up);
+        }
+        else {
+            try_line(--down, dy_down);
+        }
+    }
+
+    if (best_segment == nullptr) {
+        return false;
+    }
+    auto& row = rows.sites_->get_row(best_segment->row_);
+    append(*best_segment, i,
+           static_cast<double>(c.x_ - row.x_) / row.site_width_, get_width_in_sites(c, row));
+    return true;
+}
+
+/**
+ * Place the cell @a c, taller than a row, at the nearest spot of the rows
+ * where its sites are free and the constraints allow it, and take the
+ * sites. The spots are tried from the nearest row out.
+ * @return False if there is none.
+ */
+bool place_tall_cell (const Cell& c, SiteMap& sites, const PlacementConstraints& constraints,
+                      const util::Box& die, pair<int, int>& place)
+{
+    auto best = numeric_limits<int64_t>::max();
+    util::Box best_box;
+
+    auto try_row = [&] (uint32_t r, int64_t dy) {
+        auto& row = sites.get_row(r);
+        auto width = get_width_in_sites(c, row);
+        if (width > static_cast<int>(row.num_sites_)) {
+            return;
+        }
+        auto last = static_cast<int64_t>(row.num_sites_) - width;
+        auto start = min(last, max<int64_t>(0, llround(static_cast<double>(c.x_ - row.x_)
+                                                       / row.site_width_)));
+        // Both sides, from the nearest site out, while they may do better.
+        for (int64_t d = 0; ; d++) {
+            auto is_open = false;
+            for (auto side = 0; side < (d == 0 ? 1 : 2); side++) {
+                auto s = side == 0 ? start + d : start - d;
+                auto x = row.x_ + s * row.site_width_;
+                auto cost = dy + llabs(x - c.x_);
+                if (s < 0 || s > last || cost >= best) {
+                    continue;
+                }
+                is_open = true;
+
+                util::Box box(static_cast<int>(x), row.y_,
+                              static_cast<int>(x) + c.width_, row.y_ + c.height_);
+                if (!sites.are_sites_free(r, s, s + width)
+                    || box.lx_ < die.lx_ || box.ly_ < die.ly_
+                    || box.ux_ > die.ux_ || box.uy_ > die.uy_
+                    || !sites.is_free(box) || !constraints.is_allowed(c.id_, box)) {
+                    continue;
+                }
+                best = cost;
+                best_box = box;
+            }
+            if (!is_open) {
+                break;
+            }
+        }
+    };
+
+    auto num_rows = sites.get_num_rows();
+    uint32_t up = 0;
+    for (auto count = num_rows; count > 0; ) {
+        auto half = count / 2;
+        if (sites.get_row(up + half).y_ < c.y_) {
+            up += half + 1;
+            count -= half + 1;
+        }
+        else {
+            count = half;
+        }
+    }
+    auto down = up;
+    const auto none = numeric_limits<int64_t>::max();
+    while (true) {
+        auto dy_up = up < num_rows ? llabs(static_cast<int64_t>(sites.get_row(up).y_) - c.y_)
+                                   : none;
+        auto dy_down = down > 0 ? llabs(static_cast<int64_t>(sites.get_row(down - 1).y_) - c.y_)
+                                : none;
+        if (min(dy_up, dy_down) >= best) {
+            break;
+        }
+        if (dy_up <= dy_down) {
+            try_row(up++, dy_up);
+        }
+        else {
+            try_row(--down, dy_down);
+        }
+    }
+
+    if (best == numeric_limits<int64_t>::max()) {
+        return false;
+    }
+    sites.occupy(best_box);
+    place = make_pair(best_box.lx_, best_box.ly_);
+    return true;
+}
+
+}   // End of anonymous namespace
+
+
+/**
+ * The sites of the fixed cells, of the hard placement blockages, out of
+ * the die and across the edges of the fences are taken first. The free
+ * sites left are cut into segments at the fence edges; a cell goes only to
+ * the segments of its fence.
+ */
+LegalizationReport legalize (Def& def, int num_threads, int rows_per_band)
+{
+    auto& components = def.get_components();
+    auto& constraints = def.get_placement_constraints();
+    auto& regions = def.get_regions();
+
+    util::Box die(def.get_die_lx(), def.get_die_ly(), def.get_die_ux(), def.get_die_uy());
+    if (die.ux_ <= die.lx_ || die.uy_ <= die.ly_) {
+        die = util::Box(numeric_limits<int>::min(), numeric_limits<int>::min(),
+                        numeric_limits<int>::max(), numeric_limits<int>::max());
+    }
+
+    SiteMap sites;
+    sites.build(def);
+    const auto num_rows = sites.get_num_rows();
+
+    vector<Cell> cells;
+    for (auto& c : components) {
+        if (!c->lef_macro_ || (!c->is_placed_ && !c->is_fixed_)) {
+            continue;
+        }
+        auto box = get_cell_box(*c, c->x_, c->y_);
+        if (c->is_fixed_) {
+            sites.occupy(box);
+        }
+        else {
+            // A cell takes the orientation of its row, which does not turn it.
+            cells.push_back(Cell{c->id_, c->x_, c->y_, c->lef_macro_->size_x_dbu_,
+                                 c->lef_macro_->size_y_dbu_, constraints.get_fence(c->id_)});
+        }
+    }
+    for (auto& b : def.get_blockages()) {
+        if (b->is_hard()) {
+            for (auto& box : b->boxes_) {
+                sites.occupy(box);
+            }
+        }
+    }
+
+    vector<int> fences;
+    for (auto& r : regions) {
+        if (r->type_ == RegionType::fence) {
+            fences.push_back(r->id_);
+        }
+    }
+
+    // Sites [first, last) of a row in one fence (or none), by row.
+    struct Piece { uint32_t first_, last_; int fence_; };
+    vector<vector<Piece>> pieces(num_rows);
+    util::parallel_for(num_rows, num_threads, [&] (size_t r) {
+        auto& row = sites.get_row(r);
+        auto sw = static_cast<int64_t>(row.site_width_);
+        auto num_sites = static_cast<int64_t>(row.num_sites_);
+
+        if (row.y_ < die.ly_ || row.y_ + row.height_ > die.uy_) {
+            sites.set_sites(r, 0, row.num_sites_, true);
+            return;
+        }
+        auto lo = min(num_sites, max<int64_t>(0, (static_cast<int64_t>(die.lx_) - row.x_ + sw - 1) / sw));
+        auto hi = min(num_sites, max<int64_t>(0, (static_cast<int64_t>(die.ux_) - row.x_) / sw));
+        sites.set_sites(r, 0, lo, true);
+        sites.set_sites(r, max(lo, hi), num_sites, true);
+
+        // A site cut by a fence edge is a piece of its own.
+        vector<uint32_t> cuts = { 0, row.num_sites_ };
+        for (auto f : fences) {
+            for (auto& b : regions[f]->boxes_) {
+                if (b.ly_ >= row.y_ + row.height_ || b.uy_ <= row.y_) {
+                    continue;
+                }
+                for (auto x : { b.lx_, b.ux_ }) {
+                    auto dx = static_cast<int64_t>(x) - row.x_;
+                    if (0 < dx && dx < num_sites * sw) {
+                        cuts.push_back(dx / sw);
+                        if (dx % sw != 0) {
+                            cuts.push_back(dx / sw + 1);
+                        }
+                    }
+                }
+            }
+        }
+        sort(cuts.begin(), cuts.end());
+        cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+
+        for (size_t i = 0; i + 1 < cuts.size(); i++) {
+            util::Box box(row.x_ + cuts[i] * sw, row.y_,
+                          row.x_ + cuts[i + 1] * sw, row.y_ + row.height_);
+            auto fence = -1;
+            for (auto f : fences) {
+                auto& set = constraints.get_region_set(f);
+                if (set.contains(box)) {
+                    fence = f;
+                    break;
+                }
+                if (set.overlaps(box)) {
+                    fence = -2;
+                    break;
+                }
+            }
+            if (fence == -2) {
+                sites.set_sites(r, cuts[i], cuts[i + 1], true);
+            }
+            else if (!pieces[r].empty() && pieces[r].back().fence_ == fence) {
+                pieces[r].back().last_ = cuts[i + 1];
+            }
+            else {
+                pieces[r].push_back(Piece{cuts[i], cuts[i + 1], fence});
+            }
+        }
+    });
+
+    // Cells taller than a row go first.
+    auto min_height = numeric_limits<int>::max();
+    for (size_t r = 0; r < num_rows; r++) {
+        min_height = min(min_height, sites.get_row(r).height_);
+    }
+
+    vector<uint32_t> order(cells.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&] (uint32_t a, uint32_t b) {
+        return cells[a].x_ < cells[b].x_;
+    });
+
+    vector<pair<int, int>> places(cells.size());
+    vector<char> is_placed(cells.size(), false);
+    for (auto i : order) {
+        if (cells[i].height_ > min_height) {
+            is_placed[i] = place_tall_cell(cells[i], sites, constraints, die, places[i]);
+        }
+    }
+
+    Segments rows;
+    rows.sites_ = &sites;
+    rows.cells_ = &cells;
+    for (uint32_t r = 0; r < num_rows; r++) {
+        auto& row = sites.get_row(r);
+        if (rows.line_y_.empty() || rows.line_y_.back() != row.y_) {
+            rows.line_y_.push_back(row.y_);
+            rows.line_begin_.push_back(rows.segments_.size());
+        }
+        for (auto& p : pieces[r]) {
+            auto i = sites.find_site(r, p.first_, p.last_, false);
+            while (i < p.last_) {
+                auto j = sites.find_site(r, i, p.last_, true);
+                Segment s;
+                s.row_ = r;
+                s.first_ = i;
+                s.last_ = j;
+                s.fence_ = p.fence_;
+                s.lx_ = row.x_ + i * row.site_width_;
+                s.ux_ = row.x_ + j * row.site_width_;
+                s.used_ = 0;
+                rows.segments_.push_back(move(s));
+                i = sites.find_site(r, j, p.last_, false);
+            }
+        }
+    }
+    rows.line_begin_.push_back(rows.segments_.size());
+    const auto num_lines = static_cast<uint32_t>(rows.line_y_.size());
+
+    // Band of a cell: the band of its nearest line.
+    const auto band_size = static_cast<uint32_t>(max(1, rows_per_band));
+    const auto num_bands = (num_lines + band_size - 1) / band_size;
+    vector<vector<uint32_t>> band_cells(num_bands);
+    for (auto i : order) {
+        if (cells[i].height_ > min_height || num_lines == 0) {
+            continue;
+        }
+        auto& line_y = rows.line_y_;
+        auto l = lower_bound(line_y.begin(), line_y.end(), cells[i].y_) - line_y.begin();
+        if (l == num_lines || (l > 0 && cells[i].y_ - line_y[l - 1] < line_y[l] - cells[i].y_)) {
+            l--;
+        }
+        band_cells[l / band_size].push_back(i);
+    }
+
+    vector<vector<uint32_t>> band_failed(num_bands);
+    util::parallel_for(num_bands, num_threads, [&] (size_t b) {
+        auto first_line = static_cast<uint32_t>(b * band_size);
+        auto last_line = min(num_lines, first_line + band_size);
+        for (auto i : band_cells[b]) {
+            if (!place_cell(rows, i, first_line, last_line)) {
+                band_failed[b].push_back(i);
+            }
+        }
+    });
+
+    // Cells a band has no room for go anywhere.
+    vector<uint32_t> failed;
+    for (auto& f : band_failed) {
+        failed.insert(failed.end(), f.begin(), f.end());
+    }
+    stable_sort(failed.begin(), failed.end(), [&] (uint32_t a, uint32_t b) {
+        return cells[a].x_ < cells[b].x_ || (cells[a].x_ == cells[b].x_ && a < b);
+    });
+    for (auto i : failed) {
+        place_cell(rows, i, 0, num_lines);
+    }
+
+    util::parallel_for(rows.segments_.size(), num_threads, [&] (size_t k) {
+        auto& s = rows.segments_[k];
+        auto& row = sites.get_row(s.row_);
+        for (size_t j = 0; j < s.clusters_.size(); j++) {
+            auto end = j + 1 < s.clusters_.size() ? s.clusters_[j + 1].first_ : s.cells_.size();
+            auto x = s.clusters_[j].x_;
+            for (auto n = s.clusters_[j].first_; n < end; n++) {
+                auto i = s.cells_[n];
+                places[i] = make_pair(row.x_ + x * row.site_width_, row.y_);
+                is_placed[i] = true;
+                x += get_width_in_sites(cells[i], row);
+            }
+        }
+    });
+
+    LegalizationReport report = {};
+    report.num_cells_ = cells.size();
+    for (size_t i = 0; i < cells.size(); i++) {
+        auto& c = cells[i];
+        if (!is_placed[i]) {
+            report.num_failed_++;
+            continue;
+        }
+        auto displacement = llabs(static_cast<int64_t>(places[i].first) - c.x_)
+                            + llabs(static_cast<int64_t>(places[i].second) - c.y_);
+        report.total_displacement_ += displacement;
+        report.max_displacement_ = max<int64_t>(report.max_displacement_, displacement);
+
+        auto orient = components[c.id_]->orient_;
+        auto row = sites.find_row(places[i].first, places[i].second);
+        if (row >= 0) {
+            orient = sites.get_row(row).orient_;
+        }
+        if (displacement != 0 || orient != components[c.id_]->orient_) {
+            def.move_component(c.id_, places[i].first, places[i].second, orient);
+            report.num_moved_++;
+        }
+    }
+    return report;
+}
+
+}   // End of namespace def
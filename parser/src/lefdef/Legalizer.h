@@ -0,0 +1,49 @@
+/**
+ * @file    Legalizer.h
+ */
+
+#ifndef LEGALIZER_H
+#define LEGALIZER_H
+
+#include "common_header.h"
+#include "Def.h"
+
+namespace def
+{
+
+/**
+ * Result of a legalization. Displacements are Manhattan distances in DBU.
+ */
+struct LegalizationReport
+{
+    size_t num_cells_;          ///< Placed movable components.
+    size_t num_moved_;          ///< Moved or turned to their rows.
+    size_t num_failed_;         ///< Left in place: no room was found.
+    int64_t total_displacement_;
+    int64_t max_displacement_;
+
+    double get_average_displacement () const
+    {
+        return num_cells_ == 0 ? 0.0
+               : static_cast<double>(total_displacement_) / num_cells_;
+    }
+};
+
+/**
+ * Move the placed movable components of @a def onto the sites of its rows,
+ * without overlaps and within their fences, minimizing the displacement.
+ * The new places are written back with Def::move_component(), each cell
+ * in the orientation of the row it lands on.
+ *
+ * Cells of one row high are legalized with Abacus, in bands of
+ * @a rows_per_band rows (the lines of rows at the same height) run on
+ * @a num_threads threads; a cell stays in the band it starts in, and the
+ * cells a band has no room for are then placed on all the rows. Taller
+ * cells are placed first, one at a time, at the nearest free spot. The
+ * result does not depend on @a num_threads.
+ */
+LegalizationReport legalize (Def& def, int num_threads = 1, int rows_per_band = 64);
+
+}   // End of namespace def
+
+#endif
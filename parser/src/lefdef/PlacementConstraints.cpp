@@ -0,0 +1,192 @@
+/**
+ * @file    PlacementConstraints.cpp
+ */
+
+#include "PlacementConstraints.h"
+#include "StringUtil.h"
+
+using namespace std;
+
+namespace def
+{
+
+PlacementConstraints::PlacementConstraints ()
+    : def_(nullptr)
+{
+    //
+}
+
+void PlacementConstraints::clear ()
+{
+    *this = PlacementConstraints();
+}
+
+/**
+ * @return True if @a pattern is a name followed by its only wildcard, '*'.
+ */
+static bool is_prefix_pattern (const string& pattern)
+{
+    auto wildcard = pattern.find_first_of("*?");
+    return wildcard != string::npos && wildcard + 1 == pattern.size()
+           && pattern[wildcard] == '*';
+}
+
+/**
+ * Set the bits of the components matching @a pattern. A plain name is
+ * looked up, a name ending with the only '*' is a range of @a by_name (the
+ * component ids sorted by name), and other patterns are matched against
+ * every name.
+ */
+void PlacementConstraints::add_members (int group, const string& pattern,
+                                        const vector<uint32_t>& by_name)
+{
+    auto& components = def_->get_components();
+    auto& symbols = util::SymbolTable::get_instance();
+    auto& bits = members_[group];
+    auto add = [&] (uint32_t id) {
+        bits[id >> 6] |= uint64_t(1) << (id & 63);
+    };
+
+    if (pattern.find_first_of("*?") == string::npos) {
+        auto found = def_->get_component(symbols.find(pattern));
+        if (found != nullptr) {
+            add(found->id_);
+        }
+        return;
+    }
+
+    if (is_prefix_pattern(pattern)) {
+        auto prefix = pattern.substr(0, pattern.size() - 1);
+        auto it = lower_bound(by_name.begin(), by_name.end(), prefix,
+                              [&] (uint32_t id, const string& p) {
+                                  return strcmp(symbols.get_name(
+                                             components[id]->name_id_), 
+                                             p.c_str()) < 0;
+                              });
+        for (; it != by_name.end(); ++it) {
+            auto name = symbols.get_name(components[*it]->name_id_);
+            if (strncmp(name, prefix.c_str(), prefix.size()) != 0) {
+                break;
+            }
+            add(*it);
+        }
+        return;
+    }
+
+    for (auto& c : components) {
+        if (StringUtil::matches(pattern.c_str(), symbols.get_name(c->name_id_))) {
+            add(c->id_);
+        }
+    }
+}
+
+void PlacementConstraints::build (const Def& def)
+{
+    clear();
+    def_ = &def;
+
+    auto& components = def.get_components();
+    auto& groups = def.get_groups();
+    auto& regions = def.get_regions();
+
+    // The components by name, for the patterns "prefix*".
+    vector<uint32_t> by_name;
+    for (auto& g : groups) {
+        for (auto& p : g->patterns_) {
+            if (by_name.empty() && is_prefix_pattern(p)) {
+                by_name.resize(components.size());
+                iota(by_name.begin(), by_name.end(), 0);
+                auto& symbols = util::SymbolTable::get_instance();
+                sort(by_name.begin(), by_name.end(), [&] (uint32_t a, uint32_t b) {
+                    return strcmp(symbols.get_name(components[a]->name_id_),
+                                  symbols.get_name(components[b]->name_id_)) < 0;
+                });
+            }
+        }
+    }
+
+    auto num_words = (components.size() + 63) / 64;
+    members_.assign(groups.size(), vector<uint64_t>(num_words, 0));
+    num_members_.assign(groups.size(), 0);
+    group_of_component_.assign(components.size(), -1);
+
+    size_t num_conflicts = 0;
+    for (auto& g : groups) {
+        for (auto& p : g->patterns_) {
+            add_members(g->id_, p, by_name);
+        }
+
+        auto& bits = members_[g->id_];
+        for (size_t w = 0; w < bits.size(); w++) {
+            for (auto word = bits[w]; word != 0; word &= word - 1) {
+                auto id = static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                if (group_of_component_[id] < 0) {
+                    group_of_component_[id] = g->id_;
+                }
+                else {
+                    num_conflicts++;
+                }
+                num_members_[g->id_]++;
+            }
+        }
+    }
+    if (num_conflicts > 0) {
+        cout << "(W) " << num_conflicts << " components are in more than one group; "
+             << "the first group is kept." << endl;
+    }
+
+    regions_.resize(regions.size());
+    vector<util::Box> fence_boxes;
+    for (auto& r : regions) {
+        regions_[r->id_].build(r->boxes_);
+        if (r->type_ == RegionType::fence) {
+            fences_.push_back(r->id_);
+            fence_boxes.insert(fence_boxes.end(), r->boxes_.begin(), r->boxes_.end());
+        }
+    }
+    fence_set_.build(fence_boxes);
+
+    fence_of_group_.assign(groups.size(), -1);
+    for (auto& g : groups) {
+        if (g->region_ >= 0 && regions[g->region_]->type_ == RegionType::fence) {
+            fence_of_group_[g->id_] = g->region_;
+        }
+    }
+
+    vector<util::Box> blockage_boxes;
+    for (auto& b : def.get_blockages()) {
+        if (b->is_hard()) {
+            blockage_boxes.insert(blockage_boxes.end(), b->boxes_.begin(), b->boxes_.end());
+        }
+    }
+    blockage_set_.build(blockage_boxes);
+}
+
+bool PlacementConstraints::is_allowed (uint32_t id, int x, int y) const
+{
+    return is_allowed(id, get_cell_box(*def_->get_components()[id], x, y));
+}
+
+bool PlacementConstraints::is_allowed (uint32_t id, const util::Box& box) const
+{
+    if (blockage_set_.overlaps(box)) {
+        return false;
+    }
+
+    auto fence = get_fence(id);
+    if (fence < 0) {
+        return !fence_set_.overlaps(box);
+    }
+
+    if (!regions_[fence].contains(box)) {
+        return false;
+    }
+    for (auto f : fences_) {
+        if (f != fence && regions_[f].overlaps(box)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // End of namespace def
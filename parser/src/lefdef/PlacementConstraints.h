@@ -0,0 +1,121 @@
+/**
+ * @file    PlacementConstraints.h
+ */
+
+#ifndef PLACEMENT_CONSTRAINTS_H
+#define PLACEMENT_CONSTRAINTS_H
+
+#include "common_header.h"
+#include "Geometry.h"
+#include "RectSet.h"
+#include "Def.h"
+
+namespace def
+{
+
+/**
+ * The placement blockages, regions and groups of a Def, prepared for
+ * legality queries.
+ *
+ * Group patterns are matched against the component names once, in build();
+ * each group keeps its members as a bitset over the component ids. Regions
+ * and the hard placement blockages are kept as RectSets, so a query is a
+ * few binary searches. A component may be placed at a spot if its cell
+ * - overlaps no hard placement blockage,
+ * - lies in the fence of its group, if any, and
+ * - overlaps no other fence.
+ * Guides do not restrict a placement. Queries do not modify the index and
+ * may run concurrently.
+ */
+class PlacementConstraints
+{
+public:
+    PlacementConstraints ();
+
+    /**
+     * Resolve the groups of @a def and index its regions and blockages.
+     */
+    void build (const Def& def);
+    void clear ();
+
+    /**
+     * @return The group of the component @a id, -1 if none. A component
+     *         named by several groups belongs to the first.
+     */
+    int get_group (uint32_t id) const;
+    bool is_member (int group, uint32_t id) const;
+    size_t get_num_members (int group) const;
+
+    /**
+     * @return The fence (index in Def::get_regions()) the component @a id
+     *         must lie in, -1 if none.
+     */
+    int get_fence (uint32_t id) const;
+
+    const util::RectSet& get_region_set (int region) const;
+    const util::RectSet& get_blockage_set () const;
+
+    /**
+     * @return True if the component @a id may be placed with its lower-left
+     *         corner at (@a x, @a y), in its current orientation.
+     */
+    bool is_allowed (uint32_t id, int x, int y) const;
+
+    /**
+     * @return True if the cell of the component @a id may cover @a box.
+     */
+    bool is_allowed (uint32_t id, const util::Box& box) const;
+
+private:
+    const Def* def_;
+
+    vector<vector<uint64_t>> members_;      ///< Bitset over the components, by group.
+    vector<size_t> num_members_;
+    vector<int32_t> group_of_component_;    ///< Indexed by Component::id_.
+
+    vector<util::RectSet> regions_;         ///< Indexed by Region::id_.
+    vector<int> fences_;                    ///< Regions that are fences.
+    vector<int> fence_of_group_;
+    util::RectSet fence_set_;               ///< Union of the fences.
+    util::RectSet blockage_set_;            ///< Union of the hard blockages.
+
+    void add_members (int group, const string& pattern,
+                      const vector<uint32_t>& by_name);
+};
+
+
+inline int PlacementConstraints::get_group (uint32_t id) const
+{
+    return id < group_of_component_.size() ? group_of_component_[id] : -1;
+}
+
+inline bool PlacementConstraints::is_member (int group, uint32_t id) const
+{
+    auto& bits = members_[group];
+    return (id >> 6) < bits.size() && (bits[id >> 6] >> (id & 63) & 1) != 0;
+}
+
+inline size_t PlacementConstraints::get_num_members (int group) const
+{
+    return num_members_[group];
+}
+
+inline int PlacementConstraints::get_fence (uint32_t id) const
+{
+    auto group = get_group(id);
+    return group < 0 ? -1 : fence_of_group_[group];
+}
+
+inline const util::RectSet& PlacementConstraints::get_region_set (int region) const
+{
+    return regions_[region];
+}
+
+inline const util::RectSet& PlacementConstraints::get_blockage_set () const
+{
+    return blockage_set_;
+}
+
+}   // End of namespace def
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file    RoutedWires.cpp
+ */
+
+#include "RoutedWires.h"
+
+using namespace std;
+
+namespace def
+{
+
+static inline uint32_t zigzag (int32_t v)
+{
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+static inline int32_t unzigzag (uint32_t v)
+{
+    return static_cast<int32_t>((v >> 1) ^ (0u - (v & 1)));
+}
+
+static inline uint64_t read_varint (const uint8_t* data, size_t& pos)
+{
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+        auto b = data[pos++];
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return v;
+        }
+    }
+}
+
+
+RoutedWires::Iterator::Iterator (const RoutedWires& wires, size_t pos)
+    : wires_(&wires), pos_(pos), next_(pos), num_left_(0), num_vias_(0)
+{
+    point_.path_ = static_cast<uint32_t>(-1);
+    point_.x_ = point_.y_ = 0;
+    point_.has_via_ = false;
+    point_.via_ = util::SymbolTable::invalid_symbol;
+
+    if (pos_ < wires_->points_.size()) {
+        decode();
+    }
+}
+
+RoutedWires::Iterator& RoutedWires::Iterator::operator++ ()
+{
+    if (next_ < wires_->points_.size()) {
+        decode();
+    }
+    else {
+        pos_ = next_;
+    }
+    return *this;
+}
+
+/**
+ * Decode the point at next_, moving to the next non-empty path first if
+ * the current one is done.
+ */
+void RoutedWires::Iterator::decode ()
+{
+    auto& paths = wires_->paths_;
+    while (num_left_ == 0) {
+        num_left_ = paths[++point_.path_].num_points_;
+    }
+    num_left_--;
+
+    pos_ = next_;
+    auto data = wires_->points_.data();
+    auto vx = read_varint(data, next_);
+    auto vy = read_varint(data, next_);
+    point_.x_ += unzigzag(static_cast<uint32_t>(vx >> 1));
+    point_.y_ += unzigzag(static_cast<uint32_t>(vy));
+    point_.has_via_ = (vx & 1) != 0;
+    point_.via_ = point_.has_via_ ? wires_->vias_[num_vias_++] 
+                                  : util::SymbolTable::invalid_symbol;
+}
+
+
+RoutedWires::RoutedWires ()
+    : num_wires_(0), num_points_(0), last_point_(0), last_x_(0), last_y_(0)
+{
+    //
+}
+
+void RoutedWires::add_path (util::SymbolId wire_type, bool new_wire)
+{
+    paths_.push_back(Path{wire_type, util::SymbolTable::invalid_symbol, 0, 0, new_wire});
+    if (new_wire) {
+        num_wires_++;
+    }
+}
+
+void RoutedWires::set_layer (util::SymbolId layer_id)
+{
+    paths_.back().layer_id_ = layer_id;
+}
+
+void RoutedWires::set_width (int width)
+{
+    paths_.back().width_ = width;
+}
+
+void RoutedWires::append_varint (uint64_t v)
+{
+    while (v >= 0x80) {
+        points_.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    points_.push_back(static_cast<uint8_t>(v));
+}
+
+void RoutedWires::add_point (int x, int y)
+{
+    auto dx = static_cast<int32_t>(static_cast<uint32_t>(x) - static_cast<uint32_t>(last_x_));
+    auto dy = static_cast<int32_t>(static_cast<uint32_t>(y) - static_cast<uint32_t>(last_y_));
+
+    last_point_ = points_.size();
+    append_varint(static_cast<uint64_t>(zigzag(dx)) << 1);
+    append_varint(zigzag(dy));
+    last_x_ = x;
+    last_y_ = y;
+
+    paths_.back().num_points_++;
+    num_points_++;
+}
+
+/**
+ * The via flag is the lowest bit of the first byte of the point.
+ */
+void RoutedWires::set_via (util::SymbolId via)
+{
+    points_[last_point_] |= 1;
+    vias_.push_back(via);
+}
+
+RoutedWires::Iterator RoutedWires::begin () const
+{
+    return Iterator(*this, 0);
+}
+
+RoutedWires::Iterator RoutedWires::end () const
+{
+    return Iterator(*this, points_.size());
+}
+
+size_t RoutedWires::get_memory () const
+{
+    return paths_.capacity() * sizeof(Path) + points_.capacity() 
+           + vias_.capacity() * sizeof(util::SymbolId);
+}
+
+/**
+ * The old layout: a Net kept a vector of shared_ptrs to wires, a wire one
+ * to its segments, a segment one to its points; the objects were kept in
+ * arenas. Strings are assumed short enough to be stored inline.
+ */
+size_t RoutedWires::get_unpacked_memory () const
+{
+    struct OldRoutingPoint { int x_, y_, ext_; bool has_via_; };
+    struct OldWireSegment { string layer_name_; util::SymbolId layer_id_; int width_;
+                            vector<shared_ptr<OldRoutingPoint>> rpoints_; };
+    struct OldWire { string wire_type_; string layer_;
+                     vector<shared_ptr<OldWireSegment>> wire_segments_; };
+
+    const auto ptr_size = sizeof(shared_ptr<void>);
+    return num_wires_ * (ptr_size + sizeof(OldWire))
+           + paths_.size() * (ptr_size + sizeof(OldWireSegment))
+           + num_points_ * (ptr_size + sizeof(OldRoutingPoint));
+}
+
+void RoutedWires::write (util::BinaryWriter& w) const
+{
+    auto& symbols = util::SymbolTable::get_instance();
+
+    w.write<uint32_t>(paths_.size());
+    for (auto& p : paths_) {
+        w.write_string(symbols.get_name(p.wire_type_));
+        w.write_string(p.layer_id_ == util::SymbolTable::invalid_symbol
+                           ? "" : symbols.get_name(p.layer_id_));
+        w.write(p.width_);
+        w.write(p.num_points_);
+        w.write(p.new_wire_);
+    }
+
+    w.write<uint32_t>(points_.size());
+    auto& buffer = w.get_buffer();
+    buffer.insert(buffer.end(), points_.begin(), points_.end());
+
+    w.write<uint32_t>(vias_.size());
+    for (auto via : vias_) {
+        w.write_string(symbols.get_name(via));
+    }
+}
+
+void RoutedWires::read (util::BinaryReader& r)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+
+    *this = RoutedWires();
+    paths_.resize(r.read<uint32_t>());
+    for (auto& p : paths_) {
+        p.wire_type_ = symbols.intern(r.read_string());
+        auto layer = r.read_string();
+        p.layer_id_ = layer.empty() ? util::SymbolTable::invalid_symbol
+                                    : symbols.intern(layer);
+        p.width_ = r.read<int>();
+        p.num_points_ = r.read<uint32_t>();
+        p.new_wire_ = r.read<bool>();
+        num_wires_ += p.new_wire_;
+        num_points_ += p.num_points_;
+    }
+
+    points_.resize(r.read<uint32_t>());
+    for (auto& b : points_) {
+        b = r.read<uint8_t>();
+    }
+
+    vias_.resize(r.read<uint32_t>());
+    for (auto& via : vias_) {
+        via = symbols.intern(r.read_string());
+    }
+
+    // Restore the last point, so more can be added.
+    for (auto it = begin(); it != end(); ++it) {
+        last_point_ = it.get_position();
+        last_x_ = it->x_;
+        last_y_ = it->y_;
+    }
+}
+
+}   // End of namespace def
@@ -0,0 +1,144 @@
+/**
+ * @file    RoutedWires.h
+ */
+
+#ifndef ROUTED_WIRES_H
+#define ROUTED_WIRES_H
+
+#include "common_header.h"
+#include "SymbolTable.h"
+#include "BinaryIO.h"
+
+namespace def
+{
+
+/**
+ * The routed wires of a net, packed.
+ *
+ * A wire of the DEF ("+ ROUTED ...", "NEW ...") is a list of paths, each
+ * on one layer. Paths are kept in a table; their points are kept in one
+ * byte array, each as the difference from the point before it (across
+ * paths), in zigzag varints. The low bit of the x difference flags a via
+ * placed at the point; the names of the vias are kept in order in a table.
+ *
+ * A point takes 2 to 6 bytes instead of a shared_ptr and a heap object.
+ */
+class RoutedWires
+{
+public:
+    /**
+     * A path of a wire.
+     */
+    struct Path
+    {
+        util::SymbolId wire_type_;  ///< ROUTED, FIXED, COVER or NOSHIELD.
+        util::SymbolId layer_id_;
+        int width_;                 ///< 0 if not given.
+        uint32_t num_points_;
+        bool new_wire_;             ///< The first path of a wire.
+    };
+
+    /**
+     * A point of a path, as given by the iterator.
+     */
+    struct Point
+    {
+        uint32_t path_;     ///< Index of the path.
+        int x_;
+        int y_;
+        bool has_via_;
+        util::SymbolId via_;    ///< Name of the via, if has_via_.
+    };
+
+    /**
+     * Iterate over the points of all paths in order.
+     */
+    class Iterator
+    {
+    public:
+        Iterator (const RoutedWires& wires, size_t pos);
+
+        const Point& operator* () const { return point_; }
+        const Point* operator-> () const { return &point_; }
+        Iterator& operator++ ();
+
+        bool operator== (const Iterator& rhs) const { return pos_ == rhs.pos_; }
+        bool operator!= (const Iterator& rhs) const { return pos_ != rhs.pos_; }
+
+        size_t get_position () const { return pos_; }
+
+    private:
+        const RoutedWires* wires_;
+        size_t pos_;            ///< Byte offset of the current point.
+        size_t next_;           ///< Byte offset of the point after it.
+        uint32_t num_left_;     ///< Points left in the current path.
+        uint32_t num_vias_;     ///< Vias passed.
+        Point point_;
+
+        void decode ();
+    };
+
+    RoutedWires ();
+
+    // Building, in the order of the DEF.
+    void add_path (util::SymbolId wire_type, bool new_wire);
+    void set_layer (util::SymbolId layer_id);
+    void set_width (int width);
+    void add_point (int x, int y);
+    void set_via (util::SymbolId via);      ///< On the last point.
+
+    bool empty () const;
+    size_t get_num_wires () const;
+    size_t get_num_points () const;
+    const vector<Path>& get_paths () const;
+
+    Iterator begin () const;
+    Iterator end () const;
+
+    /**
+     * @return Bytes used, and the bytes the same wires took when every
+     *         wire, path and point was a shared_ptr to its own object.
+     */
+    size_t get_memory () const;
+    size_t get_unpacked_memory () const;
+
+    void write (util::BinaryWriter& w) const;
+    void read (util::BinaryReader& r);
+
+private:
+    vector<Path> paths_;
+    vector<uint8_t> points_;
+    vector<util::SymbolId> vias_;   ///< Via names, in the order of points.
+    uint32_t num_wires_;
+    uint32_t num_points_;
+    size_t last_point_;     ///< Byte offset of the last point added.
+    int last_x_;
+    int last_y_;
+
+    void append_varint (uint64_t v);
+};
+
+
+inline bool RoutedWires::empty () const
+{
+    return paths_.empty();
+}
+
+inline size_t RoutedWires::get_num_wires () const
+{
+    return num_wires_;
+}
+
+inline size_t RoutedWires::get_num_points () const
+{
+    return num_points_;
+}
+
+inline const vector<RoutedWires::Path>& RoutedWires::get_paths () const
+{
+    return paths_;
+}
+
+}   // End of namespace def
+
+#endif
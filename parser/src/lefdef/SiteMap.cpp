@@ -0,0 +1,234 @@
+/**
+ * @file    SiteMap.cpp
+ */
+
+#include "SiteMap.h"
+
+using namespace std;
+
+namespace def
+{
+
+SiteMap::SiteMap ()
+    : max_height_(0)
+{
+    //
+}
+
+void SiteMap::clear ()
+{
+    rows_.clear();
+    words_.clear();
+    max_height_ = 0;
+}
+
+/**
+ * A row whose site is not in the LEF takes the smallest distance between
+ * the bottoms of two rows as its height, and its step as the site width.
+ */
+void SiteMap::build (const Def& def)
+{
+    clear();
+
+    auto& lef = lef::Lef::get_instance();
+    auto dbu = def.get_dbu();
+
+    vector<int> ys;
+    for (auto& r : def.get_rows()) {
+        auto site = lef.get_site(r->macro_);
+        auto width = r->step_x_;
+        auto height = 0;
+        if (site) {
+            height = static_cast<int>(lround(site->y_ * dbu));
+            if (width == 0) {
+                width = static_cast<int>(lround(site->x_ * dbu));
+            }
+        }
+        if (width <= 0 || r->num_x_ <= 0 || r->num_y_ <= 0) {
+            continue;
+        }
+
+        for (int j = 0; j < r->num_y_; j++) {
+            // Rows "DO 1 BY m" stack single sites.
+            SiteRow row;
+            row.x_ = r->x_;
+            row.y_ = r->y_ + j * r->step_y_;
+            row.site_width_ = width;
+            row.height_ = height;
+            row.orient_ = r->orient_;
+            row.num_sites_ = r->num_x_;
+            row.first_word_ = 0;
+            rows_.push_back(row);
+            ys.push_back(row.y_);
+        }
+    }
+
+    sort(rows_.begin(), rows_.end(), [] (const SiteRow& a, const SiteRow& b) {
+        return a.y_ < b.y_ || (a.y_ == b.y_ && a.x_ < b.x_);
+    });
+
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+    auto min_gap = 0;
+    for (size_t i = 1; i < ys.size(); i++) {
+        if (min_gap == 0 || ys[i] - ys[i - 1] < min_gap) {
+            min_gap = ys[i] - ys[i - 1];
+        }
+    }
+
+    size_t num_words = 0;
+    for (auto& row : rows_) {
+        if (row.height_ == 0) {
+            row.height_ = min_gap > 0 ? min_gap : row.site_width_;
+        }
+        max_height_ = max(max_height_, row.height_);
+        row.first_word_ = num_words;
+        num_words += (row.num_sites_ + 63) / 64;
+    }
+    words_.assign(num_words, 0);
+}
+
+size_t SiteMap::get_num_sites () const
+{
+    size_t n = 0;
+    for (auto& row : rows_) {
+        n += row.num_sites_;
+    }
+    return n;
+}
+
+size_t SiteMap::get_num_occupied () const
+{
+    size_t n = 0;
+    for (auto w : words_) {
+        n += __builtin_popcountll(w);
+    }
+    return n;
+}
+
+int SiteMap::find_row (int x, int y) const
+{
+    auto it = lower_bound(rows_.begin(), rows_.end(), y,
+                          [] (const SiteRow& row, int y) { return row.y_ < y; });
+    for (; it != rows_.end() && it->y_ == y; ++it) {
+        if (it->x_ <= x && x < it->get_ux()) {
+            return static_cast<int>(it - rows_.begin());
+        }
+    }
+    return -1;
+}
+
+pair<uint32_t, uint32_t> SiteMap::find_rows (int ly, int uy) const
+{
+    // A row may reach ly only if it starts less than max_height_ below.
+    auto bottom = static_cast<int64_t>(ly) - max_height_;
+    auto first = upper_bound(rows_.begin(), rows_.end(), bottom,
+                             [] (int64_t y, const SiteRow& row) { return y < row.y_; });
+    auto last = lower_bound(first, rows_.end(), uy,
+                            [] (const SiteRow& row, int y) { return row.y_ < y; });
+    return make_pair(static_cast<uint32_t>(first - rows_.begin()),
+                     static_cast<uint32_t>(last - rows_.begin()));
+}
+
+/**
+ * @return The bits [@a first, @a end) of the word holding them; both must
+ *         be in one word.
+ */
+static inline uint64_t get_mask (uint32_t first, uint32_t end)
+{
+    return end - first == 64 ? ~uint64_t(0)
+                             : ((uint64_t(1) << (end - first)) - 1) << (first & 63);
+}
+
+/**
+ * Bits [first, last) of a row are set word by word, with masks at the ends.
+ */
+void SiteMap::set_sites (uint32_t row, uint32_t first, uint32_t last, bool value)
+{
+    auto words = words_.data() + rows_[row].first_word_;
+    for (auto i = first; i < last; ) {
+        auto w = i >> 6;
+        auto end = min(last, (w + 1) << 6);
+        auto mask = get_mask(i, end);
+        if (value) {
+            words[w] |= mask;
+        }
+        else {
+            words[w] &= ~mask;
+        }
+        i = end;
+    }
+}
+
+bool SiteMap::are_sites_free (uint32_t row, uint32_t first, uint32_t last) const
+{
+    auto words = words_.data() + rows_[row].first_word_;
+    for (auto i = first; i < last; ) {
+        auto w = i >> 6;
+        auto end = min(last, (w + 1) << 6);
+        auto mask = get_mask(i, end);
+        if (words[w] & mask) {
+            return false;
+        }
+        i = end;
+    }
+    return true;
+}
+
+uint32_t SiteMap::find_site (uint32_t row, uint32_t first, uint32_t last, bool taken) const
+{
+    auto words = words_.data() + rows_[row].first_word_;
+    for (auto i = first; i < last; ) {
+        auto w = i >> 6;
+        auto end = min(last, (w + 1) << 6);
+        auto bits = (taken ? words[w] : ~words[w]) & get_mask(i, end);
+        if (bits != 0) {
+            return (w << 6) + __builtin_ctzll(bits);
+        }
+        i = end;
+    }
+    return last;
+}
+
+bool SiteMap::is_free (const util::Box& box) const
+{
+    auto free = true;
+    for_each_site_range(box, [&] (uint32_t row, uint32_t first, uint32_t last) {
+        free = free && are_sites_free(row, first, last);
+    });
+    return free;
+}
+
+void SiteMap::occupy (const util::Box& box)
+{
+    for_each_site_range(box, [this] (uint32_t row, uint32_t first, uint32_t last) {
+        set_sites(row, first, last, true);
+    });
+}
+
+void SiteMap::release (const util::Box& box)
+{
+    for_each_site_range(box, [this] (uint32_t row, uint32_t first, uint32_t last) {
+        set_sites(row, first, last, false);
+    });
+}
+
+bool SiteMap::occupy (const Component& c)
+{
+    auto box = get_cell_box(c, c.x_, c.y_);
+    auto free = is_free(box);
+    occupy(box);
+    return free;
+}
+
+void SiteMap::release (const Component& c)
+{
+    release(get_cell_box(c, c.x_, c.y_));
+}
+
+bool SiteMap::can_place (const Component& c, int x, int y) const
+{
+    return is_free(get_cell_box(c, x, y));
+}
+
+}   // End of namespace def
@@ -0,0 +1,161 @@
+/**
+ * @file    SiteMap.h
+ */
+
+#ifndef SITE_MAP_H
+#define SITE_MAP_H
+
+#include "common_header.h"
+#include "Geometry.h"
+#include "Def.h"
+
+namespace def
+{
+
+/**
+ * The sites of the rows of a Def, one bit each: set if a cell covers it.
+ *
+ * A DEF row "DO n BY m" is split into rows of one line of sites each. The
+ * rows are sorted by y, then x; the bits of a row start at a new word, so
+ * rows can be filled on different threads. A cell covers the sites its box
+ * touches in the rows its box crosses.
+ *
+ * A bit does not count its cells: releasing one of two overlapping cells
+ * frees the sites they share. Occupy and release are meant for legal
+ * placements, to try moves.
+ */
+class SiteMap
+{
+public:
+    /**
+     * A line of sites.
+     */
+    struct SiteRow
+    {
+        int x_;             ///< Left of the first site.
+        int y_;             ///< Bottom of the row.
+        int site_width_;    ///< Step between the sites.
+        int height_;
+        int orient_;        ///< Of the DEF row; the cells on it take it.
+        uint32_t num_sites_;
+        size_t first_word_; ///< The bits of the row in the word array.
+
+        int get_ux () const
+        {
+            return x_ + static_cast<int>(num_sites_) * site_width_;
+        }
+    };
+
+    SiteMap ();
+
+    /**
+     * Take the rows of @a def, with all sites free. The sites are sized by
+     * the LEF sites of the rows.
+     */
+    void build (const Def& def);
+    void clear ();
+
+    size_t get_num_rows () const;
+    const SiteRow& get_row (size_t row) const;
+    size_t get_num_sites () const;
+    size_t get_num_occupied () const;
+
+    /**
+     * @return The row whose bottom is @a y and that spans @a x, -1 if none.
+     */
+    int find_row (int x, int y) const;
+
+    /**
+     * @return The rows that may meet the y range [@a ly, @a uy): the
+     *         rows [first, second) in get_row() order.
+     */
+    pair<uint32_t, uint32_t> find_rows (int ly, int uy) const;
+
+    /**
+     * @return The sites [first, second) of the row @a row that @a box
+     *         touches; empty if @a box misses the row.
+     */
+    pair<uint32_t, uint32_t> get_sites (uint32_t row, const util::Box& box) const;
+
+    /**
+     * Call @a func(row, first, last) for every row @a box touches sites of,
+     * with those sites [first, last).
+     */
+    template <typename Func>
+    void for_each_site_range (const util::Box& box, Func func) const;
+
+    bool is_free (const util::Box& box) const;
+    void occupy (const util::Box& box);
+    void release (const util::Box& box);
+
+    /**
+     * Occupy (release) the sites of the component @a c at its place.
+     * @return For occupy(), false if some of the sites were taken.
+     */
+    bool occupy (const Component& c);
+    void release (const Component& c);
+
+    /**
+     * @return True if the component @a c, released, would find its sites
+     *         free at (@a x, @a y).
+     */
+    bool can_place (const Component& c, int x, int y) const;
+
+    /**
+     * Set the sites [@a first, @a last) of @a row; no other row is touched.
+     */
+    void set_sites (uint32_t row, uint32_t first, uint32_t last, bool value);
+    bool are_sites_free (uint32_t row, uint32_t first, uint32_t last) const;
+
+    /**
+     * @return The first site of @a row in [@a first, @a last) that is taken
+     *         (free, if @a taken is false); @a last if none.
+     */
+    uint32_t find_site (uint32_t row, uint32_t first, uint32_t last, bool taken) const;
+
+private:
+    vector<SiteRow> rows_;
+    vector<uint64_t> words_;
+    int max_height_;
+};
+
+
+inline size_t SiteMap::get_num_rows () const
+{
+    return rows_.size();
+}
+
+inline const SiteMap::SiteRow& SiteMap::get_row (size_t row) const
+{
+    return rows_[row];
+}
+
+inline pair<uint32_t, uint32_t> SiteMap::get_sites (uint32_t row,
+                                                    const util::Box& box) const
+{
+    auto& r = rows_[row];
+    if (r.y_ + r.height_ <= box.ly_ || box.uy_ <= r.y_
+        || box.lx_ >= r.get_ux() || box.ux_ <= r.x_) {
+        return make_pair(0u, 0u);
+    }
+    auto first = box.lx_ <= r.x_ ? 0 : (box.lx_ - r.x_) / r.site_width_;
+    auto last = (static_cast<int64_t>(box.ux_) - r.x_ + r.site_width_ - 1) / r.site_width_;
+    return make_pair(static_cast<uint32_t>(first),
+                     static_cast<uint32_t>(std::min<int64_t>(last, r.num_sites_)));
+}
+
+template <typename Func>
+void SiteMap::for_each_site_range (const util::Box& box, Func func) const
+{
+    auto range = find_rows(box.ly_, box.uy_);
+    for (auto r = range.first; r < range.second; r++) {
+        auto sites = get_sites(r, box);
+        if (sites.first < sites.second) {
+            func(r, sites.first, sites.second);
+        }
+    }
+}
+
+}   // End of namespace def
+
+#endif
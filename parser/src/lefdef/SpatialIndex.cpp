@@ -0,0 +1,300 @@
+/**
+ * @file    SpatialIndex.cpp
+ */
+
+#include "SpatialIndex.h"
+#include "Def.h"
+
+using namespace std;
+
+namespace def
+{
+
+static Box get_pin_box (const Pin& p)
+{
+    auto b = transform_box(Box(p.lx_, p.ly_, p.ux_, p.uy_), p.orient_);
+    return Box(p.x_ + b.lx_, p.y_ + b.ly_, p.x_ + b.ux_, p.y_ + b.uy_);
+}
+
+
+SpatialIndex::SpatialIndex ()
+{
+    clear();
+}
+
+void SpatialIndex::clear ()
+{
+    num_components_ = 0;
+    boxes_.clear();
+    indexed_.clear();
+    origin_x_ = origin_y_ = 0;
+    bin_w_ = bin_h_ = 1;
+    num_bins_x_ = num_bins_y_ = 0;
+    bins_.clear();
+}
+
+void SpatialIndex::build (const Def& def)
+{
+    clear();
+
+    auto& components = def.get_components();
+    auto& pins = def.get_pins();
+    auto dbu = def.get_dbu();
+
+    num_components_ = components.size();
+    boxes_.resize(components.size() + pins.size());
+    indexed_.resize(boxes_.size(), false);
+
+    // The extent covers the die and every object, as the die area may be
+    // given as a polygon.
+    Box extent(def.get_die_lx(), def.get_die_ly(), def.get_die_ux(), def.get_die_uy());
+    auto extend = [&] (const Box& b) {
+        extent.lx_ = std::min(extent.lx_, b.lx_);
+        extent.ly_ = std::min(extent.ly_, b.ly_);
+        extent.ux_ = std::max(extent.ux_, b.ux_);
+        extent.uy_ = std::max(extent.uy_, b.uy_);
+    };
+
+    for (auto& c : components) {
+        if (c->is_placed_ || c->is_fixed_) {
+            boxes_[c->id_] = get_cell_box(*c, c->x_, c->y_);
+            indexed_[c->id_] = true;
+            extend(boxes_[c->id_]);
+        }
+    }
+    for (auto& p : pins) {
+        auto index = num_components_ + p->id_;
+        boxes_[index] = get_pin_box(*p);
+        indexed_[index] = true;
+        extend(boxes_[index]);
+    }
+
+    // Bin size from the gcell grids, or the row height.
+    int bin_w = 0, bin_h = 0;
+    for (auto& g : def.get_gcell_grids()) {
+        if (g->step_ <= 0) {
+            continue;
+        }
+        if (g->direction_ == TrackDir::x && bin_w == 0) {
+            bin_w = g->step_;
+        }
+        else if (g->direction_ == TrackDir::y && bin_h == 0) {
+            bin_h = g->step_;
+        }
+    }
+    if (bin_w == 0 || bin_h == 0) {
+        auto& rows = def.get_rows();
+        auto site = rows.empty() ? nullptr : lef::Lef::get_instance().get_site(rows[0]->macro_);
+        auto row_height = site ? static_cast<int>(lround(site->y_ * dbu)) : 0;
+        bin_w = bin_w > 0 ? bin_w : row_height;
+        bin_h = bin_h > 0 ? bin_h : row_height;
+    }
+
+    auto width = static_cast<int64_t>(extent.ux_) - extent.lx_ + 1;
+    auto height = static_cast<int64_t>(extent.uy_) - extent.ly_ + 1;
+    if (bin_w <= 0 || bin_h <= 0) {
+        auto side = static_cast<int>(std::max<double>(1, std::sqrt(
+                        static_cast<double>(width) * height / std::max<size_t>(1, boxes_.size()))));
+        bin_w = bin_h = side;
+    }
+
+    // Keep the number of bins within a few per object.
+    const int64_t max_bins = std::max<int64_t>(1024, 4 * boxes_.size());
+    while (((width + bin_w - 1) / bin_w) * ((height + bin_h - 1) / bin_h) > max_bins) {
+        bin_w *= 2;
+        bin_h *= 2;
+    }
+
+    origin_x_ = extent.lx_;
+    origin_y_ = extent.ly_;
+    bin_w_ = bin_w;
+    bin_h_ = bin_h;
+    num_bins_x_ = static_cast<int>((width + bin_w - 1) / bin_w);
+    num_bins_y_ = static_cast<int>((height + bin_h - 1) / bin_h);
+    bins_.resize(static_cast<size_t>(num_bins_x_) * num_bins_y_);
+
+    for (uint32_t i = 0; i < boxes_.size(); i++) {
+        if (indexed_[i]) {
+            insert(i, boxes_[i]);
+        }
+    }
+}
+
+void SpatialIndex::update_component (const Component& c)
+{
+    if (c.id_ >= num_components_ || bins_.empty()) {
+        return;
+    }
+
+    if (indexed_[c.id_]) {
+        remove(c.id_, boxes_[c.id_]);
+        indexed_[c.id_] = false;
+    }
+    if (c.is_placed_ || c.is_fixed_) {
+        boxes_[c.id_] = get_cell_box(c, c.x_, c.y_);
+        indexed_[c.id_] = true;
+        insert(c.id_, boxes_[c.id_]);
+    }
+}
+
+void SpatialIndex::insert (uint32_t index, const Box& box)
+{
+    for (auto by = bin_y(box.ly_); by <= bin_y(box.uy_); by++) {
+        for (auto bx = bin_x(box.lx_); bx <= bin_x(box.ux_); bx++) {
+            bins_[static_cast<size_t>(by) * num_bins_x_ + bx].push_back(index);
+        }
+    }
+}
+
+void SpatialIndex::remove (uint32_t index, const Box& box)
+{
+    for (auto by = bin_y(box.ly_); by <= bin_y(box.uy_); by++) {
+        for (auto bx = bin_x(box.lx_); bx <= bin_x(box.ux_); bx++) {
+            auto& bin = bins_[static_cast<size_t>(by) * num_bins_x_ + bx];
+            auto found = std::find(bin.begin(), bin.end(), index);
+            if (found != bin.end()) {
+                *found = bin.back();
+                bin.pop_back();
+            }
+        }
+    }
+}
+
+void SpatialIndex::query_window (const Box& window, vector<Item>& items) const
+{
+    items.clear();
+    for_each_in_window(window, [&] (Item item) { items.push_back(item); });
+}
+
+void SpatialIndex::query_overlaps (const Box& box, vector<Item>& items) const
+{
+    items.clear();
+    for_each_in_window(box, [&] (Item item) {
+        if (boxes_[to_index(item)].overlaps(box)) {
+            items.push_back(item);
+        }
+    });
+}
+
+/**
+ * @return Squared Euclidean distance from (@a x, @a y) to @a b.
+ */
+static int64_t get_distance2 (int x, int y, const Box& b)
+{
+    int64_t dx = x < b.lx_ ? b.lx_ - x : (x > b.ux_ ? x - b.ux_ : 0);
+    int64_t dy = y < b.ly_ ? b.ly_ - y : (y > b.uy_ ? y - b.uy_ : 0);
+    return dx * dx + dy * dy;
+}
+
+void SpatialIndex::query_nearest (int x, int y, size_t k, vector<Item>& items) const
+{
+    items.clear();
+    if (bins_.empty() || k == 0) {
+        return;
+    }
+
+    // A max-heap of the k nearest so far, by (distance, index).
+    vector<pair<int64_t, uint32_t>> heap;
+    heap.reserve(k + 1);
+
+    auto visit = [&] (int bx, int by) {
+        for (auto index : bins_[static_cast<size_t>(by) * num_bins_x_ + bx]) {
+            auto d = get_distance2(x, y, boxes_[index]);
+            if (heap.size() == k && d >= heap.front().first) {
+                continue;
+            }
+            // An object spanning several bins may be seen again.
+            auto seen = std::find_if(heap.begin(), heap.end(),
+                            [&] (const pair<int64_t, uint32_t>& e) { return e.second == index; });
+            if (seen != heap.end()) {
+                continue;
+            }
+            heap.emplace_back(d, index);
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() > k) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+        }
+    };
+
+    // Visit rings of bins around the bin of (x, y) until no closer object
+    // can be found.
+    auto cx = bin_x(x);
+    auto cy = bin_y(y);
+    auto max_ring = std::max(std::max(cx, num_bins_x_ - 1 - cx),
+                             std::max(cy, num_bins_y_ - 1 - cy));
+
+    for (int r = 0; r <= max_ring; r++) {
+        if (r > 0 && heap.size() == k) {
+            // Distance from (x, y) to the outside of the rings visited.
+            int64_t lx = static_cast<int64_t>(origin_x_) + static_cast<int64_t>(cx - r + 1) * bin_w_;
+            int64_t ux = static_cast<int64_t>(origin_x_) + static_cast<int64_t>(cx + r) * bin_w_;
+            int64_t ly = static_cast<int64_t>(origin_y_) + static_cast<int64_t>(cy - r + 1) * bin_h_;
+            int64_t uy = static_cast<int64_t>(origin_y_) + static_cast<int64_t>(cy + r) * bin_h_;
+            auto d = std::max<int64_t>(0, std::min(std::min(x - lx, ux - x),
+                                                   std::min(y - ly, uy - y)));
+            if (d * d >= heap.front().first) {
+                break;
+            }
+        }
+
+        for (auto by = cy - r; by <= cy + r; by++) {
+            if (by < 0 || by >= num_bins_y_) {
+                continue;
+            }
+            auto on_edge = (by == cy - r || by == cy + r);
+            for (auto bx = cx - r; bx <= cx + r; bx += (on_edge ? 1 : 2 * r)) {
+                if (bx >= 0 && bx < num_bins_x_) {
+                    visit(bx, by);
+                }
+                if (r == 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (auto& e : heap) {
+        items.push_back(to_item(e.second));
+    }
+}
+
+bool SpatialIndex::is_indexed (Item item) const
+{
+    auto index = to_index(item);
+    return index < indexed_.size() && indexed_[index];
+}
+
+Box SpatialIndex::get_box (Item item) const
+{
+    return boxes_[to_index(item)];
+}
+
+size_t SpatialIndex::get_num_items () const
+{
+    return boxes_.size();
+}
+
+int SpatialIndex::get_num_bins_x () const
+{
+    return num_bins_x_;
+}
+
+int SpatialIndex::get_num_bins_y () const
+{
+    return num_bins_y_;
+}
+
+int SpatialIndex::get_bin_width () const
+{
+    return bin_w_;
+}
+
+int SpatialIndex::get_bin_height () const
+{
+    return bin_h_;
+}
+
+}   // End of namespace def
@@ -0,0 +1,178 @@
+/**
+ * @file    SpatialIndex.h
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "common_header.h"
+#include "Geometry.h"
+
+namespace def
+{
+
+// Forward declaration.
+class  Def;
+struct Component;
+struct Pin;
+
+using util::Box;
+using util::transform_box;
+
+/**
+ * A uniform-bin index over the placed components and the IO pins of a Def.
+ *
+ * Each object is kept in every bin its box touches, so a query only visits
+ * the bins of its window; an object is reported from the first visited bin
+ * it touches. Queries do not modify the index and may run concurrently.
+ * Moving a component updates only the bins of its old and new boxes.
+ */
+class SpatialIndex
+{
+public:
+    enum class ItemType : uint8_t { component, pin };
+
+    /**
+     * A component or an IO pin, by its dense id.
+     */
+    struct Item
+    {
+        ItemType type_;
+        uint32_t id_;
+
+        bool operator== (const Item& rhs) const
+        {
+            return type_ == rhs.type_ && id_ == rhs.id_;
+        }
+    };
+
+    SpatialIndex ();
+
+    /**
+     * Index the components and the pins of @a def. Bins are as large as the
+     * gcell grid steps, or square with the row height if there is none.
+     */
+    void build (const Def& def);
+    void clear ();
+
+    /**
+     * Move the component @a c to its current x_/y_. Unplaced components
+     * are not indexed until placed.
+     */
+    void update_component (const Component& c);
+
+    /**
+     * Call @a func(item) for every object whose box touches @a window.
+     */
+    template <typename Func>
+    void for_each_in_window (const Box& window, Func func) const;
+
+    /**
+     * @return Objects whose boxes touch @a window, in @a items.
+     */
+    void query_window (const Box& window, vector<Item>& items) const;
+
+    /**
+     * @return Objects whose boxes share a positive area with @a box.
+     */
+    void query_overlaps (const Box& box, vector<Item>& items) const;
+
+    /**
+     * @return Up to @a k objects closest to (@a x, @a y), nearest first, in
+     *         @a items. The distance is the Euclidean one to an object's box.
+     */
+    void query_nearest (int x, int y, size_t k, vector<Item>& items) const;
+
+    /**
+     * @return False if @a item is not indexed (e.g. unplaced).
+     */
+    bool is_indexed (Item item) const;
+    Box get_box (Item item) const;
+
+    size_t get_num_items () const;
+    int get_num_bins_x () const;
+    int get_num_bins_y () const;
+    int get_bin_width () const;
+    int get_bin_height () const;
+
+private:
+    // Objects are numbered components first, then pins.
+    uint32_t num_components_;
+    vector<Box> boxes_;
+    vector<bool> indexed_;
+
+    int origin_x_;
+    int origin_y_;
+    int bin_w_;
+    int bin_h_;
+    int num_bins_x_;
+    int num_bins_y_;
+    vector<vector<uint32_t>> bins_;
+
+    uint32_t to_index (Item item) const;
+    Item to_item (uint32_t index) const;
+
+    int bin_x (int x) const;
+    int bin_y (int y) const;
+
+    void insert (uint32_t index, const Box& box);
+    void remove (uint32_t index, const Box& box);
+};
+
+
+inline uint32_t SpatialIndex::to_index (Item item) const
+{
+    return item.type_ == ItemType::component ? item.id_ : num_components_ + item.id_;
+}
+
+inline SpatialIndex::Item SpatialIndex::to_item (uint32_t index) const
+{
+    return index < num_components_ ? Item{ItemType::component, index}
+                                   : Item{ItemType::pin, index - num_components_};
+}
+
+inline int SpatialIndex::bin_x (int x) const
+{
+    auto b = (static_cast<int64_t>(x) - origin_x_) / bin_w_;
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(num_bins_x_ - 1, b)));
+}
+
+inline int SpatialIndex::bin_y (int y) const
+{
+    auto b = (static_cast<int64_t>(y) - origin_y_) / bin_h_;
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(num_bins_y_ - 1, b)));
+}
+
+template <typename Func>
+void SpatialIndex::for_each_in_window (const Box& window, Func func) const
+{
+    if (bins_.empty() || window.lx_ > window.ux_ || window.ly_ > window.uy_) {
+        return;
+    }
+
+    auto qxl = bin_x(window.lx_);
+    auto qxu = bin_x(window.ux_);
+    auto qyl = bin_y(window.ly_);
+    auto qyu = bin_y(window.uy_);
+
+    for (auto by = qyl; by <= qyu; by++) {
+        for (auto bx = qxl; bx <= qxu; bx++) {
+            for (auto index : bins_[static_cast<size_t>(by) * num_bins_x_ + bx]) {
+                auto& box = boxes_[index];
+                if (!box.intersects(window)) {
+                    continue;
+                }
+                // Report an object only from the first bin of the window it is in.
+                if (bx != std::max(qxl, bin_x(box.lx_))
+                    || by != std::max(qyl, bin_y(box.ly_))) {
+                    continue;
+                }
+                func(to_item(index));
+            }
+        }
+    }
+}
+
+}   // End of namespace def
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * @file    SpecialShapes.cpp
+ */
+
+#include "SpecialShapes.h"
+#include "Lef.h"
+
+using namespace std;
+
+namespace def
+{
+
+static const char* status_names[] = {"ROUTED", "FIXED", "COVER"};
+
+static const char* shape_type_names[] = {
+    "", "RING", "PADRING", "BLOCKRING", "STRIPE", "FOLLOWPIN", "IOWIRE",
+    "COREWIRE", "BLOCKWIRE", "BLOCKAGEWIRE", "FILLWIRE", "FILLWIREOPC", "DRCFILL"
+};
+
+static const int num_shape_types = sizeof(shape_type_names) / sizeof(shape_type_names[0]);
+
+
+SpecialShapes::SpecialShapes ()
+{
+    //
+}
+
+void SpecialShapes::clear ()
+{
+    *this = SpecialShapes();
+}
+
+const char* SpecialShapes::get_status_name (Status status)
+{
+    return status_names[static_cast<int>(status)];
+}
+
+/**
+ * SHIELD (and no status) is kept as ROUTED; the shielded net is not kept.
+ */
+SpecialShapes::Status SpecialShapes::find_status (const char* name)
+{
+    if (name == nullptr) {
+        return Status::routed;
+    }
+    if (strcmp(name, "FIXED") == 0) {
+        return Status::fixed;
+    }
+    if (strcmp(name, "COVER") == 0) {
+        return Status::cover;
+    }
+    return Status::routed;
+}
+
+const char* SpecialShapes::get_shape_type_name (int shape_type)
+{
+    return shape_type_names[shape_type];
+}
+
+int SpecialShapes::find_shape_type (const char* name)
+{
+    if (name == nullptr) {
+        return 0;
+    }
+    for (auto i = 1; i < num_shape_types; i++) {
+        if (strcmp(name, shape_type_names[i]) == 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+uint16_t SpecialShapes::get_layer (const char* name)
+{
+    auto id = util::SymbolTable::get_instance().intern(name);
+    auto found = layer_of_symbol_.find(id);
+    if (found != layer_of_symbol_.end()) {
+        return found->second;
+    }
+
+    assert(layers_.size() < numeric_limits<uint16_t>::max());
+    auto layer = static_cast<uint16_t>(layers_.size());
+    layers_.push_back(id);
+    layer_of_symbol_.emplace(id, layer);
+    return layer;
+}
+
+/**
+ * A via is kept on its cut layer: the LEF layer of type CUT, else the
+ * middle one of its layers.
+ */
+uint32_t SpecialShapes::get_via (const char* name)
+{
+    auto id = util::SymbolTable::get_instance().intern(name);
+    auto found = via_of_symbol_.find(id);
+    if (found != via_of_symbol_.end()) {
+        return found->second;
+    }
+
+    const char* cut = name;
+    auto via = lef::Lef::get_instance().get_via(name);
+    if (via != nullptr && !via->layers_.empty()) {
+        cut = via->layers_[via->layers_.size() / 2].name_.c_str();
+        for (auto& l : via->layers_) {
+            if (l.layer_ptr_ != nullptr && l.layer_ptr_->type_ == "CUT") {
+                cut = l.name_.c_str();
+                break;
+            }
+        }
+    }
+
+    auto index = static_cast<uint32_t>(vias_.size());
+    vias_.push_back(id);
+    via_of_symbol_.emplace(id, index);
+    via_layers_.push_back(get_layer(cut));
+    via_boxes_.push_back(util::Box());
+    return index;
+}
+
+void SpecialShapes::add_wire (uint32_t net, const char* layer, int width,
+                              int x1, int y1, int x2, int y2,
+                              Status status, int shape_type)
+{
+    Shape s;
+    s.x1_ = x1;
+    s.y1_ = y1;
+    s.x2_ = x2;
+    s.y2_ = y2;
+    s.width_ = width;
+    s.net_ = net;
+    s.layer_ = get_layer(layer);
+    s.kind_ = Kind::wire;
+    s.flags_ = static_cast<uint8_t>(static_cast<int>(status) | (shape_type << 2));
+    shapes_.push_back(s);
+}
+
+void SpecialShapes::add_via (uint32_t net, const char* via, const char* layer,
+                             int width, int x, int y, Status status, int shape_type)
+{
+    auto index = get_via(via);
+
+    Shape s;
+    s.x1_ = x;
+    s.y1_ = y;
+    s.x2_ = static_cast<int>(index);
+    s.y2_ = get_layer(layer);
+    s.width_ = width;
+    s.net_ = net;
+    s.layer_ = via_layers_[index];
+    s.kind_ = Kind::via;
+    s.flags_ = static_cast<uint8_t>(static_cast<int>(status) | (shape_type << 2));
+    shapes_.push_back(s);
+}
+
+void SpecialShapes::add_rect (uint32_t net, const char* layer, const util::Box& box,
+                              Status status, int shape_type)
+{
+    Shape s;
+    s.x1_ = box.lx_;
+    s.y1_ = box.ly_;
+    s.x2_ = box.ux_;
+    s.y2_ = box.uy_;
+    s.width_ = 0;
+    s.net_ = net;
+    s.layer_ = get_layer(layer);
+    s.kind_ = Kind::rect;
+    s.flags_ = static_cast<uint8_t>(static_cast<int>(status) | (shape_type << 2));
+    shapes_.push_back(s);
+}
+
+/**
+ * Group the shapes by layer in place (American flag sort): count, then
+ * swap every shape into the bucket of its layer.
+ */
+void SpecialShapes::sort_by_layer ()
+{
+    auto num_layers = layers_.size();
+    layer_begin_.assign(num_layers + 1, 0);
+    for (auto& s : shapes_) {
+        layer_begin_[s.layer_ + 1]++;
+    }
+    for (size_t l = 0; l < num_layers; l++) {
+        layer_begin_[l + 1] += layer_begin_[l];
+    }
+
+    vector<size_t> next(layer_begin_.begin(), layer_begin_.end() - 1);
+    for (size_t l = 0; l < num_layers; l++) {
+        while (next[l] < layer_begin_[l + 1]) {
+            auto& s = shapes_[next[l]];
+            if (s.layer_ == l) {
+                next[l]++;
+            }
+            else {
+                swap(s, shapes_[next[s.layer_]++]);
+            }
+        }
+    }
+}
+
+/**
+ * Bins cover the bounding box of the layer, about four shapes to a bin.
+ * A bin is at least as large as the average shape, so that long rails and
+ * stripes fall in a few bins each.
+ */
+void SpecialShapes::build_bins (uint16_t layer)
+{
+    auto& bins = bins_[layer];
+    bins = Bins();
+
+    auto first = layer_begin_[layer];
+    auto last = layer_begin_[layer + 1];
+    auto n = last - first;
+    if (n == 0) {
+        return;
+    }
+
+    util::Box bbox = get_box(shapes_[first]);
+    double sum_w = 0, sum_h = 0;
+    for (auto i = first; i < last; i++) {
+        auto box = get_box(shapes_[i]);
+        bbox.lx_ = min(bbox.lx_, box.lx_);
+        bbox.ly_ = min(bbox.ly_, box.ly_);
+        bbox.ux_ = max(bbox.ux_, box.ux_);
+        bbox.uy_ = max(bbox.uy_, box.uy_);
+        sum_w += static_cast<double>(box.ux_) - box.lx_;
+        sum_h += static_cast<double>(box.uy_) - box.ly_;
+    }
+
+    auto width = static_cast<double>(bbox.ux_) - bbox.lx_ + 1;
+    auto height = static_cast<double>(bbox.uy_) - bbox.ly_ + 1;
+    auto side = sqrt(width * height / max<double>(1, n / 4.0));
+    auto bin_w = max({side, sum_w / n, 1.0});
+    auto bin_h = max({side, sum_h / n, 1.0});
+
+    bins.origin_x_ = bbox.lx_;
+    bins.origin_y_ = bbox.ly_;
+    bins.num_x_ = static_cast<int>(min(4096.0, ceil(width / bin_w)));
+    bins.num_y_ = static_cast<int>(min(4096.0, ceil(height / bin_h)));
+    bins.bin_w_ = static_cast<int>(min<double>(numeric_limits<int>::max(),
+                                               ceil(width / bins.num_x_)));
+    bins.bin_h_ = static_cast<int>(min<double>(numeric_limits<int>::max(),
+                                               ceil(height / bins.num_y_)));
+
+    auto num_bins = static_cast<size_t>(bins.num_x_) * bins.num_y_;
+    bins.begin_.assign(num_bins + 1, 0);
+    for (auto i = first; i < last; i++) {
+        auto box = get_box(shapes_[i]);
+        auto bxl = bins.bin_x(box.lx_), bxu = bins.bin_x(box.ux_);
+        for (auto by = bins.bin_y(box.ly_); by <= bins.bin_y(box.uy_); by++) {
+            for (auto bx = bxl; bx <= bxu; bx++) {
+                bins.begin_[static_cast<size_t>(by) * bins.num_x_ + bx + 1]++;
+            }
+        }
+    }
+    for (size_t b = 0; b < num_bins; b++) {
+        bins.begin_[b + 1] += bins.begin_[b];
+    }
+
+    bins.items_.resize(bins.begin_[num_bins]);
+    vector<uint32_t> next(bins.begin_.begin(), bins.begin_.end() - 1);
+    for (auto i = first; i < last; i++) {
+        auto box = get_box(shapes_[i]);
+        auto bxl = bins.bin_x(box.lx_), bxu = bins.bin_x(box.ux_);
+        for (auto by = bins.bin_y(box.ly_); by <= bins.bin_y(box.uy_); by++) {
+            for (auto bx = bxl; bx <= bxu; bx++) {
+                auto bin = static_cast<size_t>(by) * bins.num_x_ + bx;
+                bins.items_[next[bin]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+}
+
+void SpecialShapes::build (int dbu)
+{
+    auto& lef = lef::Lef::get_instance();
+
+    for (size_t v = 0; v < vias_.size(); v++) {
+        auto via = lef.get_via(util::SymbolTable::get_instance().get_name(vias_[v]));
+        if (via == nullptr) {
+            via_boxes_[v] = util::Box();
+            continue;
+        }
+
+        lef::Rect r;
+        for (auto& l : via->layers_) {
+            for (auto& rect : l.rect_vec_) {
+                r.lx_ = min(r.lx_, rect.lx_);
+                r.ly_ = min(r.ly_, rect.ly_);
+                r.ux_ = max(r.ux_, rect.ux_);
+                r.uy_ = max(r.uy_, rect.uy_);
+            }
+        }
+        via_boxes_[v] = r.lx_ > r.ux_ ? util::Box()
+                        : util::Box(static_cast<int>(lround(r.lx_ * dbu)),
+                                    static_cast<int>(lround(r.ly_ * dbu)),
+                                    static_cast<int>(lround(r.ux_ * dbu)),
+                                    static_cast<int>(lround(r.uy_ * dbu)));
+    }
+
+    sort_by_layer();
+
+    bins_.resize(layers_.size());
+    for (size_t l = 0; l < layers_.size(); l++) {
+        build_bins(static_cast<uint16_t>(l));
+    }
+}
+
+util::Span<SpecialShapes::Shape> SpecialShapes::get_layer_shapes (uint16_t layer) const
+{
+    if (static_cast<size_t>(layer) + 1 >= layer_begin_.size()) {
+        return util::Span<Shape>();
+    }
+    return util::Span<Shape>(shapes_.data() + layer_begin_[layer],
+                             shapes_.data() + layer_begin_[layer + 1]);
+}
+
+const char* SpecialShapes::get_layer_name (uint16_t layer) const
+{
+    return util::SymbolTable::get_instance().get_name(layers_[layer]);
+}
+
+int SpecialShapes::find_layer (const string& name) const
+{
+    auto id = util::SymbolTable::get_instance().find(name);
+    auto found = layer_of_symbol_.find(id);
+    return found == layer_of_symbol_.end() ? -1 : found->second;
+}
+
+const char* SpecialShapes::get_via_name (const Shape& s) const
+{
+    return util::SymbolTable::get_instance().get_name(vias_[s.x2_]);
+}
+
+uint16_t SpecialShapes::get_path_layer (const Shape& s) const
+{
+    return s.kind_ == Kind::via ? static_cast<uint16_t>(s.y2_) : s.layer_;
+}
+
+void SpecialShapes::query_window (uint16_t layer, const util::Box& window,
+                                  vector<uint32_t>& shapes) const
+{
+    shapes.clear();
+    for_each_in_window(layer, window, [&shapes] (uint32_t i) { shapes.push_back(i); });
+}
+
+size_t SpecialShapes::get_memory () const
+{
+    auto bytes = shapes_.capacity() * sizeof(Shape)
+                 + layer_begin_.capacity() * sizeof(size_t);
+    for (auto& b : bins_) {
+        bytes += (b.begin_.capacity() + b.items_.capacity()) * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void SpecialShapes::write (util::BinaryWriter& w) const
+{
+    auto& symbols = util::SymbolTable::get_instance();
+
+    w.write<uint32_t>(layers_.size());
+    for (auto l : layers_) {
+        w.write_string(symbols.get_name(l));
+    }
+    w.write<uint32_t>(vias_.size());
+    for (size_t v = 0; v < vias_.size(); v++) {
+        w.write_string(symbols.get_name(vias_[v]));
+        w.write(via_layers_[v]);
+    }
+    w.write<uint64_t>(shapes_.size());
+    for (auto& s : shapes_) {
+        w.write(s);
+    }
+}
+
+void SpecialShapes::read (util::BinaryReader& r, int dbu)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+
+    clear();
+    auto num_layers = r.read<uint32_t>();
+    for (uint32_t l = 0; l < num_layers; l++) {
+        auto id = symbols.intern(r.read_string());
+        layer_of_symbol_.emplace(id, static_cast<uint16_t>(layers_.size()));
+        layers_.push_back(id);
+    }
+    auto num_vias = r.read<uint32_t>();
+    for (uint32_t v = 0; v < num_vias; v++) {
+        auto id = symbols.intern(r.read_string());
+        via_of_symbol_.emplace(id, static_cast<uint32_t>(vias_.size()));
+        vias_.push_back(id);
+        via_layers_.push_back(r.read<uint16_t>());
+        via_boxes_.push_back(util::Box());
+    }
+    shapes_.resize(r.read<uint64_t>());
+    for (auto& s : shapes_) {
+        s = r.read<Shape>();
+    }
+
+    build(dbu);
+}
+
+}   // End of namespace def
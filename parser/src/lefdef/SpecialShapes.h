@@ -0,0 +1,227 @@
+/**
+ * @file    SpecialShapes.h
+ */
+
+#ifndef SPECIAL_SHAPES_H
+#define SPECIAL_SHAPES_H
+
+#include "common_header.h"
+#include "Geometry.h"
+#include "SymbolTable.h"
+#include "BinaryIO.h"
+#include "Span.h"
+
+namespace def
+{
+
+/**
+ * The geometry of the special nets (stripes, rails, vias and rectangles)
+ * of a Def, grouped by layer, with a uniform-bin index per layer.
+ *
+ * A shape is a fixed-size record in one array; there is no heap object
+ * per shape. A wire keeps its center line and width, and covers the line
+ * extended by half the width on every side. A via covers the union of the
+ * rectangles of its LEF definition, and is kept on its cut layer; a via not
+ * in the LEF covers its origin only, on a layer named after the via.
+ *
+ * Shapes are added in any order; build() groups them by layer and bins
+ * them. Queries do not modify the store and may run concurrently.
+ */
+class SpecialShapes
+{
+public:
+    enum class Kind : uint8_t { wire, via, rect };
+    enum class Status : uint8_t { routed, fixed, cover };
+
+    struct Shape
+    {
+        int x1_;            ///< Wire: first end; via: origin; rect: lower-left.
+        int y1_;
+        int x2_;            ///< Wire: second end; rect: upper-right; via:
+        int y2_;            ///<   the via index, and the path layer.
+        int width_;         ///< Wire and via: the path width.
+        uint32_t net_;      ///< Index in Def::get_special_nets().
+        uint16_t layer_;    ///< Index in the layer table.
+        Kind kind_;
+        uint8_t flags_;     ///< Status, and the shape type above it.
+
+        Status get_status () const { return static_cast<Status>(flags_ & 3); }
+        int get_shape_type () const { return flags_ >> 2; }
+    };
+
+    SpecialShapes ();
+    void clear ();
+
+    /**
+     * Add a wire from (@a x1, @a y1) to (@a x2, @a y2). @a shape_type is an
+     * index given by find_shape_type().
+     */
+    void add_wire (uint32_t net, const char* layer, int width,
+                   int x1, int y1, int x2, int y2, Status status, int shape_type);
+    void add_via (uint32_t net, const char* via, const char* layer, int width,
+                  int x, int y, Status status, int shape_type);
+    void add_rect (uint32_t net, const char* layer, const util::Box& box,
+                   Status status, int shape_type);
+
+    /**
+     * Group the shapes by layer and index them. The vias are sized from the
+     * LEF in @a dbu DBU per micron.
+     */
+    void build (int dbu);
+
+    size_t get_num_shapes () const;
+    size_t get_num_layers () const;
+    const vector<Shape>& get_shapes () const;
+
+    /**
+     * @return The shapes on the layer @a layer (after build()).
+     */
+    util::Span<Shape> get_layer_shapes (uint16_t layer) const;
+    const char* get_layer_name (uint16_t layer) const;
+    int find_layer (const string& name) const;      ///< -1 if none.
+
+    util::Box get_box (const Shape& s) const;
+    const char* get_via_name (const Shape& s) const;
+    uint16_t get_path_layer (const Shape& s) const;
+
+    /**
+     * Call @a func(index) for every shape on @a layer whose box touches
+     * @a window; index is the position in get_shapes().
+     */
+    template <typename Func>
+    void for_each_in_window (uint16_t layer, const util::Box& window, Func func) const;
+    void query_window (uint16_t layer, const util::Box& window,
+                       vector<uint32_t>& shapes) const;
+
+    /**
+     * @return Bytes used by the shapes and the bins.
+     */
+    size_t get_memory () const;
+
+    void write (util::BinaryWriter& w) const;
+    void read (util::BinaryReader& r, int dbu);
+
+    static const char* get_status_name (Status status);
+    static Status find_status (const char* name);
+    static const char* get_shape_type_name (int shape_type);
+    static int find_shape_type (const char* name);     ///< 0 if none.
+
+private:
+    vector<Shape> shapes_;
+
+    // Layers, and the shapes of each after build().
+    vector<util::SymbolId> layers_;
+    unordered_map<util::SymbolId, uint16_t> layer_of_symbol_;
+    vector<size_t> layer_begin_;
+
+    // Vias by name: the cut layer, and the box relative to the origin.
+    vector<util::SymbolId> vias_;
+    unordered_map<util::SymbolId, uint32_t> via_of_symbol_;
+    vector<uint16_t> via_layers_;
+    vector<util::Box> via_boxes_;
+
+    /**
+     * Uniform bins over the shapes of a layer, in CSR form.
+     */
+    struct Bins
+    {
+        int origin_x_, origin_y_;
+        int bin_w_, bin_h_;
+        int num_x_, num_y_;
+        vector<uint32_t> begin_;
+        vector<uint32_t> items_;
+
+        int bin_x (int x) const;
+        int bin_y (int y) const;
+    };
+    vector<Bins> bins_;     ///< Indexed by layer.
+
+    uint16_t get_layer (const char* name);
+    uint32_t get_via (const char* name);
+    void sort_by_layer ();
+    void build_bins (uint16_t layer);
+};
+
+
+inline size_t SpecialShapes::get_num_shapes () const
+{
+    return shapes_.size();
+}
+
+inline size_t SpecialShapes::get_num_layers () const
+{
+    return layers_.size();
+}
+
+inline const vector<SpecialShapes::Shape>& SpecialShapes::get_shapes () const
+{
+    return shapes_;
+}
+
+inline util::Box SpecialShapes::get_box (const Shape& s) const
+{
+    switch (s.kind_) {
+        case Kind::wire: {
+            auto half = s.width_ / 2;
+            return util::Box(std::min(s.x1_, s.x2_) - half, std::min(s.y1_, s.y2_) - half,
+                             std::max(s.x1_, s.x2_) + half, std::max(s.y1_, s.y2_) + half);
+        }
+        case Kind::via:
+            return via_boxes_[s.x2_].shifted(s.x1_, s.y1_);
+        default:
+            return util::Box(s.x1_, s.y1_, s.x2_, s.y2_);
+    }
+}
+
+inline int SpecialShapes::Bins::bin_x (int x) const
+{
+    auto b = (static_cast<int64_t>(x) - origin_x_) / bin_w_;
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(num_x_ - 1, b)));
+}
+
+inline int SpecialShapes::Bins::bin_y (int y) const
+{
+    auto b = (static_cast<int64_t>(y) - origin_y_) / bin_h_;
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(num_y_ - 1, b)));
+}
+
+template <typename Func>
+void SpecialShapes::for_each_in_window (uint16_t layer, const util::Box& window,
+                                        Func func) const
+{
+    if (layer >= bins_.size() || window.lx_ > window.ux_ || window.ly_ > window.uy_) {
+        return;
+    }
+    auto& bins = bins_[layer];
+    if (bins.begin_.empty()) {
+        return;
+    }
+
+    auto qxl = bins.bin_x(window.lx_);
+    auto qxu = bins.bin_x(window.ux_);
+    auto qyl = bins.bin_y(window.ly_);
+    auto qyu = bins.bin_y(window.uy_);
+
+    for (auto by = qyl; by <= qyu; by++) {
+        for (auto bx = qxl; bx <= qxu; bx++) {
+            auto bin = static_cast<size_t>(by) * bins.num_x_ + bx;
+            for (auto i = bins.begin_[bin]; i < bins.begin_[bin + 1]; i++) {
+                auto index = bins.items_[i];
+                auto box = get_box(shapes_[index]);
+                if (!box.intersects(window)) {
+                    continue;
+                }
+                // Report a shape only from the first bin of the window it is in.
+                if (bx != std::max(qxl, bins.bin_x(box.lx_))
+                    || by != std::max(qyl, bins.bin_y(box.ly_))) {
+                    continue;
+                }
+                func(index);
+            }
+        }
+    }
+}
+
+}   // End of namespace def
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file    CostModel.cpp
+ */
+
+#include "CostModel.h"
+#include "StringUtil.h"
+
+using namespace std;
+
+namespace opt
+{
+
+Weights read_weights (string filename)
+{
+    ifstream ifs(filename);
+    if (!ifs) {
+        throw invalid_argument("(E) Weight file (" + filename + ") not found.");
+    }
+
+    const pair<const char*, double Weights::*> keys[] = {
+        {"alpha", &Weights::alpha_}, {"beta", &Weights::beta_}, {"gamma", &Weights::gamma_},
+        {"tns", &Weights::tns_}, {"tpo", &Weights::tpo_}, {"area", &Weights::area_}
+    };
+
+    Weights w;
+    string key;
+    double value;
+    while (ifs >> key >> value) {
+        auto lower = StringUtil::to_lower(key);
+        auto found = find_if(begin(keys), end(keys),
+                             [&] (const pair<const char*, double Weights::*>& k) {
+                                 return lower == k.first;
+                             });
+        if (found == end(keys)) {
+            cout << "(W) Unknown key " << key << " in " << filename << "." << endl;
+        }
+        else {
+            w.*(found->second) = value;
+        }
+    }
+    if (!ifs.eof()) {
+        cout << "(W) " << filename << " is not a list of keys and values; "
+             << "the rest of it is ignored." << endl;
+    }
+    return w;
+}
+
+
+CostModel::CostModel ()
+{
+    clear();
+}
+
+void CostModel::clear ()
+{
+    def_ = nullptr;
+    weights_ = Weights();
+    area_scale_ = 1;
+    areas_.clear();
+    total_area_ = 0;
+
+    timing_ = TermState();
+    power_ = TermState();
+}
+
+void CostModel::build (const def::Def& def, const Weights& weights)
+{
+    auto timing = move(timing_.term_);
+    auto power = move(power_.term_);
+
+    clear();
+    def_ = &def;
+    weights_ = weights;
+
+    auto dbu = static_cast<double>(def.get_dbu());
+    area_scale_ = 1.0 / (dbu * dbu);
+
+    auto& components = def.get_components();
+    areas_.resize(components.size());
+    for (auto& c : components) {
+        auto& m = c->lef_macro_;
+        areas_[c->id_] = m ? static_cast<int64_t>(m->size_x_dbu_) * m->size_y_dbu_ : 0;
+        total_area_ += areas_[c->id_];
+    }
+
+    set_term(timing_, move(timing), weights_.tns_);
+    set_term(power_, move(power), weights_.tpo_);
+}
+
+void CostModel::set_timing_term (Term term)
+{
+    set_term(timing_, move(term), weights_.tns_);
+}
+
+void CostModel::set_power_term (Term term)
+{
+    set_term(power_, move(term), weights_.tpo_);
+}
+
+void CostModel::set_term (TermState& state, Term term, double baseline)
+{
+    state.term_ = move(term);
+    state.value_ = baseline;
+    state.changed_.clear();
+    state.is_changed_.assign(areas_.size(), false);
+    state.is_all_changed_ = true;
+}
+
+void CostModel::mark_changed (TermState& state, uint32_t id)
+{
+    if (state.term_ && !state.is_all_changed_ && !state.is_changed_[id]) {
+        state.is_changed_[id] = true;
+        state.changed_.push_back(id);
+    }
+}
+
+void CostModel::update_moved (uint32_t id)
+{
+    mark_changed(timing_, id);
+    mark_changed(power_, id);
+}
+
+void CostModel::update_swapped (uint32_t id)
+{
+    if (def_ == nullptr) {
+        return;
+    }
+    auto& m = def_->get_components()[id]->lef_macro_;
+    auto area = m ? static_cast<int64_t>(m->size_x_dbu_) * m->size_y_dbu_ : 0;
+    total_area_ += area - areas_[id];
+    areas_[id] = area;
+
+    mark_changed(timing_, id);
+    mark_changed(power_, id);
+}
+
+/**
+ * The term is asked only if a component changed since it was last asked.
+ */
+double CostModel::get_value (TermState& state)
+{
+    if (!state.term_) {
+        return state.value_;
+    }
+
+    if (state.is_all_changed_) {
+        state.changed_.resize(areas_.size());
+        iota(state.changed_.begin(), state.changed_.end(), 0);
+        state.value_ = state.term_(state.changed_);
+        state.is_all_changed_ = false;
+    }
+    else if (!state.changed_.empty()) {
+        state.value_ = state.term_(state.changed_);
+        for (auto id : state.changed_) {
+            state.is_changed_[id] = false;
+        }
+    }
+    state.changed_.clear();
+    return state.value_;
+}
+
+double CostModel::get_tns ()
+{
+    return get_value(timing_);
+}
+
+double CostModel::get_tpo ()
+{
+    return get_value(power_);
+}
+
+double CostModel::get_cost ()
+{
+    return weights_.alpha_ * get_tns() + weights_.beta_ * get_tpo()
+           + weights_.gamma_ * get_area();
+}
+
+void CostModel::report ()
+{
+    auto baseline = weights_.get_baseline_cost();
+    auto cost = get_cost();
+
+    cout << "Summary of the cost." << endl;
+    auto precision = cout.precision();
+    cout << fixed << setprecision(2);
+    cout << "\tTNS  : " << get_tns() << " x " << weights_.alpha_
+         << (timing_.term_ ? "" : " (baseline)") << endl;
+    cout << "\tTPO  : " << get_tpo() << " x " << weights_.beta_
+         << (power_.term_ ? "" : " (baseline)") << endl;
+    cout << "\tArea : " << get_area() << " x " << weights_.gamma_
+         << " (baseline " << weights_.area_ << ")" << endl;
+    cout << "\tCost : " << cost << " (baseline " << baseline << ")" << endl;
+    cout.unsetf(std::ios_base::floatfield);
+    cout.precision(precision);
+}
+
+}   // End of namespace opt
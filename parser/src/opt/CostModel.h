@@ -0,0 +1,135 @@
+/**
+ * @file    CostModel.h
+ */
+
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include "common_header.h"
+#include "Def.h"
+
+#include <functional>
+
+namespace opt
+{
+
+/**
+ * The weights of the objective and the values of the baseline design, as
+ * in a weight file ("Alpha 1", "TNS 1058.87", ...). Timing, power and area
+ * are in the units of the file; the TNS is a magnitude, not negative.
+ */
+struct Weights
+{
+    double alpha_;      ///< Of the TNS.
+    double beta_;       ///< Of the total power.
+    double gamma_;      ///< Of the cell area.
+
+    double tns_;
+    double tpo_;
+    double area_;
+
+    Weights () : alpha_(0), beta_(0), gamma_(0), tns_(0), tpo_(0), area_(0) { }
+
+    double get_baseline_cost () const
+    {
+        return alpha_ * tns_ + beta_ * tpo_ + gamma_ * area_;
+    }
+};
+
+/**
+ * Read the weight file @a filename. Keys are not case sensitive; missing
+ * keys are 0.
+ */
+Weights read_weights (string filename);
+
+/**
+ * The objective Alpha * TNS + Beta * TPO + Gamma * Area of a Def, kept up
+ * to date as its components are moved or swapped.
+ *
+ * The area, in square microns, is the sum of the macro sizes of the
+ * components; a swap updates it in O(1). TNS and TPO come from terms
+ * plugged in by the timing and power engines, which are given the
+ * components changed since they were last asked, so they can update
+ * incrementally. A term is only asked when a component changed; a term
+ * not plugged in stays at its baseline value.
+ */
+class CostModel
+{
+public:
+    /**
+     * @return The value of a term, given the components changed since the
+     *         last call (all of them on the first call).
+     */
+    using Term = std::function<double (const vector<uint32_t>& changed)>;
+
+    CostModel ();
+
+    /**
+     * Take the components of @a def and the weights @a weights. The terms
+     * plugged in are kept, and asked again for all the components.
+     */
+    void build (const def::Def& def, const Weights& weights);
+    void clear ();
+
+    void set_timing_term (Term term);
+    void set_power_term (Term term);
+
+    /**
+     * Tell that the component @a id was moved. Its area is kept.
+     */
+    void update_moved (uint32_t id);
+
+    /**
+     * Tell that the macro of the component @a id changed; its area is
+     * taken again. Ignored until the model is built.
+     */
+    void update_swapped (uint32_t id);
+
+    double get_area () const;
+    double get_tns ();
+    double get_tpo ();
+    double get_cost ();
+
+    const Weights& get_weights () const;
+
+    void report ();
+
+private:
+    const def::Def* def_;
+    Weights weights_;
+    double area_scale_;             ///< Square microns per square DBU.
+
+    vector<int64_t> areas_;         ///< By component id, in square DBU.
+    int64_t total_area_;
+
+    struct TermState
+    {
+        Term term_;
+        double value_;
+        vector<uint32_t> changed_;  ///< Component ids, unsorted.
+        vector<bool> is_changed_;   ///< By component id.
+        bool is_all_changed_;
+    };
+
+    TermState timing_;
+    TermState power_;
+
+    void set_term (TermState& state, Term term, double baseline);
+    void mark_changed (TermState& state, uint32_t id);
+    double get_value (TermState& state);
+};
+
+
+inline double CostModel::get_area () const
+{
+    return total_area_ * area_scale_;
+}
+
+inline const Weights& CostModel::get_weights () const
+{
+    return weights_;
+}
+
+}   // End of namespace opt
+
+#endif
@@ -0,0 +1,923 @@
+/**
+ * @file    Sdc.cpp
+ */
+
+#include "Sdc.h"
+#include "MappedFile.h"
+#include "StringUtil.h"
+
+#include <limits>
+
+using namespace std;
+
+namespace sdc
+{
+
+/**
+ * A word of a command: a string, or the objects a nested command returns.
+ */
+struct Word
+{
+    enum class Kind { text, ports, clocks, design, other };
+
+    Kind kind_;
+    string text_;
+    vector<uint32_t> ids_;      ///< Pin ids for ports, clock indices for clocks.
+
+    Word () : kind_(Kind::text) { }
+};
+
+/**
+ * Reads the Tcl subset SDC files are written in: commands end at a new
+ * line or ';', words are grouped with braces or quotes, and nested
+ * commands in brackets return collections of ports or clocks. Variables
+ * made by "set" are substituted.
+ */
+class SdcReader
+{
+public:
+    SdcReader (Sdc& sdc, const def::Def& def, const string& filename);
+    void read (const char* data, size_t size);
+
+private:
+    Sdc& sdc_;
+    const def::Def& def_;
+    string filename_;
+
+    const char* p_;
+    const char* end_;
+    size_t line_;
+    size_t num_warnings_;
+
+    unordered_map<string, string> variables_;
+    unordered_map<string, Word> results_;   ///< Nested commands already run, by text.
+    vector<uint32_t> pins_by_name_;         ///< Pin ids sorted by name, for wildcards.
+
+    /**
+     * The options and the other words of a command.
+     */
+    struct Arguments
+    {
+        vector<const string*> flags_;
+        vector<pair<const string*, const Word*>> values_;
+        vector<const Word*> positionals_;
+
+        bool has (const char* flag) const
+        {
+            for (auto f : flags_) {
+                if (*f == flag) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @return The value of @a option, nullptr if not given.
+         */
+        const Word* get (const char* option) const
+        {
+            for (auto& v : values_) {
+                if (*v.first == option) {
+                    return v.second;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    void skip_space (bool nested);
+    void parse_command (vector<Word>& words, bool nested);
+    void parse_word (Word& word, bool nested);
+    void substitute_variable (string& text);
+
+    Word evaluate (const vector<Word>& words);
+    void execute (const vector<Word>& words);
+
+    Arguments get_arguments (const vector<Word>& words) const;
+    bool get_value (const Arguments& args, float& value);
+    vector<uint32_t> get_ports (const Arguments& args, size_t first_object = 1);
+    vector<uint32_t> get_clocks (const Arguments& args);
+    int get_clock (const Word& word);
+
+    void match_ports (const string& pattern, vector<uint32_t>& ids);
+    void find_ports (const string& pattern, vector<uint32_t>& ids);
+    void match_clocks (const string& pattern, vector<uint32_t>& ids);
+
+    void create_clock (const Arguments& args);
+    void set_units (const Arguments& args);
+    void set_port_delay (const Arguments& args, vector<PortDelay>& delays);
+    void set_limit (const Arguments& args, vector<float>& limits, float& design_limit);
+
+    void warn (const string& message);
+};
+
+/**
+ * Set @a value for the early analysis if @a min, for the late one if
+ * @a max, and for both if neither.
+ */
+static void set_min_max (MinMax& m, float value, bool min, bool max)
+{
+    if (min || !max) {
+        m.min_ = value;
+    }
+    if (max || !min) {
+        m.max_ = value;
+    }
+}
+
+/**
+ * @return The words of @a list, a Tcl list without nested braces.
+ */
+static vector<string> split_list (const string& list)
+{
+    vector<string> items;
+    size_t i = 0;
+    while (i < list.size()) {
+        while (i < list.size() && isspace(static_cast<unsigned char>(list[i]))) {
+            i++;
+        }
+        auto begin = i;
+        while (i < list.size() && !isspace(static_cast<unsigned char>(list[i]))) {
+            i++;
+        }
+        if (i > begin) {
+            items.push_back(list.substr(begin, i - begin));
+        }
+    }
+    return items;
+}
+
+static bool is_option (const Word& word)
+{
+    return word.kind_ == Word::Kind::text && word.text_.size() > 1 && word.text_[0] == '-'
+           && isalpha(static_cast<unsigned char>(word.text_[1]));
+}
+
+
+SdcReader::SdcReader (Sdc& sdc, const def::Def& def, const string& filename)
+    : sdc_(sdc), def_(def), filename_(filename),
+      p_(nullptr), end_(nullptr), line_(1), num_warnings_(0)
+{
+    //
+}
+
+void SdcReader::warn (const string& message)
+{
+    const size_t max_warnings = 10;
+    if (num_warnings_++ < max_warnings) {
+        cout << "(W) " << filename_ << ":" << line_ << ": " << message << endl;
+    }
+    else if (num_warnings_ == max_warnings + 1) {
+        cout << "(W) More warnings are not shown." << endl;
+    }
+}
+
+void SdcReader::read (const char* data, size_t size)
+{
+    p_ = data;
+    end_ = data + size;
+
+    vector<Word> words;
+    while (p_ < end_) {
+        auto c = *p_;
+        if (c == '\n') {
+            line_++;
+            p_++;
+        }
+        else if (isspace(static_cast<unsigned char>(c)) || c == ';') {
+            p_++;
+        }
+        else if (c == '#') {
+            while (p_ < end_ && *p_ != '\n') {
+                p_++;
+            }
+        }
+        else {
+            parse_command(words, false);
+            if (!words.empty()) {
+                execute(words);
+            }
+        }
+    }
+}
+
+/**
+ * Skip blanks and escaped new lines; a nested command also spans new lines.
+ */
+void SdcReader::skip_space (bool nested)
+{
+    while (p_ < end_) {
+        auto c = *p_;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            p_++;
+        }
+        else if (c == '\\' && p_ + 1 < end_ && p_[1] == '\n') {
+            p_ += 2;
+            line_++;
+        }
+        else if (nested && c == '\n') {
+            p_++;
+            line_++;
+        }
+        else {
+            break;
+        }
+    }
+}
+
+void SdcReader::parse_command (vector<Word>& words, bool nested)
+{
+    words.clear();
+    while (true) {
+        skip_space(nested);
+        if (p_ == end_) {
+            break;
+        }
+        auto c = *p_;
+        if (!nested && (c == '\n' || c == ';')) {
+            break;
+        }
+        if (nested && c == ']') {
+            p_++;
+            break;
+        }
+        words.emplace_back();
+        parse_word(words.back(), nested);
+    }
+}
+
+/**
+ * A bare word may hold a bus index, as in "out[3]"; its brackets are kept.
+ */
+void SdcReader::parse_word (Word& word, bool nested)
+{
+    auto c = *p_;
+    if (c == '{') {
+        auto depth = 1;
+        auto begin = ++p_;
+        for (; p_ < end_; p_++) {
+            if (*p_ == '\\' && p_ + 1 < end_) {
+                p_++;
+            }
+            else if (*p_ == '{') {
+                depth++;
+            }
+            else if (*p_ == '}' && --depth == 0) {
+                break;
+            }
+            if (*p_ == '\n') {
+                line_++;
+            }
+        }
+        word.text_.assign(begin, p_);
+        if (p_ < end_) {
+            p_++;
+        }
+        return;
+    }
+
+    if (c == '[') {
+        auto begin = ++p_;
+        vector<Word> words;
+        parse_command(words, true);
+        string key(begin, p_ - 1);
+        auto found = results_.find(key);
+        if (found != results_.end()) {
+            word = found->second;
+        }
+        else {
+            // A port looked up by its name is not worth keeping.
+            word = evaluate(words);
+            if (word.kind_ != Word::Kind::ports || word.ids_.size() > 1) {
+                results_.emplace(move(key), word);
+            }
+        }
+        return;
+    }
+
+    auto quoted = c == '"';
+    if (quoted) {
+        p_++;
+    }
+    auto depth = 0;
+    while (p_ < end_) {
+        c = *p_;
+        if (quoted ? c == '"'
+                   : (isspace(static_cast<unsigned char>(c)) || c == ';'
+                      || (nested && c == ']' && depth == 0))) {
+            break;
+        }
+        if (c == '\\' && p_ + 1 < end_ && p_[1] != '\n') {
+            word.text_ += p_[1];
+            p_ += 2;
+            continue;
+        }
+        if (c == '$') {
+            p_++;
+            substitute_variable(word.text_);
+            continue;
+        }
+        if (c == '[') {
+            depth++;
+        }
+        else if (c == ']' && depth > 0) {
+            depth--;
+        }
+        else if (c == '\n') {
+            line_++;
+        }
+        word.text_ += c;
+        p_++;
+    }
+    if (quoted && p_ < end_) {
+        p_++;
+    }
+}
+
+/**
+ * Append the value of the variable named at the cursor, "name" or
+ * "{name}", to @a text.
+ */
+void SdcReader::substitute_variable (string& text)
+{
+    string name;
+    if (p_ < end_ && *p_ == '{') {
+        auto begin = ++p_;
+        while (p_ < end_ && *p_ != '}') {
+            p_++;
+        }
+        name.assign(begin, p_);
+        if (p_ < end_) {
+            p_++;
+        }
+    }
+    else {
+        while (p_ < end_ && (isalnum(static_cast<unsigned char>(*p_)) || *p_ == '_')) {
+            name += *p_++;
+        }
+    }
+
+    if (name.empty()) {
+        text += '$';
+        return;
+    }
+    auto found = variables_.find(name);
+    if (found == variables_.end()) {
+        warn("Variable $" + name + " is not set.");
+        return;
+    }
+    text += found->second;
+}
+
+SdcReader::Arguments SdcReader::get_arguments (const vector<Word>& words) const
+{
+    // Options followed by a value; the others are flags.
+    static const unordered_set<string> with_value = {
+        "-name", "-period", "-waveform", "-clock", "-reference_pin", "-time",
+        "-capacitance", "-resistance", "-voltage", "-current", "-power", "-from",
+        "-to", "-through", "-rise_from", "-fall_from", "-rise_to", "-fall_to",
+        "-comment", "-filter"
+    };
+
+    Arguments args;
+    for (size_t i = 1; i < words.size(); i++) {
+        if (is_option(words[i])) {
+            if (with_value.count(words[i].text_) && i + 1 < words.size()) {
+                args.values_.emplace_back(&words[i].text_, &words[i + 1]);
+                i++;
+            }
+            else {
+                args.flags_.push_back(&words[i].text_);
+            }
+        }
+        else {
+            args.positionals_.push_back(&words[i]);
+        }
+    }
+    return args;
+}
+
+/**
+ * @return False (with a warning) if the first positional word is not a
+ *         number; otherwise it is stored in @a value.
+ */
+bool SdcReader::get_value (const Arguments& args, float& value)
+{
+    if (args.positionals_.empty() || args.positionals_[0]->kind_ != Word::Kind::text) {
+        warn("A value is missing.");
+        return false;
+    }
+    auto& text = args.positionals_[0]->text_;
+    char* end = nullptr;
+    value = strtof(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0') {
+        warn("\"" + text + "\" is not a number.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @return The ports of the positional words from @a first_object on; a
+ *         plain word is taken as a port pattern.
+ */
+vector<uint32_t> SdcReader::get_ports (const Arguments& args, size_t first_object)
+{
+    vector<uint32_t> ids;
+    for (auto i = first_object; i < args.positionals_.size(); i++) {
+        auto& word = *args.positionals_[i];
+        if (word.kind_ == Word::Kind::ports) {
+            ids.insert(ids.end(), word.ids_.begin(), word.ids_.end());
+        }
+        else if (word.kind_ == Word::Kind::text) {
+            for (auto& pattern : split_list(word.text_)) {
+                match_ports(pattern, ids);
+            }
+        }
+    }
+    return ids;
+}
+
+vector<uint32_t> SdcReader::get_clocks (const Arguments& args)
+{
+    vector<uint32_t> ids;
+    for (size_t i = 1; i < args.positionals_.size(); i++) {
+        auto& word = *args.positionals_[i];
+        if (word.kind_ == Word::Kind::clocks) {
+            ids.insert(ids.end(), word.ids_.begin(), word.ids_.end());
+        }
+        else if (word.kind_ == Word::Kind::text) {
+            for (auto& pattern : split_list(word.text_)) {
+                match_clocks(pattern, ids);
+            }
+        }
+    }
+    return ids;
+}
+
+/**
+ * @return The clock of an option "-clock", given by name or by get_clocks;
+ *         -1 if none.
+ */
+int SdcReader::get_clock (const Word& word)
+{
+    if (word.kind_ == Word::Kind::clocks) {
+        return word.ids_.empty() ? -1 : static_cast<int>(word.ids_[0]);
+    }
+    auto clock = sdc_.find_clock(word.text_);
+    if (clock < 0) {
+        warn("Clock " + word.text_ + " is not defined.");
+    }
+    return clock;
+}
+
+void SdcReader::match_ports (const string& pattern, vector<uint32_t>& ids)
+{
+    auto size = ids.size();
+    find_ports(pattern, ids);
+    if (ids.size() == size) {
+        sdc_.num_unknown_ports_++;
+        warn("No port matches " + pattern + ".");
+    }
+}
+
+/**
+ * A name is looked up; a name with a range, "bus[msb:lsb]", is the bits
+ * of the range; a bus name alone is all its bits. A pattern with wildcards
+ * is matched against the pins from the first name with its prefix on.
+ */
+void SdcReader::find_ports (const string& pattern, vector<uint32_t>& ids)
+{
+    auto& symbols = util::SymbolTable::get_instance();
+    auto& pins = def_.get_pins();
+    auto wildcard = pattern.find_first_of("*?");
+
+    if (wildcard == string::npos) {
+        auto found = def_.get_pin(symbols.find(pattern));
+        if (found != nullptr) {
+            ids.push_back(found->id_);
+            return;
+        }
+
+        auto open = pattern.rfind('[');
+        if (open == string::npos) {
+            find_ports(pattern + "[*]", ids);
+            return;
+        }
+        auto colon = pattern.find(':', open);
+        if (colon != string::npos && pattern.back() == ']') {
+            auto base = pattern.substr(0, open);
+            auto msb = atoi(pattern.c_str() + open + 1);
+            auto lsb = atoi(pattern.c_str() + colon + 1);
+            auto step = msb <= lsb ? 1 : -1;
+            for (auto i = msb; ; i += step) {
+                auto bit = def_.get_pin(symbols.find(base + "[" + to_string(i) + "]"));
+                if (bit != nullptr) {
+                    ids.push_back(bit->id_);
+                }
+                if (i == lsb) {
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    if (pins_by_name_.empty()) {
+        pins_by_name_.resize(pins.size());
+        iota(pins_by_name_.begin(), pins_by_name_.end(), 0);
+        sort(pins_by_name_.begin(), pins_by_name_.end(), [&] (uint32_t a, uint32_t b) {
+            return strcmp(symbols.get_name(pins[a]->name_id_), 
+                          symbols.get_name(pins[b]->name_id_)) < 0;
+        });
+    }
+
+    auto prefix = pattern.substr(0, wildcard);
+    auto it = lower_bound(pins_by_name_.begin(), pins_by_name_.end(), prefix,
+                          [&] (uint32_t id, const string& p) {
+                              return strcmp(symbols.get_name(pins[id]->name_id_), 
+                                            p.c_str()) < 0;
+                          });
+    for (; it != pins_by_name_.end(); ++it) {
+        auto name = symbols.get_name(pins[*it]->name_id_);
+        if (strncmp(name, prefix.c_str(), prefix.size()) != 0) {
+            break;
+        }
+        if (StringUtil::matches(pattern.c_str(), name)) {
+            ids.push_back(*it);
+        }
+    }
+}
+
+void SdcReader::match_clocks (const string& pattern, vector<uint32_t>& ids)
+{
+    auto size = ids.size();
+    for (auto& c : sdc_.clocks_) {
+        if (StringUtil::matches(pattern.c_str(), c.name_.c_str())) {
+            ids.push_back(c.id_);
+        }
+    }
+    if (ids.size() == size) {
+        warn("No clock matches " + pattern + ".");
+    }
+}
+
+/**
+ * Run a nested command, one that returns a collection.
+ */
+Word SdcReader::evaluate (const vector<Word>& words)
+{
+    Word result;
+    if (words.empty()) {
+        return result;
+    }
+
+    auto& name = words[0].text_;
+    auto args = get_arguments(words);
+    if (name == "get_ports") {
+        result.kind_ = Word::Kind::ports;
+        result.ids_ = get_ports(args, 0);
+    }
+    else if (name == "get_clocks") {
+        result.kind_ = Word::Kind::clocks;
+        for (auto w : args.positionals_) {
+            for (auto& pattern : split_list(w->text_)) {
+                match_clocks(pattern, result.ids_);
+            }
+        }
+    }
+    else if (name == "all_clocks") {
+        result.kind_ = Word::Kind::clocks;
+        for (auto& c : sdc_.clocks_) {
+            result.ids_.push_back(c.id_);
+        }
+    }
+    else if (name == "all_inputs" || name == "all_outputs") {
+        result.kind_ = Word::Kind::ports;
+        auto dir = name == "all_inputs" ? PinDir::input : PinDir::output;
+        auto no_clocks = args.has("-no_clocks");
+        for (auto& p : def_.get_pins()) {
+            if ((p->dir_ == dir || p->dir_ == PinDir::inout)
+                && !(no_clocks && sdc_.get_clock_of_pin(p->id_) >= 0)) {
+                result.ids_.push_back(p->id_);
+            }
+        }
+    }
+    else if (name == "current_design") {
+        result.kind_ = Word::Kind::design;
+    }
+    else if (name == "remove_from_collection" && args.positionals_.size() == 2) {
+        result = *args.positionals_[0];
+        auto& removed = args.positionals_[1]->ids_;
+        unordered_set<uint32_t> set(removed.begin(), removed.end());
+        result.ids_.erase(remove_if(result.ids_.begin(), result.ids_.end(),
+                                    [&] (uint32_t id) { return set.count(id) != 0; }),
+                          result.ids_.end());
+    }
+    else {
+        // get_pins, get_nets, get_cells and the like: not ports.
+        result.kind_ = Word::Kind::other;
+        sdc_.num_ignored_[name]++;
+    }
+    return result;
+}
+
+void SdcReader::execute (const vector<Word>& words)
+{
+    sdc_.num_commands_++;
+
+    auto& name = words[0].text_;
+    auto args = get_arguments(words);
+    auto min = args.has("-min") || args.has("-early");
+    auto max = args.has("-max") || args.has("-late");
+    float value = 0;
+
+    if (name == "set") {
+        if (args.positionals_.size() == 2) {
+            variables_[args.positionals_[0]->text_] = args.positionals_[1]->text_;
+            results_.clear();
+        }
+    }
+    else if (name == "set_units") {
+        set_units(args);
+    }
+    else if (name == "create_clock") {
+        create_clock(args);
+    }
+    else if (name == "set_clock_latency") {
+        if (get_value(args, value)) {
+            for (auto id : get_clocks(args)) {
+                auto& c = sdc_.clocks_[id];
+                set_min_max(args.has("-source") ? c.source_latency_ : c.network_latency_,
+                            value, min, max);
+            }
+        }
+    }
+    else if (name == "set_clock_uncertainty") {
+        if (args.get("-from") || args.get("-to")
+            || args.get("-rise_from") || args.get("-fall_from")) {
+            sdc_.num_ignored_["set_clock_uncertainty -from/-to"]++;
+        }
+        else if (get_value(args, value)) {
+            for (auto id : get_clocks(args)) {
+                set_min_max(sdc_.clocks_[id].uncertainty_, value,
+                            args.has("-hold"), args.has("-setup"));
+            }
+        }
+    }
+    else if (name == "set_clock_transition") {
+        if (get_value(args, value)) {
+            for (auto id : get_clocks(args)) {
+                set_min_max(sdc_.clocks_[id].transition_, value, min, max);
+            }
+        }
+    }
+    else if (name == "set_input_delay") {
+        set_port_delay(args, sdc_.input_delays_);
+    }
+    else if (name == "set_output_delay") {
+        set_port_delay(args, sdc_.output_delays_);
+    }
+    else if (name == "set_load") {
+        if (get_value(args, value)) {
+            for (auto id : get_ports(args)) {
+                set_min_max(sdc_.loads_[id], value, min, max);
+            }
+        }
+    }
+    else if (name == "set_input_transition") {
+        if (get_value(args, value)) {
+            for (auto id : get_ports(args)) {
+                set_min_max(sdc_.input_transitions_[id], value, min, max);
+            }
+        }
+    }
+    else if (name == "set_max_transition") {
+        set_limit(args, sdc_.max_transitions_, sdc_.design_max_transition_);
+    }
+    else if (name == "set_max_capacitance") {
+        set_limit(args, sdc_.max_capacitances_, sdc_.design_max_capacitance_);
+    }
+    else {
+        sdc_.num_ignored_[name]++;
+    }
+}
+
+void SdcReader::set_units (const Arguments& args)
+{
+    struct Unit { const char* option_; const char* base_; double* unit_; };
+    Unit units[] = {
+        { "-time", "s", &sdc_.time_unit_ },
+        { "-capacitance", "F", &sdc_.capacitance_unit_ },
+        { "-resistance", "Ohm", &sdc_.resistance_unit_ }
+    };
+    for (auto& u : units) {
+        auto found = args.get(u.option_);
+        if (found == nullptr) {
+            continue;
+        }
+        auto scale = StringUtil::parse_unit(found->text_, u.base_);
+        if (scale > 0) {
+            *u.unit_ = scale;
+        }
+        else {
+            warn("Unit " + found->text_ + " is not known.");
+        }
+    }
+}
+
+/**
+ * A clock without -name is named after its first source. A clock defined
+ * again is replaced.
+ */
+void SdcReader::create_clock (const Arguments& args)
+{
+    auto period = args.get("-period");
+    if (period == nullptr) {
+        warn("create_clock has no -period.");
+        return;
+    }
+
+    Clock clock;
+    clock.period_ = strtod(period->text_.c_str(), nullptr);
+    clock.rise_ = 0;
+    clock.fall_ = clock.period_ / 2;
+    clock.pins_ = get_ports(args, 0);
+
+    auto waveform = args.get("-waveform");
+    if (waveform != nullptr) {
+        auto edges = split_list(waveform->text_);
+        if (edges.size() >= 2) {
+            clock.rise_ = strtod(edges[0].c_str(), nullptr);
+            clock.fall_ = strtod(edges[1].c_str(), nullptr);
+        }
+    }
+
+    auto name = args.get("-name");
+    if (name != nullptr) {
+        clock.name_ = name->text_;
+    }
+    else if (!clock.pins_.empty()) {
+        clock.name_ = def_.get_pins()[clock.pins_[0]]->get_name();
+    }
+    else {
+        warn("create_clock has neither -name nor a source.");
+        return;
+    }
+
+    auto found = sdc_.clock_umap_.find(clock.name_);
+    if (found != sdc_.clock_umap_.end()) {
+        clock.id_ = found->second;
+        for (auto pin : sdc_.clocks_[clock.id_].pins_) {
+            sdc_.clock_of_pin_[pin] = -1;
+        }
+        sdc_.clocks_[clock.id_] = clock;
+    }
+    else {
+        clock.id_ = static_cast<uint32_t>(sdc_.clocks_.size());
+        sdc_.clock_umap_[clock.name_] = clock.id_;
+        sdc_.clocks_.push_back(clock);
+    }
+    for (auto pin : clock.pins_) {
+        sdc_.clock_of_pin_[pin] = clock.id_;
+    }
+    results_.clear();
+}
+
+void SdcReader::set_port_delay (const Arguments& args, vector<PortDelay>& delays)
+{
+    float value = 0;
+    if (!get_value(args, value)) {
+        return;
+    }
+    auto clock = -1;
+    auto found = args.get("-clock");
+    if (found != nullptr) {
+        clock = get_clock(*found);
+    }
+
+    auto min = args.has("-min");
+    auto max = args.has("-max");
+    for (auto id : get_ports(args)) {
+        auto& d = delays[id];
+        d.clock_ = clock;
+        set_min_max(d.delay_, value, min, max);
+    }
+}
+
+/**
+ * The limit is set on the design with current_design, or on ports.
+ */
+void SdcReader::set_limit (const Arguments& args, vector<float>& limits, float& design_limit)
+{
+    float value = 0;
+    if (!get_value(args, value)) {
+        return;
+    }
+    for (size_t i = 1; i < args.positionals_.size(); i++) {
+        if (args.positionals_[i]->kind_ == Word::Kind::design) {
+            design_limit = value;
+        }
+    }
+    for (auto id : get_ports(args)) {
+        limits[id] = value;
+    }
+}
+
+
+Sdc::Sdc ()
+{
+    clear();
+}
+
+void Sdc::clear ()
+{
+    time_unit_ = 1e-9;
+    capacitance_unit_ = 1e-12;
+    resistance_unit_ = 1e3;
+
+    clocks_.clear();
+    clock_umap_.clear();
+    clock_of_pin_.clear();
+    input_delays_.clear();
+    output_delays_.clear();
+    loads_.clear();
+    input_transitions_.clear();
+    max_transitions_.clear();
+    max_capacitances_.clear();
+
+    design_max_transition_ = NAN;
+    design_max_capacitance_ = NAN;
+
+    num_commands_ = 0;
+    num_ignored_.clear();
+    num_unknown_ports_ = 0;
+}
+
+void Sdc::read_sdc (string filename, const def::Def& def)
+{
+    clear();
+
+    auto num_pins = def.get_pins().size();
+    clock_of_pin_.assign(num_pins, -1);
+    input_delays_.assign(num_pins, PortDelay());
+    output_delays_.assign(num_pins, PortDelay());
+    loads_.assign(num_pins, MinMax());
+    input_transitions_.assign(num_pins, MinMax());
+    max_transitions_.assign(num_pins, NAN);
+    max_capacitances_.assign(num_pins, NAN);
+
+    util::MappedFile file(filename);
+    SdcReader reader(*this, def, filename);
+    reader.read(file.get_data(), file.get_size());
+}
+
+int Sdc::find_clock (const string& name) const
+{
+    auto found = clock_umap_.find(name);
+    return found == clock_umap_.end() ? -1 : found->second;
+}
+
+double Sdc::get_time_unit () const
+{
+    return time_unit_;
+}
+
+double Sdc::get_capacitance_unit () const
+{
+    return capacitance_unit_;
+}
+
+double Sdc::get_resistance_unit () const
+{
+    return resistance_unit_;
+}
+
+void Sdc::report () const
+{
+    auto count = [] (const vector<PortDelay>& delays) {
+        return count_if(delays.begin(), delays.end(),
+                        [] (const PortDelay& d) { return d.delay_.is_set(); });
+    };
+
+    cout << "Summary of the SDC file read." << endl;
+    cout << "\t#Commands  : " << num_commands_ << endl;
+    cout << "\t#Clocks    : " << clocks_.size() << endl;
+    for (auto& c : clocks_) {
+        cout << "\t\t" << c.name_ << ": period " << setprecision(6) << c.period_ << ", "
+             << c.pins_.size() << " sources" << endl;
+    }
+    cout << "\t#In. delays: " << count(input_delays_) << endl;
+    cout << "\t#Out delays: " << count(output_delays_) << endl;
+    cout << "\t#Loads     : " << count_if(loads_.begin(), loads_.end(),
+                                          [] (const MinMax& m) { return m.is_set(); }) << endl;
+    if (num_unknown_ports_ > 0) {
+        cout << "\t#Unknown   : " << num_unknown_ports_ << " port patterns" << endl;
+    }
+    for (auto& i : num_ignored_) {
+        cout << "\tIgnored    : " << i.first << " (" << i.second << ")" << endl;
+    }
+}
+
+}   // End of namespace sdc
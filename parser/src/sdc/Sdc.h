@@ -0,0 +1,179 @@
+/**
+ * @file    Sdc.h
+ */
+
+#ifndef SDC_H
+#define SDC_H
+
+#include "common_header.h"
+#include "Def.h"
+
+#include <cmath>
+
+namespace sdc
+{
+
+/**
+ * A constraint for the early (min) and the late (max) analysis; NaN where
+ * it is not set.
+ */
+struct MinMax
+{
+    float min_;
+    float max_;
+
+    MinMax () : min_(NAN), max_(NAN) { }
+
+    bool is_set () const { return !std::isnan(min_) || !std::isnan(max_); }
+};
+
+/**
+ * A clock made by create_clock. Values are in the units of the SDC file.
+ */
+struct Clock
+{
+    uint32_t id_;               ///< Index in Sdc::get_clocks().
+    string name_;
+    double period_;
+    double rise_;               ///< First edge of the waveform.
+    double fall_;               ///< Second edge of the waveform.
+    vector<uint32_t> pins_;     ///< Source ports, as def::Pin ids.
+
+    MinMax source_latency_;
+    MinMax network_latency_;
+    MinMax uncertainty_;        ///< Hold (min) and setup (max).
+    MinMax transition_;
+};
+
+/**
+ * An input or output delay of a port.
+ */
+struct PortDelay
+{
+    int clock_;                 ///< Index in Sdc::get_clocks(), -1 if none.
+    MinMax delay_;
+
+    PortDelay () : clock_(-1) { }
+};
+
+/**
+ * The timing constraints of an SDC file, bound to the IO pins of a Def.
+ *
+ * The port patterns are matched once, when the file is read, and the
+ * constraints of the ports are kept in arrays indexed by def::Pin::id_.
+ * Constraints on objects other than ports and clocks are ignored.
+ */
+class Sdc
+{
+public:
+    Sdc ();
+
+    /**
+     * Read @a filename and bind its ports to the pins of @a def. Commands
+     * that are not supported are counted and skipped.
+     */
+    void read_sdc (string filename, const def::Def& def);
+    void clear ();
+    void report () const;
+
+    // Units of the values, in seconds, farads and ohms.
+    double get_time_unit () const;
+    double get_capacitance_unit () const;
+    double get_resistance_unit () const;
+
+    const vector<Clock>& get_clocks () const;
+
+    /**
+     * @return Index of the clock @a name in get_clocks(), -1 if none.
+     */
+    int find_clock (const string& name) const;
+
+    /**
+     * @return The clock whose source is the pin @a pin, -1 if none.
+     */
+    int get_clock_of_pin (uint32_t pin) const;
+
+    const PortDelay& get_input_delay (uint32_t pin) const;
+    const PortDelay& get_output_delay (uint32_t pin) const;
+    const MinMax& get_load (uint32_t pin) const;
+    const MinMax& get_input_transition (uint32_t pin) const;
+
+    /**
+     * @return The limit set on the port @a pin, or else the limit of the
+     *         design; NaN if none.
+     */
+    float get_max_transition (uint32_t pin) const;
+    float get_max_capacitance (uint32_t pin) const;
+
+private:
+    double time_unit_;
+    double capacitance_unit_;
+    double resistance_unit_;
+
+    vector<Clock> clocks_;
+    unordered_map<string, int> clock_umap_;
+
+    // Indexed by def::Pin::id_.
+    vector<int> clock_of_pin_;
+    vector<PortDelay> input_delays_;
+    vector<PortDelay> output_delays_;
+    vector<MinMax> loads_;
+    vector<MinMax> input_transitions_;
+    vector<float> max_transitions_;
+    vector<float> max_capacitances_;
+
+    float design_max_transition_;
+    float design_max_capacitance_;
+
+    size_t num_commands_;
+    map<string, size_t> num_ignored_;   ///< Unsupported commands, by name.
+    size_t num_unknown_ports_;
+
+    friend class SdcReader;
+};
+
+
+inline const vector<Clock>& Sdc::get_clocks () const
+{
+    return clocks_;
+}
+
+inline int Sdc::get_clock_of_pin (uint32_t pin) const
+{
+    return pin < clock_of_pin_.size() ? clock_of_pin_[pin] : -1;
+}
+
+inline const PortDelay& Sdc::get_input_delay (uint32_t pin) const
+{
+    return input_delays_[pin];
+}
+
+inline const PortDelay& Sdc::get_output_delay (uint32_t pin) const
+{
+    return output_delays_[pin];
+}
+
+inline const MinMax& Sdc::get_load (uint32_t pin) const
+{
+    return loads_[pin];
+}
+
+inline const MinMax& Sdc::get_input_transition (uint32_t pin) const
+{
+    return input_transitions_[pin];
+}
+
+inline float Sdc::get_max_transition (uint32_t pin) const
+{
+    return std::isnan(max_transitions_[pin]) ? design_max_transition_ : max_transitions_[pin];
+}
+
+inline float Sdc::get_max_capacitance (uint32_t pin) const
+{
+    return std::isnan(max_capacitances_[pin]) ? design_max_capacitance_
+                                              : max_capacitances_[pin];
+}
+
+}   // End of namespace sdc
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * @file    DelayModel.cpp
+ */
+
+#include "DelayModel.h"
+
+using namespace std;
+
+namespace sta
+{
+
+bool is_sequential (const lef::Macro& macro)
+{
+    for (auto& p : macro.pins_) {
+        if (p->use_ == PinUse::clock) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return The number @a name ends with after a '_', 1 if none.
+ */
+static double get_drive_strength (const string& name)
+{
+    auto underscore = name.rfind('_');
+    if (underscore == string::npos || underscore + 1 == name.size()) {
+        return 1;
+    }
+    char* end = nullptr;
+    auto strength = strtod(name.c_str() + underscore + 1, &end);
+    return *end == '\0' && strength > 0 ? strength : 1;
+}
+
+
+DriveTable::DriveTable ()
+{
+    set_default(Drive{0.015, 3.0, 0.0008, 0},
+                Drive{0.045, 3.0, 0.0008, 0.03});
+}
+
+void DriveTable::read (string filename)
+{
+    ifstream ifs(filename);
+    if (!ifs) {
+        throw invalid_argument("(E) Drive table (" + filename + ") not found.");
+    }
+
+    auto& symbols = util::SymbolTable::get_instance();
+    string line;
+    size_t line_number = 0;
+    while (getline(ifs, line)) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+
+        istringstream iss(line);
+        string macro;
+        Drive d;
+        if (!(iss >> macro)) {
+            continue;
+        }
+        if (!(iss >> d.intrinsic_ >> d.resistance_ >> d.input_capacitance_ >> d.setup_)) {
+            cout << "(W) " << filename << ":" << line_number
+                 << ": Expected a macro and four numbers." << endl;
+            continue;
+        }
+        set(symbols.intern(macro), d);
+    }
+}
+
+void DriveTable::set (util::SymbolId macro, const Drive& drive)
+{
+    drives_[macro] = drive;
+}
+
+void DriveTable::set_default (const Drive& combinational, const Drive& sequential)
+{
+    combinational_ = combinational;
+    sequential_ = sequential;
+}
+
+/**
+ * A stronger cell drives with less resistance and loads its inputs more.
+ */
+Drive DriveTable::get (const lef::Macro& macro) const
+{
+    auto found = drives_.find(macro.name_id_);
+    if (found != drives_.end()) {
+        return found->second;
+    }
+
+    auto d = is_sequential(macro) ? sequential_ : combinational_;
+    auto strength = get_drive_strength(macro.name_);
+    d.resistance_ /= strength;
+    d.input_capacitance_ *= strength;
+    return d;
+}
+
+
+DelayModel make_delay_model (const DriveTable& table, double resistance, double capacitance)
+{
+    auto drives = make_shared<DriveTable>(table);
+
+    DelayModel m;
+    m.cell_delay_ = [drives] (const lef::Macro& macro, uint32_t, uint32_t, double load) {
+        auto d = drives->get(macro);
+        return d.intrinsic_ + d.resistance_ * load;
+    };
+    m.pin_capacitance_ = [drives] (const lef::Macro& macro, uint32_t pin) {
+        return macro.pins_[pin]->dir_ == PinDir::output
+               ? 0.0 : drives->get(macro).input_capacitance_;
+    };
+    m.setup_time_ = [drives] (const lef::Macro& macro, uint32_t) {
+        return drives->get(macro).setup_;
+    };
+
+    // Elmore delay of a uniform wire: its resistance drives half its own
+    // capacitance and all of the sink.
+    m.wire_delay_ = [resistance, capacitance] (double length, double load) {
+        return resistance * length * (0.5 * capacitance * length + load);
+    };
+    m.wire_capacitance_ = [capacitance] (double length) {
+        return capacitance * length;
+    };
+    return m;
+}
+
+}   // End of namespace sta
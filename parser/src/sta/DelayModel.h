@@ -0,0 +1,95 @@
+/**
+ * @file    DelayModel.h
+ */
+
+#ifndef DELAY_MODEL_H
+#define DELAY_MODEL_H
+
+#include "common_header.h"
+#include "Lef.h"
+
+#include <functional>
+
+namespace sta
+{
+
+/**
+ * The delays and capacitances the timer asks for, in the time and
+ * capacitance units of the SDC. Pins are indices in the pins of the
+ * macro; lengths are in microns.
+ */
+struct DelayModel
+{
+    /**
+     * Delay of the macro from the input @a from to the output @a to,
+     * driving @a load.
+     */
+    std::function<double (const lef::Macro&, uint32_t from, uint32_t to, double load)> cell_delay_;
+    std::function<double (const lef::Macro&, uint32_t pin)> pin_capacitance_;
+
+    /**
+     * Setup time of the data input @a pin of a register.
+     */
+    std::function<double (const lef::Macro&, uint32_t pin)> setup_time_;
+
+    /**
+     * Delay of a wire of @a length to a sink of @a capacitance.
+     */
+    std::function<double (double length, double capacitance)> wire_delay_;
+    std::function<double (double length)> wire_capacitance_;
+};
+
+/**
+ * The drive of a macro: cell delay = intrinsic_ + resistance_ * load.
+ */
+struct Drive
+{
+    double intrinsic_;
+    double resistance_;
+    double input_capacitance_;  ///< Of each input.
+    double setup_;              ///< Of each data input of a register.
+};
+
+/**
+ * A drive per macro, in the units of the SDC (ns, kOhm and pF by default).
+ *
+ * A macro without an entry gets the default drive of a combinational cell
+ * or of a register (a macro with a CLOCK pin), scaled by the drive
+ * strength its name ends with ("_4" is four times stronger than "_1").
+ */
+class DriveTable
+{
+public:
+    DriveTable ();
+
+    /**
+     * Read lines "<macro> <intrinsic> <resistance> <input cap.> <setup>";
+     * '#' starts a comment.
+     */
+    void read (string filename);
+
+    void set (util::SymbolId macro, const Drive& drive);
+    void set_default (const Drive& combinational, const Drive& sequential);
+
+    Drive get (const lef::Macro& macro) const;
+
+private:
+    Drive combinational_;
+    Drive sequential_;
+    unordered_map<util::SymbolId, Drive> drives_;
+};
+
+/**
+ * @return The model of @a table, with wires of @a resistance and
+ *         @a capacitance per micron.
+ */
+DelayModel make_delay_model (const DriveTable& table, double resistance, double capacitance);
+
+/**
+ * @return True if @a macro has a pin of USE CLOCK.
+ */
+bool is_sequential (const lef::Macro& macro);
+
+}   // End of namespace sta
+
+#endif
@@ -0,0 +1,718 @@
+/**
+ * @file    Timer.cpp
+ */
+
+#include "Timer.h"
+#include "Parallel.h"
+
+#include <limits>
+
+using namespace std;
+
+namespace sta
+{
+
+static const double infinity = numeric_limits<double>::infinity();
+
+/**
+ * Nodes handed to a thread at a time in a full timing.
+ */
+static const size_t chunk_size = 256;
+
+static bool is_driver (const def::Connection& c)
+{
+    return c.component_ ? c.lef_pin_->dir_ == PinDir::output
+                        : c.pin_->dir_ == PinDir::input;
+}
+
+static bool is_clock_pin (const def::Connection& c)
+{
+    return c.component_ && c.lef_pin_->use_ == PinUse::clock;
+}
+
+static double value_or_zero (double value)
+{
+    return std::isnan(value) ? 0 : value;
+}
+
+/**
+ * Call @a func(i) for every i in [0, @a n), in chunks of chunk_size.
+ */
+template <typename Func>
+static void for_chunks (size_t n, int num_threads, Func func)
+{
+    util::parallel_for((n + chunk_size - 1) / chunk_size, num_threads, [&] (size_t chunk) {
+        auto last = min(n, (chunk + 1) * chunk_size);
+        for (auto i = chunk * chunk_size; i < last; i++) {
+            func(i);
+        }
+    });
+}
+
+
+const uint32_t Timer::no_level;
+
+Timer::Timer ()
+{
+    clear();
+}
+
+void Timer::clear ()
+{
+    def_ = nullptr;
+    sdc_ = nullptr;
+    model_ = DelayModel();
+    num_threads_ = 1;
+    dbu_ = 1;
+
+    connections_.clear();
+    node_nets_.clear();
+    levels_.clear();
+    arrivals_.clear();
+    requireds_.clear();
+    source_arrivals_.clear();
+    endpoint_of_node_.clear();
+
+    net_first_node_.clear();
+    net_drivers_.clear();
+    net_loads_.clear();
+
+    arc_from_.clear();
+    arc_to_.clear();
+    arc_delays_.clear();
+    first_cell_arc_ = 0;
+    comp_arc_begin_.clear();
+
+    fanin_begin_.clear();
+    fanin_arcs_.clear();
+    fanout_begin_.clear();
+    fanout_arcs_.clear();
+
+    level_begin_.clear();
+    level_nodes_.clear();
+    num_loop_nodes_ = 0;
+
+    endpoints_.clear();
+    tns_ = 0;
+    num_violations_ = 0;
+
+    buckets_.clear();
+    is_queued_.clear();
+    net_stamps_.clear();
+    stamp_ = 0;
+}
+
+void Timer::build (const def::Def& def, const sdc::Sdc& sdc, DelayModel model,
+                   int num_threads)
+{
+    clear();
+    def_ = &def;
+    sdc_ = &sdc;
+    model_ = move(model);
+    num_threads_ = num_threads;
+    dbu_ = def.get_dbu();
+
+    build_nodes();
+    build_arcs();
+    build_levels();
+    build_endpoints();
+
+    buckets_.resize(level_begin_.size() - 1);
+    is_queued_.assign(connections_.size(), 0);
+    net_stamps_.assign(net_drivers_.size(), 0);
+
+    update_timing();
+}
+
+/**
+ * Number the pins of the nets and find their drivers. Input ports start
+ * paths at their input delays, and CLOCK pins at their clock latencies.
+ */
+void Timer::build_nodes ()
+{
+    auto& nets = def_->get_nets();
+
+    net_first_node_.resize(nets.size() + 1);
+    uint32_t num_nodes = 0;
+    for (auto& n : nets) {
+        net_first_node_[n->id_] = num_nodes;
+        num_nodes += n->connections_.size();
+    }
+    net_first_node_.back() = num_nodes;
+
+    connections_.resize(num_nodes);
+    node_nets_.resize(num_nodes);
+    net_drivers_.assign(nets.size(), -1);
+    net_loads_.assign(nets.size(), 0);
+    for (auto& n : nets) {
+        auto node = net_first_node_[n->id_];
+        for (auto& c : n->connections_) {
+            connections_[node] = &c;
+            node_nets_[node] = n->id_;
+            if (net_drivers_[n->id_] == -1 && is_driver(c)) {
+                net_drivers_[n->id_] = node;
+            }
+            node++;
+        }
+    }
+
+    source_arrivals_.assign(num_nodes, NAN);
+    for (uint32_t v = 0; v < num_nodes; v++) {
+        auto& c = *connections_[v];
+        if (c.pin_ && c.pin_->dir_ == PinDir::input) {
+            auto& delay = sdc_->get_input_delay(c.pin_->id_);
+            if (!std::isnan(delay.delay_.max_)) {
+                auto clock = delay.clock_ != -1 ? delay.clock_ : sdc_->get_clocks().empty() ? -1 : 0;
+                auto edge = clock == -1 ? 0 : sdc_->get_clocks()[clock].rise_;
+                source_arrivals_[v] = edge + delay.delay_.max_;
+            }
+        }
+    }
+}
+
+/**
+ * The net arcs come first, net by net, and then the cell arcs, component
+ * by component.
+ */
+void Timer::build_arcs ()
+{
+    auto add_arc = [this] (uint32_t from, uint32_t to) {
+        arc_from_.push_back(from);
+        arc_to_.push_back(to);
+    };
+
+    for (size_t n = 0; n < net_drivers_.size(); n++) {
+        auto driver = net_drivers_[n];
+        if (driver == -1) {
+            continue;
+        }
+        for (auto v = net_first_node_[n]; v < net_first_node_[n + 1]; v++) {
+            auto& c = *connections_[v];
+            if (static_cast<int>(v) != driver && !is_driver(c) && !is_clock_pin(c)) {
+                add_arc(driver, v);
+            }
+        }
+    }
+    first_cell_arc_ = arc_from_.size();
+
+    auto& components = def_->get_components();
+    comp_arc_begin_.resize(components.size() + 1);
+    vector<uint32_t> inputs, outputs;
+    for (auto& comp : components) {
+        comp_arc_begin_[comp->id_] = arc_from_.size();
+        if (!comp->lef_macro_) {
+            continue;
+        }
+
+        auto sequential = is_sequential(*comp->lef_macro_);
+        inputs.clear();
+        outputs.clear();
+        for (auto& np : def_->get_component_nets(comp->id_)) {
+            auto v = get_node(np.net_, np.pin_);
+            auto& c = *connections_[v];
+            if (c.lef_pin_->dir_ == PinDir::output) {
+                outputs.push_back(v);
+            }
+            else if (c.lef_pin_->dir_ == PinDir::input && is_clock_pin(c) == sequential) {
+                inputs.push_back(v);
+            }
+        }
+        for (auto from : inputs) {
+            for (auto to : outputs) {
+                add_arc(from, to);
+            }
+        }
+    }
+    comp_arc_begin_.back() = arc_from_.size();
+    arc_delays_.assign(arc_from_.size(), 0);
+
+    auto build_csr = [this] (const vector<uint32_t>& keys, vector<uint32_t>& begin,
+                             vector<uint32_t>& arcs) {
+        begin.assign(connections_.size() + 1, 0);
+        for (auto k : keys) {
+            begin[k + 1]++;
+        }
+        partial_sum(begin.begin(), begin.end(), begin.begin());
+        arcs.resize(keys.size());
+        auto next = begin;
+        for (uint32_t a = 0; a < keys.size(); a++) {
+            arcs[next[keys[a]]++] = a;
+        }
+    };
+    build_csr(arc_to_, fanin_begin_, fanin_arcs_);
+    build_csr(arc_from_, fanout_begin_, fanout_arcs_);
+}
+
+/**
+ * Kahn's algorithm; the nodes it never reaches are on or behind loops.
+ */
+void Timer::build_levels ()
+{
+    auto num_nodes = connections_.size();
+    levels_.assign(num_nodes, no_level);
+
+    vector<uint32_t> num_fanins(num_nodes);
+    vector<uint32_t> order;
+    order.reserve(num_nodes);
+    for (uint32_t v = 0; v < num_nodes; v++) {
+        num_fanins[v] = fanin_begin_[v + 1] - fanin_begin_[v];
+        if (num_fanins[v] == 0) {
+            levels_[v] = 0;
+            order.push_back(v);
+        }
+    }
+
+    uint32_t num_levels = num_nodes > 0 ? 1 : 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        auto u = order[i];
+        for (auto a = fanout_begin_[u]; a < fanout_begin_[u + 1]; a++) {
+            auto v = arc_to_[fanout_arcs_[a]];
+            levels_[v] = levels_[v] == no_level ? levels_[u] + 1 : max(levels_[v], levels_[u] + 1);
+            if (--num_fanins[v] == 0) {
+                order.push_back(v);
+                num_levels = max(num_levels, levels_[v] + 1);
+            }
+        }
+    }
+
+    num_loop_nodes_ = num_nodes - order.size();
+    for (uint32_t v = 0; v < num_nodes; v++) {
+        if (num_fanins[v] != 0) {
+            levels_[v] = no_level;
+        }
+    }
+
+    level_begin_.assign(num_levels + 1, 0);
+    for (auto v : order) {
+        level_begin_[levels_[v] + 1]++;
+    }
+    partial_sum(level_begin_.begin(), level_begin_.end(), level_begin_.begin());
+    level_nodes_.resize(order.size());
+    auto next = level_begin_;
+    for (auto v : order) {
+        level_nodes_[next[levels_[v]]++] = v;
+    }
+}
+
+/**
+ * The data inputs of the registers and the output ports with an output
+ * delay end paths.
+ */
+void Timer::build_endpoints ()
+{
+    auto& clocks = sdc_->get_clocks();
+    auto default_clock = clocks.empty() ? -1 : 0;
+    endpoint_of_node_.assign(connections_.size(), -1);
+
+    auto add_endpoint = [this] (uint32_t node, int clock) {
+        endpoint_of_node_[node] = endpoints_.size();
+        endpoints_.push_back(Endpoint{node, clock, infinity, infinity});
+    };
+
+    for (auto& comp : def_->get_components()) {
+        if (!comp->lef_macro_ || !is_sequential(*comp->lef_macro_)) {
+            continue;
+        }
+
+        auto pins = def_->get_component_nets(comp->id_);
+        auto clock = default_clock;
+        for (auto& np : pins) {
+            auto v = get_node(np.net_, np.pin_);
+            if (!is_clock_pin(*connections_[v])) {
+                continue;
+            }
+            auto driver = net_drivers_[np.net_];
+            if (driver != -1 && connections_[driver]->pin_) {
+                auto port_clock = sdc_->get_clock_of_pin(connections_[driver]->pin_->id_);
+                clock = port_clock != -1 ? port_clock : clock;
+            }
+            break;
+        }
+        if (clock == -1) {
+            continue;
+        }
+
+        for (auto& np : pins) {
+            auto v = get_node(np.net_, np.pin_);
+            auto& c = *connections_[v];
+            if (is_clock_pin(c)) {
+                source_arrivals_[v] = clocks[clock].rise_ + get_clock_latency(clock);
+            }
+            else if (c.lef_pin_->dir_ == PinDir::input) {
+                add_endpoint(v, clock);
+            }
+        }
+    }
+
+    for (uint32_t v = 0; v < connections_.size(); v++) {
+        auto& c = *connections_[v];
+        if (c.pin_ && c.pin_->dir_ == PinDir::output) {
+            auto& delay = sdc_->get_output_delay(c.pin_->id_);
+            auto clock = delay.clock_ != -1 ? delay.clock_ : default_clock;
+            if (!std::isnan(delay.delay_.max_) && clock != -1) {
+                add_endpoint(v, clock);
+            }
+        }
+    }
+}
+
+double Timer::get_clock_latency (int clock) const
+{
+    auto& c = sdc_->get_clocks()[clock];
+    return value_or_zero(c.source_latency_.max_) + value_or_zero(c.network_latency_.max_);
+}
+
+/**
+ * An output port is loaded by its set_load.
+ */
+double Timer::get_pin_capacitance (uint32_t node) const
+{
+    auto& c = *connections_[node];
+    if (c.component_) {
+        return model_.pin_capacitance_(*c.component_->lef_macro_, c.pin_index_);
+    }
+    return c.pin_->dir_ == PinDir::output
+           ? value_or_zero(sdc_->get_load(c.pin_->id_).max_) : 0;
+}
+
+/**
+ * Take the load of the net and the delays of its arcs from the places of
+ * its pins: a wire as long as the half perimeter of the pins loads the
+ * driver, and each sink is reached by a wire of its distance to the driver.
+ * Pins of unplaced components still load the driver, but add no wire.
+ */
+void Timer::update_net (uint32_t net)
+{
+    auto driver = net_drivers_[net];
+    if (driver == -1) {
+        return;
+    }
+
+    auto placed = [this] (uint32_t v) {
+        return def::is_placed(*connections_[v]);
+    };
+    auto center = [this] (uint32_t v) {
+        auto box = def::get_connection_box(*connections_[v]);
+        return make_pair((static_cast<int64_t>(box.lx_) + box.ux_) / 2,
+                         (static_cast<int64_t>(box.ly_) + box.uy_) / 2);
+    };
+
+    auto lx = numeric_limits<int64_t>::max(), ly = lx;
+    auto ux = numeric_limits<int64_t>::min(), uy = ux;
+    auto load = 0.0;
+    for (auto v = net_first_node_[net]; v < net_first_node_[net + 1]; v++) {
+        if (static_cast<int>(v) != driver) {
+            load += get_pin_capacitance(v);
+        }
+        if (placed(v)) {
+            auto p = center(v);
+            lx = min(lx, p.first);
+            ux = max(ux, p.first);
+            ly = min(ly, p.second);
+            uy = max(uy, p.second);
+        }
+    }
+    auto half_perimeter = lx <= ux ? ux - lx + uy - ly : 0;
+    net_loads_[net] = load + model_.wire_capacitance_(half_perimeter / dbu_);
+
+    auto driver_placed = placed(driver);
+    auto d = driver_placed ? center(driver) : make_pair(int64_t(0), int64_t(0));
+    for (auto a = fanout_begin_[driver]; a < fanout_begin_[driver + 1]; a++) {
+        auto arc = fanout_arcs_[a];
+        auto sink = arc_to_[arc];
+        auto length = 0.0;
+        if (driver_placed && placed(sink)) {
+            auto p = center(sink);
+            length = (abs(p.first - d.first) + abs(p.second - d.second)) / dbu_;
+        }
+        arc_delays_[arc] = model_.wire_delay_(length, get_pin_capacitance(sink));
+    }
+}
+
+void Timer::update_cell_arcs (uint32_t comp)
+{
+    for (auto arc = comp_arc_begin_[comp]; arc < comp_arc_begin_[comp + 1]; arc++) {
+        auto& from = *connections_[arc_from_[arc]];
+        auto& to = *connections_[arc_to_[arc]];
+        arc_delays_[arc] = model_.cell_delay_(*from.component_->lef_macro_, from.pin_index_,
+                                              to.pin_index_, net_loads_[node_nets_[arc_to_[arc]]]);
+    }
+}
+
+/**
+ * A path launched at a rising edge is captured at the next one.
+ */
+void Timer::update_endpoint (uint32_t endpoint)
+{
+    auto& e = endpoints_[endpoint];
+    auto& clock = sdc_->get_clocks()[e.clock_];
+    auto capture = clock.rise_ + clock.period_ - value_or_zero(clock.uncertainty_.max_);
+
+    auto& c = *connections_[e.node_];
+    if (c.component_) {
+        e.required_ = capture + get_clock_latency(e.clock_)
+                      - model_.setup_time_(*c.component_->lef_macro_, c.pin_index_);
+    }
+    else {
+        e.required_ = capture - sdc_->get_output_delay(c.pin_->id_).delay_.max_;
+    }
+}
+
+double Timer::compute_arrival (uint32_t node) const
+{
+    if (!std::isnan(source_arrivals_[node])) {
+        return source_arrivals_[node];
+    }
+    auto arrival = -infinity;
+    for (auto a = fanin_begin_[node]; a < fanin_begin_[node + 1]; a++) {
+        auto arc = fanin_arcs_[a];
+        arrival = max(arrival, arrivals_[arc_from_[arc]] + arc_delays_[arc]);
+    }
+    return arrival;
+}
+
+double Timer::compute_required (uint32_t node) const
+{
+    auto e = endpoint_of_node_[node];
+    auto required = e == -1 ? infinity : endpoints_[e].required_;
+    for (auto a = fanout_begin_[node]; a < fanout_begin_[node + 1]; a++) {
+        auto arc = fanout_arcs_[a];
+        required = min(required, requireds_[arc_to_[arc]] - arc_delays_[arc]);
+    }
+    return required;
+}
+
+void Timer::set_slack (Endpoint& e, double slack)
+{
+    tns_ += min(slack, 0.0) - min(e.slack_, 0.0);
+    if (slack < 0 && !(e.slack_ < 0)) {
+        num_violations_++;
+    }
+    else if (!(slack < 0) && e.slack_ < 0) {
+        num_violations_--;
+    }
+    e.slack_ = slack;
+}
+
+void Timer::update_timing ()
+{
+    auto num_nodes = connections_.size();
+    for_chunks(net_drivers_.size(), num_threads_, [this] (size_t n) { update_net(n); });
+    for_chunks(comp_arc_begin_.size() - 1, num_threads_,
+               [this] (size_t c) { update_cell_arcs(c); });
+    for (uint32_t e = 0; e < endpoints_.size(); e++) {
+        update_endpoint(e);
+    }
+
+    arrivals_.assign(num_nodes, -infinity);
+    requireds_.assign(num_nodes, infinity);
+
+    auto num_levels = level_begin_.size() - 1;
+    for (size_t l = 0; l < num_levels; l++) {
+        auto nodes = level_nodes_.data() + level_begin_[l];
+        for_chunks(level_begin_[l + 1] - level_begin_[l], num_threads_,
+                   [&] (size_t i) { arrivals_[nodes[i]] = compute_arrival(nodes[i]); });
+    }
+    for (auto l = num_levels; l-- > 0; ) {
+        auto nodes = level_nodes_.data() + level_begin_[l];
+        for_chunks(level_begin_[l + 1] - level_begin_[l], num_threads_,
+                   [&] (size_t i) { requireds_[nodes[i]] = compute_required(nodes[i]); });
+    }
+
+    tns_ = 0;
+    num_violations_ = 0;
+    for (auto& e : endpoints_) {
+        e.slack_ = infinity;
+        set_slack(e, get_slack(e.node_));
+    }
+}
+
+/**
+ * Re-time the nets of the components and the cells driving them, and the
+ * cells themselves; then propagate the arrival times forward and the
+ * required times backward from the arcs that changed.
+ */
+void Timer::update (const vector<uint32_t>& ids)
+{
+    if (ids.size() * 4 >= comp_arc_begin_.size()) {
+        update_timing();
+        return;
+    }
+
+    vector<uint32_t> forward, backward, comps(ids);
+    stamp_++;
+    for (auto id : ids) {
+        for (auto& np : def_->get_component_nets(id)) {
+            if (net_stamps_[np.net_] == stamp_) {
+                continue;
+            }
+            net_stamps_[np.net_] = stamp_;
+            update_net(np.net_);
+
+            auto driver = net_drivers_[np.net_];
+            if (driver == -1) {
+                continue;
+            }
+            backward.push_back(driver);
+            for (auto a = fanout_begin_[driver]; a < fanout_begin_[driver + 1]; a++) {
+                forward.push_back(arc_to_[fanout_arcs_[a]]);
+            }
+            if (connections_[driver]->component_) {
+                comps.push_back(connections_[driver]->component_->id_);
+            }
+        }
+    }
+
+    sort(comps.begin(), comps.end());
+    comps.erase(unique(comps.begin(), comps.end()), comps.end());
+    for (auto c : comps) {
+        update_cell_arcs(c);
+        for (auto arc = comp_arc_begin_[c]; arc < comp_arc_begin_[c + 1]; arc++) {
+            forward.push_back(arc_to_[arc]);
+            backward.push_back(arc_from_[arc]);
+        }
+    }
+    for (auto id : ids) {
+        for (auto& np : def_->get_component_nets(id)) {
+            auto e = endpoint_of_node_[get_node(np.net_, np.pin_)];
+            if (e != -1) {
+                update_endpoint(e);
+                backward.push_back(endpoints_[e].node_);
+            }
+        }
+    }
+
+    propagate_arrivals(forward);
+    propagate_requireds(backward);
+}
+
+/**
+ * Fanouts are on higher levels, so a level is done once it is reached.
+ */
+void Timer::propagate_arrivals (vector<uint32_t>& seeds)
+{
+    size_t first = buckets_.size();
+    size_t last = 0;
+    auto push = [&] (uint32_t v) {
+        auto l = levels_[v];
+        if (l == no_level || is_queued_[v]) {
+            return;
+        }
+        is_queued_[v] = 1;
+        buckets_[l].push_back(v);
+        first = min<size_t>(first, l);
+        last = max<size_t>(last, l);
+    };
+
+    for (auto v : seeds) {
+        push(v);
+    }
+    if (first > last) {
+        return;
+    }
+    for (auto l = first; l <= last; l++) {
+        for (auto v : buckets_[l]) {
+            is_queued_[v] = 0;
+            auto arrival = compute_arrival(v);
+            if (arrival == arrivals_[v]) {
+                continue;
+            }
+            arrivals_[v] = arrival;
+            if (endpoint_of_node_[v] != -1) {
+                set_slack(endpoints_[endpoint_of_node_[v]], get_slack(v));
+            }
+            for (auto a = fanout_begin_[v]; a < fanout_begin_[v + 1]; a++) {
+                push(arc_to_[fanout_arcs_[a]]);
+            }
+        }
+        buckets_[l].clear();
+    }
+}
+
+void Timer::propagate_requireds (vector<uint32_t>& seeds)
+{
+    size_t first = buckets_.size();
+    size_t last = 0;
+    auto push = [&] (uint32_t v) {
+        auto l = levels_[v];
+        if (l == no_level || is_queued_[v]) {
+            return;
+        }
+        is_queued_[v] = 1;
+        buckets_[l].push_back(v);
+        first = min<size_t>(first, l);
+        last = max<size_t>(last, l);
+    };
+
+    for (auto v : seeds) {
+        push(v);
+    }
+    if (first > last) {
+        return;
+    }
+    for (auto l = last + 1; l-- > first; ) {
+        for (auto v : buckets_[l]) {
+            is_queued_[v] = 0;
+            auto required = compute_required(v);
+            if (required == requireds_[v]) {
+                continue;
+            }
+            requireds_[v] = required;
+            if (endpoint_of_node_[v] != -1) {
+                set_slack(endpoints_[endpoint_of_node_[v]], get_slack(v));
+            }
+            for (auto a = fanin_begin_[v]; a < fanin_begin_[v + 1]; a++) {
+                push(arc_from_[fanin_arcs_[a]]);
+            }
+        }
+        buckets_[l].clear();
+    }
+}
+
+double Timer::get_tns () const
+{
+    return tns_;
+}
+
+double Timer::get_wns () const
+{
+    auto wns = infinity;
+    for (auto& e : endpoints_) {
+        wns = min(wns, e.slack_);
+    }
+    return wns == infinity ? 0 : wns;
+}
+
+size_t Timer::get_num_nodes () const
+{
+    return connections_.size();
+}
+
+size_t Timer::get_num_endpoints () const
+{
+    return endpoints_.size();
+}
+
+size_t Timer::get_num_violations () const
+{
+    return num_violations_;
+}
+
+void Timer::report () const
+{
+    cout << "Summary of the timing." << endl;
+    cout << "\t#Nodes     : " << connections_.size();
+    if (num_loop_nodes_ > 0) {
+        cout << " (" << num_loop_nodes_ << " on or behind loops)";
+    }
+    cout << endl;
+    cout << "\t#Arcs      : " << first_cell_arc_ << " net, "
+         << arc_from_.size() - first_cell_arc_ << " cell" << endl;
+    cout << "\t#Levels    : " << level_begin_.size() - 1 << endl;
+    cout << "\t#Endpoints : " << endpoints_.size() << " (" << num_violations_
+         << " violating)" << endl;
+    cout << "\tWNS        : " << setprecision(6) << get_wns() << endl;
+    cout << "\tTNS        : " << get_tns() << endl;
+}
+
+}   // End of namespace sta
@@ -0,0 +1,185 @@
+/**
+ * @file    Timer.h
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "common_header.h"
+#include "Def.h"
+#include "Sdc.h"
+#include "DelayModel.h"
+
+namespace sta
+{
+
+/**
+ * A static timing analysis of the setup checks of a Def, with ideal
+ * clocks. Times are in the units of the SDC.
+ *
+ * A node is a pin of a net (a def::Connection), numbered net by net in the
+ * order of the connections. A net has arcs from its driver (an output of a
+ * component or an input port) to its other pins; a component has arcs
+ * from its inputs to its outputs, or from its CLOCK pins to its outputs
+ * if it is a register. A CLOCK pin takes no arc from its net: it starts
+ * a path at the latency of its clock, and the other inputs of a register
+ * end paths. Input ports start paths at their input delays, and output
+ * ports with an output delay end them.
+ *
+ * The nodes are levelized once; a full timing runs level by level on the
+ * threads. update() re-times the nets and the cells around the changed
+ * components, and then only the nodes whose times change.
+ */
+class Timer
+{
+public:
+    Timer ();
+
+    /**
+     * Build the timing graph of @a def with the constraints of @a sdc, and
+     * time it on @a num_threads threads. A register is clocked by the
+     * clock of the port driving its CLOCK net, or else by the first clock.
+     */
+    void build (const def::Def& def, const sdc::Sdc& sdc, DelayModel model,
+                int num_threads = 1);
+    void clear ();
+
+    /**
+     * Time the whole graph again.
+     */
+    void update_timing ();
+
+    /**
+     * Re-time after the components @a ids were moved, or had their macros
+     * swapped for macros of the same pins.
+     */
+    void update (const vector<uint32_t>& ids);
+
+    /**
+     * @return The sum of the negative slacks of the endpoints, 0 or less.
+     */
+    double get_tns () const;
+
+    /**
+     * @return The worst slack of the endpoints, 0 if none.
+     */
+    double get_wns () const;
+
+    size_t get_num_nodes () const;
+    size_t get_num_endpoints () const;
+    size_t get_num_violations () const;
+
+    /**
+     * @return The node of the connection @a pin of the net @a net.
+     */
+    uint32_t get_node (uint32_t net, uint32_t pin) const;
+
+    // -inf where no path arrives, +inf where no path is required.
+    double get_arrival (uint32_t node) const;
+    double get_required (uint32_t node) const;
+    double get_slack (uint32_t node) const;
+
+    void report () const;
+
+private:
+    const def::Def* def_;
+    const sdc::Sdc* sdc_;
+    DelayModel model_;
+    int num_threads_;
+    double dbu_;
+
+    // By node.
+    vector<const def::Connection*> connections_;
+    vector<uint32_t> node_nets_;
+    vector<uint32_t> levels_;       ///< no_level for nodes on loops.
+    vector<double> arrivals_;
+    vector<double> requireds_;
+    vector<double> source_arrivals_;    ///< NaN if the node does not start paths.
+    vector<int> endpoint_of_node_;      ///< Index in endpoints_, -1 if none.
+
+    // By net.
+    vector<uint32_t> net_first_node_;   ///< And the number of nodes at the end.
+    vector<int> net_drivers_;           ///< Driving node, -1 if none.
+    vector<double> net_loads_;
+
+    // Arcs; the cell arcs are grouped by component.
+    vector<uint32_t> arc_from_;
+    vector<uint32_t> arc_to_;
+    vector<double> arc_delays_;
+    uint32_t first_cell_arc_;
+    vector<uint32_t> comp_arc_begin_;
+
+    // Arc ids into and out of the nodes.
+    vector<uint32_t> fanin_begin_;
+    vector<uint32_t> fanin_arcs_;
+    vector<uint32_t> fanout_begin_;
+    vector<uint32_t> fanout_arcs_;
+
+    // Nodes by level.
+    vector<uint32_t> level_begin_;
+    vector<uint32_t> level_nodes_;
+    size_t num_loop_nodes_;
+
+    // Endpoints.
+    struct Endpoint
+    {
+        uint32_t node_;
+        int clock_;                 ///< Index in the clocks of the SDC.
+        double required_;           ///< Own required time.
+        double slack_;              ///< Counted in tns_.
+    };
+
+    vector<Endpoint> endpoints_;
+    double tns_;
+    size_t num_violations_;
+
+    // Work lists of update().
+    vector<vector<uint32_t>> buckets_;
+    vector<char> is_queued_;
+    vector<uint32_t> net_stamps_;
+    uint32_t stamp_;
+
+    static const uint32_t no_level = 0xFFFFFFFF;
+
+    void build_nodes ();
+    void build_arcs ();
+    void build_levels ();
+    void build_endpoints ();
+
+    double get_clock_latency (int clock) const;
+    double get_pin_capacitance (uint32_t node) const;
+    void update_net (uint32_t net);
+    void update_cell_arcs (uint32_t comp);
+    void update_endpoint (uint32_t endpoint);
+    double compute_arrival (uint32_t node) const;
+    double compute_required (uint32_t node) const;
+    void set_slack (Endpoint& e, double slack);
+
+    void propagate_arrivals (vector<uint32_t>& seeds);
+    void propagate_requireds (vector<uint32_t>& seeds);
+};
+
+
+inline uint32_t Timer::get_node (uint32_t net, uint32_t pin) const
+{
+    return net_first_node_[net] + pin;
+}
+
+inline double Timer::get_arrival (uint32_t node) const
+{
+    return arrivals_[node];
+}
+
+inline double Timer::get_required (uint32_t node) const
+{
+    return requireds_[node];
+}
+
+inline double Timer::get_slack (uint32_t node) const
+{
+    return requireds_[node] - arrivals_[node];
+}
+
+}   // End of namespace sta
+
+#endif
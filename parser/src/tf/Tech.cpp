@@ -0,0 +1,717 @@
+/**
+ * @file    Tech.cpp
+ */
+
+#include "Tech.h"
+#include "MappedFile.h"
+#include "StringUtil.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace tf
+{
+
+/**
+ * An attribute "name = value" of a section; the value is a word, a quoted
+ * string or a list in parentheses.
+ */
+struct Attribute
+{
+    string name_;
+    string text_;               ///< A single value, without its quotes.
+    vector<string> items_;      ///< The values of a list.
+};
+
+/**
+ * A section "keyword [name] { attributes }". The attributes are kept from
+ * one section to the next, so their strings are reused.
+ */
+struct Section
+{
+    string keyword_;
+    string name_;
+    vector<Attribute> attributes_;
+    size_t num_attributes_;
+
+    Section () : num_attributes_(0) { }
+
+    const Attribute* find (const char* name) const
+    {
+        for (size_t i = 0; i < num_attributes_; i++) {
+            if (attributes_[i].name_ == name) {
+                return &attributes_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    double get_number (const char* name, double value) const
+    {
+        auto a = find(name);
+        return a == nullptr || a->text_.empty() ? value : strtod(a->text_.c_str(), nullptr);
+    }
+
+    const string& get_text (const char* name) const
+    {
+        static const string empty;
+        auto a = find(name);
+        return a == nullptr ? empty : a->text_;
+    }
+
+    vector<double> get_numbers (const char* name) const
+    {
+        vector<double> numbers;
+        auto a = find(name);
+        if (a != nullptr) {
+            numbers.reserve(a->items_.size());
+            for (auto& i : a->items_) {
+                numbers.push_back(strtod(i.c_str(), nullptr));
+            }
+        }
+        return numbers;
+    }
+
+    /**
+     * @return The values of "unitMin<what>", "unitNom<what>" and
+     *         "unitMax<what>".
+     */
+    MinNomMax get_min_nom_max (const string& what) const
+    {
+        MinNomMax m;
+        m.min_ = get_number(("unitMin" + what).c_str(), NAN);
+        m.nom_ = get_number(("unitNom" + what).c_str(), NAN);
+        m.max_ = get_number(("unitMax" + what).c_str(), NAN);
+        return m;
+    }
+};
+
+/**
+ * Reads the sections of a technology file one at a time, and keeps those
+ * the tables need. Comments are C style.
+ */
+class TfReader
+{
+public:
+    TfReader (Tech& tech, const string& filename);
+    void read (const char* data, size_t size);
+
+private:
+    enum class Token { end, word, text, symbol };
+
+    Tech& tech_;
+    string filename_;
+
+    const char* p_;
+    const char* end_;
+    size_t line_;
+    size_t num_warnings_;
+
+    Section section_;
+
+    void skip_space ();
+    Token next (string& token);
+    bool parse_attributes ();
+    bool parse_list (Attribute& attribute);
+    bool skip_block ();
+
+    int find_layer (const string& name) const;
+
+    void read_technology ();
+    void read_layer ();
+    void read_contact_code ();
+    void read_design_rule ();
+    void read_density_rule ();
+
+    void warn (const string& message);
+};
+
+TfReader::TfReader (Tech& tech, const string& filename)
+    : tech_(tech), filename_(filename),
+      p_(nullptr), end_(nullptr), line_(1), num_warnings_(0)
+{
+    //
+}
+
+void TfReader::warn (const string& message)
+{
+    const size_t max_warnings = 10;
+    if (num_warnings_++ < max_warnings) {
+        cout << "(W) " << filename_ << ":" << line_ << ": " << message << endl;
+    }
+    else if (num_warnings_ == max_warnings + 1) {
+        cout << "(W) More warnings are not shown." << endl;
+    }
+}
+
+void TfReader::skip_space ()
+{
+    while (p_ < end_) {
+        auto c = *p_;
+        if (c == '\n') {
+            line_++;
+            p_++;
+        }
+        else if (isspace(static_cast<unsigned char>(c))) {
+            p_++;
+        }
+        else if (c == '/' && p_ + 1 < end_ && p_[1] == '*') {
+            p_ += 2;
+            while (p_ < end_ && !(*p_ == '*' && p_ + 1 < end_ && p_[1] == '/')) {
+                line_ += *p_ == '\n';
+                p_++;
+            }
+            p_ = min(p_ + 2, end_);
+        }
+        else {
+            break;
+        }
+    }
+}
+
+/**
+ * A symbol is one of "{}()=,"; @a token then holds it.
+ */
+TfReader::Token TfReader::next (string& token)
+{
+    skip_space();
+    if (p_ == end_) {
+        return Token::end;
+    }
+
+    auto c = *p_;
+    if (strchr("{}()=,", c) != nullptr) {
+        token.assign(1, c);
+        p_++;
+        return Token::symbol;
+    }
+    if (c == '"') {
+        auto first = ++p_;
+        while (p_ < end_ && *p_ != '"') {
+            line_ += *p_ == '\n';
+            p_++;
+        }
+        token.assign(first, p_);
+        p_ = min(p_ + 1, end_);
+        return Token::text;
+    }
+
+    auto first = p_;
+    while (p_ < end_ && !isspace(static_cast<unsigned char>(*p_))
+           && strchr("{}()=,\"", *p_) == nullptr) {
+        p_++;
+    }
+    token.assign(first, p_);
+    return Token::word;
+}
+
+void TfReader::read (const char* data, size_t size)
+{
+    p_ = data;
+    end_ = data + size;
+
+    string token;
+    while (true) {
+        auto t = next(token);
+        if (t == Token::end) {
+            break;
+        }
+        if (t != Token::word) {
+            warn("Unexpected '" + token + "'.");
+            continue;
+        }
+
+        section_.keyword_ = token;
+        section_.name_.clear();
+        section_.num_attributes_ = 0;
+
+        t = next(token);
+        if (t == Token::word || t == Token::text) {
+            section_.name_ = token;
+            t = next(token);
+        }
+        if (t != Token::symbol || token != "{") {
+            warn("Expected '{' after " + section_.keyword_ + ".");
+            continue;
+        }
+        if (!parse_attributes()) {
+            warn("Unexpected end of file in " + section_.keyword_ + ".");
+            break;
+        }
+
+        auto& keyword = section_.keyword_;
+        if (keyword == "Layer") {
+            read_layer();
+        }
+        else if (keyword == "ContactCode") {
+            read_contact_code();
+        }
+        else if (keyword == "DesignRule") {
+            read_design_rule();
+        }
+        else if (keyword == "DensityRule") {
+            read_density_rule();
+        }
+        else if (keyword == "Technology") {
+            read_technology();
+        }
+        else {
+            tech_.num_ignored_[keyword]++;
+        }
+    }
+}
+
+/**
+ * Read the attributes up to the '}' closing the section. Nested sections
+ * are skipped.
+ *
+ * @return False at the end of the file.
+ */
+bool TfReader::parse_attributes ()
+{
+    auto& attributes = section_.attributes_;
+    string token;
+
+    while (true) {
+        auto t = next(token);
+        if (t == Token::end) {
+            return false;
+        }
+        if (t == Token::symbol && token == "}") {
+            return true;
+        }
+        if (t != Token::word) {
+            warn("Unexpected '" + token + "' in " + section_.keyword_ + ".");
+            continue;
+        }
+
+        if (section_.num_attributes_ == attributes.size()) {
+            attributes.emplace_back();
+        }
+        auto& a = attributes[section_.num_attributes_];
+        a.name_ = token;
+        a.text_.clear();
+        a.items_.clear();
+
+        t = next(token);
+        if (t == Token::word || t == Token::text) {
+            // A nested section with a name.
+            t = next(token);
+        }
+        if (t == Token::symbol && token == "{") {
+            if (!skip_block()) {
+                return false;
+            }
+            continue;
+        }
+        if (t != Token::symbol || token != "=") {
+            warn("Expected '=' after " + a.name_ + ".");
+            continue;
+        }
+
+        t = next(a.text_);
+        if (t == Token::end) {
+            return false;
+        }
+        if (t == Token::symbol) {
+            if (a.text_ != "(") {
+                warn("Unexpected '" + a.text_ + "' after " + a.name_ + ".");
+                continue;
+            }
+            a.text_.clear();
+            if (!parse_list(a)) {
+                return false;
+            }
+        }
+        section_.num_attributes_++;
+    }
+}
+
+/**
+ * Read the items of a list up to its ')'. Nested lists are flattened.
+ */
+bool TfReader::parse_list (Attribute& attribute)
+{
+    string token;
+    int depth = 1;
+    while (depth > 0) {
+        auto t = next(token);
+        if (t == Token::end) {
+            return false;
+        }
+        if (t != Token::symbol) {
+            attribute.items_.push_back(token);
+        }
+        else if (token == "(") {
+            depth++;
+        }
+        else if (token == ")") {
+            depth--;
+        }
+    }
+    return true;
+}
+
+bool TfReader::skip_block ()
+{
+    string token;
+    int depth = 1;
+    while (depth > 0) {
+        auto t = next(token);
+        if (t == Token::end) {
+            return false;
+        }
+        if (t == Token::symbol) {
+            depth += (token == "{") - (token == "}");
+        }
+    }
+    return true;
+}
+
+int TfReader::find_layer (const string& name) const
+{
+    return tech_.find_layer(util::SymbolTable::get_instance().find(name));
+}
+
+void TfReader::read_technology ()
+{
+    struct UnitName
+    {
+        const char* attribute_;
+        const char* base_;
+        double* unit_;
+    };
+    const UnitName units[] = {
+        {"unitLengthName", "m", &tech_.length_unit_},
+        {"unitResistanceName", "ohm", &tech_.resistance_unit_},
+        {"unitCapacitanceName", "f", &tech_.capacitance_unit_},
+        {"unitTimeName", "s", &tech_.time_unit_}
+    };
+
+    for (auto& u : units) {
+        auto& name = section_.get_text(u.attribute_);
+        if (name.empty()) {
+            continue;
+        }
+        auto scale = StringUtil::to_lower(name) == "micron"
+                     ? 1e-6 : StringUtil::parse_unit(name, u.base_);
+        if (scale == 0) {
+            warn("Unknown unit " + name + " of " + u.attribute_ + ".");
+        }
+        else {
+            *u.unit_ = scale;
+        }
+    }
+}
+
+void TfReader::read_layer ()
+{
+    auto name_id = section_.name_.empty() ? util::SymbolTable::invalid_symbol
+                   : util::SymbolTable::get_instance().intern(section_.name_);
+    if (name_id == util::SymbolTable::invalid_symbol || tech_.find_layer(name_id) != -1) {
+        warn("Layer \"" + section_.name_ + "\" is not a new name; ignored.");
+        return;
+    }
+
+    Layer l;
+    l.id_ = tech_.layers_.size();
+    l.name_ = section_.name_;
+    l.name_id_ = name_id;
+    l.number_ = static_cast<int>(section_.get_number("layerNumber", -1));
+    l.mask_name_ = section_.get_text("maskName");
+
+    l.pitch_ = section_.get_number("pitch", 0);
+    l.default_width_ = section_.get_number("defaultWidth", 0);
+    l.min_width_ = section_.get_number("minWidth", 0);
+    l.max_width_ = section_.get_number("maxWidth", 0);
+    l.min_spacing_ = section_.get_number("minSpacing", 0);
+    l.same_net_min_spacing_ = section_.get_number("sameNetMinSpacing", l.min_spacing_);
+    l.min_area_ = section_.get_number("minArea", 0);
+    l.max_current_density_ = section_.get_number("maxCurrDensity", 0);
+
+    l.unit_resistance_ = section_.get_min_nom_max("Resistance");
+    l.unit_capacitance_ = section_.get_min_nom_max("Capacitance");
+
+    l.fat_spacings_ = section_.get_numbers("fatTblSpacing");
+    if (!l.fat_spacings_.empty()) {
+        l.fat_widths_ = section_.get_numbers("fatTblThreshold");
+        l.fat_lengths_ = section_.get_numbers("fatTblParallelLength");
+        auto num_lengths = max<size_t>(l.fat_lengths_.size(), 1);
+        if (l.fat_widths_.empty()
+            || l.fat_spacings_.size() != l.fat_widths_.size() * num_lengths) {
+            warn("The spacing table of layer " + l.name_ + " does not match its size.");
+            l.fat_widths_.clear();
+            l.fat_lengths_.clear();
+            l.fat_spacings_.clear();
+        }
+    }
+
+    auto cut_names = section_.find("cutNameTbl");
+    if (cut_names != nullptr) {
+        auto widths = section_.get_numbers("cutWidthTbl");
+        auto heights = section_.get_numbers("cutHeightTbl");
+        auto& items = cut_names->items_;
+        if (widths.size() != items.size() || heights.size() != items.size()) {
+            warn("The cut tables of layer " + l.name_ + " differ in size.");
+        }
+        else {
+            auto& symbols = util::SymbolTable::get_instance();
+            for (size_t i = 0; i < items.size(); i++) {
+                l.cuts_.push_back(Cut{symbols.intern(items[i]), widths[i], heights[i]});
+            }
+        }
+    }
+    l.is_cut_ = !l.cuts_.empty();
+
+    tech_.layer_umap_[name_id] = l.id_;
+    tech_.layers_.push_back(move(l));
+}
+
+void TfReader::read_contact_code ()
+{
+    auto name_id = section_.name_.empty() ? util::SymbolTable::invalid_symbol
+                   : util::SymbolTable::get_instance().intern(section_.name_);
+    if (name_id == util::SymbolTable::invalid_symbol || tech_.find_contact_code(name_id) != -1) {
+        warn("ContactCode \"" + section_.name_ + "\" is not a new name; ignored.");
+        return;
+    }
+
+    ContactCode c;
+    c.id_ = tech_.contact_codes_.size();
+    c.name_ = section_.name_;
+    c.name_id_ = name_id;
+    c.number_ = static_cast<int>(section_.get_number("contactCodeNumber", -1));
+
+    c.cut_layer_ = find_layer(section_.get_text("cutLayer"));
+    c.lower_layer_ = find_layer(section_.get_text("lowerLayer"));
+    c.upper_layer_ = find_layer(section_.get_text("upperLayer"));
+    if (c.cut_layer_ == -1 || c.lower_layer_ == -1 || c.upper_layer_ == -1) {
+        warn("ContactCode " + c.name_ + " has an unknown layer.");
+    }
+    if (c.cut_layer_ != -1) {
+        tech_.layers_[c.cut_layer_].is_cut_ = true;
+    }
+
+    c.cut_width_ = section_.get_number("cutWidth", 0);
+    c.cut_height_ = section_.get_number("cutHeight", 0);
+    c.min_cut_spacing_ = section_.get_number("minCutSpacing", 0);
+    c.lower_enc_width_ = section_.get_number("lowerLayerEncWidth", 0);
+    c.lower_enc_height_ = section_.get_number("lowerLayerEncHeight", 0);
+    c.upper_enc_width_ = section_.get_number("upperLayerEncWidth", 0);
+    c.upper_enc_height_ = section_.get_number("upperLayerEncHeight", 0);
+    c.is_default_ = section_.get_number("isDefaultContact", 0) != 0;
+    c.unit_resistance_ = section_.get_min_nom_max("Resistance");
+
+    tech_.contact_code_umap_[name_id] = c.id_;
+    tech_.contact_codes_.push_back(move(c));
+}
+
+void TfReader::read_design_rule ()
+{
+    DesignRule r;
+    r.layer1_ = find_layer(section_.get_text("layer1"));
+    r.layer2_ = find_layer(section_.get_text("layer2"));
+    if (r.layer1_ == -1 || r.layer2_ == -1) {
+        warn("DesignRule between " + section_.get_text("layer1") + " and "
+             + section_.get_text("layer2") + " has an unknown layer; ignored.");
+        return;
+    }
+
+    r.min_spacing_ = section_.get_number("minSpacing", 0);
+    r.min_enclosure_ = section_.get_number("minEnclosure", 0);
+    r.is_stackable_ = section_.get_number("stackable", 0) != 0;
+
+    auto& symbols = util::SymbolTable::get_instance();
+    auto cuts1 = section_.find("cut1NameTbl");
+    auto cuts2 = section_.find("cut2NameTbl");
+    if (cuts1 != nullptr && cuts2 != nullptr) {
+        for (auto& name : cuts1->items_) {
+            r.cuts1_.push_back(symbols.intern(name));
+        }
+        for (auto& name : cuts2->items_) {
+            r.cuts2_.push_back(symbols.intern(name));
+        }
+        r.same_net_spacings_ = section_.get_numbers("sameNetXMinSpacingTbl");
+        r.diff_net_spacings_ = section_.get_numbers("diffNetXMinSpacingTbl");
+
+        auto size = r.cuts1_.size() * r.cuts2_.size();
+        for (auto table : {&r.same_net_spacings_, &r.diff_net_spacings_}) {
+            if (!table->empty() && table->size() != size) {
+                warn("A cut spacing table between " + tech_.layers_[r.layer1_].name_
+                     + " and " + tech_.layers_[r.layer2_].name_ + " does not match its size.");
+                table->clear();
+            }
+        }
+    }
+
+    auto key = (static_cast<uint64_t>(min(r.layer1_, r.layer2_)) << 32)
+               | static_cast<uint32_t>(max(r.layer1_, r.layer2_));
+    tech_.design_rule_umap_.emplace(key, tech_.design_rules_.size());
+    tech_.design_rules_.push_back(move(r));
+}
+
+void TfReader::read_density_rule ()
+{
+    DensityRule r;
+    r.layer_ = find_layer(section_.get_text("layer"));
+    if (r.layer_ == -1) {
+        warn("DensityRule of " + section_.get_text("layer") + " has an unknown layer; ignored.");
+        return;
+    }
+    r.window_size_ = section_.get_number("windowSize", 0);
+    r.min_density_ = section_.get_number("minDensity", 0);
+    r.max_density_ = section_.get_number("maxDensity", 100);
+    tech_.density_rules_.push_back(r);
+}
+
+
+Layer::Layer ()
+    : id_(0), name_id_(util::SymbolTable::invalid_symbol), number_(-1), is_cut_(false),
+      pitch_(0), default_width_(0), min_width_(0), max_width_(0), min_spacing_(0),
+      same_net_min_spacing_(0), min_area_(0), max_current_density_(0)
+{
+    //
+}
+
+/**
+ * The row and the column are the last whose threshold is not above
+ * @a width and @a parallel_length.
+ */
+double Layer::get_spacing (double width, double parallel_length) const
+{
+    if (fat_spacings_.empty()) {
+        return min_spacing_;
+    }
+
+    auto last_not_above = [] (const vector<double>& thresholds, double value) {
+        auto found = upper_bound(thresholds.begin(), thresholds.end(), value);
+        return found == thresholds.begin() ? 0 : found - thresholds.begin() - 1;
+    };
+    auto row = last_not_above(fat_widths_, width);
+    if (fat_lengths_.empty()) {
+        return fat_spacings_[row];
+    }
+    auto column = last_not_above(fat_lengths_, parallel_length);
+    return fat_spacings_[row * fat_lengths_.size() + column];
+}
+
+ContactCode::ContactCode ()
+    : id_(0), name_id_(util::SymbolTable::invalid_symbol), number_(-1),
+      cut_layer_(-1), lower_layer_(-1), upper_layer_(-1),
+      cut_width_(0), cut_height_(0), min_cut_spacing_(0),
+      lower_enc_width_(0), lower_enc_height_(0), upper_enc_width_(0), upper_enc_height_(0),
+      is_default_(false)
+{
+    //
+}
+
+DesignRule::DesignRule ()
+    : layer1_(-1), layer2_(-1), min_spacing_(0), min_enclosure_(0), is_stackable_(false)
+{
+    //
+}
+
+double DesignRule::get_cut_spacing (size_t cut1, size_t cut2, bool same_net) const
+{
+    auto& table = same_net ? same_net_spacings_ : diff_net_spacings_;
+    if (table.empty() || cut1 >= cuts1_.size() || cut2 >= cuts2_.size()) {
+        return NAN;
+    }
+    return table[cut1 * cuts2_.size() + cut2];
+}
+
+
+Tech::Tech ()
+{
+    clear();
+}
+
+void Tech::clear ()
+{
+    length_unit_ = 1e-6;
+    resistance_unit_ = 1;
+    capacitance_unit_ = 1e-12;
+    time_unit_ = 1e-9;
+
+    layers_.clear();
+    contact_codes_.clear();
+    design_rules_.clear();
+    density_rules_.clear();
+    layer_umap_.clear();
+    contact_code_umap_.clear();
+    design_rule_umap_.clear();
+    num_ignored_.clear();
+}
+
+void Tech::read_tf (string filename, lef::Lef& lef)
+{
+    clear();
+
+    util::MappedFile file(filename);
+    TfReader reader(*this, filename);
+    reader.read(file.get_data(), file.get_size());
+
+    for (auto& l : layers_) {
+        l.lef_layer_ = lef.get_layer(l.name_);
+    }
+    for (auto& c : contact_codes_) {
+        c.lef_via_ = lef.get_via(c.name_);
+    }
+}
+
+double Tech::get_length_unit () const
+{
+    return length_unit_;
+}
+
+double Tech::get_resistance_unit () const
+{
+    return resistance_unit_;
+}
+
+double Tech::get_capacitance_unit () const
+{
+    return capacitance_unit_;
+}
+
+double Tech::get_time_unit () const
+{
+    return time_unit_;
+}
+
+const DesignRule* Tech::find_design_rule (int layer1, int layer2) const
+{
+    auto key = (static_cast<uint64_t>(min(layer1, layer2)) << 32)
+               | static_cast<uint32_t>(max(layer1, layer2));
+    auto found = design_rule_umap_.find(key);
+    return found == design_rule_umap_.end() ? nullptr : &design_rules_[found->second];
+}
+
+void Tech::report () const
+{
+    auto num_cut = count_if(layers_.begin(), layers_.end(),
+                            [] (const Layer& l) { return l.is_cut_; });
+    auto num_rc = count_if(layers_.begin(), layers_.end(), [] (const Layer& l) {
+        return l.unit_resistance_.is_set() || l.unit_capacitance_.is_set();
+    });
+    auto num_lef_layers = count_if(layers_.begin(), layers_.end(),
+                                   [] (const Layer& l) { return l.lef_layer_ != nullptr; });
+    auto num_lef_vias = count_if(contact_codes_.begin(), contact_codes_.end(),
+                                 [] (const ContactCode& c) { return c.lef_via_ != nullptr; });
+
+    cout << "Summary of the technology file read." << endl;
+    cout << "\t#Layers    : " << layers_.size() << " (" << num_cut << " cut, "
+         << num_rc << " with RC)" << endl;
+    cout << "\t#Contacts  : " << contact_codes_.size() << endl;
+    cout << "\t#Rules     : " << design_rules_.size() << " design, "
+         << density_rules_.size() << " density" << endl;
+    cout << "\tLEF links  : " << num_lef_layers << " layers, " << num_lef_vias << " vias" << endl;
+    cout << "\tUnits      : " << setprecision(6) << length_unit_ << " m, "
+         << resistance_unit_ << " ohm, " << capacitance_unit_ << " F" << endl;
+    for (auto& i : num_ignored_) {
+        cout << "\tIgnored    : " << i.first << " (" << i.second << ")" << endl;
+    }
+}
+
+}   // End of namespace tf
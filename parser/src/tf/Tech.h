@@ -0,0 +1,258 @@
+/**
+ * @file    Tech.h
+ */
+
+#ifndef TECH_H
+#define TECH_H
+
+#include "common_header.h"
+#include "SymbolTable.h"
+#include "Lef.h"
+
+#include <cmath>
+
+namespace tf
+{
+
+/**
+ * A value at the minimum, nominal and maximum corners; NaN where it is not
+ * set.
+ */
+struct MinNomMax
+{
+    double min_;
+    double nom_;
+    double max_;
+
+    MinNomMax () : min_(NAN), nom_(NAN), max_(NAN) { }
+
+    bool is_set () const { return !std::isnan(nom_); }
+};
+
+/**
+ * A cut shape of a cut layer (cutNameTbl), as named in the design rules.
+ */
+struct Cut
+{
+    util::SymbolId name_id_;
+    double width_;
+    double height_;
+};
+
+/**
+ * A layer of the technology file. Lengths are in the length unit of the
+ * file, and 0 where the file does not give them.
+ */
+struct Layer
+{
+    uint32_t id_;               ///< Index in Tech::get_layers().
+    string name_;
+    util::SymbolId name_id_;
+    int number_;                ///< layerNumber.
+    string mask_name_;
+    bool is_cut_;               ///< Has cut shapes or is the cut of a contact.
+
+    double pitch_;
+    double default_width_;
+    double min_width_;
+    double max_width_;
+    double min_spacing_;
+    double same_net_min_spacing_;
+    double min_area_;
+    double max_current_density_;
+
+    MinNomMax unit_resistance_;     ///< Per square.
+    MinNomMax unit_capacitance_;    ///< Per unit length.
+
+    // Spacing by wire width (rows) and parallel run length (columns).
+    vector<double> fat_widths_;
+    vector<double> fat_lengths_;
+    vector<double> fat_spacings_;
+
+    vector<Cut> cuts_;
+
+    lef::LayerPtr lef_layer_;   ///< The LEF layer of the same name, if any.
+
+    Layer ();
+
+    /**
+     * @return The spacing a wire of @a width needs to a wire running along
+     *         it for @a parallel_length.
+     */
+    double get_spacing (double width, double parallel_length) const;
+};
+
+/**
+ * A via of the technology file. Resistances are per cut.
+ */
+struct ContactCode
+{
+    uint32_t id_;               ///< Index in Tech::get_contact_codes().
+    string name_;
+    util::SymbolId name_id_;
+    int number_;                ///< contactCodeNumber.
+
+    // Indices in Tech::get_layers(), -1 if unknown.
+    int cut_layer_;
+    int lower_layer_;
+    int upper_layer_;
+
+    double cut_width_;
+    double cut_height_;
+    double min_cut_spacing_;
+    double lower_enc_width_;
+    double lower_enc_height_;
+    double upper_enc_width_;
+    double upper_enc_height_;
+    bool is_default_;
+
+    MinNomMax unit_resistance_;
+
+    lef::ViaPtr lef_via_;       ///< The LEF via of the same name, if any.
+
+    ContactCode ();
+};
+
+/**
+ * A rule between two layers. The cut spacing tables are indexed by the
+ * cuts of layer1_ (rows) and of layer2_ (columns), in the order of cuts1_
+ * and cuts2_.
+ */
+struct DesignRule
+{
+    int layer1_;
+    int layer2_;
+    double min_spacing_;
+    double min_enclosure_;
+    bool is_stackable_;
+
+    vector<util::SymbolId> cuts1_;
+    vector<util::SymbolId> cuts2_;
+    vector<double> same_net_spacings_;
+    vector<double> diff_net_spacings_;
+
+    DesignRule ();
+
+    /**
+     * @return The spacing between the cuts @a cut1 and @a cut2 (indices in
+     *         cuts1_ and cuts2_), NaN if the table has none.
+     */
+    double get_cut_spacing (size_t cut1, size_t cut2, bool same_net) const;
+};
+
+/**
+ * A metal density limit in windows of window_size_, in percent.
+ */
+struct DensityRule
+{
+    int layer_;
+    double window_size_;
+    double min_density_;
+    double max_density_;
+};
+
+/**
+ * The tables of a technology (.tf) file.
+ *
+ * The file is read once into arrays of layers and contact codes, found by
+ * their interned names; lef::Layer::name_id_ and lef::Via::name_id_ find
+ * the entries of the same LEF objects. Sections other than Technology,
+ * Layer, ContactCode, DesignRule and DensityRule are counted and skipped.
+ */
+class Tech
+{
+public:
+    Tech ();
+
+    /**
+     * Read @a filename and link its layers and contact codes to the layers
+     * and vias of @a lef.
+     */
+    void read_tf (string filename, lef::Lef& lef);
+    void clear ();
+    void report () const;
+
+    // Units of the values, in meters, ohms, farads and seconds.
+    double get_length_unit () const;
+    double get_resistance_unit () const;
+    double get_capacitance_unit () const;
+    double get_time_unit () const;
+
+    const vector<Layer>& get_layers () const;
+    const vector<ContactCode>& get_contact_codes () const;
+    const vector<DesignRule>& get_design_rules () const;
+    const vector<DensityRule>& get_density_rules () const;
+
+    /**
+     * @return Index of the layer named @a name in get_layers(), -1 if none.
+     */
+    int find_layer (util::SymbolId name) const;
+
+    /**
+     * @return Index of the contact code @a name in get_contact_codes(), -1
+     *         if none.
+     */
+    int find_contact_code (util::SymbolId name) const;
+
+    /**
+     * @return The rule between the layers @a layer1 and @a layer2, in
+     *         either order, nullptr if none.
+     */
+    const DesignRule* find_design_rule (int layer1, int layer2) const;
+
+private:
+    double length_unit_;
+    double resistance_unit_;
+    double capacitance_unit_;
+    double time_unit_;
+
+    vector<Layer> layers_;
+    vector<ContactCode> contact_codes_;
+    vector<DesignRule> design_rules_;
+    vector<DensityRule> density_rules_;
+
+    unordered_map<util::SymbolId, int> layer_umap_;
+    unordered_map<util::SymbolId, int> contact_code_umap_;
+    unordered_map<uint64_t, int> design_rule_umap_;    ///< By the pair of layers.
+
+    map<string, size_t> num_ignored_;   ///< Skipped sections, by keyword.
+
+    friend class TfReader;
+};
+
+
+inline const vector<Layer>& Tech::get_layers () const
+{
+    return layers_;
+}
+
+inline const vector<ContactCode>& Tech::get_contact_codes () const
+{
+    return contact_codes_;
+}
+
+inline const vector<DesignRule>& Tech::get_design_rules () const
+{
+    return design_rules_;
+}
+
+inline const vector<DensityRule>& Tech::get_density_rules () const
+{
+    return density_rules_;
+}
+
+inline int Tech::find_layer (util::SymbolId name) const
+{
+    auto found = layer_umap_.find(name);
+    return found == layer_umap_.end() ? -1 : found->second;
+}
+
+inline int Tech::find_contact_code (util::SymbolId name) const
+{
+    auto found = contact_code_umap_.find(name);
+    return found == contact_code_umap_.end() ? -1 : found->second;
+}
+
+}   // End of namespace tf
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file    Arena.h
+ * @brief   A header only block arena for design objects.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+/**
+ * An arena that constructs objects of type @a T in large contiguous blocks.
+ *
+ * Objects are never moved once created, so raw pointers (and aliasing
+ * shared_ptrs) stay valid until the arena is cleared. Objects created one
+ * after another are adjacent in memory unless a block boundary is crossed.
+ */
+template <typename T>
+class Arena
+{
+public:
+    explicit Arena (size_t block_size = 4096)
+        : block_size_(block_size ? block_size : 1), size_(0) {}
+    ~Arena () { clear(); }
+
+    Arena (const Arena&) = delete;
+    Arena& operator= (const Arena&) = delete;
+
+    /**
+     * Construct a new object in place and return its address.
+     */
+    template <typename... Args>
+    T* create (Args&&... args)
+    {
+        auto block_id = size_ / block_size_;
+        auto offset = size_ % block_size_;
+
+        if (block_id == blocks_.size()) {
+            blocks_.emplace_back(new Storage[block_size_]);
+        }
+
+        auto ptr = reinterpret_cast<T*>(&blocks_[block_id][offset]);
+        new (ptr) T(std::forward<Args>(args)...);
+        size_++;
+
+        return ptr;
+    }
+
+    /**
+     * Return the @a i-th object created in this arena.
+     */
+    T& operator[] (size_t i)
+    {
+        return *reinterpret_cast<T*>(&blocks_[i / block_size_][i % block_size_]);
+    }
+
+    const T& operator[] (size_t i) const
+    {
+        return *reinterpret_cast<const T*>(&blocks_[i / block_size_][i % block_size_]);
+    }
+
+    /**
+     * Destroy all the objects and release the blocks.
+     */
+    void clear ()
+    {
+        for (size_t i = 0; i < size_; i++) {
+            (*this)[i].~T();
+        }
+        blocks_.clear();
+        size_ = 0;
+    }
+
+    size_t size () const { return size_; }
+
+    /**
+     * @return Bytes reserved by the blocks.
+     */
+    size_t get_reserved_bytes () const
+    {
+        return blocks_.size() * block_size_ * sizeof(Storage);
+    }
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    size_t block_size_;                             ///< Objects per block.
+    size_t size_;                                   ///< Number of objects.
+    std::vector<std::unique_ptr<Storage[]>> blocks_;
+};
+
+}   // End of namespace util
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file    BinaryIO.h
+ * @brief   A header only binary writer/reader for snapshots.
+ */
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace util
+{
+
+/**
+ * @return 64-bit FNV-1a hash of @a size bytes at @a data, continuing @a h.
+ */
+inline uint64_t hash_bytes (const char* data, size_t size,
+                            uint64_t h = 14695981039346656037ULL)
+{
+    for (size_t i = 0; i < size; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+
+/**
+ * Appends values to a byte buffer in the host byte order.
+ */
+class BinaryWriter
+{
+public:
+    template <typename T>
+    void write (const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable types can be written.");
+        auto p = reinterpret_cast<const char*>(&value);
+        buffer_.insert(buffer_.end(), p, p + sizeof(T));
+    }
+
+    void write_string (const std::string& str)
+    {
+        write<uint32_t>(str.size());
+        buffer_.insert(buffer_.end(), str.begin(), str.end());
+    }
+
+    const std::vector<char>& get_buffer () const { return buffer_; }
+    std::vector<char>& get_buffer () { return buffer_; }
+
+private:
+    std::vector<char> buffer_;
+};
+
+
+/**
+ * Reads values written by BinaryWriter from a byte range.
+ * Reading past the end throws std::runtime_error.
+ */
+class BinaryReader
+{
+public:
+    BinaryReader (const char* data, size_t size)
+        : data_(data), size_(size), pos_(0) {}
+
+    template <typename T>
+    T read ()
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable types can be read.");
+        T value;
+        memcpy(&value, consume(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string read_string ()
+    {
+        auto len = read<uint32_t>();
+        return std::string(consume(len), len);
+    }
+
+    size_t get_position () const { return pos_; }
+    bool at_end () const { return pos_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+
+    const char* consume (size_t n)
+    {
+        if (n > size_ - pos_) {
+            throw std::runtime_error("(E) Unexpected end of binary data.");
+        }
+        auto p = data_ + pos_;
+        pos_ += n;
+        return p;
+    }
+};
+
+}   // End of namespace util
+
+#endif
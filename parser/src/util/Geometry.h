@@ -0,0 +1,95 @@
+/**
+ * @file    Geometry.h
+ * @brief   Integer boxes and the DEF orientations.
+ */
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+namespace util
+{
+
+/**
+ * An axis-aligned box in DBU. Boxes include their boundaries.
+ */
+struct Box
+{
+    int lx_;
+    int ly_;
+    int ux_;
+    int uy_;
+
+    Box () : lx_(0), ly_(0), ux_(0), uy_(0) {}
+    Box (int lx, int ly, int ux, int uy) : lx_(lx), ly_(ly), ux_(ux), uy_(uy) {}
+
+    /**
+     * @return True if the boxes share a point (touching counts).
+     */
+    bool intersects (const Box& b) const
+    {
+        return lx_ <= b.ux_ && b.lx_ <= ux_ && ly_ <= b.uy_ && b.ly_ <= uy_;
+    }
+
+    /**
+     * @return True if the boxes share a positive area.
+     */
+    bool overlaps (const Box& b) const
+    {
+        return lx_ < b.ux_ && b.lx_ < ux_ && ly_ < b.uy_ && b.ly_ < uy_;
+    }
+
+    Box shifted (int dx, int dy) const
+    {
+        return Box(lx_ + dx, ly_ + dy, ux_ + dx, uy_ + dy);
+    }
+};
+
+/**
+ * Number of the DEF orientations, N, W, S, E, FN, FW, FS and FE, coded 0
+ * to 7 as by the DEF parser.
+ */
+const int num_orients = 8;
+
+/**
+ * @return The DEF name of @a orient, "N" if it is not one.
+ */
+inline const char* get_orient_name (int orient)
+{
+    static const char* names[] = {"N", "W", "S", "E", "FN", "FW", "FS", "FE"};
+    return 0 <= orient && orient < num_orients ? names[orient] : "N";
+}
+
+/**
+ * @return @a b (relative to an origin) transformed by the DEF orientation
+ *         @a orient. W, S and E rotate counterclockwise by 90, 180 and 270
+ *         degrees; FN, FW, FS and FE rotate the same way, then mirror
+ *         about the y axis.
+ */
+inline Box transform_box (const Box& b, int orient)
+{
+    switch (orient) {
+        case 1:  return Box(-b.uy_,  b.lx_, -b.ly_,  b.ux_);    // W
+        case 2:  return Box(-b.ux_, -b.uy_, -b.lx_, -b.ly_);    // S
+        case 3:  return Box( b.ly_, -b.ux_,  b.uy_, -b.lx_);    // E
+        case 4:  return Box(-b.ux_,  b.ly_, -b.lx_,  b.uy_);    // FN
+        case 5:  return Box( b.ly_,  b.lx_,  b.uy_,  b.ux_);    // FW
+        case 6:  return Box( b.lx_, -b.uy_,  b.ux_, -b.ly_);    // FS
+        case 7:  return Box(-b.uy_, -b.ux_, -b.ly_, -b.lx_);    // FE
+        default: return b;                                      // N
+    }
+}
+
+/**
+ * @return @a b, a box inside a cell of size @a w x @a h, as seen from the
+ *         lower-left corner of the cell placed with @a orient. DEF places a
+ *         cell by that corner, whatever the orientation.
+ */
+inline Box transform_cell_box (const Box& b, int w, int h, int orient)
+{
+    auto cell = transform_box(Box(0, 0, w, h), orient);
+    return transform_box(b, orient).shifted(-cell.lx_, -cell.ly_);
+}
+
+}   // End of namespace util
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file    MappedFile.cpp
+ */
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace util
+{
+
+MappedFile* MappedFile::active_ = nullptr;
+
+/**
+ * Map the file @a filename.
+ */
+MappedFile::MappedFile (string filename)
+    : filename_(filename), data_(nullptr), size_(0), range_id_(0), cursor_(0)
+{
+    auto fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument("(E) " + filename + " not found.");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw runtime_error("(E) Cannot stat " + filename + ".");
+    }
+    size_ = st.st_size;
+
+    if (size_ > 0) {
+        auto addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("(E) Cannot map " + filename + ".");
+        }
+        data_ = static_cast<const char*>(addr);
+
+        // Hints only; failures are harmless.
+        madvise(addr, size_, MADV_SEQUENTIAL);
+        madvise(addr, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+        madvise(addr, size_, MADV_HUGEPAGE);
+#endif
+    }
+    close(fd);
+
+    ranges_.emplace_back(0, size_);
+}
+
+MappedFile::~MappedFile ()
+{
+    if (active_ == this) {
+        active_ = nullptr;
+    }
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+const char* MappedFile::get_data () const
+{
+    return data_;
+}
+
+size_t MappedFile::get_size () const
+{
+    return size_;
+}
+
+void MappedFile::set_ranges (vector<pair<size_t, size_t>> ranges)
+{
+    ranges_ = ranges;
+    range_id_ = 0;
+    cursor_ = ranges_.empty() ? 0 : ranges_[0].first;
+}
+
+size_t MappedFile::read (char* buf, size_t len)
+{
+    size_t copied = 0;
+
+    while (copied < len && range_id_ < ranges_.size()) {
+        auto end = ranges_[range_id_].second;
+
+        if (cursor_ >= end) {
+            range_id_++;
+            if (range_id_ < ranges_.size()) {
+                cursor_ = ranges_[range_id_].first;
+            }
+            continue;
+        }
+
+        auto n = std::min(len - copied, end - cursor_);
+        memcpy(buf + copied, data_ + cursor_, n);
+        copied += n;
+        cursor_ += n;
+    }
+
+    return copied;
+}
+
+void MappedFile::set_active (MappedFile* file)
+{
+    active_ = file;
+}
+
+size_t MappedFile::read_active (FILE*, char* buf, size_t len)
+{
+    return active_ ? active_->read(buf, len) : 0;
+}
+
+}   // End of namespace util
@@ -0,0 +1,62 @@
+/**
+ * @file    MappedFile.h
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "common_header.h"
+
+namespace util
+{
+
+/**
+ * A read-only memory mapping of a whole file.
+ *
+ * The mapping is advised for sequential access (and transparent huge pages
+ * where available). It can also serve as the input of the Si2 LEF/DEF
+ * readers: make it active with set_active() and register read_active()
+ * through defrSetReadFunction()/lefrSetReadFunction().
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile (string filename);
+    ~MappedFile ();
+
+    const char* get_data () const;
+    size_t get_size () const;
+
+    /**
+     * Restrict what read() returns to the byte ranges [first, second), 
+     * in the given order. By default the whole file is read.
+     */
+    void set_ranges (vector<pair<size_t, size_t>> ranges);
+
+    /**
+     * Copy up to @a len bytes at the read cursor into @a buf.
+     * @return The number of bytes copied, 0 at the end.
+     */
+    size_t read (char* buf, size_t len);
+
+    static void set_active (MappedFile* file);
+    static size_t read_active (FILE*, char* buf, size_t len);
+
+private:
+    string filename_;
+    const char* data_;
+    size_t size_;
+
+    vector<pair<size_t, size_t>> ranges_;
+    size_t range_id_;       ///< The range being read.
+    size_t cursor_;         ///< Offset in the file.
+
+    static MappedFile* active_;
+
+    MappedFile (const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+};
+
+}   // End of namespace util
+
+#endif
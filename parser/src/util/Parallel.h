@@ -0,0 +1,88 @@
+/**
+ * @file    Parallel.h
+ * @brief   A header only parallel loop on std::thread.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace util
+{
+
+/**
+ * @return @a requested if positive, the number of hardware threads otherwise.
+ */
+inline int get_num_threads (int requested = 0)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    auto n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 0 ? n : 1;
+}
+
+/**
+ * Call @a func(i) for every i in [0, @a n) on up to @a num_threads threads.
+ * Iterations are handed out one at a time, so uneven work balances itself.
+ * The calling thread takes part in the loop. The first exception thrown by
+ * @a func stops the loop and is rethrown on the calling thread once all
+ * the threads are joined.
+ */
+template <typename Func>
+void parallel_for (size_t n, int num_threads, Func func)
+{
+    auto num_workers = static_cast<size_t>(std::max(1, num_threads));
+    num_workers = std::min(num_workers, n);
+
+    if (num_workers <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&] () {
+        try {
+            for (auto i = next++; i < n; i = next++) {
+                func(i);
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = n;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1);
+    for (size_t t = 1; t < num_workers; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}   // End of namespace util
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file    RectSet.cpp
+ */
+
+#include "RectSet.h"
+
+using namespace std;
+
+namespace util
+{
+
+/**
+ * Sweep the slab boundaries upwards, keeping the boxes that span the
+ * current slab, and merge their x intervals.
+ */
+void RectSet::build (const vector<Box>& boxes)
+{
+    clear();
+
+    vector<uint32_t> order;
+    vector<int> ys;
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        auto& b = boxes[i];
+        if (b.lx_ < b.ux_ && b.ly_ < b.uy_) {
+            order.push_back(i);
+            ys.push_back(b.ly_);
+            ys.push_back(b.uy_);
+        }
+    }
+    if (order.empty()) {
+        return;
+    }
+
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+    sort(order.begin(), order.end(), [&boxes] (uint32_t a, uint32_t b) {
+        return boxes[a].ly_ < boxes[b].ly_;
+    });
+
+    begin_.push_back(0);
+
+    vector<uint32_t> active;
+    vector<pair<int, int>> slab;
+    size_t next = 0;
+    for (size_t k = 0; k + 1 < ys.size(); k++) {
+        active.erase(remove_if(active.begin(), active.end(), [&] (uint32_t i) {
+                         return boxes[i].uy_ <= ys[k];
+                     }), active.end());
+        while (next < order.size() && boxes[order[next]].ly_ == ys[k]) {
+            active.push_back(order[next++]);
+        }
+
+        slab.clear();
+        for (auto i : active) {
+            slab.emplace_back(boxes[i].lx_, boxes[i].ux_);
+        }
+        sort(slab.begin(), slab.end());
+
+        auto merged_end = slab.begin();
+        for (auto it = slab.begin(); it != slab.end(); ++it) {
+            if (merged_end != slab.begin() && it->first <= (merged_end - 1)->second) {
+                (merged_end - 1)->second = max((merged_end - 1)->second, it->second);
+            }
+            else {
+                *merged_end++ = *it;
+            }
+        }
+        slab.erase(merged_end, slab.end());
+
+        // The slab below has the same intervals; it grows instead.
+        if (!ys_.empty()) {
+            auto prev = intervals_.begin() + begin_[begin_.size() - 2];
+            if (static_cast<size_t>(intervals_.end() - prev) == slab.size()
+                && equal(slab.begin(), slab.end(), prev)) {
+                continue;
+            }
+        }
+
+        ys_.push_back(ys[k]);
+        intervals_.insert(intervals_.end(), slab.begin(), slab.end());
+        begin_.push_back(intervals_.size());
+    }
+    ys_.push_back(ys.back());
+}
+
+void RectSet::clear ()
+{
+    ys_.clear();
+    begin_.clear();
+    intervals_.clear();
+}
+
+int RectSet::find_slab (int y) const
+{
+    if (ys_.empty() || y < ys_.front() || y >= ys_.back()) {
+        return -1;
+    }
+    return static_cast<int>(upper_bound(ys_.begin(), ys_.end(), y) - ys_.begin()) - 1;
+}
+
+bool RectSet::contains (int x, int y) const
+{
+    auto s = find_slab(y);
+    if (s < 0) {
+        return false;
+    }
+
+    auto first = intervals_.begin() + begin_[s];
+    auto last = intervals_.begin() + begin_[s + 1];
+    auto found = upper_bound(first, last, x, [] (int x, const pair<int, int>& i) {
+                     return x < i.first;
+                 });
+    return found != first && x < (found - 1)->second;
+}
+
+bool RectSet::contains (const Box& b) const
+{
+    if (b.lx_ >= b.ux_ || b.ly_ >= b.uy_) {
+        return contains(b.lx_, b.ly_);
+    }
+
+    auto s = find_slab(b.ly_);
+    if (s < 0 || b.uy_ > ys_.back()) {
+        return false;
+    }
+
+    for (; ys_[s] < b.uy_; s++) {
+        auto first = intervals_.begin() + begin_[s];
+        auto last = intervals_.begin() + begin_[s + 1];
+        auto found = upper_bound(first, last, b.lx_, [] (int x, const pair<int, int>& i) {
+                         return x < i.first;
+                     });
+        if (found == first || b.ux_ > (found - 1)->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RectSet::overlaps (const Box& b) const
+{
+    if (ys_.empty() || b.lx_ >= b.ux_ || b.ly_ >= b.uy_
+        || b.uy_ <= ys_.front() || b.ly_ >= ys_.back()) {
+        return false;
+    }
+
+    auto s = max(0, find_slab(b.ly_));
+    for (; s + 1 < static_cast<int>(ys_.size()) && ys_[s] < b.uy_; s++) {
+        auto first = intervals_.begin() + begin_[s];
+        auto last = intervals_.begin() + begin_[s + 1];
+        // The first interval ending right of lx.
+        auto found = upper_bound(first, last, b.lx_, [] (int x, const pair<int, int>& i) {
+                         return x < i.second;
+                     });
+        if (found != last && found->first < b.ux_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}   // End of namespace util
@@ -0,0 +1,83 @@
+/**
+ * @file    RectSet.h
+ * @brief   The union of a set of boxes, with logarithmic containment tests.
+ */
+
+#ifndef RECT_SET_H
+#define RECT_SET_H
+
+#include "common_header.h"
+#include "Geometry.h"
+
+namespace util
+{
+
+/**
+ * The union of a set of boxes, kept as horizontal slabs, each a sorted list
+ * of disjoint x intervals. Slabs with the same intervals are merged.
+ *
+ * The set covers [lx, ux) x [ly, uy) of every box, so that boxes sharing
+ * an edge join. A point test is two binary searches; a box test is a binary
+ * search in every slab the box crosses.
+ */
+class RectSet
+{
+public:
+    RectSet () = default;
+
+    /**
+     * Replace the set with the union of @a boxes. Empty boxes are ignored.
+     */
+    void build (const vector<Box>& boxes);
+    void clear ();
+    bool empty () const;
+
+    /**
+     * @return True if the point (@a x, @a y) is in the set.
+     */
+    bool contains (int x, int y) const;
+
+    /**
+     * @return True if all of @a b is in the set. An empty box is tested
+     *         as its lower-left corner.
+     */
+    bool contains (const Box& b) const;
+
+    /**
+     * @return True if @a b and the set share a positive area.
+     */
+    bool overlaps (const Box& b) const;
+
+    size_t get_num_slabs () const;
+    size_t get_num_intervals () const;
+
+private:
+    vector<int> ys_;                        ///< Slab i is [ys_[i], ys_[i+1]).
+    vector<uint32_t> begin_;                ///< Intervals of slab i: [begin_[i], begin_[i+1]).
+    vector<pair<int, int>> intervals_;      ///< [first, second) in x.
+
+    /**
+     * @return The slab containing @a y, -1 if none.
+     */
+    int find_slab (int y) const;
+};
+
+
+inline bool RectSet::empty () const
+{
+    return ys_.empty();
+}
+
+inline size_t RectSet::get_num_slabs () const
+{
+    return ys_.empty() ? 0 : ys_.size() - 1;
+}
+
+inline size_t RectSet::get_num_intervals () const
+{
+    return intervals_.size();
+}
+
+}   // End of namespace util
+
+#endif
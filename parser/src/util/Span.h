@@ -0,0 +1,40 @@
+/**
+ * @file    Span.h
+ * @brief   A read-only view of a contiguous range.
+ */
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+
+namespace util
+{
+
+/**
+ * A pair of pointers to a contiguous range of T owned by someone else,
+ * usable in range-based for loops. It stays valid as long as the storage.
+ */
+template <typename T>
+class Span
+{
+public:
+    Span () : begin_(nullptr), end_(nullptr) {}
+    Span (const T* begin, const T* end) : begin_(begin), end_(end) {}
+
+    const T* begin () const { return begin_; }
+    const T* end () const { return end_; }
+
+    size_t size () const { return end_ - begin_; }
+    bool empty () const { return begin_ == end_; }
+
+    const T& operator[] (size_t i) const { return begin_[i]; }
+
+private:
+    const T* begin_;
+    const T* end_;
+};
+
+}   // End of namespace util
+
+#endif
@@ -8,6 +8,8 @@
 
 #include "StringUtil.h"
 
+#include <cstring>
+
 /**
  * Tokenize the string and add the tokens into a deque.
  */
@@ -48,3 +50,74 @@ string StringUtil::to_lower (string str)
 
     return str;
 }
+
+/**
+ * Match greedily, and on a mismatch retry from the last '*' with one more
+ * character swallowed by it.
+ */
+bool StringUtil::matches (const char* pattern, const char* str)
+{
+    const char* star = nullptr;
+    const char* retry = nullptr;
+
+    while (*str != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            retry = str;
+        }
+        else if (*pattern == '?' || *pattern == *str) {
+            pattern++;
+            str++;
+        }
+        else if (star != nullptr) {
+            pattern = star + 1;
+            str = ++retry;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+/**
+ * The prefix is one SI letter; 'k' and 'K' are both kilo.
+ */
+double StringUtil::parse_unit (string unit, const char* base)
+{
+    auto scale = 1.0;
+    char* rest = nullptr;
+    auto number = strtod(unit.c_str(), &rest);
+    if (rest != unit.c_str()) {
+        scale = number;
+        unit = rest;
+    }
+
+    auto base_length = strlen(base);
+    if (unit.size() < base_length
+        || StringUtil::to_lower(unit.substr(unit.size() - base_length))
+           != StringUtil::to_lower(base)) {
+        return 0;
+    }
+    auto prefix = unit.substr(0, unit.size() - base_length);
+    if (prefix.empty()) {
+        return scale;
+    }
+    if (prefix.size() > 1) {
+        return 0;
+    }
+    switch (prefix[0]) {
+        case 'f': return scale * 1e-15;
+        case 'p': return scale * 1e-12;
+        case 'n': return scale * 1e-9;
+        case 'u': return scale * 1e-6;
+        case 'm': return scale * 1e-3;
+        case 'k': case 'K': return scale * 1e3;
+        case 'M': return scale * 1e6;
+        default: return 0;
+    }
+}
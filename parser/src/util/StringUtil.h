@@ -18,6 +18,18 @@ public:
     static string to_upper (string);
     static string to_lower (string);
 
+    /**
+     * @return True if @a str matches @a pattern, in which '*' stands for
+     *         any string and '?' for any character.
+     */
+    static bool matches (const char* pattern, const char* str);
+
+    /**
+     * @return The value of a unit such as "ns", "1ps", "pF" or "kOhm" in the
+     *         base unit @a base, 0 if it is not one.
+     */
+    static double parse_unit (string unit, const char* base);
+
 private:
     StringUtil () = default;
     ~StringUtil () = default;
@@ -0,0 +1,193 @@
+/**
+ * @file    SymbolTable.cpp
+ */
+
+#include "SymbolTable.h"
+
+using namespace std;
+
+namespace util
+{
+
+static const size_t block_size = 1 << 20;
+
+static uint32_t hash_name (const char* str, size_t len)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= static_cast<unsigned char>(str[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Implementation of the class SymbolTable.
+ *
+ * Characters are packed into large blocks, and the lookup table is an
+ * open-addressing hash table of (id + 1), where 0 marks an empty slot.
+ */
+struct SymbolTable::Impl
+{
+    vector<unique_ptr<char[]>> blocks_;
+    size_t block_used_ = block_size;
+
+    vector<const char*> names_;     ///< Indexed by SymbolId.
+    vector<uint32_t> lengths_;      ///< Indexed by SymbolId.
+    vector<uint32_t> hashes_;       ///< Indexed by SymbolId.
+    vector<uint32_t> slots_;
+
+    Impl () : slots_(1024, 0) {}
+
+    const char* store (const char* str, size_t len)
+    {
+        if (len + 1 > block_size) {
+            // A dedicated block, inserted before the one being filled.
+            auto pos = blocks_.empty() ? blocks_.end() : blocks_.end() - 1;
+            auto it = blocks_.emplace(pos, new char[len + 1]);
+            auto dest = it->get();
+            memcpy(dest, str, len);
+            dest[len] = '\0';
+
+            return dest;
+        }
+
+        if (block_used_ + len + 1 > block_size) {
+            blocks_.emplace_back(new char[block_size]);
+            block_used_ = 0;
+        }
+        auto dest = blocks_.back().get() + block_used_;
+        memcpy(dest, str, len);
+        dest[len] = '\0';
+        block_used_ += len + 1;
+
+        return dest;
+    }
+
+    size_t find_slot (const char* str, size_t len, uint32_t h) const
+    {
+        auto mask = slots_.size() - 1;
+        auto i = h & mask;
+
+        while (slots_[i] != 0) {
+            auto id = slots_[i] - 1;
+            if (hashes_[id] == h && lengths_[id] == len
+                && memcmp(names_[id], str, len) == 0) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void grow ()
+    {
+        vector<uint32_t> slots(slots_.size() * 2, 0);
+        auto mask = slots.size() - 1;
+
+        for (uint32_t id = 0; id < names_.size(); id++) {
+            auto i = hashes_[id] & mask;
+            while (slots[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = id + 1;
+        }
+        slots_.swap(slots);
+    }
+};
+
+
+const SymbolId SymbolTable::invalid_symbol;
+
+SymbolTable::SymbolTable () : pimpl_{new Impl()}
+{
+    intern("", 0);
+}
+
+SymbolTable::~SymbolTable () = default;
+
+SymbolTable& SymbolTable::get_instance ()
+{
+    static SymbolTable symbol_table;
+    return symbol_table;
+}
+
+SymbolId SymbolTable::intern (const char* str, size_t len)
+{
+    auto h = hash_name(str, len);
+    auto i = pimpl_->find_slot(str, len, h);
+
+    if (pimpl_->slots_[i] != 0) {
+        return pimpl_->slots_[i] - 1;
+    }
+
+    SymbolId id = pimpl_->names_.size();
+    pimpl_->names_.push_back(pimpl_->store(str, len));
+    pimpl_->lengths_.push_back(len);
+    pimpl_->hashes_.push_back(h);
+    pimpl_->slots_[i] = id + 1;
+
+    // Keep the load factor below 1/2.
+    if (pimpl_->names_.size() * 2 > pimpl_->slots_.size()) {
+        pimpl_->grow();
+    }
+
+    return id;
+}
+
+SymbolId SymbolTable::intern (const char* str)
+{
+    return intern(str, strlen(str));
+}
+
+SymbolId SymbolTable::intern (const string& str)
+{
+    return intern(str.data(), str.size());
+}
+
+SymbolId SymbolTable::find (const char* str, size_t len) const
+{
+    auto i = pimpl_->find_slot(str, len, hash_name(str, len));
+
+    if (pimpl_->slots_[i] == 0) {
+        return invalid_symbol;
+    }
+    return pimpl_->slots_[i] - 1;
+}
+
+SymbolId SymbolTable::find (const char* str) const
+{
+    return find(str, strlen(str));
+}
+
+SymbolId SymbolTable::find (const string& str) const
+{
+    return find(str.data(), str.size());
+}
+
+const char* SymbolTable::get_name (SymbolId id) const
+{
+    return pimpl_->names_[id];
+}
+
+size_t SymbolTable::get_length (SymbolId id) const
+{
+    return pimpl_->lengths_[id];
+}
+
+size_t SymbolTable::size () const
+{
+    return pimpl_->names_.size();
+}
+
+size_t SymbolTable::get_reserved_bytes () const
+{
+    return pimpl_->blocks_.size() * block_size
+           + pimpl_->names_.capacity() * sizeof(const char*)
+           + pimpl_->lengths_.capacity() * sizeof(uint32_t)
+           + pimpl_->hashes_.capacity() * sizeof(uint32_t)
+           + pimpl_->slots_.capacity() * sizeof(uint32_t);
+}
+
+}   // End of namespace util
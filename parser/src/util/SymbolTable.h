@@ -0,0 +1,68 @@
+/**
+ * @file    SymbolTable.h
+ */
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "common_header.h"
+
+namespace util
+{
+
+using SymbolId = uint32_t;
+
+/**
+ * A process-wide table of interned names.
+ *
+ * Every distinct string is stored once and identified by a dense 32-bit id
+ * that stays valid for the lifetime of the process. Id 0 is always the
+ * empty string, so value-initialized ids refer to "". Not thread-safe;
+ * intern names from one thread at a time.
+ */
+class SymbolTable
+{
+public:
+    static const SymbolId invalid_symbol = 0xFFFFFFFF;
+
+    static SymbolTable& get_instance ();
+
+    SymbolId intern (const char* str, size_t len);
+    SymbolId intern (const char* str);
+    SymbolId intern (const string& str);
+
+    /**
+     * @return The id of @a str, or invalid_symbol if it was never interned.
+     */
+    SymbolId find (const char* str, size_t len) const;
+    SymbolId find (const char* str) const;
+    SymbolId find (const string& str) const;
+
+    const char* get_name (SymbolId id) const;
+    size_t get_length (SymbolId id) const;
+
+    size_t size () const;
+    size_t get_reserved_bytes () const;
+
+private:
+    struct Impl;
+    unique_ptr<Impl> pimpl_;   ///< Pointer to the implementation.
+
+    SymbolTable ();
+    ~SymbolTable ();
+    SymbolTable (const SymbolTable&) = delete;
+    SymbolTable& operator= (const SymbolTable&) = delete;
+};
+
+/**
+ * @return The name of the symbol @a id of the process-wide table.
+ */
+inline string get_symbol_name (SymbolId id)
+{
+    auto& symbols = SymbolTable::get_instance();
+    return string(symbols.get_name(id), symbols.get_length(id));
+}
+
+}   // End of namespace util
+
+#endif
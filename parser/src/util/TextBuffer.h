@@ -0,0 +1,186 @@
+/**
+ * @file    TextBuffer.h
+ * @brief   A header only append-only text buffer with fast integer output.
+ */
+
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "Parallel.h"
+
+namespace util
+{
+
+/**
+ * An append-only text buffer for writers of large text files.
+ *
+ * Integers are converted with a two-digits-at-a-time table instead of
+ * printf/iostream formatting, and produce the same text as "%d".
+ */
+class TextBuffer
+{
+public:
+    TextBuffer& append (const char* str, size_t len)
+    {
+        buffer_.append(str, len);
+        return *this;
+    }
+
+    TextBuffer& append (const char* str)
+    {
+        return append(str, strlen(str));
+    }
+
+    TextBuffer& append (const std::string& str)
+    {
+        return append(str.data(), str.size());
+    }
+
+    TextBuffer& append (char c)
+    {
+        buffer_.push_back(c);
+        return *this;
+    }
+
+    TextBuffer& append_int (int64_t value)
+    {
+        static const char digit_pairs[] =
+            "00010203040506070809101112131415161718192021222324"
+            "25262728293031323334353637383940414243444546474849"
+            "50515253545556575859606162636465666768697071727374"
+            "75767778798081828384858687888990919293949596979899";
+
+        char buf[24];
+        auto end = buf + sizeof(buf);
+        auto p = end;
+
+        // Work on the magnitude as unsigned, so INT64_MIN does not overflow.
+        auto u = value < 0 ? 0 - static_cast<uint64_t>(value)
+                           : static_cast<uint64_t>(value);
+
+        while (u >= 100) {
+            auto i = (u % 100) * 2;
+            u /= 100;
+            *--p = digit_pairs[i + 1];
+            *--p = digit_pairs[i];
+        }
+        if (u >= 10) {
+            auto i = u * 2;
+            *--p = digit_pairs[i + 1];
+            *--p = digit_pairs[i];
+        }
+        else {
+            *--p = static_cast<char>('0' + u);
+        }
+        if (value < 0) {
+            *--p = '-';
+        }
+
+        return append(p, end - p);
+    }
+
+    /**
+     * Append @a value as "%g" (ostream's default) would.
+     */
+    TextBuffer& append_double (double value)
+    {
+        if (value < 1e6 && value > -1e6 && value == static_cast<int64_t>(value)
+            && !(value == 0 && std::signbit(value))) {
+            return append_int(static_cast<int64_t>(value));
+        }
+        char buf[32];
+        auto len = snprintf(buf, sizeof(buf), "%g", value);
+        return append(buf, len);
+    }
+
+    /**
+     * Append @a str left-aligned in @a width columns, like std::left and
+     * std::setw(width).
+     */
+    TextBuffer& append_left (const std::string& str, size_t width)
+    {
+        return append_left(str.data(), str.size(), width);
+    }
+
+    TextBuffer& append_left (const char* str, size_t len, size_t width)
+    {
+        append(str, len);
+        if (len < width) {
+            buffer_.append(width - len, ' ');
+        }
+        return *this;
+    }
+
+    /**
+     * Append @a value right-aligned in @a width columns, like std::right and
+     * std::setw(width).
+     */
+    TextBuffer& append_int_right (int64_t value, size_t width)
+    {
+        auto pos = buffer_.size();
+        append_int(value);
+        auto len = buffer_.size() - pos;
+        if (len < width) {
+            buffer_.insert(pos, width - len, ' ');
+        }
+        return *this;
+    }
+
+    const char* data () const { return buffer_.data(); }
+    size_t size () const { return buffer_.size(); }
+    bool empty () const { return buffer_.empty(); }
+
+    void reserve (size_t n) { buffer_.reserve(n); }
+    void clear () { buffer_.clear(); }
+
+    /**
+     * Write the contents to @a fp.
+     * @return false on an error.
+     */
+    bool write (FILE* fp) const
+    {
+        return fwrite(buffer_.data(), 1, buffer_.size(), fp) == buffer_.size();
+    }
+
+private:
+    std::string buffer_;
+};
+
+/**
+ * Call @a emit(buf, i) for every i in [0, @a n) on @a num_threads threads.
+ * The records are formatted in chunks into separate buffers, which hold
+ * them in order of i when concatenated.
+ */
+template <typename Emit>
+std::vector<TextBuffer> format_chunks (size_t n, int num_threads, Emit emit)
+{
+    const size_t min_chunk_size = 4096;
+    auto num_chunks = std::max<size_t>(1, std::min<size_t>(
+                          static_cast<size_t>(std::max(1, num_threads)) * 4, 
+                          n / min_chunk_size));
+    auto chunk_size = (n + num_chunks - 1) / num_chunks;
+
+    std::vector<TextBuffer> buffers(num_chunks);
+    parallel_for(num_chunks, num_threads, [&] (size_t i) {
+        auto begin = i * chunk_size;
+        auto end = std::min(n, begin + chunk_size);
+        auto& buf = buffers[i];
+        for (auto j = begin; j < end; j++) {
+            emit(buf, j);
+        }
+    });
+
+    return buffers;
+}
+
+}   // End of namespace util
+
+#endif